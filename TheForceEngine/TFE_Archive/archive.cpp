@@ -6,6 +6,7 @@
 #include "labArchive.h"
 #include "zipArchive.h"
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/pathIndex.h>
 #include <assert.h>
 #include <string>
 #include <map>
@@ -106,6 +107,8 @@ void Archive::freeArchive(Archive* archive)
 
 		s_archives[type].erase(iArchive);
 	}
+	// Cached path lookups may point into the freed archive.
+	TFE_PathIndex::invalidateAll();
 }
 
 void Archive::freeAllArchives()
@@ -121,6 +124,7 @@ void Archive::freeAllArchives()
 		}
 		s_archives[i].clear();
 	}
+	TFE_PathIndex::invalidateAll();
 }
 
 Archive* Archive::createCustomArchive(ArchiveType type, const char* path)
@@ -179,4 +183,5 @@ void Archive::deleteCustomArchive(Archive* archive)
 		s_archives->erase(iArchive);
 	}
 	delete archive;
+	TFE_PathIndex::invalidateAll();
 }
@@ -60,6 +60,9 @@ public:
 	virtual size_t readFile(void *data, size_t size) = 0;
 	virtual bool seekFile(s32 offset, s32 origin = SEEK_SET) = 0;
 	virtual size_t getLocInFile() = 0;
+	// Read-only view of a file's data when the archive supports reading in place (memory mapped), otherwise nullptr.
+	// The view remains valid until the archive is closed or modified.
+	virtual const u8* getFileData(u32 index) { return nullptr; }
 
 	// Directory
 	virtual u32 getFileCount() = 0;
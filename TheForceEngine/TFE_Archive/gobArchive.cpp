@@ -2,6 +2,7 @@
 
 #include <TFE_System/system.h>
 #include "gobArchive.h"
+#include <TFE_FileSystem/pathIndex.h>
 #include <assert.h>
 #include <algorithm>
 #include <vector>
@@ -76,6 +77,7 @@ bool GobArchive::open(const char *archivePath)
 
 	strcpy(m_archivePath, archivePath);
 	m_file.close();
+	mapArchive();
 
 	return true;
 }
@@ -83,6 +85,7 @@ bool GobArchive::open(const char *archivePath)
 void GobArchive::close()
 {
 	m_file.close();
+	m_map.close();
 	m_archiveOpen = false;
 	delete[] m_fileList.entries;
 	m_fileList.entries = nullptr;
@@ -93,7 +96,7 @@ bool GobArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
+	if (!m_map.isOpen()) { m_file.open(m_archivePath, Stream::MODE_READ); }
 	m_curFile = -1;
 	m_fileOffset = 0;
 
@@ -112,7 +115,7 @@ bool GobArchive::openFile(const char *file)
 		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "GOB", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
-	else
+	else if (!m_map.isOpen())
 	{
 		m_file.seek(m_fileList.entries[m_curFile].IX);
 	}
@@ -125,8 +128,11 @@ bool GobArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
-	m_file.open(m_archivePath, Stream::MODE_READ);
-	m_file.seek(m_fileList.entries[m_curFile].IX);
+	if (!m_map.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+		m_file.seek(m_fileList.entries[m_curFile].IX);
+	}
 	return true;
 }
 
@@ -184,6 +190,14 @@ size_t GobArchive::readFile(void *data, size_t size)
 	if (m_curFile < 0) { return false; }
 	if (size == 0) { size = m_fileList.entries[m_curFile].LEN; }
 	const size_t sizeToRead = std::min(size, (size_t)m_fileList.entries[m_curFile].LEN);
+	if (m_map.isOpen())
+	{
+		// Copy directly from the mapped archive, stopping at the end of the file.
+		const size_t sizeToCopy = std::min(sizeToRead, (size_t)m_fileList.entries[m_curFile].LEN - (size_t)m_fileOffset);
+		memcpy(data, m_map.getData() + m_fileList.entries[m_curFile].IX + m_fileOffset, sizeToCopy);
+		m_fileOffset += (s32)sizeToCopy;
+		return sizeToCopy;
+	}
 
 	u32 bytesRead = m_file.readBuffer(data, (u32)sizeToRead);
 	m_fileOffset += (s32)sizeToRead;
@@ -217,7 +231,10 @@ bool GobArchive::seekFile(s32 offset, s32 origin)
 		return false;
 	}
 
-	m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	if (!m_map.isOpen())
+	{
+		m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	}
 	return true;
 }
 
@@ -226,6 +243,29 @@ size_t GobArchive::getLocInFile()
 	return m_fileOffset;
 }
 
+const u8* GobArchive::getFileData(u32 index)
+{
+	if (!m_map.isOpen() || index >= getFileCount()) { return nullptr; }
+	return m_map.getData() + m_fileList.entries[index].IX;
+}
+
+// Map the archive so files can be read in place, the stream is used instead if this fails.
+void GobArchive::mapArchive()
+{
+	if (!m_map.open(m_archivePath)) { return; }
+
+	const size_t mapSize = m_map.getSize();
+	for (u32 i = 0; i < m_fileList.MASTERN; i++)
+	{
+		if ((size_t)m_fileList.entries[i].IX + (size_t)m_fileList.entries[i].LEN > mapSize)
+		{
+			TFE_System::logWrite(LOG_WARNING, "Archive", "\"%s\" is truncated, reading through a file stream instead.", m_archivePath);
+			m_map.close();
+			return;
+		}
+	}
+}
+
 // Directory
 u32 GobArchive::getFileCount()
 {
@@ -253,6 +293,9 @@ void GobArchive::addFile(const char* fileName, const char* filePath)
 	{
 		return;
 	}
+	// The archive is rewritten below, so release the mapping first.
+	m_map.close();
+
 	const size_t len = file.getSize();
 	const u32 newId = m_fileList.MASTERN;
 	m_fileList.MASTERN++;
@@ -297,4 +340,7 @@ void GobArchive::addFile(const char* fileName, const char* filePath)
 		m_file.writeBuffer(m_fileList.entries, sizeof(GOB_Entry_t), m_fileList.MASTERN);
 		m_file.close();
 	}
+	mapArchive();
+	// Lookups of the new file may have been cached as missing.
+	TFE_PathIndex::invalidateAll();
 }
@@ -196,6 +196,12 @@ size_t GobMemoryArchive::getLocInFile()
 	return m_fileOffset;
 }
 
+const u8* GobMemoryArchive::getFileData(u32 index)
+{
+	if (!m_archiveOpen || index >= getFileCount()) { return nullptr; }
+	return m_buffer + m_fileList.entries[index].IX;
+}
+
 // Directory
 u32 GobMemoryArchive::getFileCount()
 {
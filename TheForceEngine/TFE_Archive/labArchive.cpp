@@ -36,6 +36,7 @@ bool LabArchive::open(const char *archivePath)
 	m_file.close();
 		
 	strcpy(m_archivePath, archivePath);
+	mapArchive();
 	
 	return true;
 }
@@ -43,6 +44,7 @@ bool LabArchive::open(const char *archivePath)
 void LabArchive::close()
 {
 	m_file.close();
+	m_map.close();
 	m_archiveOpen = false;
 	delete[] m_entries;
 	delete[] m_stringTable;
@@ -53,7 +55,7 @@ bool LabArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
+	if (!m_map.isOpen()) { m_file.open(m_archivePath, Stream::MODE_READ); }
 	m_curFile = -1;
 	m_fileOffset = 0;
 
@@ -72,7 +74,7 @@ bool LabArchive::openFile(const char *file)
 		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "GOB", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
-	else
+	else if (!m_map.isOpen())
 	{
 		m_file.seek(m_entries[m_curFile].dataOffset);
 	}
@@ -85,8 +87,11 @@ bool LabArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
-	m_file.open(m_archivePath, Stream::MODE_READ);
-	m_file.seek(m_entries[m_curFile].dataOffset);
+	if (!m_map.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+		m_file.seek(m_entries[m_curFile].dataOffset);
+	}
 	return true;
 }
 
@@ -145,6 +150,14 @@ size_t LabArchive::readFile(void *data, size_t size)
 	if (m_curFile < 0) { return false; }
 	if (size == 0) { size = m_entries[m_curFile].len; }
 	const size_t sizeToRead = std::min(size, (size_t)m_entries[m_curFile].len);
+	if (m_map.isOpen())
+	{
+		// Copy directly from the mapped archive, stopping at the end of the file.
+		const size_t sizeToCopy = std::min(sizeToRead, (size_t)m_entries[m_curFile].len - (size_t)m_fileOffset);
+		memcpy(data, m_map.getData() + m_entries[m_curFile].dataOffset + m_fileOffset, sizeToCopy);
+		m_fileOffset += (s32)sizeToCopy;
+		return sizeToCopy;
+	}
 
 	size_t bytesRead = m_file.readBuffer(data, (u32)sizeToRead);
 	m_fileOffset += (s32)sizeToRead;
@@ -178,7 +191,10 @@ bool LabArchive::seekFile(s32 offset, s32 origin)
 		return false;
 	}
 
-	m_file.seek(m_entries[m_curFile].dataOffset + m_fileOffset);
+	if (!m_map.isOpen())
+	{
+		m_file.seek(m_entries[m_curFile].dataOffset + m_fileOffset);
+	}
 	return true;
 }
 
@@ -187,6 +203,29 @@ size_t LabArchive::getLocInFile()
 	return m_fileOffset;
 }
 
+const u8* LabArchive::getFileData(u32 index)
+{
+	if (!m_map.isOpen() || index >= getFileCount()) { return nullptr; }
+	return m_map.getData() + m_entries[index].dataOffset;
+}
+
+// Map the archive so files can be read in place, the stream is used instead if this fails.
+void LabArchive::mapArchive()
+{
+	if (!m_map.open(m_archivePath)) { return; }
+
+	const size_t mapSize = m_map.getSize();
+	for (u32 i = 0; i < m_header.fileCount; i++)
+	{
+		if ((size_t)m_entries[i].dataOffset + (size_t)m_entries[i].len > mapSize)
+		{
+			TFE_System::logWrite(LOG_WARNING, "Archive", "\"%s\" is truncated, reading through a file stream instead.", m_archivePath);
+			m_map.close();
+			return;
+		}
+	}
+}
+
 // Directory
 u32 LabArchive::getFileCount()
 {
@@ -1,6 +1,7 @@
 #pragma once
 #include <TFE_System/types.h>
 #include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/mappedFile.h>
 #include <TFE_FileSystem/paths.h>
 #include "archive.h"
 
@@ -28,6 +29,7 @@ public:
 	size_t readFile(void *data, size_t size) override;
 	bool seekFile(s32 offset, s32 origin = SEEK_SET) override;
 	size_t getLocInFile() override;
+	const u8* getFileData(u32 index) override;
 
 	// Directory
 	u32 getFileCount() override;
@@ -57,7 +59,10 @@ private:
 	};
 	#pragma pack(pop)
 
+	void mapArchive();
+
 	FileStream m_file;
+	MappedFile m_map;
 	bool m_archiveOpen;
 
 	LAB_Header_t m_header;
@@ -62,6 +62,7 @@ bool LfdArchive::open(const char *archivePath)
 
 	strcpy(m_archivePath, archivePath);
 	m_file.close();
+	mapArchive();
 
 	return true;
 }
@@ -69,6 +70,7 @@ bool LfdArchive::open(const char *archivePath)
 void LfdArchive::close()
 {
 	m_file.close();
+	m_map.close();
 	m_archiveOpen = false;
 
 	if (m_fileList.entries)
@@ -83,7 +85,7 @@ bool LfdArchive::openFile(const char *file)
 {
 	if (!m_archiveOpen) { return false; }
 
-	m_file.open(m_archivePath, Stream::MODE_READ);
+	if (!m_map.isOpen()) { m_file.open(m_archivePath, Stream::MODE_READ); }
 	m_curFile = -1;
 	m_fileOffset = 0;
 
@@ -102,7 +104,7 @@ bool LfdArchive::openFile(const char *file)
 		m_file.close();
 		TFE_System::logWrite(LOG_ERROR, "LFD", "Failed to load \"%s\" from \"%s\"", file, m_archivePath);
 	}
-	else
+	else if (!m_map.isOpen())
 	{
 		m_file.seek(m_fileList.entries[m_curFile].IX);
 	}
@@ -115,8 +117,11 @@ bool LfdArchive::openFile(u32 index)
 
 	m_curFile = s32(index);
 	m_fileOffset = 0;
-	m_file.open(m_archivePath, Stream::MODE_READ);
-	m_file.seek(m_fileList.entries[m_curFile].IX);
+	if (!m_map.isOpen())
+	{
+		m_file.open(m_archivePath, Stream::MODE_READ);
+		m_file.seek(m_fileList.entries[m_curFile].IX);
+	}
 	return true;
 }
 
@@ -175,6 +180,14 @@ size_t LfdArchive::readFile(void *data, size_t size)
 	if (m_curFile < 0) { return false; }
 	if (size == 0) { size = m_fileList.entries[m_curFile].LENGTH; }
 	const size_t sizeToRead = std::min(size, (size_t)m_fileList.entries[m_curFile].LENGTH);
+	if (m_map.isOpen())
+	{
+		// Copy directly from the mapped archive, stopping at the end of the file.
+		const size_t sizeToCopy = std::min(sizeToRead, (size_t)m_fileList.entries[m_curFile].LENGTH - (size_t)m_fileOffset);
+		memcpy(data, m_map.getData() + m_fileList.entries[m_curFile].IX + m_fileOffset, sizeToCopy);
+		m_fileOffset += (s32)sizeToCopy;
+		return sizeToCopy;
+	}
 
 	size_t bytesRead = m_file.readBuffer(data, (u32)sizeToRead);
 	m_fileOffset += (s32)sizeToRead;
@@ -208,7 +221,10 @@ bool LfdArchive::seekFile(s32 offset, s32 origin)
 		return false;
 	}
 
-	m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	if (!m_map.isOpen())
+	{
+		m_file.seek(m_fileList.entries[m_curFile].IX + m_fileOffset);
+	}
 	return true;
 }
 
@@ -217,6 +233,29 @@ size_t LfdArchive::getLocInFile()
 	return m_fileOffset;
 }
 
+const u8* LfdArchive::getFileData(u32 index)
+{
+	if (!m_map.isOpen() || index >= getFileCount()) { return nullptr; }
+	return m_map.getData() + m_fileList.entries[index].IX;
+}
+
+// Map the archive so files can be read in place, the stream is used instead if this fails.
+void LfdArchive::mapArchive()
+{
+	if (!m_map.open(m_archivePath)) { return; }
+
+	const size_t mapSize = m_map.getSize();
+	for (u32 i = 0; i < m_fileList.MASTERN; i++)
+	{
+		if ((size_t)m_fileList.entries[i].IX + (size_t)m_fileList.entries[i].LENGTH > mapSize)
+		{
+			TFE_System::logWrite(LOG_WARNING, "Archive", "\"%s\" is truncated, reading through a file stream instead.", m_archivePath);
+			m_map.close();
+			return;
+		}
+	}
+}
+
 // Directory
 u32 LfdArchive::getFileCount()
 {
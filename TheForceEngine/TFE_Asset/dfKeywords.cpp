@@ -229,20 +229,49 @@ static const char* c_keywords[] =
 
 #define KEYWORD_COUNT TFE_ARRAYSIZE(c_keywords)
 
-KEYWORD getKeywordIndex(const char* keywordString)
+// TFE: Keyword lookups happen many times per line while parsing INF and object data, so the
+// keywords are stored in an open addressing hash table instead of being searched linearly.
+enum
+{
+	KEYWORD_TABLE_SIZE = 1024,	// Power of two, kept well above the keyword count so probes stay short.
+};
+static_assert(KEYWORD_COUNT * 2 <= KEYWORD_TABLE_SIZE, "The keyword table is too small.");
+
+// Case-insensitive FNV-1a hash.
+static constexpr u32 keywordHash(const char* str, u32 hash = 2166136261u)
 {
-	s32 result = -1;
-	for (s32 i = 0; i < KEYWORD_COUNT; i++)
+	return *str ? keywordHash(str + 1, (hash ^ u32((*str >= 'a' && *str <= 'z') ? *str - 'a' + 'A' : *str)) * 16777619u) : hash;
+}
+
+struct KeywordTable
+{
+	s16 slot[KEYWORD_TABLE_SIZE];
+
+	KeywordTable()
 	{
-		const char* keyword = c_keywords[i];
-		if (toupper(keywordString[0]) == keyword[0])
+		for (s32 i = 0; i < KEYWORD_TABLE_SIZE; i++) { slot[i] = -1; }
+		// Insert in order, so repeated keywords resolve to the first index like the original search.
+		for (s32 i = 0; i < KEYWORD_COUNT; i++)
 		{
-			if (!strcasecmp(keywordString, keyword))
+			u32 s = keywordHash(c_keywords[i]) & (KEYWORD_TABLE_SIZE - 1);
+			while (slot[s] >= 0 && strcasecmp(c_keywords[slot[s]], c_keywords[i]) != 0)
 			{
-				result = i;
-				break;
+				s = (s + 1) & (KEYWORD_TABLE_SIZE - 1);
 			}
+			if (slot[s] < 0) { slot[s] = s16(i); }
+		}
+	}
+};
+
+KEYWORD getKeywordIndex(const char* keywordString)
+{
+	static const KeywordTable s_table;
+	for (u32 s = keywordHash(keywordString) & (KEYWORD_TABLE_SIZE - 1); s_table.slot[s] >= 0; s = (s + 1) & (KEYWORD_TABLE_SIZE - 1))
+	{
+		if (!strcasecmp(keywordString, c_keywords[s_table.slot[s]]))
+		{
+			return KEYWORD(s_table.slot[s]);
 		}
 	}
-	return KEYWORD(result);
+	return KW_UNKNOWN;
 }
@@ -7,6 +7,8 @@
 #include <TFE_FileSystem/filestream.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_System/parser.h>
+#include <TFE_System/parallel.h>
+#include <TFE_System/profiler.h>
 
 #include <TFE_Jedi/Math/core_math.h>
 #include <TFE_Jedi/Level/rtexture.h>
@@ -167,7 +169,19 @@ namespace TFE_Model_Jedi
 	// Remove 3DO limits.
 	static std::vector<vec2> s_tmpVtx;
 
-	bool parseModel(JediModel* model, const char* name, AssetPool pool);
+	// TFE: Models read ahead of time by preload(), so their textures can be decoded on the worker threads.
+	// The models themselves are parsed in get() since they allocate from the level region and need the texture sizes.
+	struct StagedModel
+	{
+		FilePath filePath = {};
+		const u8* fileView = nullptr;	// File data in a memory mapped archive.
+		std::vector<u8> fileData;		// File data read up front when it cannot be mapped.
+		size_t fileSize = 0;
+		std::vector<std::string> textureNames;
+	};
+	static std::vector<StagedModel> s_stagedModels;
+
+	bool parseModel(JediModel* model, const char* name, AssetPool pool, const char* fileData, size_t len);
 
 	JediModel* get(const char* name, AssetPool pool)
 	{
@@ -183,15 +197,13 @@ namespace TFE_Model_Jedi
 		{
 			return nullptr;
 		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
+		// Parse in place when the file is in a memory mapped archive.
+		size_t len = 0;
+		const char* fileData = FileStream::readView(&filePath, s_buffer, &len);
+		if (!fileData)
 		{
 			return nullptr;
 		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
 			
 		s_memRegion = (pool == POOL_GAME) ? s_gameRegion : s_levelRegion;
 		JediModel* model = (JediModel*)model_alloc(sizeof(JediModel));
@@ -200,7 +212,7 @@ namespace TFE_Model_Jedi
 		////////////////////////////////////////////////////////////////
 		// Load and parse the model.
 		////////////////////////////////////////////////////////////////
-		if (!parseModel(model, name, pool))
+		if (!parseModel(model, name, pool, fileData, len))
 		{
 			return nullptr;
 		}
@@ -249,6 +261,95 @@ namespace TFE_Model_Jedi
 		return model;
 	}
 
+	// Returns the next line that is not empty or a comment, with leading whitespace removed.
+	// TFE_Parser shares a single line buffer, so it cannot be used on the worker threads.
+	static const char* model_readLine(const char* data, size_t len, size_t& pos, char* line, size_t lineSize)
+	{
+		while (pos < len)
+		{
+			size_t count = 0;
+			for (; pos < len && data[pos] != '\n' && data[pos] != '\r'; pos++)
+			{
+				if (count + 1 < lineSize) { line[count++] = data[pos]; }
+			}
+			for (; pos < len && (data[pos] == '\n' || data[pos] == '\r'); pos++);
+			line[count] = 0;
+
+			const char* start = line;
+			while (*start == ' ' || *start == '\t') { start++; }
+			if (*start && *start != '#') { return start; }
+		}
+		return nullptr;
+	}
+
+	// Read the texture list from the model header, this only touches the staged model so it can run on any thread.
+	static void model_preloadTask(s32 index, void* userData)
+	{
+		StagedModel* staged = &s_stagedModels[index];
+		const char* data = (const char*)(staged->fileView ? staged->fileView : staged->fileData.data());
+
+		char line[256];
+		size_t pos = 0;
+		s32 textureCount = 0;
+		// The texture list follows a fixed size header.
+		for (s32 i = 0; i < 8; i++)
+		{
+			const char* buffer = model_readLine(data, staged->fileSize, pos, line, sizeof(line));
+			if (!buffer) { return; }
+			if (sscanf(buffer, "TEXTURES %d", &textureCount) == 1) { break; }
+		}
+		for (s32 i = 0; i < textureCount; i++)
+		{
+			const char* buffer = model_readLine(data, staged->fileSize, pos, line, sizeof(line));
+			if (!buffer) { break; }
+
+			char textureName[256];
+			if (sscanf(buffer, "TEXTURE: %255s ", textureName) == 1 && strcasecmp(textureName, "<NoTexture>"))
+			{
+				staged->textureNames.push_back(textureName);
+			}
+		}
+	}
+
+	void preload(const char* const* names, s32 count, AssetPool pool)
+	{
+		TFE_ZONE("Model Preload");
+		s_stagedModels.clear();
+
+		// Gather the file data on the calling thread, archives that are not memory mapped can only be read serially.
+		s_stagedModels.reserve(count);
+		for (s32 i = 0; i < count; i++)
+		{
+			if (s_models[pool].find(names[i]) != s_models[pool].end()) { continue; }
+
+			StagedModel staged;
+			if (!TFE_Paths::getFilePath(names[i], &staged.filePath))
+			{
+				continue;
+			}
+			staged.fileView = FileStream::getMappedContents(&staged.filePath, &staged.fileSize);
+			if (!staged.fileView && !FileStream::readView(&staged.filePath, staged.fileData, &staged.fileSize))
+			{
+				continue;
+			}
+			s_stagedModels.push_back(std::move(staged));
+		}
+		TFE_Parallel::run((s32)s_stagedModels.size(), model_preloadTask, nullptr);
+
+		// Then decode all of the textures together, they are committed as the models are parsed.
+		std::vector<const char*> textureNames;
+		for (size_t m = 0; m < s_stagedModels.size(); m++)
+		{
+			const std::vector<std::string>& modelTextures = s_stagedModels[m].textureNames;
+			for (size_t t = 0; t < modelTextures.size(); t++)
+			{
+				textureNames.push_back(modelTextures[t].c_str());
+			}
+		}
+		TFE_Jedi::bitmap_preload(textureNames.data(), (s32)textureNames.size(), 1, pool);
+		s_stagedModels.clear();
+	}
+
 	bool getModelIndex(JediModel* model, s32* index, AssetPool* pool)
 	{
 		assert(index && pool);
@@ -361,10 +462,9 @@ namespace TFE_Model_Jedi
 		polygon->indices = (s32*)model_alloc(vertexCount * sizeof(s32));
 	}
 	
-	bool parseModel(JediModel* model, const char* name, AssetPool pool)
+	bool parseModel(JediModel* model, const char* name, AssetPool pool, const char* fileData, size_t len)
 	{
-		if (s_buffer.empty()) { return false; }
-		const size_t len = s_buffer.size();
+		if (!fileData || !len) { return false; }
 
 		model->isBridge = 0;
 		model->vertexCount = 0;
@@ -393,8 +493,8 @@ namespace TFE_Model_Jedi
 
 		TFE_Parser parser;
 		size_t bufferPos = 0;
-		parser.init(s_buffer.data(), len);
-		const char* fileBuffer = s_buffer.data();
+		parser.init(fileData, len);
+		const char* fileBuffer = fileData;
 		parser.addCommentString("#");
 
 		// For now just do what the original code does.
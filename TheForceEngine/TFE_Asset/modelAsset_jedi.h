@@ -71,6 +71,8 @@ struct JediModel
 namespace TFE_Model_Jedi
 {
 	JediModel* get(const char* name, AssetPool pool = POOL_LEVEL);
+	// TFE: Read the texture lists of the models and decode the textures on the worker threads, before the models are loaded.
+	void preload(const char* const* names, s32 count, AssetPool pool = POOL_LEVEL);
 	const std::vector<JediModel*>& getModelList(AssetPool pool);
 	void freeAll();
 	void freeLevelData();
@@ -10,6 +10,8 @@
 #include <TFE_Jedi/Level/robject.h>
 #include <TFE_Jedi/Serialization/serialization.h>
 #include <TFE_Settings/settings.h>
+#include <TFE_System/parallel.h>
+#include <TFE_System/profiler.h>
 // TODO: dependency on JediRenderer, this should be refactored...
 #include <TFE_Jedi/Renderer/rlimits.h>
 //
@@ -18,6 +20,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <unordered_map>
 
 using namespace TFE_Jedi;
 
@@ -46,6 +49,28 @@ namespace TFE_Sprite_Jedi
 	static NameList    s_spriteNames[POOL_COUNT];
 	static std::vector<u8> s_buffer;
 
+	// TFE: Sprites and frames read and decoded ahead of time by preload().
+	struct StagedSprite
+	{
+		FilePath filePath = {};
+		const u8* fileView = nullptr;	// File data in a memory mapped archive.
+		std::vector<u8> fileData;		// File data read up front when it cannot be mapped.
+		size_t fileSize = 0;
+		bool isWax = false;
+		AssetPool pool = POOL_LEVEL;
+
+		bool decoded = false;
+		void* asset = nullptr;			// Owned by the staging list until it is committed.
+		std::vector<u32> cellOffsets;
+	};
+	typedef std::unordered_map<std::string, s32> StagedTable;
+	static std::vector<StagedSprite> s_stagedSprites;
+	static StagedTable s_stagedWax;
+	static StagedTable s_stagedFrames;
+
+	static JediFrame* frame_decode(const u8* data, size_t len, AssetPool pool);
+	static JediWax* wax_decode(const u8* data, size_t len, AssetPool pool, std::vector<u32>& cellOffsets);
+
 	bool loadFrameHd(const char* name, const JediFrame* frame, AssetPool pool, HdWax* hdWax, const WaxCell* cell)
 	{
 		char hdPath[TFE_MAX_PATH];
@@ -98,32 +123,9 @@ namespace TFE_Sprite_Jedi
 		return true;
 	}
 
-	JediFrame* getFrame(const char* name, AssetPool pool)
+	// Copy the frame into newly allocated memory and fix it up for rendering, this does not touch any shared state.
+	static JediFrame* frame_decode(const u8* data, size_t len, AssetPool pool)
 	{
-		FrameMap::iterator iFrame = s_frames[pool].find(name);
-		if (iFrame != s_frames[pool].end())
-		{
-			return iFrame->second;
-		}
-
-		// It doesn't exist yet, try to load the frame.
-		FilePath filePath;
-		if (!TFE_Paths::getFilePath(name, &filePath))
-		{
-			return nullptr;
-		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
-		{
-			return nullptr;
-		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
-		const u8* data = s_buffer.data();
-
 		// Determine ahead of time how much we need to allocate.
 		const WaxFrame* base_frame = (WaxFrame*)data;
 		const WaxCell* base_cell = WAX_CellPtr(data, base_frame);
@@ -131,10 +133,10 @@ namespace TFE_Sprite_Jedi
 
 		// This is a "load in place" format in the original code.
 		// We are going to allocate new memory and copy the data.
-		u8* assetPtr = (u8*)malloc(s_buffer.size() + columnSize);
+		u8* assetPtr = (u8*)malloc(len + columnSize);
 		JediFrame* asset = (JediFrame*)assetPtr;
 		
-		memcpy(asset, data, s_buffer.size());
+		memcpy(asset, data, len);
 
 		WaxFrame* frame = asset;
 		WaxCell* cell = WAX_CellPtr(asset, frame);
@@ -158,7 +160,7 @@ namespace TFE_Sprite_Jedi
 		}
 		else
 		{
-			u32* columns = (u32*)((u8*)asset + s_buffer.size());
+			u32* columns = (u32*)((u8*)asset + len);
 			// Local pointer.
 			cell->columnOffset = u32((u8*)columns - (u8*)asset);
 			// Calculate column offsets.
@@ -168,6 +170,13 @@ namespace TFE_Sprite_Jedi
 			}
 		}
 		
+		return asset;
+	}
+
+	// Register a decoded frame and load its HD version, main thread only.
+	static JediFrame* frame_commit(const char* name, JediFrame* asset, AssetPool pool)
+	{
+		WaxCell* cell = WAX_CellPtr(asset, asset);
 		s_frames[pool][name] = asset;
 		s_frameList[pool].push_back(asset);
 		s_frameNames[pool].push_back(name);
@@ -194,6 +203,44 @@ namespace TFE_Sprite_Jedi
 		return asset;
 	}
 
+	JediFrame* getFrame(const char* name, AssetPool pool)
+	{
+		FrameMap::iterator iFrame = s_frames[pool].find(name);
+		if (iFrame != s_frames[pool].end())
+		{
+			return iFrame->second;
+		}
+
+		// TFE: Use the result of preload() if available, frames are still committed in load order.
+		StagedTable::iterator iStaged = s_stagedFrames.find(name);
+		if (iStaged != s_stagedFrames.end())
+		{
+			StagedSprite* staged = &s_stagedSprites[iStaged->second];
+			if (staged->decoded && staged->pool == pool)
+			{
+				s_stagedFrames.erase(iStaged);
+				JediFrame* asset = (JediFrame*)staged->asset;
+				staged->asset = nullptr;
+				return frame_commit(name, asset, pool);
+			}
+		}
+
+		// It doesn't exist yet, try to load the frame.
+		FilePath filePath;
+		if (!TFE_Paths::getFilePath(name, &filePath))
+		{
+			return nullptr;
+		}
+		// Read in place when the file is in a memory mapped archive, the data is copied below anyway.
+		size_t len = 0;
+		const u8* data = FileStream::readView(&filePath, s_buffer, &len);
+		if (!data)
+		{
+			return nullptr;
+		}
+		return frame_commit(name, frame_decode(data, len, pool), pool);
+	}
+
 	JediFrame* loadFrameFromMemory(const u8* data, size_t size, bool transformOffsets)
 	{
 		// Determine ahead of time how much we need to allocate.
@@ -245,19 +292,24 @@ namespace TFE_Sprite_Jedi
 
 	static std::vector<u32> s_cellOffsets;
 
-	bool isUniqueCell(u32 offset)
+	static bool isUniqueCell(std::vector<u32>& cellOffsets, u32 offset)
 	{
-		const size_t count = s_cellOffsets.size();
-		const u32* offsetList = s_cellOffsets.data();
+		const size_t count = cellOffsets.size();
+		const u32* offsetList = cellOffsets.data();
 		for (u32 i = 0; i < count; i++)
 		{
 			if (offsetList[i] == offset) { return false; }
 		}
-		s_cellOffsets.push_back(offset);
+		cellOffsets.push_back(offset);
 
 		return true;
 	}
 
+	bool isUniqueCell(u32 offset)
+	{
+		return isUniqueCell(s_cellOffsets, offset);
+	}
+
 	void sprite_serializeSpritesAndFrames(Stream* stream)
 	{
 		const bool modeWrite = serialization_getMode() == SMODE_WRITE;
@@ -320,7 +372,7 @@ namespace TFE_Sprite_Jedi
 		}
 	}
 		
-	bool loadWaxHd(const char* name, const JediWax* wax, AssetPool pool, HdWax* hdWax)
+	bool loadWaxHd(const char* name, const JediWax* wax, AssetPool pool, HdWax* hdWax, const std::vector<u32>& cellOffsets)
 	{
 		char hdPath[TFE_MAX_PATH];
 		FileUtil::replaceExtension(name, "wxx", hdPath);
@@ -348,7 +400,7 @@ namespace TFE_Sprite_Jedi
 		assert(entryCount > 0);
 
 		// Verify that the number of cells is correct.
-		if (entryCount != (s32)s_cellOffsets.size())
+		if (entryCount != (s32)cellOffsets.size())
 		{
 			return false;
 		}
@@ -363,7 +415,7 @@ namespace TFE_Sprite_Jedi
 			hdWax->cells[i].id = i;
 
 			// Verify that the sizes match expectations.
-			WaxCell* cell = (WaxCell*)((u8*)wax + s_cellOffsets[i]);
+			WaxCell* cell = (WaxCell*)((u8*)wax + cellOffsets[i]);
 			s32 targetPixelCount = 4 * cell->sizeX * cell->sizeY;
 			if (targetPixelCount != hdWax->cells[i].pixelCount)
 			{
@@ -383,66 +435,39 @@ namespace TFE_Sprite_Jedi
 		return true;
 	}
 
-	JediWax* getWax(const char* name, AssetPool pool)
+	// Copy the wax into newly allocated memory and fix it up for rendering, this does not touch any shared state.
+	// The offsets of the unique cells are returned in 'cellOffsets', in the order the cells are numbered.
+	static JediWax* wax_decode(const u8* data, size_t len, AssetPool pool, std::vector<u32>& cellOffsets)
 	{
-		SpriteMap::iterator iSprite = s_sprites[pool].find(name);
-		if (iSprite != s_sprites[pool].end())
-		{
-			return iSprite->second;
-		}
-
-		// It doesn't exist yet, try to load the frame.
-		FilePath filePath;
-		if (!TFE_Paths::getFilePath(name, &filePath))
-		{
-			return nullptr;
-		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
-		{
-			return nullptr;
-		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
-		u8* data = s_buffer.data();
-		Wax* srcWax = (Wax*)data;
+		const Wax* srcWax = (const Wax*)data;
 		
 		// every animation is filled out until the end, so no animations = no wax.
 		if (!srcWax->animOffsets[0])
 		{
 			return nullptr;
 		}
-		s_cellOffsets.clear();
+		cellOffsets.clear();
 
 		// First determine the size to allocate (note that this will overallocate a bit because cells are shared).
-		u32 cellId = 0;
-		u32 sizeToAlloc = sizeof(JediWax) + (u32)s_buffer.size();
+		u32 sizeToAlloc = sizeof(JediWax) + (u32)len;
 		const s32* animOffset = srcWax->animOffsets;
 		for (s32 animIdx = 0; animIdx < 32 && animOffset[animIdx]; animIdx++)
 		{
-			const WaxAnim* anim = (WaxAnim*)(data + animOffset[animIdx]);
+			const WaxAnim* anim = (const WaxAnim*)(data + animOffset[animIdx]);
 			const s32* viewOffsets = anim->viewOffsets;
 			for (s32 v = 0; v < 32; v++)
 			{
-				const WaxView* view = (WaxView*)(data + viewOffsets[v]);
+				const WaxView* view = (const WaxView*)(data + viewOffsets[v]);
 				const s32* frameOffset = view->frameOffsets;
 				for (s32 f = 0; f < 32 && frameOffset[f]; f++)
 				{
-					WaxFrame* frame = (WaxFrame*)(data + frameOffset[f]);
-					WaxCell* cell = frame->cellOffset ? (WaxCell*)(data + frame->cellOffset) : nullptr;
-					bool unique = cell && isUniqueCell(frame->cellOffset);
+					const WaxFrame* frame = (const WaxFrame*)(data + frameOffset[f]);
+					const WaxCell* cell = frame->cellOffset ? (const WaxCell*)(data + frame->cellOffset) : nullptr;
+					bool unique = cell && isUniqueCell(cellOffsets, frame->cellOffset);
 					if (unique && cell->compressed == 0)
 					{
 						sizeToAlloc += cell->sizeX * sizeof(u32);
 					}
-					if (unique)
-					{
-						cell->id = cellId;
-						cellId++;
-					}
 				}
 			}
 		}
@@ -450,7 +475,15 @@ namespace TFE_Sprite_Jedi
 		// Allocate and copy the data (this is a "copy in place" format... mostly.
 		JediWax* asset = (JediWax*)malloc(sizeToAlloc);
 		Wax* dstWax = asset;
-		memcpy(dstWax, srcWax, s_buffer.size());
+		memcpy(dstWax, srcWax, len);
+
+		// Unique cells are numbered in the order they were found.
+		const u32 uniqueCellCount = (u32)cellOffsets.size();
+		for (u32 c = 0; c < uniqueCellCount; c++)
+		{
+			WaxCell* cell = (WaxCell*)((u8*)asset + cellOffsets[c]);
+			cell->id = c;
+		}
 
 		// Loop through animation list until we reach 32 (maximum count) or a null animation.
 		// This means that animations are contiguous.
@@ -512,7 +545,7 @@ namespace TFE_Sprite_Jedi
 							}
 							else
 							{
-								u32* columns = (u32*)((u8*)asset + s_buffer.size() + cellOffsetPtr);
+								u32* columns = (u32*)((u8*)asset + len + cellOffsetPtr);
 								cellOffsetPtr += dstCell->sizeX * sizeof(u32);
 
 								// Local pointer.
@@ -540,6 +573,14 @@ namespace TFE_Sprite_Jedi
 		asset->animCount = animIdx;
 		asset->pool = u32(pool);
 
+		return asset;
+	}
+
+	// Register a decoded wax and load its HD version, main thread only.
+	static JediWax* wax_commit(const char* name, JediWax* asset, AssetPool pool, const std::vector<u32>& cellOffsets)
+	{
+		if (!asset) { return nullptr; }
+
 		s_sprites[pool][name] = asset;
 		s_spriteList[pool].push_back(asset);
 		s_spriteNames[pool].push_back(name);
@@ -554,7 +595,7 @@ namespace TFE_Sprite_Jedi
 		if (canUseHdAsset)
 		{
 			HdWax* hdWax = (HdWax*)malloc(sizeof(HdWax));
-			if (loadWaxHd(name, asset, pool, hdWax))
+			if (loadWaxHd(name, asset, pool, hdWax, cellOffsets))
 			{
 				s_hdSpriteList[pool].push_back(hdWax);
 				s_hdSprites[pool][asset] = hdWax;
@@ -568,6 +609,117 @@ namespace TFE_Sprite_Jedi
 		return asset;
 	}
 		
+	JediWax* getWax(const char* name, AssetPool pool)
+	{
+		SpriteMap::iterator iSprite = s_sprites[pool].find(name);
+		if (iSprite != s_sprites[pool].end())
+		{
+			return iSprite->second;
+		}
+
+		// TFE: Use the result of preload() if available, sprites are still committed in load order.
+		StagedTable::iterator iStaged = s_stagedWax.find(name);
+		if (iStaged != s_stagedWax.end())
+		{
+			StagedSprite* staged = &s_stagedSprites[iStaged->second];
+			if (staged->decoded && staged->pool == pool)
+			{
+				s_stagedWax.erase(iStaged);
+				JediWax* asset = (JediWax*)staged->asset;
+				staged->asset = nullptr;
+				return wax_commit(name, asset, pool, staged->cellOffsets);
+			}
+		}
+
+		// It doesn't exist yet, try to load the frame.
+		FilePath filePath;
+		if (!TFE_Paths::getFilePath(name, &filePath))
+		{
+			return nullptr;
+		}
+		// Read in place when the file is in a memory mapped archive, so the source data must not be modified.
+		size_t len = 0;
+		const u8* data = FileStream::readView(&filePath, s_buffer, &len);
+		if (!data)
+		{
+			return nullptr;
+		}
+		JediWax* asset = wax_decode(data, len, pool, s_cellOffsets);
+		return wax_commit(name, asset, pool, s_cellOffsets);
+	}
+
+	static void sprite_preloadTask(s32 index, void* userData)
+	{
+		StagedSprite* staged = &s_stagedSprites[index];
+		const u8* data = staged->fileView ? staged->fileView : staged->fileData.data();
+		if (staged->isWax)
+		{
+			staged->asset = wax_decode(data, staged->fileSize, staged->pool, staged->cellOffsets);
+		}
+		else
+		{
+			staged->asset = frame_decode(data, staged->fileSize, staged->pool);
+		}
+		staged->decoded = true;
+		std::vector<u8>().swap(staged->fileData);
+	}
+
+	static void sprite_stage(const char* name, bool isWax, AssetPool pool, StagedTable& table)
+	{
+		if (table.find(name) != table.end()) { return; }
+
+		StagedSprite staged;
+		if (!TFE_Paths::getFilePath(name, &staged.filePath))
+		{
+			return;
+		}
+		staged.fileView = FileStream::getMappedContents(&staged.filePath, &staged.fileSize);
+		if (!staged.fileView && !FileStream::readView(&staged.filePath, staged.fileData, &staged.fileSize))
+		{
+			return;
+		}
+		staged.isWax = isWax;
+		staged.pool = pool;
+
+		table[name] = (s32)s_stagedSprites.size();
+		s_stagedSprites.push_back(std::move(staged));
+	}
+
+	void preload(const char* const* waxNames, s32 waxCount, const char* const* frameNames, s32 frameCount, AssetPool pool)
+	{
+		TFE_ZONE("Sprite Preload");
+		clearPreloaded();
+
+		// Gather the file data on the calling thread, archives that are not memory mapped can only be read serially.
+		s_stagedSprites.reserve(waxCount + frameCount);
+		for (s32 i = 0; i < waxCount; i++)
+		{
+			if (s_sprites[pool].find(waxNames[i]) != s_sprites[pool].end()) { continue; }
+			sprite_stage(waxNames[i], true, pool, s_stagedWax);
+		}
+		for (s32 i = 0; i < frameCount; i++)
+		{
+			if (s_frames[pool].find(frameNames[i]) != s_frames[pool].end()) { continue; }
+			sprite_stage(frameNames[i], false, pool, s_stagedFrames);
+		}
+
+		// Decode on the worker threads, decoding only touches the staged sprite.
+		TFE_Parallel::run((s32)s_stagedSprites.size(), sprite_preloadTask, nullptr);
+	}
+
+	void clearPreloaded()
+	{
+		// Free anything that was decoded but never requested.
+		const size_t count = s_stagedSprites.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			free(s_stagedSprites[i].asset);
+		}
+		s_stagedSprites.clear();
+		s_stagedWax.clear();
+		s_stagedFrames.clear();
+	}
+
 	const HdWax* getHdWaxData(const void* srcData)
 	{
 		const s32* srcData32 = (s32*)srcData;
@@ -105,6 +105,9 @@ namespace TFE_Sprite_Jedi
 {
 	JediFrame* getFrame(const char* name, AssetPool pool = POOL_LEVEL);
 	JediWax*   getWax(const char* name, AssetPool pool = POOL_LEVEL);
+	// TFE: Decode sprites and frames on the worker threads, getWax() and getFrame() then register them in the order requested.
+	void preload(const char* const* waxNames, s32 waxCount, const char* const* frameNames, s32 frameCount, AssetPool pool = POOL_LEVEL);
+	void clearPreloaded();
 	const HdWax* getHdWaxData(const void* srcWax);
 	void freeAll();
 	void freeLevelData();
@@ -19,6 +19,9 @@ namespace TFE_VocAsset
 	static VocMap s_vocAssets;
 	static VocList s_vocAssetList;
 	static std::vector<u8> s_buffer;
+	// View of the current sound file, either in place in a memory mapped archive or in s_buffer.
+	static const u8* s_fileData = nullptr;
+	static size_t s_fileSize = 0;
 
 	bool parseVoc(SoundBuffer* voc);
 
@@ -30,17 +33,8 @@ namespace TFE_VocAsset
 			return false;
 		}
 
-		FileStream vocAsset;
-		if (!vocAsset.open(&filePath, Stream::MODE_READ))
-		{
-			return false;
-		}
-		size_t size = vocAsset.getSize();
-		s_buffer.resize(size + 1);
-		vocAsset.readBuffer(s_buffer.data(), (u32)size);
-		vocAsset.close();
-
-		return true;
+		s_fileData = FileStream::readView(&filePath, s_buffer, &s_fileSize);
+		return s_fileData != nullptr;
 	}
 	
 	SoundBuffer* get(const char* name)
@@ -297,10 +291,10 @@ namespace TFE_VocAsset
 
 	bool parseVoc(SoundBuffer* voc)
 	{
-		if (s_buffer.empty() || !voc) { return false; }
+		if (!s_fileData || !s_fileSize || !voc) { return false; }
 
-		const size_t len = s_buffer.size();
-		const u8* buffer = s_buffer.data();
+		const size_t len = s_fileSize;
+		const u8* buffer = s_fileData;
 		const u8* end = buffer + len;
 		memset(voc, 0, sizeof(SoundBuffer));
 		voc->type = SOUND_DATA_8BIT;
@@ -310,7 +304,7 @@ namespace TFE_VocAsset
 		buffer += sizeof(VocHeader);
 
 		// Parse blocks.
-		buffer = s_buffer.data() + header->datablockOffset;
+		buffer = s_fileData + header->datablockOffset;
 		while (buffer < end)
 		{
 			const BlockType type = BlockType(*buffer); buffer++;
@@ -68,9 +68,6 @@ namespace TFE_Audio
 	static const char* c_Opl3_Name = "OPL3";
 	static const char* c_Output_Name = "FM4 Driver";
 
-	// This is stored internally, there will only be one FM chip (for now).
-	static opl3_chip s_fmChip = { 0 };
-
 	Fm4Opl3Device::~Fm4Opl3Device()
 	{
 		exit();
@@ -120,10 +117,10 @@ namespace TFE_Audio
 	void Fm4Opl3Device::beginStream(s32 sampleRate)
 	{
 		assert(!m_streamActive);
-		s_fmChip = { 0 };
+		m_fmChip = new opl3_chip();
 		memset(m_registers, 0, FM4_RegisterCount * FM4_OutCount);
 
-		OPL3_Reset(&s_fmChip, sampleRate);
+		OPL3_Reset(m_fmChip, sampleRate);
 		fm4_reset();
 
 		// Initialize channels
@@ -158,7 +155,8 @@ namespace TFE_Audio
 
 	void Fm4Opl3Device::exit()
 	{
-		s_fmChip = { 0 };
+		delete m_fmChip;
+		m_fmChip = nullptr;
 		m_streamActive = false;
 	}
 		
@@ -170,18 +168,22 @@ namespace TFE_Audio
 	bool Fm4Opl3Device::render(f32* buffer, u32 sampleCount)
 	{
 		if (!m_streamActive) { return false; }
+		renderEvents(buffer, sampleCount);
+		return true;
+	}
 
+	void Fm4Opl3Device::renderSamples(f32* buffer, u32 sampleCount)
+	{
 		for (u32 i = 0; i < sampleCount; i++)
 		{
 			s16 buf[2];
-			OPL3_GenerateResampled(&s_fmChip, buf);
+			OPL3_GenerateResampled(m_fmChip, buf);
 			
 			s16 left  = clamp(s32(buf[0]), INT16_MIN, INT16_MAX);
 			s16 right = clamp(s32(buf[1]), INT16_MIN, INT16_MAX);
 			*buffer++ = f32(left)  * m_volumeScaled;
 			*buffer++ = f32(right) * m_volumeScaled;
 		}
-		return true;
 	}
 
 	bool Fm4Opl3Device::canRender()
@@ -453,7 +455,7 @@ namespace TFE_Audio
 		if (m_registers[regIndex] == value) { return; }
 
 		m_registers[regIndex] = value;
-		OPL3_WriteRegBuffered(&s_fmChip, regIndex, value);
+		OPL3_WriteRegBuffered(m_fmChip, regIndex, value);
 	}
 
 	void Fm4Opl3Device::fm4_setVoicePitch(s32 voice, s32 key, s32 pitchOffset)
@@ -14,6 +14,7 @@
 #include <TFE_System/types.h>
 #include <TFE_Audio/midiDevice.h>
 #include <TFE_Audio/midi.h>
+struct _opl3_chip;
 
 namespace TFE_Audio
 {
@@ -22,7 +23,7 @@ namespace TFE_Audio
 	class Fm4Opl3Device : public MidiDevice
 	{
 	public:
-		Fm4Opl3Device() : m_streamActive(false), m_volume(1.0f), m_volumeScaled(1.0f), m_fmVoicePitchRight(nullptr), m_fmVoicePitchLeft(nullptr), m_fmVoiceLevel(nullptr) {}
+		Fm4Opl3Device() : m_fmChip(nullptr), m_streamActive(false), m_volume(1.0f), m_volumeScaled(1.0f), m_fmVoicePitchRight(nullptr), m_fmVoicePitchLeft(nullptr), m_fmVoiceLevel(nullptr) {}
 		~Fm4Opl3Device() override;
 
 		MidiDeviceType getType() override { return MIDI_TYPE_OPL3; }
@@ -44,6 +45,9 @@ namespace TFE_Audio
 		bool selectOutput(s32 index) override;
 		s32  getActiveOutput(void) override;
 
+	protected:
+		void renderSamples(f32* buffer, u32 sampleCount) override;
+
 	private:
 		enum
 		{
@@ -126,6 +130,8 @@ namespace TFE_Audio
 		void fm4_setVoiceVolumeSide(FmOutputChannel outChannel, s32 voice, s32 offset, s32 volume);
 		s32  fm4_getVelocityToVolumeMapping(s32 velocity);
 	
+		// Each device owns its chip, so a second device can render on another thread.
+		_opl3_chip* m_fmChip;
 		bool m_streamActive;
 		f32  m_volume;
 		f32  m_volumeScaled;
@@ -135,10 +135,15 @@ namespace TFE_Audio
 	bool SoundFontDevice::render(f32* buffer, u32 sampleCount)
 	{
 		if (!m_soundFont) { return false; }
-		tsf_render_float(m_soundFont, buffer, sampleCount);
+		renderEvents(buffer, sampleCount);
 		return true;
 	}
 
+	void SoundFontDevice::renderSamples(f32* buffer, u32 sampleCount)
+	{
+		tsf_render_float(m_soundFont, buffer, sampleCount);
+	}
+
 	bool SoundFontDevice::canRender()
 	{
 		return m_soundFont != nullptr;
@@ -32,6 +32,9 @@ namespace TFE_Audio
 		bool selectOutput(s32 index) override;
 		s32  getActiveOutput(void) override;
 
+	protected:
+		void renderSamples(f32* buffer, u32 sampleCount) override;
+
 	private:
 		bool beginStream(const char* soundFont, s32 sampleRate);
 
@@ -0,0 +1,452 @@
+#include <TFE_System/simd.h>
+#include <TFE_System/math.h>
+#include "audioMixer.h"
+#include "audioFilters.h"
+
+namespace TFE_Audio
+{
+	// Sample conversion: value * scale + offset, mapping unsigned 8-bit and 16-bit data to [-1, 1].
+	static const f32 c_scale8    = 2.0f / 255.0f;
+	static const f32 c_scale16   = 2.0f / 65535.0f;
+	static const f32 c_offset8   = -1.0f;
+	static const f32 c_offset16  = -1.0f;
+	static const f32 c_scaleF    = 1.0f;
+	static const f32 c_offsetF   = 0.0f;
+	// tanhf_series() is clamped outside of this range.
+	static const f32 c_tanhRange = 4.8f;
+
+	/////////////////////////////////////////////////
+	// Scalar
+	/////////////////////////////////////////////////
+	static void mix_convert8(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const u8* src = data + start;
+		for (u32 i = 0; i < count; i++)
+		{
+			out[i] = f32(src[i]) * c_scale8 + c_offset8;
+		}
+	}
+
+	static void mix_convert16(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const u16* src = (const u16*)data + start;
+		for (u32 i = 0; i < count; i++)
+		{
+			out[i] = f32(src[i]) * c_scale16 + c_offset16;
+		}
+	}
+
+	static void mix_convertFloat(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const f32* src = (const f32*)data + start;
+		for (u32 i = 0; i < count; i++)
+		{
+			out[i] = src[i] * c_scaleF + c_offsetF;
+		}
+	}
+
+	static void mix_addMonoToStereo(f32* out, const f32* samples, f32 volume, u32 count)
+	{
+		for (u32 i = 0; i < count; i++, out += 2)
+		{
+			const f32 sample = samples[i] * volume;
+			out[0] += sample;
+			out[1] += sample;
+		}
+	}
+
+	static void mix_limitTanh(f32* buffer, u32 count)
+	{
+		for (u32 i = 0; i < count; i++)
+		{
+			buffer[i] = TFE_Math::tanhf_series(buffer[i]);
+		}
+	}
+
+	static const MixerKernels c_scalarKernels =
+	{
+		"Scalar",
+		{ mix_convert8, mix_convert16, mix_convertFloat },
+		mix_addMonoToStereo,
+		mix_limitTanh,
+		upsample4x_linear,
+	};
+	MixerKernels s_mixerKernels = c_scalarKernels;
+
+	/////////////////////////////////////////////////
+	// SSE2
+	/////////////////////////////////////////////////
+#ifdef TFE_SIMD_SSE2
+	static inline __m128 mix_scaleOffset_SSE2(__m128i value, __m128 scale, __m128 offset)
+	{
+		return _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(value), scale), offset);
+	}
+
+	static void mix_convert8_SSE2(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scale = _mm_set1_ps(c_scale8);
+		const __m128 offset = _mm_set1_ps(c_offset8);
+		const u8* src = data + start;
+
+		u32 i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i value = _mm_loadu_si128((const __m128i*)(src + i));
+			const __m128i lo = _mm_unpacklo_epi8(value, zero);
+			const __m128i hi = _mm_unpackhi_epi8(value, zero);
+			_mm_storeu_ps(out + i,      mix_scaleOffset_SSE2(_mm_unpacklo_epi16(lo, zero), scale, offset));
+			_mm_storeu_ps(out + i + 4,  mix_scaleOffset_SSE2(_mm_unpackhi_epi16(lo, zero), scale, offset));
+			_mm_storeu_ps(out + i + 8,  mix_scaleOffset_SSE2(_mm_unpacklo_epi16(hi, zero), scale, offset));
+			_mm_storeu_ps(out + i + 12, mix_scaleOffset_SSE2(_mm_unpackhi_epi16(hi, zero), scale, offset));
+		}
+		mix_convert8(out + i, data, start + i, count - i);
+	}
+
+	static void mix_convert16_SSE2(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scale = _mm_set1_ps(c_scale16);
+		const __m128 offset = _mm_set1_ps(c_offset16);
+		const u16* src = (const u16*)data + start;
+
+		u32 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i value = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_ps(out + i,     mix_scaleOffset_SSE2(_mm_unpacklo_epi16(value, zero), scale, offset));
+			_mm_storeu_ps(out + i + 4, mix_scaleOffset_SSE2(_mm_unpackhi_epi16(value, zero), scale, offset));
+		}
+		mix_convert16(out + i, data, start + i, count - i);
+	}
+
+	static void mix_convertFloat_SSE2(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const __m128 scale = _mm_set1_ps(c_scaleF);
+		const __m128 offset = _mm_set1_ps(c_offsetF);
+		const f32* src = (const f32*)data + start;
+
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), offset));
+		}
+		mix_convertFloat(out + i, data, start + i, count - i);
+	}
+
+	static void mix_addMonoToStereo_SSE2(f32* out, const f32* samples, f32 volume, u32 count)
+	{
+		const __m128 vol = _mm_set1_ps(volume);
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4, out += 8)
+		{
+			// s0 s1 s2 s3 -> s0 s0 s1 s1 | s2 s2 s3 s3
+			const __m128 sample = _mm_mul_ps(_mm_loadu_ps(samples + i), vol);
+			_mm_storeu_ps(out,     _mm_add_ps(_mm_loadu_ps(out),     _mm_unpacklo_ps(sample, sample)));
+			_mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_unpackhi_ps(sample, sample)));
+		}
+		mix_addMonoToStereo(out, samples + i, volume, count - i);
+	}
+
+	// Same operations as TFE_Math::tanhf_series().
+	static inline __m128 mix_tanh_SSE2(__m128 x)
+	{
+		const __m128 x2 = _mm_mul_ps(x, x);
+		__m128 a = _mm_add_ps(_mm_set1_ps(378.0f), x2);
+		a = _mm_add_ps(_mm_set1_ps(17325.0f), _mm_mul_ps(x2, a));
+		a = _mm_add_ps(_mm_set1_ps(135135.0f), _mm_mul_ps(x2, a));
+		a = _mm_mul_ps(x, a);
+
+		__m128 b = _mm_add_ps(_mm_set1_ps(3150.0f), _mm_mul_ps(x2, _mm_set1_ps(28.0f)));
+		b = _mm_add_ps(_mm_set1_ps(62370.0f), _mm_mul_ps(x2, b));
+		b = _mm_add_ps(_mm_set1_ps(135135.0f), _mm_mul_ps(x2, b));
+		__m128 result = _mm_div_ps(a, b);
+
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 negOne = _mm_set1_ps(-1.0f);
+		const __m128 above = _mm_cmpgt_ps(x, _mm_set1_ps(c_tanhRange));
+		const __m128 below = _mm_cmple_ps(x, _mm_set1_ps(-c_tanhRange));
+		result = _mm_or_ps(_mm_and_ps(above, one), _mm_andnot_ps(above, result));
+		result = _mm_or_ps(_mm_and_ps(below, negOne), _mm_andnot_ps(below, result));
+		return result;
+	}
+
+	static void mix_limitTanh_SSE2(f32* buffer, u32 count)
+	{
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			_mm_storeu_ps(buffer + i, mix_tanh_SSE2(_mm_loadu_ps(buffer + i)));
+		}
+		mix_limitTanh(buffer + i, count - i);
+	}
+
+	static void upsample4x_linear_SSE2(f32* output, const f32* input, s32 inputSampleCount)
+	{
+		const __m128 u0 = _mm_set1_ps(0.25f);
+		const __m128 u1 = _mm_setr_ps(0.5f, 0.5f, 0.75f, 0.75f);
+		for (s32 i = 0; i < inputSampleCount; i += 2, input += 2, output += 8)
+		{
+			// cur = L0 R0 L0 R0, next = L1 R1 L1 R1
+			const __m128 in0 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)input);
+			const __m128 in1 = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(input + 2));
+			const __m128 cur = _mm_movelh_ps(in0, in0);
+			const __m128 delta = _mm_sub_ps(_mm_movelh_ps(in1, in1), cur);
+
+			// The first output is a copy of the input, as in the scalar version.
+			const __m128 quarter = _mm_add_ps(cur, _mm_mul_ps(delta, u0));
+			_mm_storeu_ps(output,     _mm_movelh_ps(cur, quarter));
+			_mm_storeu_ps(output + 4, _mm_add_ps(cur, _mm_mul_ps(delta, u1)));
+		}
+	}
+
+	static const MixerKernels c_sse2Kernels =
+	{
+		"SSE2",
+		{ mix_convert8_SSE2, mix_convert16_SSE2, mix_convertFloat_SSE2 },
+		mix_addMonoToStereo_SSE2,
+		mix_limitTanh_SSE2,
+		upsample4x_linear_SSE2,
+	};
+#endif
+
+	/////////////////////////////////////////////////
+	// AVX2
+	// Sample conversion and the limiter, mixing into the
+	// interleaved output uses the SSE2 kernel since the
+	// interleave would cross 128-bit lanes.
+	/////////////////////////////////////////////////
+#ifdef TFE_SIMD_AVX2
+	TFE_TARGET_AVX2 static void mix_convert8_AVX2(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const __m256 scale = _mm256_set1_ps(c_scale8);
+		const __m256 offset = _mm256_set1_ps(c_offset8);
+		const u8* src = data + start;
+
+		u32 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256i value = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i)));
+			_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(value), scale), offset));
+		}
+		mix_convert8(out + i, data, start + i, count - i);
+	}
+
+	TFE_TARGET_AVX2 static void mix_convert16_AVX2(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const __m256 scale = _mm256_set1_ps(c_scale16);
+		const __m256 offset = _mm256_set1_ps(c_offset16);
+		const u16* src = (const u16*)data + start;
+
+		u32 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256i value = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src + i)));
+			_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(_mm256_cvtepi32_ps(value), scale), offset));
+		}
+		mix_convert16(out + i, data, start + i, count - i);
+	}
+
+	TFE_TARGET_AVX2 static void mix_limitTanh_AVX2(f32* buffer, u32 count)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 negOne = _mm256_set1_ps(-1.0f);
+		const __m256 rangeMax = _mm256_set1_ps(c_tanhRange);
+		const __m256 rangeMin = _mm256_set1_ps(-c_tanhRange);
+
+		u32 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256 x = _mm256_loadu_ps(buffer + i);
+			const __m256 x2 = _mm256_mul_ps(x, x);
+			__m256 a = _mm256_add_ps(_mm256_set1_ps(378.0f), x2);
+			a = _mm256_add_ps(_mm256_set1_ps(17325.0f), _mm256_mul_ps(x2, a));
+			a = _mm256_add_ps(_mm256_set1_ps(135135.0f), _mm256_mul_ps(x2, a));
+			a = _mm256_mul_ps(x, a);
+
+			__m256 b = _mm256_add_ps(_mm256_set1_ps(3150.0f), _mm256_mul_ps(x2, _mm256_set1_ps(28.0f)));
+			b = _mm256_add_ps(_mm256_set1_ps(62370.0f), _mm256_mul_ps(x2, b));
+			b = _mm256_add_ps(_mm256_set1_ps(135135.0f), _mm256_mul_ps(x2, b));
+			__m256 result = _mm256_div_ps(a, b);
+
+			result = _mm256_blendv_ps(result, one, _mm256_cmp_ps(x, rangeMax, _CMP_GT_OQ));
+			result = _mm256_blendv_ps(result, negOne, _mm256_cmp_ps(x, rangeMin, _CMP_LE_OQ));
+			_mm256_storeu_ps(buffer + i, result);
+		}
+		mix_limitTanh(buffer + i, count - i);
+	}
+
+	static const MixerKernels c_avx2Kernels =
+	{
+		"AVX2",
+		{ mix_convert8_AVX2, mix_convert16_AVX2, mix_convertFloat_SSE2 },
+		mix_addMonoToStereo_SSE2,
+		mix_limitTanh_AVX2,
+		upsample4x_linear_SSE2,
+	};
+#endif
+
+	/////////////////////////////////////////////////
+	// NEON
+	/////////////////////////////////////////////////
+#ifdef TFE_SIMD_NEON
+	static inline float32x4_t mix_scaleOffset_NEON(uint32x4_t value, float32x4_t scale, float32x4_t offset)
+	{
+		return vaddq_f32(vmulq_f32(vcvtq_f32_u32(value), scale), offset);
+	}
+
+	static void mix_convert8_NEON(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const float32x4_t scale = vdupq_n_f32(c_scale8);
+		const float32x4_t offset = vdupq_n_f32(c_offset8);
+		const u8* src = data + start;
+
+		u32 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const uint16x8_t value = vmovl_u8(vld1_u8(src + i));
+			vst1q_f32(out + i,     mix_scaleOffset_NEON(vmovl_u16(vget_low_u16(value)), scale, offset));
+			vst1q_f32(out + i + 4, mix_scaleOffset_NEON(vmovl_u16(vget_high_u16(value)), scale, offset));
+		}
+		mix_convert8(out + i, data, start + i, count - i);
+	}
+
+	static void mix_convert16_NEON(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const float32x4_t scale = vdupq_n_f32(c_scale16);
+		const float32x4_t offset = vdupq_n_f32(c_offset16);
+		const u16* src = (const u16*)data + start;
+
+		u32 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const uint16x8_t value = vld1q_u16(src + i);
+			vst1q_f32(out + i,     mix_scaleOffset_NEON(vmovl_u16(vget_low_u16(value)), scale, offset));
+			vst1q_f32(out + i + 4, mix_scaleOffset_NEON(vmovl_u16(vget_high_u16(value)), scale, offset));
+		}
+		mix_convert16(out + i, data, start + i, count - i);
+	}
+
+	static void mix_convertFloat_NEON(f32* out, const u8* data, u32 start, u32 count)
+	{
+		const float32x4_t scale = vdupq_n_f32(c_scaleF);
+		const float32x4_t offset = vdupq_n_f32(c_offsetF);
+		const f32* src = (const f32*)data + start;
+
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			vst1q_f32(out + i, vaddq_f32(vmulq_f32(vld1q_f32(src + i), scale), offset));
+		}
+		mix_convertFloat(out + i, data, start + i, count - i);
+	}
+
+	static void mix_addMonoToStereo_NEON(f32* out, const f32* samples, f32 volume, u32 count)
+	{
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4, out += 8)
+		{
+			const float32x4_t sample = vmulq_f32(vld1q_f32(samples + i), vdupq_n_f32(volume));
+			float32x4x2_t stereo = vld2q_f32(out);
+			stereo.val[0] = vaddq_f32(stereo.val[0], sample);
+			stereo.val[1] = vaddq_f32(stereo.val[1], sample);
+			vst2q_f32(out, stereo);
+		}
+		mix_addMonoToStereo(out, samples + i, volume, count - i);
+	}
+
+	static void mix_limitTanh_NEON(f32* buffer, u32 count)
+	{
+		const float32x4_t one = vdupq_n_f32(1.0f);
+		const float32x4_t negOne = vdupq_n_f32(-1.0f);
+		const float32x4_t rangeMax = vdupq_n_f32(c_tanhRange);
+		const float32x4_t rangeMin = vdupq_n_f32(-c_tanhRange);
+
+		u32 i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const float32x4_t x = vld1q_f32(buffer + i);
+			const float32x4_t x2 = vmulq_f32(x, x);
+			float32x4_t a = vaddq_f32(vdupq_n_f32(378.0f), x2);
+			a = vaddq_f32(vdupq_n_f32(17325.0f), vmulq_f32(x2, a));
+			a = vaddq_f32(vdupq_n_f32(135135.0f), vmulq_f32(x2, a));
+			a = vmulq_f32(x, a);
+
+			float32x4_t b = vaddq_f32(vdupq_n_f32(3150.0f), vmulq_f32(x2, vdupq_n_f32(28.0f)));
+			b = vaddq_f32(vdupq_n_f32(62370.0f), vmulq_f32(x2, b));
+			b = vaddq_f32(vdupq_n_f32(135135.0f), vmulq_f32(x2, b));
+			// Use a true division rather than the reciprocal estimate to match the scalar version.
+		#if defined(__aarch64__) || defined(_M_ARM64)
+			float32x4_t result = vdivq_f32(a, b);
+		#else
+			f32 lanes[4];
+			vst1q_f32(lanes, a);
+			lanes[0] /= vgetq_lane_f32(b, 0);
+			lanes[1] /= vgetq_lane_f32(b, 1);
+			lanes[2] /= vgetq_lane_f32(b, 2);
+			lanes[3] /= vgetq_lane_f32(b, 3);
+			float32x4_t result = vld1q_f32(lanes);
+		#endif
+
+			result = vbslq_f32(vcgtq_f32(x, rangeMax), one, result);
+			result = vbslq_f32(vcleq_f32(x, rangeMin), negOne, result);
+			vst1q_f32(buffer + i, result);
+		}
+		mix_limitTanh(buffer + i, count - i);
+	}
+
+	static void upsample4x_linear_NEON(f32* output, const f32* input, s32 inputSampleCount)
+	{
+		for (s32 i = 0; i < inputSampleCount; i += 2, input += 2, output += 8)
+		{
+			const float32x2_t cur = vld1_f32(input);
+			const float32x2_t delta = vsub_f32(vld1_f32(input + 2), cur);
+			vst1q_f32(output,     vcombine_f32(cur, vadd_f32(cur, vmul_n_f32(delta, 0.25f))));
+			vst1q_f32(output + 4, vcombine_f32(vadd_f32(cur, vmul_n_f32(delta, 0.5f)), vadd_f32(cur, vmul_n_f32(delta, 0.75f))));
+		}
+	}
+
+	static const MixerKernels c_neonKernels =
+	{
+		"NEON",
+		{ mix_convert8_NEON, mix_convert16_NEON, mix_convertFloat_NEON },
+		mix_addMonoToStereo_NEON,
+		mix_limitTanh_NEON,
+		upsample4x_linear_NEON,
+	};
+#endif
+
+	/////////////////////////////////////////////////
+	// API
+	/////////////////////////////////////////////////
+	void mixer_selectKernels()
+	{
+		s_mixerKernels = c_scalarKernels;
+	#ifdef TFE_SIMD_AVX2
+		if (TFE_Simd::hasFeature(SIMD_AVX2))
+		{
+			s_mixerKernels = c_avx2Kernels;
+			return;
+		}
+	#endif
+	#ifdef TFE_SIMD_SSE2
+		if (TFE_Simd::hasFeature(SIMD_SSE2))
+		{
+			s_mixerKernels = c_sse2Kernels;
+			return;
+		}
+	#endif
+	#ifdef TFE_SIMD_NEON
+		if (TFE_Simd::hasFeature(SIMD_NEON))
+		{
+			s_mixerKernels = c_neonKernels;
+			return;
+		}
+	#endif
+	}
+
+	const MixerKernels* mixer_getScalarKernels()
+	{
+		return &c_scalarKernels;
+	}
+}
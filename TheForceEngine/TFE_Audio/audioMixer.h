@@ -0,0 +1,43 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Audio Mixer
+// Block based (SIMD) versions of the sound source mixing and output
+// limiter loops used by the audio callback.
+//
+// The scalar kernels are the reference implementation, the vector
+// kernels perform the same operations in the same order so they
+// produce identical output.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+
+namespace TFE_Audio
+{
+	enum MixerConstants
+	{
+		MIX_BLOCK_SIZE = 256,	// Maximum number of source samples converted at once.
+	};
+
+	// Converts 'count' samples, starting at sample 'start', to floating point.
+	typedef void(*MixConvertFunc)(f32* out, const u8* data, u32 start, u32 count);
+	// Scales mono samples by 'volume' and adds them to both channels of the interleaved stereo output.
+	typedef void(*MixAddFunc)(f32* out, const f32* samples, f32 volume, u32 count);
+	// Limits 'count' samples in place using the tanh sigmoid (see TFE_Math::tanhf_series).
+	typedef void(*MixLimitFunc)(f32* buffer, u32 count);
+	// Same as upsample4x_linear() (see audioFilters.h).
+	typedef void(*MixUpsampleFunc)(f32* output, const f32* input, s32 inputSampleCount);
+
+	struct MixerKernels
+	{
+		const char* name;
+		MixConvertFunc  convert[3];	// Indexed by SoundDataType.
+		MixAddFunc      addMonoToStereo;
+		MixLimitFunc    limitTanh;
+		MixUpsampleFunc upsampleLinear;
+	};
+	extern MixerKernels s_mixerKernels;
+
+	// Select the best kernels for the current CPU, called when the audio system is initialized.
+	void mixer_selectKernels();
+	// The scalar reference kernels.
+	const MixerKernels* mixer_getScalarKernels();
+}
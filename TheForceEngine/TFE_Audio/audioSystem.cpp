@@ -1,15 +1,20 @@
 #include <cstring>
 #include "audioSystem.h"
 #include "audioDevice.h"
+#include "audioMixer.h"
 #include "midiPlayer.h"
 #include <SDL_mutex.h>
 #include <TFE_System/system.h>
+#include <TFE_System/spscQueue.h>
 #include <TFE_System/math.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_FrontEndUI/console.h>
 #include <TFE_System/profiler.h>
 #include <assert.h>
 #include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
 
 // Comment out the desired sigmoid function and comment all of the others.
 //#define AUDIO_SIGMOID_CLIP 1
@@ -31,13 +36,15 @@ enum SoundSourceFlags
 	SND_FLAG_FINISHED = (1 << 4),
 };
 
+// Client side state of a sound source, only accessed from the game thread.
+// The mixer keeps its own copy of the playback state (see MixerSource).
 struct SoundSource
 {
 	SoundType type;
 	f32 volume;
-	u32 sampleIndex;
 	u32 flags;
 	s32 slot;
+	u32 sequence;	// Incremented every time the source is (re)started, used to ignore stale events from the mixer.
 
 	// Sound data.
 	const SoundBuffer* buffer;
@@ -48,6 +55,51 @@ struct SoundSource
 	s32 finishedArg = 0;
 };
 
+// Playback state owned by the audio thread.
+struct MixerSource
+{
+	SoundType type;
+	f32 volume;
+	u32 sampleIndex;
+	u32 flags;
+	u32 sequence;
+
+	// Sound data.
+	const SoundBuffer* buffer;
+};
+
+// Commands sent from the game thread to the mixer.
+enum AudioCommandType
+{
+	ACMD_START = 0,		// Setup the source and start playing if SND_FLAG_PLAYING is set.
+	// PLAY and SET_BUFFER carry the full client flags, since the mixer may have already finished and
+	// deactivated the source by the time they arrive.
+	ACMD_PLAY,
+	ACMD_STOP,
+	ACMD_FREE,
+	ACMD_SET_VOLUME,
+	ACMD_SET_BUFFER,
+	ACMD_STOP_ALL,
+};
+
+struct AudioCommand
+{
+	AudioCommandType cmd;
+	s32 slot;
+	u32 flags;
+	u32 sequence;
+	SoundType type;
+	f32 volume;
+	const SoundBuffer* buffer;
+};
+
+// Sources that finished playing, sent from the mixer back to the game thread.
+struct AudioEvent
+{
+	s32 slot;
+	u32 sequence;
+};
+
 namespace TFE_Audio
 {
 	static const f32 c_channelLimit  = 1.0f;
@@ -60,24 +112,41 @@ namespace TFE_Audio
 		AUDIO_FRAME_SIZE = 1024,
 		AUDIO_CALLBACK_BUFFER_SIZE = 256,	// 256
 		BUFFERED_SILENT_FRAME_COUNT = 16,
+		AUDIO_COMMAND_QUEUE_SIZE = 1024,
+		AUDIO_EVENT_QUEUE_SIZE = 256,
 	};
 
 	// Client volume controls, ranging from [0, 1]
 	static f32 s_soundFxVolume = 1.0f;
 
+	// Game thread.
 	static u32 s_sourceCount;
 	static SoundSource s_sources[MAX_SOUND_SOURCES];
+	// Audio thread.
+	static u32 s_mixSourceCount;
+	static MixerSource s_mixSources[MAX_SOUND_SOURCES];
+	// The game thread is the only producer of commands and the mixer is the only producer of events.
+	static SpscQueue<AudioCommand, AUDIO_COMMAND_QUEUE_SIZE> s_commandQueue;
+	static SpscQueue<AudioEvent, AUDIO_EVENT_QUEUE_SIZE> s_eventQueue;
+
+	// Only protects the audio thread callback (iMuse) state, see lock() and unlock().
 	static SDL_mutex* s_mutex;
-	static bool s_paused = false;
+	static std::atomic<bool> s_paused(false);
 	static bool s_nullDevice = false;
 	static volatile s32 s_silentAudioFrames = 0;
 
 	static AudioUpsampleFilter s_upsampleFilter = AUF_DEFAULT;
 	static AudioThreadCallback s_audioThreadCallback = nullptr;
 
+	// Performance counters, written by the audio thread.
+	static s32 s_commandQueueDepth = 0;
+	static s32 s_mixTimeMicroSec = 0;
+
 	static void audioCallback(void*, unsigned char*, int);
+	static void resetSources();
 	void setSoundVolumeConsole(const ConsoleArgList& args);
 	void getSoundVolumeConsole(const ConsoleArgList& args);
+	void audioBenchmarkConsole(const ConsoleArgList& args);
 
 #if AUDIO_TIMING == 1
 	static f64 s_soundIterMaxF = 0.0;
@@ -89,11 +158,13 @@ namespace TFE_Audio
 	bool init(bool useNullDevice/*=false*/, s32 outputId/*=-1*/)
 	{
 		TFE_System::logWrite(LOG_MSG, "Startup", "TFE_AudioSystem::init");
-		s_sourceCount = 0u;
 
 		CCMD("setSoundVolume", setSoundVolumeConsole, 1, "Sets the sound volume, range is 0.0 to 1.0");
 		CCMD("getSoundVolume", getSoundVolumeConsole, 0, "Get the current sound volume.");
+		CCMD("audioBenchmark", audioBenchmarkConsole, 0, "Mix MAX_SOUND_SOURCES test sources with the scalar and vector mixers and compare. Optional: iteration count.");
 
+		TFE_COUNTER(s_commandQueueDepth, "Audio Command Queue Depth");
+		TFE_COUNTER(s_mixTimeMicroSec, "Audio Mix Time (MicroSec)");
 	#if AUDIO_TIMING == 1
 		TFE_COUNTER(s_soundIterMax, "SoundIterMax-MicroSec");
 		TFE_COUNTER(s_soundIterAve, "SoundIterAve-MicroSec");
@@ -102,11 +173,10 @@ namespace TFE_Audio
 		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->soundFxVolume);
 
-		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
-		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
-		{
-			s_sources[i].slot = i;
-		}
+		// The audio thread is not running yet, so the mixer state can be reset directly.
+		resetSources();
+		mixer_selectKernels();
+		TFE_System::logWrite(LOG_MSG, "Audio", "Using %s mixer kernels.", s_mixerKernels.name);
 
 		bool audDev = TFE_AudioDevice::init(AUDIO_FRAME_SIZE, outputId, useNullDevice);
 		if (!audDev)
@@ -148,18 +218,75 @@ namespace TFE_Audio
 		SDL_DestroyMutex(s_mutex);
 	}
 
+	static void resetSources()
+	{
+		s_commandQueue.clear();
+		s_eventQueue.clear();
+
+		s_sourceCount = 0u;
+		s_mixSourceCount = 0u;
+		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
+		{
+			const u32 sequence = s_sources[i].sequence;
+			s_sources[i] = {};
+			s_sources[i].slot = i;
+			// Keep the sequence so events from before the reset are ignored.
+			s_sources[i].sequence = sequence + 1;
+			s_mixSources[i] = {};
+		}
+	}
+
+	static void sendCommand(const AudioCommand& command)
+	{
+		if (!s_commandQueue.push(command))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Audio", "Audio command queue is full, dropping command %d for slot %d.", command.cmd, command.slot);
+		}
+	}
+
 	void stopAllSounds()
 	{
 		if (s_nullDevice) { return; }
 
-		SDL_LockMutex(s_mutex);
 		s_sourceCount = 0u;
-		memset(s_sources, 0, sizeof(SoundSource) * MAX_SOUND_SOURCES);
 		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
 		{
+			const u32 sequence = s_sources[i].sequence;
+			s_sources[i] = {};
 			s_sources[i].slot = i;
+			s_sources[i].sequence = sequence + 1;
+		}
+
+		AudioCommand command = {};
+		command.cmd = ACMD_STOP_ALL;
+		sendCommand(command);
+	}
+
+	// Handle events sent back from the mixer, called once per frame from the game thread.
+	void update()
+	{
+		if (s_nullDevice) { return; }
+
+		AudioEvent evt;
+		while (s_eventQueue.pop(evt))
+		{
+			SoundSource* source = &s_sources[evt.slot];
+			// The source was stopped, freed or restarted after the mixer finished with it.
+			if (source->sequence != evt.sequence || !(source->flags & SND_FLAG_ACTIVE)) { continue; }
+
+			source->flags = 0;
+			source->buffer = nullptr;
+			if (source->finishedCallback)
+			{
+				source->finishedCallback(source->finishedUserData, source->finishedArg);
+			}
+		}
+
+		// Shrink the number of sources until an active source is found.
+		while (s_sourceCount > 0 && !(s_sources[s_sourceCount - 1].flags & SND_FLAG_ACTIVE))
+		{
+			s_sourceCount--;
 		}
-		SDL_UnlockMutex(s_mutex);
 	}
 
 	void selectDevice(s32 id)
@@ -198,16 +325,12 @@ namespace TFE_Audio
 
 	void pause()
 	{
-		SDL_LockMutex(s_mutex);
 		s_paused = true;
-		SDL_UnlockMutex(s_mutex);
 	}
 
 	void resume()
 	{
-		SDL_LockMutex(s_mutex);
 		s_paused = false;
-		SDL_UnlockMutex(s_mutex);
 	}
 
 	// Really the buffered audio will continue to process so time advances properly.
@@ -244,30 +367,48 @@ namespace TFE_Audio
 		SDL_UnlockMutex(s_mutex);
 	}
 
-	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
-	// Note that looping one shots are valid.
-	bool playOneShot(SoundType type, f32 volume, const SoundBuffer* buffer, bool looping, SoundFinishedCallback finishedCallback, void* cbUserData, s32 cbArg)
+	static SoundSource* allocateSource()
 	{
-		if (!buffer || s_nullDevice) { return false; }
-
-		SDL_LockMutex(s_mutex);
 		// Find the first inactive source.
 		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
 		for (u32 s = 0; s < s_sourceCount; s++, snd++)
 		{
 			if (!(snd->flags&SND_FLAG_ACTIVE))
 			{
-				newSource = snd;
-				break;
+				return snd;
 			}
 		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
+		if (s_sourceCount < MAX_SOUND_SOURCES)
 		{
-			newSource = &s_sources[s_sourceCount];
+			snd = &s_sources[s_sourceCount];
 			s_sourceCount++;
+			return snd;
 		}
+		return nullptr;
+	}
 
+	static void startSource(SoundSource* source)
+	{
+		source->sequence++;
+
+		AudioCommand command = {};
+		command.cmd = ACMD_START;
+		command.slot = source->slot;
+		command.flags = source->flags;
+		command.sequence = source->sequence;
+		command.type = source->type;
+		command.volume = source->volume;
+		command.buffer = source->buffer;
+		sendCommand(command);
+	}
+
+	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
+	// Note that looping one shots are valid.
+	bool playOneShot(SoundType type, f32 volume, const SoundBuffer* buffer, bool looping, SoundFinishedCallback finishedCallback, void* cbUserData, s32 cbArg)
+	{
+		if (!buffer || s_nullDevice) { return false; }
+
+		SoundSource* newSource = allocateSource();
 		if (newSource)
 		{
 			newSource->type = type;
@@ -278,13 +419,11 @@ namespace TFE_Audio
 			}
 			newSource->volume = type == SOUND_3D ? 0.0f : volume;
 			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
 			newSource->finishedCallback = finishedCallback;
 			newSource->finishedUserData = cbUserData;
 			newSource->finishedArg = cbArg;
+			startSource(newSource);
 		}
-		SDL_UnlockMutex(s_mutex);
-
 		return newSource != nullptr;
 	}
 
@@ -294,36 +433,18 @@ namespace TFE_Audio
 		if (!buffer || s_nullDevice) { return nullptr; }
 		assert(volume >= 0.0f && volume <= 1.0f);
 
-		SDL_LockMutex(s_mutex);
-		// Find the first inactive source.
-		SoundSource* snd = s_sources;
-		SoundSource* newSource = nullptr;
-		for (u32 s = 0; s < s_sourceCount; s++, snd++)
-		{
-			if (!(snd->flags&SND_FLAG_ACTIVE))
-			{
-				newSource = snd;
-				break;
-			}
-		}
-		if (!newSource && s_sourceCount < MAX_SOUND_SOURCES)
-		{
-			newSource = &s_sources[s_sourceCount];
-			s_sourceCount++;
-		}
-
+		SoundSource* newSource = allocateSource();
 		if (newSource)
 		{
 			newSource->type = type;
 			newSource->flags = SND_FLAG_ACTIVE;
 			newSource->volume = volume;
 			newSource->buffer = buffer;
-			newSource->sampleIndex = 0u;
 			newSource->finishedCallback = callback;
 			newSource->finishedUserData = userData;
+			newSource->finishedArg = 0;
+			startSource(newSource);
 		}
-		SDL_UnlockMutex(s_mutex);
-
 		return newSource;
 	}
 
@@ -355,48 +476,74 @@ namespace TFE_Audio
 		{
 			return;
 		}
-		
-		SDL_LockMutex(s_mutex);
-			source->flags |= SND_FLAG_PLAYING;
-			if (looping) { source->flags |= SND_FLAG_LOOPING; }
-			source->sampleIndex = 0u;
-		SDL_UnlockMutex(s_mutex);
+
+		source->flags |= SND_FLAG_PLAYING;
+		if (looping) { source->flags |= SND_FLAG_LOOPING; }
+		source->sequence++;
+
+		AudioCommand command = {};
+		command.cmd = ACMD_PLAY;
+		command.slot = source->slot;
+		command.flags = source->flags;
+		command.sequence = source->sequence;
+		sendCommand(command);
 	}
 
 	void stopSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-		SDL_UnlockMutex(s_mutex);
+		source->flags &= ~SND_FLAG_PLAYING;
+
+		AudioCommand command = {};
+		command.cmd = ACMD_STOP;
+		command.slot = source->slot;
+		sendCommand(command);
 	}
 	
 	void freeSource(SoundSource* source)
 	{
 		if (!source || s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
-			source->flags &= ~SND_FLAG_PLAYING;
-			source->flags &= ~SND_FLAG_ACTIVE;
-			source->buffer = nullptr;
-		SDL_UnlockMutex(s_mutex);
+		source->flags &= ~SND_FLAG_PLAYING;
+		source->flags &= ~SND_FLAG_ACTIVE;
+		source->buffer = nullptr;
+		source->sequence++;
+
+		AudioCommand command = {};
+		command.cmd = ACMD_FREE;
+		command.slot = source->slot;
+		sendCommand(command);
 	}
 
 	void setSourceVolume(SoundSource* source, f32 volume)
 	{
 		if (s_nullDevice) { return; }
 		source->volume = std::max(0.0f, std::min(1.0f, volume));
+
+		AudioCommand command = {};
+		command.cmd = ACMD_SET_VOLUME;
+		command.slot = source->slot;
+		command.volume = source->volume;
+		sendCommand(command);
 	}
 
 	// This will restart the sound and change the buffer.
 	void setSourceBuffer(SoundSource* source, const SoundBuffer* buffer)
 	{
 		if (s_nullDevice) { return; }
-		SDL_LockMutex(s_mutex);
-			source->sampleIndex = 0u;
-			source->buffer = buffer;
-		SDL_UnlockMutex(s_mutex);
+		source->buffer = buffer;
+		source->sequence++;
+
+		AudioCommand command = {};
+		command.cmd = ACMD_SET_BUFFER;
+		command.slot = source->slot;
+		command.flags = source->flags;
+		command.sequence = source->sequence;
+		command.buffer = buffer;
+		sendCommand(command);
 	}
 
+	// Note: the source stops playing from the point of view of the client once the mixer
+	// reports that it has finished, which is handled in update().
 	bool isSourcePlaying(SoundSource* source)
 	{
 		if (s_nullDevice) { return false; }
@@ -410,90 +557,95 @@ namespace TFE_Audio
 	}
 
 	// Internal
-	static const f32 c_scale[] = { 2.0f / 255.0f, 2.0f / 65535.0f, 1.0f };
-	static const f32 c_offset[] = { -1.0f, -1.0f, 0.0f };
-
-	void cleanupSources()
+	// Apply the commands queued by the game thread, called at the start of the mix.
+	static void processCommands()
 	{
-		// call any finished callbacks.
-		for (u32 s = 0; s < s_sourceCount; s++)
-		{
-			if (s_sources[s].flags&SND_FLAG_FINISHED)
-			{
-				s_sources[s].flags = 0;
-				s_sources[s].buffer = nullptr;
-				if (s_sources[s].finishedCallback)
-				{
-					s_sources[s].finishedCallback(s_sources[s].finishedUserData, s_sources[s].finishedArg);
-				}
-			}
-		}
+		s_commandQueueDepth = (s32)s_commandQueue.size();
 
-		const s32 end = (s32)s_sourceCount - 1;
-		//shrink the number of sources until an active source is found.
-		for (s32 s = end; s >= 0; s--)
+		AudioCommand command;
+		while (s_commandQueue.pop(command))
 		{
-			if (s_sources[s].flags&SND_FLAG_ACTIVE)
+			MixerSource* snd = &s_mixSources[command.slot];
+			switch (command.cmd)
 			{
-				break;
+				case ACMD_START:
+				{
+					snd->type = command.type;
+					snd->flags = command.flags;
+					snd->volume = command.volume;
+					snd->buffer = command.buffer;
+					snd->sequence = command.sequence;
+					snd->sampleIndex = 0u;
+					s_mixSourceCount = std::max(s_mixSourceCount, u32(command.slot + 1));
+				} break;
+				case ACMD_PLAY:
+				{
+					snd->flags = command.flags;
+					snd->sequence = command.sequence;
+					snd->sampleIndex = 0u;
+					s_mixSourceCount = std::max(s_mixSourceCount, u32(command.slot + 1));
+				} break;
+				case ACMD_STOP:
+				{
+					snd->flags &= ~SND_FLAG_PLAYING;
+				} break;
+				case ACMD_FREE:
+				{
+					snd->flags = 0;
+					snd->buffer = nullptr;
+				} break;
+				case ACMD_SET_VOLUME:
+				{
+					snd->volume = command.volume;
+				} break;
+				case ACMD_SET_BUFFER:
+				{
+					snd->flags = command.flags;
+					snd->buffer = command.buffer;
+					snd->sequence = command.sequence;
+					snd->sampleIndex = 0u;
+					s_mixSourceCount = std::max(s_mixSourceCount, u32(command.slot + 1));
+				} break;
+				case ACMD_STOP_ALL:
+				{
+					memset(s_mixSources, 0, sizeof(MixerSource) * MAX_SOUND_SOURCES);
+					s_mixSourceCount = 0u;
+				} break;
 			}
-			s_sourceCount--;
 		}
 	}
-		
-	f32 sampleBuffer(u32 index, SoundDataType type, const u8* data)
-	{
-		f32 sampleValue = 0.0f;
-		switch (type)
-		{
-			case SOUND_DATA_8BIT:  { sampleValue = (f32)data[index]; } break;
-			case SOUND_DATA_16BIT: { sampleValue = (f32)(*((u16*)data + index)); } break;
-			case SOUND_DATA_FLOAT: { sampleValue = *((f32*)data + index); } break;
-		};
 
-		return sampleValue * c_scale[type] + c_offset[type];
-	}
-			
-	// Audio callback
-	static void audioCallback(void* userData, unsigned char* outputBuffer, int bufsize)
+	// Report finished sources to the game thread, which calls the finished callbacks.
+	static void cleanupSources()
 	{
-		f32* buffer = (f32*)outputBuffer;
-		u32 bufferSize = (u32)bufsize;
-		u32 frames = bufferSize / (AUDIO_CHANNEL_COUNT * sizeof(f32));
-
-	#if AUDIO_TIMING == 1
-		u64 soundIterStart = TFE_System::getCurrentTimeInTicks();
-	#endif
-
-		// First clear samples
-		memset(buffer, 0, bufferSize);
-			   
-		SDL_LockMutex(s_mutex);
-		// Then call the audio thread callback
-		if (s_audioThreadCallback && !s_paused)
+		for (u32 s = 0; s < s_mixSourceCount; s++)
 		{
-			static f32 callbackBuffer[(AUDIO_CALLBACK_BUFFER_SIZE + 2)*AUDIO_CHANNEL_COUNT];	// 256 stereo + oversampling.
-			s_audioThreadCallback(callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE, s_soundFxVolume * c_soundHeadroom);
-			// The audio buffer is 1/4 as large as it should be.
-			// This means that in-between samples must be interpolated.
-			if (!s_silentAudioFrames)
+			MixerSource* snd = &s_mixSources[s];
+			if (snd->flags&SND_FLAG_FINISHED)
 			{
-				if (s_upsampleFilter == AUF_NONE)
-				{
-					upsample4x_point(buffer, callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE*AUDIO_CHANNEL_COUNT);
-				}
-				else if (s_upsampleFilter == AUF_LINEAR)
-				{
-					upsample4x_linear(buffer, callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE*AUDIO_CHANNEL_COUNT);
-				}
+				// If the event queue is full, try again in the next callback.
+				const AudioEvent evt = { s32(s), snd->sequence };
+				if (!s_eventQueue.push(evt)) { break; }
+
+				snd->flags = 0;
+				snd->buffer = nullptr;
 			}
 		}
 
-		// Then loop through the sources.
-		// Note: this is no longer used by Dark Forces. However I decided to keep direct sound support around
-		// so it can be used for tools.
-		SoundSource* snd = s_sources;
-		for (u32 s = 0; s < s_sourceCount && !s_paused; s++, snd++)
+		// Shrink the number of sources until an active source is found.
+		while (s_mixSourceCount > 0 && !(s_mixSources[s_mixSourceCount - 1].flags & SND_FLAG_ACTIVE))
+		{
+			s_mixSourceCount--;
+		}
+	}
+		
+	// Mix 'count' sources into the interleaved stereo output.
+	// Source samples are converted to float in blocks, which are then added to the output using the mixer kernels.
+	static void mixSources(const MixerKernels* kernels, MixerSource* sources, u32 count, f32* output, u32 frames)
+	{
+		f32 samples[MIX_BLOCK_SIZE];
+		MixerSource* snd = sources;
+		for (u32 s = 0; s < count; s++, snd++)
 		{
 			if (!(snd->flags&SND_FLAG_PLAYING)) { continue; }
 			assert(snd->buffer->data);
@@ -521,7 +673,8 @@ namespace TFE_Audio
 			}
 
 			// Sample loop.
-			buffer = (f32*)outputBuffer;
+			f32* buffer = output;
+			const MixConvertFunc convert = kernels->convert[snd->buffer->type];
 			// The sound may be split into multiple iterations if it loops or the loop
 			// may end early, once we reach the end.
 			for (u32 i = 0; i < frames;)
@@ -541,58 +694,111 @@ namespace TFE_Audio
 					}
 				}
 
-				const SoundDataType type = snd->buffer->type;
-				const u8* data = snd->buffer->data;
-				const u32 end = std::min(sndBufferSize, snd->sampleIndex + frames - i);
-				u32 sIndex = snd->sampleIndex;
-				for (; sIndex < end; i++, sIndex++, buffer += 2)
-				{
-					const f32 sample = sampleBuffer(sIndex, type, data) * snd->volume;
-					buffer[0] += sample;
-					buffer[1] += sample;
-				}
-				snd->sampleIndex = sIndex;
+				const u32 blockSize = std::min(std::min(sndBufferSize - snd->sampleIndex, frames - i), u32(MIX_BLOCK_SIZE));
+				convert(samples, snd->buffer->data, snd->sampleIndex, blockSize);
+				kernels->addMonoToStereo(buffer, samples, snd->volume, blockSize);
+
+				snd->sampleIndex += blockSize;
+				buffer += blockSize * AUDIO_CHANNEL_COUNT;
+				i += blockSize;
 			}
 		}
-		// Cleanup sound sources while we are still in the mutex.
-		cleanupSources();
-		
-		// Handle midi synthesis results.
-		if (!s_paused)
-		{
-			TFE_MidiPlayer::synthesizeMidi((f32*)outputBuffer, frames, !s_silentAudioFrames);
-		}
-		if (s_silentAudioFrames > 0) { s_silentAudioFrames--; }
-		SDL_UnlockMutex(s_mutex);
+	}
 
-		// Handle out of range audio samples.
-		buffer = (f32*)outputBuffer;
+	static void limitOutput(f32* buffer, u32 frames)
+	{
+		// Audio outside of the [-1, 1] range will cause overflow, which is a major artifact.
+		// Instead the audio needs to be limited in range, which can be done in several ways.
+		// Sigmoid functions map an arbitrary range into [-1, 1] generall along an S-Curve, allowing us to avoid overflow.
+	#if defined(AUDIO_SIGMOID_TANH)	// Considered one of the most "musical sounding" sigmoid functions, it avoids hard clipping.
+		// Note the usable range is approximately -4.8 to 4.8 so the volumes should be adjusted to stay within those ranges when possible.
+		// Still much better than the effect -1 to 1 range with hard clipping and cheaper than the more accurate library tanh(). :)
+		s_mixerKernels.limitTanh(buffer, frames * AUDIO_CHANNEL_COUNT);
+	#else
 		for (u32 i = 0; i < frames; i++, buffer += 2)
 		{
 			const f32 valueLeft  = buffer[0];
 			const f32 valueRight = buffer[1];
-
-			// Audio outside of the [-1, 1] range will cause overflow, which is a major artifact.
-			// Instead the audio needs to be limited in range, which can be done in several ways.
-			// Sigmoid functions map an arbitrary range into [-1, 1] generall along an S-Curve, allowing us to avoid overflow.
 		#if defined(AUDIO_SIGMOID_CLIP)		// Not really a Sigmoid function but acts in a similar way, naively mapping to the required range.
 			buffer[0] = std::max(-c_channelLimit, std::min(valueLeft,  c_channelLimit));
 			buffer[1] = std::max(-c_channelLimit, std::min(valueRight, c_channelLimit));
-		#elif defined(AUDIO_SIGMOID_TANH)	// Considered one of the most "musical sounding" sigmoid functions, it avoids hard clipping.
-			// Note the usable range is approximately -4.8 to 4.8 so the volumes should be adjusted to stay within those ranges when possible.
-			// Still much better than the effect -1 to 1 range with hard clipping and cheaper than the more accurate library tanh(). :)
-			buffer[0] = TFE_Math::tanhf_series(valueLeft);
-			buffer[1] = TFE_Math::tanhf_series(valueRight);
 		#elif defined(AUDIO_SIGMOID_RCP_SQRT)
 			buffer[0] = valueLeft  / sqrtf(1.0f + valueLeft * valueLeft);
 			buffer[1] = valueRight / sqrtf(1.0f + valueRight * valueRight);
 		#endif
 		}
+	#endif
+	}
+			
+	// Audio callback
+	static void audioCallback(void* userData, unsigned char* outputBuffer, int bufsize)
+	{
+		// The device thread can change when the audio device is reset, so each new thread is named on its first callback.
+		static thread_local bool s_threadNamed = false;
+		if (!s_threadNamed)
+		{
+			TFE_Profiler::setThreadName("Audio");
+			s_threadNamed = true;
+		}
+		TFE_ZONE("Audio Callback");
+
+		f32* buffer = (f32*)outputBuffer;
+		u32 bufferSize = (u32)bufsize;
+		u32 frames = bufferSize / (AUDIO_CHANNEL_COUNT * sizeof(f32));
+		const u64 soundIterStart = TFE_System::getCurrentTimeInTicks();
+		const bool paused = s_paused;
+
+		// First clear samples
+		memset(buffer, 0, bufferSize);
+		// The mixer owns the source state, so apply any pending changes from the game thread.
+		processCommands();
+
+		// Then call the audio thread callback
+		SDL_LockMutex(s_mutex);
+		if (s_audioThreadCallback && !paused)
+		{
+			static f32 callbackBuffer[(AUDIO_CALLBACK_BUFFER_SIZE + 2)*AUDIO_CHANNEL_COUNT];	// 256 stereo + oversampling.
+			s_audioThreadCallback(callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE, s_soundFxVolume * c_soundHeadroom);
+			// The audio buffer is 1/4 as large as it should be.
+			// This means that in-between samples must be interpolated.
+			if (!s_silentAudioFrames)
+			{
+				if (s_upsampleFilter == AUF_NONE)
+				{
+					upsample4x_point(buffer, callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE*AUDIO_CHANNEL_COUNT);
+				}
+				else if (s_upsampleFilter == AUF_LINEAR)
+				{
+					s_mixerKernels.upsampleLinear(buffer, callbackBuffer, AUDIO_CALLBACK_BUFFER_SIZE*AUDIO_CHANNEL_COUNT);
+				}
+			}
+		}
+		SDL_UnlockMutex(s_mutex);
+
+		// Then loop through the sources.
+		// Note: this is no longer used by Dark Forces. However I decided to keep direct sound support around
+		// so it can be used for tools.
+		if (!paused)
+		{
+			mixSources(&s_mixerKernels, s_mixSources, s_mixSourceCount, buffer, frames);
+		}
+		cleanupSources();
+		
+		// Handle midi synthesis results, the midi player has its own locks.
+		if (!paused)
+		{
+			TFE_MidiPlayer::synthesizeMidi((f32*)outputBuffer, frames, !s_silentAudioFrames);
+		}
+		if (s_silentAudioFrames > 0) { s_silentAudioFrames--; }
+
+		// Handle out of range audio samples.
+		limitOutput(buffer, frames);
 
 		// Timing
-	#if AUDIO_TIMING == 1
 		u64 soundIterEnd = TFE_System::getCurrentTimeInTicks();
 		f64 soundIterDeltaMS = 1000000.0 * TFE_System::convertFromTicksToSeconds(soundIterEnd - soundIterStart);
+		s_mixTimeMicroSec = s32(soundIterDeltaMS);
+	#if AUDIO_TIMING == 1
 		s_soundIterAveF = soundIterDeltaMS * 0.01 + s_soundIterAveF * 0.99;
 		s_soundIterMaxF = std::max(s_soundIterMaxF, soundIterDeltaMS);
 		s_soundIterAve = s32(s_soundIterAveF);
@@ -618,4 +824,83 @@ namespace TFE_Audio
 		sprintf(res, "Sound Volume: %2.3f", s_soundFxVolume);
 		TFE_Console::addToHistory(res);
 	}
+
+	// Mixes MAX_SOUND_SOURCES synthetic sources, using every sample format, through the scalar reference kernels
+	// and the selected kernels. This runs on the calling thread and does not touch the live mixer state.
+	void audioBenchmarkConsole(const ConsoleArgList& args)
+	{
+		const s32 iterations = args.size() >= 2 ? std::max(1, atoi(args[1].c_str())) : 1000;
+		const u32 sampleCount = AUDIO_FREQ;
+
+		// Source data, with a few odd lengths so the block tails and loop splits are exercised.
+		std::vector<u8> data8(sampleCount);
+		std::vector<u16> data16(sampleCount);
+		std::vector<f32> dataFlt(sampleCount);
+		for (u32 i = 0; i < sampleCount; i++)
+		{
+			const u32 hash = i * 2654435761u;
+			data8[i] = u8(hash >> 24u);
+			data16[i] = u16(hash >> 16u);
+			dataFlt[i] = f32(hash >> 8u) / f32(1 << 24) * 2.0f - 1.0f;
+		}
+		SoundBuffer buffers[3] = {};
+		u8* bufferData[3] = { data8.data(), (u8*)data16.data(), (u8*)dataFlt.data() };
+		for (s32 b = 0; b < 3; b++)
+		{
+			buffers[b].type = SoundDataType(b);
+			buffers[b].size = sampleCount - 7 * b;
+			buffers[b].sampleRate = AUDIO_FREQ;
+			buffers[b].loopStart = 13 * b;
+			buffers[b].loopEnd = buffers[b].size;
+			buffers[b].data = bufferData[b];
+		}
+
+		MixerSource baseSources[MAX_SOUND_SOURCES] = {};
+		for (s32 i = 0; i < MAX_SOUND_SOURCES; i++)
+		{
+			baseSources[i].type = SOUND_2D;
+			baseSources[i].volume = 0.02f + 0.01f * f32(i & 7);
+			baseSources[i].sampleIndex = u32(i) * 331u;
+			baseSources[i].flags = SND_FLAG_ACTIVE | SND_FLAG_PLAYING | SND_FLAG_LOOPING;
+			baseSources[i].buffer = &buffers[i % 3];
+		}
+
+		const MixerKernels* kernelList[] = { mixer_getScalarKernels(), &s_mixerKernels };
+		std::vector<f32> output[2];
+		f64 timeMicroSec[2] = { 0 };
+		for (s32 k = 0; k < 2; k++)
+		{
+			const MixerKernels* kernels = kernelList[k];
+			MixerSource sources[MAX_SOUND_SOURCES];
+			memcpy(sources, baseSources, sizeof(MixerSource) * MAX_SOUND_SOURCES);
+			output[k].resize(AUDIO_FRAME_SIZE * AUDIO_CHANNEL_COUNT);
+
+			const u64 start = TFE_System::getCurrentTimeInTicks();
+			for (s32 iter = 0; iter < iterations; iter++)
+			{
+				f32* buffer = output[k].data();
+				memset(buffer, 0, sizeof(f32) * AUDIO_FRAME_SIZE * AUDIO_CHANNEL_COUNT);
+				mixSources(kernels, sources, MAX_SOUND_SOURCES, buffer, AUDIO_FRAME_SIZE);
+				kernels->limitTanh(buffer, AUDIO_FRAME_SIZE * AUDIO_CHANNEL_COUNT);
+			}
+			const u64 end = TFE_System::getCurrentTimeInTicks();
+			timeMicroSec[k] = 1000000.0 * TFE_System::convertFromTicksToSeconds(end - start) / f64(iterations);
+		}
+
+		// The vector kernels perform the same operations as the scalar kernels, so the output should match exactly.
+		s32 mismatchCount = 0;
+		for (size_t i = 0; i < output[0].size(); i++)
+		{
+			if (output[0][i] != output[1][i]) { mismatchCount++; }
+		}
+
+		char res[256];
+		sprintf(res, "Audio mix, %d sources x %d frames: Scalar %2.2f us, %s %2.2f us per callback (%d iterations).",
+			MAX_SOUND_SOURCES, AUDIO_FRAME_SIZE, timeMicroSec[0], s_mixerKernels.name, timeMicroSec[1], iterations);
+		TFE_Console::addToHistory(res);
+		sprintf(res, "Output %s (%d of %d samples differ).", mismatchCount ? "MISMATCH" : "matches", mismatchCount, s32(output[0].size()));
+		TFE_Console::addToHistory(res);
+		TFE_System::logWrite(mismatchCount ? LOG_ERROR : LOG_MSG, "Audio", "Mixer benchmark: Scalar %2.2f us, %s %2.2f us, %d mismatched samples.",
+			timeMicroSec[0], s_mixerKernels.name, timeMicroSec[1], mismatchCount);
+	}
 }
@@ -59,6 +59,8 @@ namespace TFE_Audio
 	// functions
 	bool init(bool useNullDevice = false, s32 outputId = -1);
 	void shutdown();
+	// Handles sounds that finished playing (calling their finished callbacks), called once per frame.
+	void update();
 	void stopAllSounds();
 	void selectDevice(s32 id);
 
@@ -78,6 +80,9 @@ namespace TFE_Audio
 	void setAudioThreadCallback(AudioThreadCallback callback = nullptr);
 	const OutputDeviceInfo* getOutputDeviceList(s32& count, s32& curOutput);
 
+	// The sound source functions below must be called from the game thread, changes are queued and applied
+	// by the mixer on the audio thread. Finished callbacks are called from update().
+
 	// One shot, play and forget. Only do this if the client needs no control until stopAllSounds() is called.
 	// Note that looping one shots are valid though may generate too many sound sources if not used carefully.
 	bool playOneShot(SoundType type, f32 volume, const SoundBuffer* buffer, bool looping,
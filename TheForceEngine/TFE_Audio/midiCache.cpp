@@ -0,0 +1,477 @@
+#include "midiCache.h"
+#include <TFE_Audio/MidiSynth/soundFontDevice.h>
+#include <TFE_Audio/MidiSynth/fm4Opl3Device.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace TFE_Audio;
+
+namespace TFE_MidiCache
+{
+	enum CacheFileConstants
+	{
+		CACHE_FILE_MAGIC   = 0x41434d54,	// "TMCA"
+		CACHE_FILE_VERSION = 1,
+		CACHE_MAX_PRELUDE  = MIDI_CHANNEL_COUNT * (MID_ALL_SOUND_OFF + 2),
+		// Render and load requests that are waiting for the worker, more are dropped.
+		CACHE_MAX_JOBS     = 8,
+		// Loaded takes that were not received, the oldest are freed.
+		CACHE_MAX_LOADED   = 4,
+		CACHE_RENDER_BLOCK = 1024,
+	};
+	// The oldest takes are deleted when the cache grows past this size.
+	static const u64 c_maxCacheSize = 256ull * 1024ull * 1024ull;
+
+	struct CacheFileHeader
+	{
+		u32 magic;
+		u32 version;
+		u64 key;
+		u32 preludeCount;
+		u32 eventCount;
+		u32 sampleCount;
+	};
+
+	struct CacheJob
+	{
+		u64 key;
+		bool render;
+		// Render only.
+		MidiDeviceType deviceType;
+		std::string output;
+		std::vector<CacheEvent> prelude;
+		std::vector<CacheEvent> events;
+		u32 sampleCount;
+	};
+
+	struct CacheLoad
+	{
+		u64 key;
+		CachedTake* take;	// nullptr if the take is not in the cache.
+	};
+
+	static std::thread s_worker;
+	static std::mutex s_mutex;
+	static std::condition_variable s_wake;
+	static std::deque<CacheJob> s_jobs;
+	static std::vector<CacheLoad> s_loaded;
+	static bool s_quit = false;
+
+	static void getCacheDir(char* cacheDir)
+	{
+		sprintf(cacheDir, "%sMidiCache/", TFE_Paths::getPath(PATH_PROGRAM_DATA));
+	}
+
+	static void getCachePath(u64 key, char* cachePath)
+	{
+		char cacheDir[TFE_MAX_PATH];
+		getCacheDir(cacheDir);
+		sprintf(cachePath, "%s%016llx.MCA", cacheDir, (unsigned long long)key);
+	}
+
+	static u64 hashBytes(u64 hash, const void* data, size_t len)
+	{
+		// FNV-1a
+		const u8* bytes = (const u8*)data;
+		for (size_t i = 0; i < len; i++)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	bool eventsMatch(const CacheEvent& a, const CacheEvent& b)
+	{
+		return a.time == b.time && a.type == b.type && a.len == b.len && memcmp(a.msg, b.msg, a.len) == 0;
+	}
+
+	// A prelude message sets the same state as 'evt': the same message type and controller on the same channel.
+	static bool setsSameState(const CacheEvent& prelude, const CacheEvent& evt)
+	{
+		if (evt.type != MIDI_EVENT_MESSAGE || evt.msg[0] != prelude.msg[0]) { return false; }
+		return (prelude.msg[0] & 0xf0) != MID_CONTROL_CHANGE || evt.msg[1] == prelude.msg[1];
+	}
+
+	bool preludeMatches(const CachedTake* take, const std::vector<CacheEvent>& prelude)
+	{
+		for (size_t i = 0; i < take->prelude.size(); i++)
+		{
+			const CacheEvent& dep = take->prelude[i];
+			bool found = false;
+			for (size_t p = 0; p < prelude.size() && !found; p++)
+			{
+				found = setsSameState(dep, prelude[p]) && eventsMatch(dep, prelude[p]);
+			}
+			if (!found) { return false; }
+		}
+		return true;
+	}
+
+	// Keep the prelude messages whose state is used by a note before the take sets it.
+	static void getPreludeDependencies(std::vector<CacheEvent>& prelude, const std::vector<CacheEvent>& events)
+	{
+		std::vector<CacheEvent> deps;
+		for (size_t i = 0; i < prelude.size(); i++)
+		{
+			const u8 channel = prelude[i].msg[0] & 0x0f;
+			for (size_t e = 0; e < events.size(); e++)
+			{
+				const CacheEvent& evt = events[e];
+				if (evt.type != MIDI_EVENT_MESSAGE || (evt.msg[0] & 0x0f) != channel) { continue; }
+
+				const u8 msgType = evt.msg[0] & 0xf0;
+				if (msgType == MID_NOTE_ON && evt.msg[2])
+				{
+					deps.push_back(prelude[i]);
+					break;
+				}
+				const bool resetsControllers = msgType == MID_CONTROL_CHANGE && evt.msg[1] == MID_ALL_CTRL_OFF && (prelude[i].msg[0] & 0xf0) == MID_CONTROL_CHANGE;
+				if (resetsControllers || setsSameState(prelude[i], evt)) { break; }
+			}
+		}
+		prelude.swap(deps);
+	}
+
+	u64 getKey(MidiDevice* device, const CacheEvent* events, u32 count)
+	{
+		// The engine version is part of the key, so synthesizer changes are not hidden by stale takes.
+		const char* version = TFE_System::getVersionString();
+		const u32 sampleRate = CACHE_SAMPLE_RATE;
+		const MidiDeviceType type = device->getType();
+		char output[TFE_MAX_PATH] = "";
+		device->getOutputName(device->getActiveOutput(), output, TFE_MAX_PATH);
+
+		u64 hash = 14695981039346656037ull;
+		hash = hashBytes(hash, version, strlen(version));
+		hash = hashBytes(hash, &type, sizeof(type));
+		hash = hashBytes(hash, output, strlen(output));
+		hash = hashBytes(hash, &sampleRate, sizeof(sampleRate));
+		for (u32 i = 0; i < count; i++)
+		{
+			hash = hashBytes(hash, &events[i].time, sizeof(u32));
+			hash = hashBytes(hash, &events[i].type, 1);
+			hash = hashBytes(hash, events[i].msg, events[i].len);
+		}
+		return hash;
+	}
+
+	static MidiDevice* createDevice(MidiDeviceType type, const char* outputName)
+	{
+		MidiDevice* device = nullptr;
+		switch (type)
+		{
+			case MIDI_TYPE_SF2:
+				device = new SoundFontDevice();
+				break;
+			case MIDI_TYPE_OPL3:
+				device = new Fm4Opl3Device();
+				break;
+			default:
+				return nullptr;
+		}
+
+		// Outputs are matched by name, since the take key uses the name.
+		const s32 outputCount = s32(device->getOutputCount());
+		s32 outputIndex = -1;
+		for (s32 i = 0; i < outputCount && outputIndex < 0; i++)
+		{
+			char name[TFE_MAX_PATH] = "";
+			device->getOutputName(i, name, TFE_MAX_PATH);
+			if (strcasecmp(name, outputName) == 0)
+			{
+				outputIndex = i;
+			}
+		}
+		if (outputIndex < 0 || !device->selectOutput(outputIndex) || !device->canRender())
+		{
+			delete device;
+			return nullptr;
+		}
+		return device;
+	}
+
+	static CachedTake* renderJob(CacheJob& job)
+	{
+		MidiDevice* device = createDevice(job.deviceType, job.output.c_str());
+		if (!device)
+		{
+			TFE_System::logWrite(LOG_WARNING, "MidiCache", "Cannot create a '%s' device to render music.", job.output.c_str());
+			return nullptr;
+		}
+		device->setVolume(c_cacheRenderVolume);
+
+		CachedTake* take = new CachedTake();
+		take->key = job.key;
+		take->sampleCount = job.sampleCount;
+		take->samples.resize(size_t(job.sampleCount) * 2);
+
+		// The device starts in the state the take depends on, after the "all notes off" that ended the previous take.
+		getPreludeDependencies(job.prelude, job.events);
+		for (size_t i = 0; i < job.prelude.size(); i++)
+		{
+			device->message(job.prelude[i].msg, job.prelude[i].len);
+		}
+		device->noteAllOff();
+
+		// Events are queued block by block and split the blocks at the exact sample, the same as in live playback.
+		f32 buffer[CACHE_RENDER_BLOCK * 2];
+		size_t e = 0;
+		s16* out = take->samples.data();
+		for (u32 pos = 0; pos < job.sampleCount; )
+		{
+			const u32 count = std::min(u32(CACHE_RENDER_BLOCK), job.sampleCount - pos);
+			for (; e < job.events.size() && job.events[e].time < pos + count; e++)
+			{
+				const CacheEvent& evt = job.events[e];
+				const bool queued = evt.type == MIDI_EVENT_NOTE_ALL_OFF ? device->queueNoteAllOff(evt.time) : device->queueMessage(evt.time, evt.msg, evt.len);
+				// If the queue is full, the rest is queued with the next block.
+				if (!queued) { break; }
+			}
+			device->render(buffer, count);
+			for (u32 i = 0; i < count * 2; i++)
+			{
+				*out++ = s16(std::max(-32768.0f, std::min(32767.0f, buffer[i] * 32767.0f)));
+			}
+			pos += count;
+		}
+		delete device;
+
+		take->prelude = std::move(job.prelude);
+		take->events = std::move(job.events);
+		return take;
+	}
+
+	// Delete the oldest takes until the cache fits into c_maxCacheSize.
+	static void trimCache()
+	{
+		char cacheDir[TFE_MAX_PATH];
+		getCacheDir(cacheDir);
+		FileList files;
+		FileUtil::readDirectory(cacheDir, "MCA", files);
+
+		struct CacheFile
+		{
+			std::string path;
+			u64 time;
+			u64 size;
+		};
+		std::vector<CacheFile> cacheFiles;
+		u64 totalSize = 0;
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			char path[TFE_MAX_PATH];
+			sprintf(path, "%s%s", cacheDir, files[i].c_str());
+			const CacheFile file = { path, FileUtil::getModifiedTime(path), FileUtil::getFileSize(path) };
+			cacheFiles.push_back(file);
+			totalSize += file.size;
+		}
+		if (totalSize <= c_maxCacheSize) { return; }
+
+		std::sort(cacheFiles.begin(), cacheFiles.end(), [](const CacheFile& a, const CacheFile& b) { return a.time < b.time; });
+		for (size_t i = 0; i < cacheFiles.size() && totalSize > c_maxCacheSize; i++)
+		{
+			FileUtil::deleteFile(cacheFiles[i].path.c_str());
+			totalSize -= cacheFiles[i].size;
+		}
+	}
+
+	static void writeTake(const CachedTake* take)
+	{
+		char cacheDir[TFE_MAX_PATH];
+		getCacheDir(cacheDir);
+		if (!FileUtil::directoryExits(cacheDir))
+		{
+			FileUtil::makeDirectory(cacheDir);
+		}
+
+		char cachePath[TFE_MAX_PATH], tmpPath[TFE_MAX_PATH];
+		getCachePath(take->key, cachePath);
+		sprintf(tmpPath, "%s.tmp", cachePath);
+
+		FileStream file;
+		if (!file.open(tmpPath, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_WARNING, "MidiCache", "Cannot write music cache '%s'.", tmpPath);
+			return;
+		}
+		const CacheFileHeader header = { CACHE_FILE_MAGIC, CACHE_FILE_VERSION, take->key, u32(take->prelude.size()), u32(take->events.size()), take->sampleCount };
+		file.writeBuffer(&header, sizeof(header));
+		file.writeBuffer(take->prelude.data(), u32(take->prelude.size() * sizeof(CacheEvent)));
+		file.writeBuffer(take->events.data(), u32(take->events.size() * sizeof(CacheEvent)));
+		file.writeBuffer(take->samples.data(), u32(take->samples.size() * sizeof(s16)));
+		file.close();
+
+		if (!FileUtil::replaceFile(tmpPath, cachePath))
+		{
+			TFE_System::logWrite(LOG_WARNING, "MidiCache", "Cannot write music cache '%s'.", cachePath);
+			FileUtil::deleteFile(tmpPath);
+			return;
+		}
+		trimCache();
+	}
+
+	static CachedTake* loadTake(u64 key)
+	{
+		char cachePath[TFE_MAX_PATH];
+		getCachePath(key, cachePath);
+		FileStream file;
+		if (!FileUtil::exists(cachePath) || !file.open(cachePath, Stream::MODE_READ)) { return nullptr; }
+
+		CacheFileHeader header;
+		const size_t size = file.getSize();
+		if (size < sizeof(header) || file.readBuffer(&header, sizeof(header)) != sizeof(header) || header.magic != CACHE_FILE_MAGIC ||
+			header.version != CACHE_FILE_VERSION || header.key != key || header.sampleCount > CACHE_MAX_TAKE_SAMPLES || header.preludeCount > CACHE_MAX_PRELUDE ||
+			size != sizeof(header) + size_t(header.preludeCount + header.eventCount) * sizeof(CacheEvent) + size_t(header.sampleCount) * 2 * sizeof(s16))
+		{
+			TFE_System::logWrite(LOG_WARNING, "MidiCache", "Ignoring invalid music cache '%s'.", cachePath);
+			return nullptr;
+		}
+
+		CachedTake* take = new CachedTake();
+		take->key = key;
+		take->sampleCount = header.sampleCount;
+		take->prelude.resize(header.preludeCount);
+		take->events.resize(header.eventCount);
+		take->samples.resize(size_t(header.sampleCount) * 2);
+		file.readBuffer(take->prelude.data(), u32(take->prelude.size() * sizeof(CacheEvent)));
+		file.readBuffer(take->events.data(), u32(take->events.size() * sizeof(CacheEvent)));
+		file.readBuffer(take->samples.data(), u32(take->samples.size() * sizeof(s16)));
+		file.close();
+		return take;
+	}
+
+	static void workerLoop()
+	{
+		TFE_Profiler::setThreadName("Midi Cache");
+		std::unique_lock<std::mutex> lock(s_mutex);
+		while (1)
+		{
+			s_wake.wait(lock, [] { return s_quit || !s_jobs.empty(); });
+			if (s_quit) { break; }
+
+			CacheJob job = std::move(s_jobs.front());
+			s_jobs.pop_front();
+			lock.unlock();
+
+			if (job.render)
+			{
+				CachedTake* take = renderJob(job);
+				if (take)
+				{
+					writeTake(take);
+					freeTake(take);
+				}
+				lock.lock();
+			}
+			else
+			{
+				CachedTake* take = loadTake(job.key);
+				lock.lock();
+				// The midi player stops polling when its take ends before the load finishes.
+				if (s_loaded.size() >= CACHE_MAX_LOADED)
+				{
+					freeTake(s_loaded.front().take);
+					s_loaded.erase(s_loaded.begin());
+				}
+				s_loaded.push_back({ job.key, take });
+			}
+		}
+	}
+
+	static void addJob(CacheJob&& job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			if (s_jobs.size() >= CACHE_MAX_JOBS)
+			{
+				TFE_System::logWrite(LOG_WARNING, "MidiCache", "Too many music cache requests, dropping a request.");
+				if (job.render) { return; }
+				// Report a dropped load as missing, so the midi player does not wait for it.
+				s_loaded.push_back({ job.key, nullptr });
+				return;
+			}
+			s_jobs.push_back(std::move(job));
+
+			// The worker thread is started on demand.
+			if (!s_worker.joinable())
+			{
+				s_quit = false;
+				s_worker = std::thread(workerLoop);
+			}
+		}
+		s_wake.notify_one();
+	}
+
+	void destroy()
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_quit = true;
+			s_jobs.clear();
+		}
+		s_wake.notify_all();
+		// A render in progress finishes first.
+		if (s_worker.joinable())
+		{
+			s_worker.join();
+		}
+		for (size_t i = 0; i < s_loaded.size(); i++)
+		{
+			freeTake(s_loaded[i].take);
+		}
+		s_loaded.clear();
+	}
+
+	void requestTake(u64 key)
+	{
+		CacheJob job = {};
+		job.key = key;
+		job.render = false;
+		addJob(std::move(job));
+	}
+
+	CacheResult receiveTake(u64 key, CachedTake** take)
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		for (size_t i = 0; i < s_loaded.size(); i++)
+		{
+			if (s_loaded[i].key != key) { continue; }
+
+			*take = s_loaded[i].take;
+			s_loaded.erase(s_loaded.begin() + i);
+			return *take ? CACHE_READY : CACHE_MISSING;
+		}
+		return CACHE_PENDING;
+	}
+
+	void freeTake(CachedTake* take)
+	{
+		delete take;
+	}
+
+	void renderTake(u64 key, MidiDevice* device, std::vector<CacheEvent>&& prelude, std::vector<CacheEvent>&& events, u32 sampleCount)
+	{
+		char output[TFE_MAX_PATH] = "";
+		device->getOutputName(device->getActiveOutput(), output, TFE_MAX_PATH);
+
+		CacheJob job = {};
+		job.key = key;
+		job.render = true;
+		job.deviceType = device->getType();
+		job.output = output;
+		job.prelude = std::move(prelude);
+		job.events = std::move(events);
+		job.sampleCount = std::min(sampleCount, u32(CACHE_MAX_TAKE_SAMPLES));
+		addJob(std::move(job));
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Midi Cache
+// Synthesized music is recorded as "takes": the timestamped events
+// sent to the midi device, starting with the first message after all
+// notes were stopped. A take is rendered to PCM on a worker thread,
+// with its own device, and stored on disk keyed by its first events,
+// the device, the output (soundfont) and the sample rate.
+// The channel state left by earlier music is the take's "prelude",
+// only the parts the take uses before setting them are stored and
+// have to match when the take is played again.
+//
+// When the same take plays again, the midi player outputs the cached
+// PCM for as long as the live events match the recorded ones and
+// goes back to live synthesis when they diverge.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include "midiDevice.h"
+#include <vector>
+
+namespace TFE_MidiCache
+{
+	enum CacheConstants
+	{
+		CACHE_SAMPLE_RATE   = 44100,
+		// Takes are rendered and stored up to this length, longer takes are cut.
+		CACHE_MAX_TAKE_SAMPLES = CACHE_SAMPLE_RATE * 120,
+		// Shorter takes are not worth storing.
+		CACHE_MIN_TAKE_SAMPLES = CACHE_SAMPLE_RATE * 5,
+	};
+	// Takes are rendered at this device volume, playback scales them by the current volume.
+	static const f32 c_cacheRenderVolume = 0.5f;
+
+	enum CacheResult
+	{
+		CACHE_PENDING = 0,
+		CACHE_MISSING,
+		CACHE_READY,
+	};
+
+	// A device event timed in samples from the start of the take. Volume events are not recorded.
+	struct CacheEvent
+	{
+		u32 time;
+		u8  type;		// TFE_Audio::MidiEventType
+		u8  len;
+		u8  msg[3];
+		u8  pad[3];
+	};
+
+	struct CachedTake
+	{
+		u64 key;
+		std::vector<CacheEvent> prelude;	// Channel state messages the take depends on.
+		std::vector<CacheEvent> events;
+		std::vector<s16> samples;	// Interleaved stereo.
+		u32 sampleCount;			// Stereo samples.
+	};
+
+	void destroy();
+
+	bool eventsMatch(const CacheEvent& a, const CacheEvent& b);
+	// Returns true if the channel state 'prelude' has every message the cached take depends on.
+	bool preludeMatches(const CachedTake* take, const std::vector<CacheEvent>& prelude);
+	// Key of a take played on 'device' that starts with 'events'.
+	u64  getKey(TFE_Audio::MidiDevice* device, const CacheEvent* events, u32 count);
+
+	// Load a take from the disk cache on the worker thread, then poll for it with receiveTake().
+	void requestTake(u64 key);
+	// Returns CACHE_READY and hands over 'take' once it is loaded, which is released with freeTake().
+	CacheResult receiveTake(u64 key, CachedTake** take);
+	void freeTake(CachedTake* take);
+
+	// Render the first 'sampleCount' samples of a take on the worker thread and store it in the disk cache.
+	// 'prelude' is the channel state at the start of the take: controller, program change and pitch bend messages.
+	void renderTake(u64 key, TFE_Audio::MidiDevice* device, std::vector<CacheEvent>&& prelude, std::vector<CacheEvent>&& events, u32 sampleCount);
+}
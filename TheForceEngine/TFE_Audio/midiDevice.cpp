@@ -0,0 +1,153 @@
+#include "midiDevice.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace TFE_Audio
+{
+	MidiDevice::MidiDevice() : m_renderPos(0), m_renderBlockSize(0), m_queuedVolume(1.0f)
+	{
+		memset(m_heldNotes, 0, sizeof(m_heldNotes));
+		const size_t align = alignof(MidiEventQueue);
+		m_eventMem = new u8[sizeof(MidiEventQueue) + align - 1];
+		void* queueMem = (void*)((uintptr_t(m_eventMem) + align - 1) & ~uintptr_t(align - 1));
+		m_events = new (queueMem) MidiEventQueue();
+	}
+
+	MidiDevice::~MidiDevice()
+	{
+		m_events->~MidiEventQueue();
+		delete[] m_eventMem;
+	}
+
+	bool MidiDevice::queueMessage(u64 time, const u8* msg, u32 len)
+	{
+		MidiEvent evt = {};
+		evt.time = time;
+		evt.type = MIDI_EVENT_MESSAGE;
+		evt.len  = u8(std::min(len, 3u));
+		for (u32 i = 0; i < evt.len; i++)
+		{
+			evt.msg[i] = msg[i];
+		}
+		return m_events->push(evt);
+	}
+
+	bool MidiDevice::queueNoteAllOff(u64 time)
+	{
+		MidiEvent evt = {};
+		evt.time = time;
+		evt.type = MIDI_EVENT_NOTE_ALL_OFF;
+		return m_events->push(evt);
+	}
+
+	bool MidiDevice::queueVolume(u64 time, f32 volume)
+	{
+		MidiEvent evt = {};
+		evt.time = time;
+		evt.type = MIDI_EVENT_VOLUME;
+		evt.volume = volume;
+		return m_events->push(evt);
+	}
+
+	void MidiDevice::renderEvents(f32* buffer, u32 sampleCount)
+	{
+		const u64 blockStart = m_renderPos.load(std::memory_order_relaxed);
+		const u64 blockEnd = blockStart + sampleCount;
+
+		// Events are applied in queue order. An event that is older than the one before it (the midi thread resynced its clock)
+		// is applied at the same offset, so the rendered position never moves backwards.
+		u32 offset = 0;
+		MidiEvent evt;
+		while (m_events->peek(evt) && evt.time < blockEnd)
+		{
+			const u32 evtOffset = evt.time > blockStart ? u32(evt.time - blockStart) : 0;
+			if (evtOffset > offset)
+			{
+				renderSamples(buffer + offset * 2, evtOffset - offset);
+				offset = evtOffset;
+			}
+			applyEvent(evt, true);
+			m_events->pop(evt);
+		}
+		if (offset < sampleCount)
+		{
+			renderSamples(buffer + offset * 2, sampleCount - offset);
+		}
+
+		m_renderBlockSize.store(sampleCount, std::memory_order_relaxed);
+		m_renderPos.store(blockEnd, std::memory_order_release);
+	}
+
+	void MidiDevice::skipEvents(u32 sampleCount)
+	{
+		const u64 blockEnd = m_renderPos.load(std::memory_order_relaxed) + sampleCount;
+		MidiEvent evt;
+		while (m_events->peek(evt) && evt.time < blockEnd)
+		{
+			applyEvent(evt, false);
+			m_events->pop(evt);
+		}
+		m_renderBlockSize.store(sampleCount, std::memory_order_relaxed);
+		m_renderPos.store(blockEnd, std::memory_order_release);
+	}
+
+	void MidiDevice::releaseHeldNotes()
+	{
+		for (u32 c = 0; c < MIDI_CHANNEL_COUNT; c++)
+		{
+			for (u32 k = 0; k < MIDI_INSTRUMENT_COUNT; k++)
+			{
+				if (m_heldNotes[c][k])
+				{
+					message(u8(MID_NOTE_OFF | c), u8(k), 0);
+				}
+			}
+		}
+	}
+
+	void MidiDevice::restoreHeldNotes()
+	{
+		for (u32 c = 0; c < MIDI_CHANNEL_COUNT; c++)
+		{
+			for (u32 k = 0; k < MIDI_INSTRUMENT_COUNT; k++)
+			{
+				if (m_heldNotes[c][k])
+				{
+					message(u8(MID_NOTE_ON | c), u8(k), m_heldNotes[c][k]);
+				}
+			}
+		}
+	}
+
+	void MidiDevice::applyEvent(const MidiEvent& evt, bool playNotes)
+	{
+		switch (evt.type)
+		{
+			case MIDI_EVENT_MESSAGE:
+			{
+				const u8 msgType = evt.msg[0] & 0xf0;
+				const bool isNote = (msgType == MID_NOTE_ON || msgType == MID_NOTE_OFF) && evt.len >= 3;
+				if (isNote)
+				{
+					// Note on with a velocity of 0 is the same as note off.
+					m_heldNotes[evt.msg[0] & 0x0f][evt.msg[1] & 0x7f] = msgType == MID_NOTE_ON ? evt.msg[2] : 0;
+				}
+				if (playNotes || !isNote)
+				{
+					message(evt.msg, evt.len);
+				}
+			} break;
+			case MIDI_EVENT_NOTE_ALL_OFF:
+			{
+				memset(m_heldNotes, 0, sizeof(m_heldNotes));
+				noteAllOff();
+			} break;
+			case MIDI_EVENT_VOLUME:
+			{
+				m_queuedVolume = evt.volume;
+				setVolume(evt.volume);
+			} break;
+		}
+	}
+};
@@ -1,6 +1,9 @@
 #pragma once
 #include <TFE_System/types.h>
+#include <TFE_System/spscQueue.h>
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_Audio/midi.h>
+#include <atomic>
 
 enum MidiDeviceType
 {
@@ -15,11 +18,28 @@ enum MidiDeviceType
 
 namespace TFE_Audio
 {
+	enum MidiEventType
+	{
+		MIDI_EVENT_MESSAGE = 0,
+		MIDI_EVENT_NOTE_ALL_OFF,
+		MIDI_EVENT_VOLUME,
+	};
+
+	// A midi message tagged with the sample at which it should take effect.
+	struct MidiEvent
+	{
+		u64 time;
+		u8  type;
+		u8  len;
+		u8  msg[3];
+		f32 volume;
+	};
+
 	class MidiDevice
 	{
 	public:
-		MidiDevice() {}
-		virtual ~MidiDevice() {}
+		MidiDevice();
+		virtual ~MidiDevice();
 
 		virtual MidiDeviceType getType() = 0;
 
@@ -35,10 +55,57 @@ namespace TFE_Audio
 		virtual bool render(f32* buffer, u32 sampleCount) = 0;
 		virtual bool canRender() = 0;
 
+		// Immediate messages, for devices that render these must be called from the thread calling render().
 		virtual void message(u8 type, u8 arg1, u8 arg2 = 0) = 0;
 		virtual void message(const u8* msg, u32 len) = 0;
 
 		virtual void noteAllOff() = 0;
 		virtual void setVolume(f32 volume) = 0;
+
+		// Timestamped messages for devices that render (canRender()).
+		// These are queued by the midi thread and applied inside of render() at the sample given by 'time',
+		// so note timing does not depend on the audio buffer size. Events that arrive late are applied at the start of the next block.
+		// Returns false if the queue is full.
+		bool queueMessage(u64 time, const u8* msg, u32 len);
+		bool queueNoteAllOff(u64 time);
+		bool queueVolume(u64 time, f32 volume);
+		// The number of samples rendered so far and the size of the last rendered block, safe to read from any thread.
+		u64 getRenderPosition() const { return m_renderPos.load(std::memory_order_acquire); }
+		u32 getRenderBlockSize() const { return m_renderBlockSize.load(std::memory_order_relaxed); }
+		u32 getQueuedEventCount() const { return m_events->size(); }
+		// The volume set by the last queued volume event.
+		f32 getQueuedVolume() const { return m_queuedVolume; }
+
+		// Used by the midi player while it plays cached music instead of rendering, called from the thread calling render().
+		// skipEvents() advances the render position by 'sampleCount' without rendering: channel state changes are applied,
+		// note on/off only update the held notes. releaseHeldNotes() stops the held notes before skipping and
+		// restoreHeldNotes() starts them again when rendering resumes.
+		void skipEvents(u32 sampleCount);
+		void releaseHeldNotes();
+		void restoreHeldNotes();
+
+	protected:
+		// Render 'sampleCount' stereo samples, splitting the block at the queued events that fall inside of it.
+		void renderEvents(f32* buffer, u32 sampleCount);
+		// Render a span of stereo samples with the current device state, used by renderEvents().
+		virtual void renderSamples(f32* buffer, u32 sampleCount) {}
+
+	private:
+		enum { MIDI_EVENT_QUEUE_SIZE = 4096 };
+		typedef SpscQueue<MidiEvent, MIDI_EVENT_QUEUE_SIZE> MidiEventQueue;
+
+		MidiDevice(const MidiDevice&) = delete;
+		MidiDevice& operator=(const MidiDevice&) = delete;
+		void applyEvent(const MidiEvent& evt, bool playNotes);
+
+		// The queue is over-aligned, which plain new does not respect before C++17, so devices allocated with new
+		// keep it in separately allocated storage that is aligned by hand.
+		u8* m_eventMem;
+		MidiEventQueue* m_events;
+		std::atomic<u64> m_renderPos;
+		std::atomic<u32> m_renderBlockSize;
+		f32 m_queuedVolume;
+		// Velocity of the notes currently held by queued events, per channel and key (0 = off).
+		u8 m_heldNotes[MIDI_CHANNEL_COUNT][MIDI_INSTRUMENT_COUNT];
 	};
 };
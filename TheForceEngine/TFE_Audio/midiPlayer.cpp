@@ -1,5 +1,6 @@
 #include "midiPlayer.h"
 #include "midiDevice.h"
+#include "midiCache.h"
 #include "audioDevice.h"
 #ifdef BUILD_SYSMIDI
 #include "systemMidiDevice.h"
@@ -8,6 +9,7 @@
 #include <SDL_thread.h>
 #include <TFE_Asset/gmidAsset.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_FrontEndUI/console.h>
 #include <TFE_Audio/MidiSynth/soundFontDevice.h>
@@ -23,6 +25,7 @@
 #endif
 
 using namespace TFE_Audio;
+using namespace TFE_MidiCache;
 
 namespace TFE_MidiPlayer
 {
@@ -79,10 +82,71 @@ namespace TFE_MidiPlayer
 	static Instrument s_instrOn[MIDI_INSTRUMENT_COUNT] = { 0 };
 	static f64 s_curNoteTime = 0.0;
 
+	// Timestamped events.
+	// Devices that render on the audio thread receive messages tagged with a sample time, which advances by exactly one
+	// callback time step per callback. This keeps note timing independent of both the midi thread scheduling and the
+	// audio buffer size. The time is kept about one audio block ahead of the render position.
+	static const f64 c_midiSampleRate = 44100.0;	// The synthesized devices render at the audio output rate.
+	static f64 s_eventTime = 0.0;
+	static s32 s_eventQueueDepth = 0;
+	static s32 s_eventsDropped = 0;
+
+	// Music cache (see midiCache.h).
+	// Channel state sent to the device, -1 = never set. It is the prelude of each take.
+	struct ChannelState
+	{
+		s16 program;
+		s16 pitchBend;
+		s16 control[MID_ALL_SOUND_OFF];	// Controllers below the channel mode messages.
+	};
+	// The take being played, only accessed by the midi thread.
+	struct Take
+	{
+		bool active;
+		bool recording;			// Events are recorded to render the take if it is not cached.
+		bool keyed;
+		// Time in samples since the first event, advanced by exactly one time step per callback. Unlike the event time
+		// it is not resynced, so the same music gives the same take.
+		f64  time;
+		u64  key;
+		CacheResult result;
+		std::vector<CacheEvent> prelude;	// Channel state at the start of the take.
+		std::vector<CacheEvent> events;
+		CachedTake* cached;		// Cached take that matches every event so far.
+		bool published;			// The cached take was handed to the audio thread.
+		u32  matched;			// Number of cached events matched.
+	};
+	// The cached take played by the audio thread, guarded by s_deviceChangeMutex.
+	struct CachePlayback
+	{
+		const CachedTake* take;	// Set by the midi thread, cleared by the audio thread once it stops playing it.
+		u64  start;				// Render position of the first sample of the take.
+		bool stop;				// Set by the midi thread to go back to live synthesis.
+		bool playing;			// The take replaces live synthesis.
+	};
+	enum
+	{
+		// The take is looked up in the cache after this many events, which are part of the key.
+		CACHE_KEY_EVENTS = 32,
+	};
+	static atomic_bool s_cacheEnabled;
+	static ChannelState s_channelState[MIDI_CHANNEL_COUNT];
+	static MidiDevice* s_stateDevice = nullptr;
+	static Take s_take = {};
+	static bool s_takeArmed = true;			// The next message starts a take.
+	static CachedTake* s_retiredTake = nullptr;	// Freed once the audio thread lets go of it.
+	static CachePlayback s_cachePlay = {};
+	static s32 s_cacheBlocks = 0;
+
 	int midiUpdateFunc(void* userData);
 	void stopAllNotes();
 	void changeVolume();
 	void allocateMidiDevice(MidiDeviceType type);
+	void syncEventTime();
+	void deviceMessage(const u8* msg, u32 len);
+	void cacheMessage(const u8* msg, u32 len);
+	void cacheEndTake(bool render);
+	void cacheUpdate();
 
 	// Console Functions
 	void setMusicVolumeConsole(const ConsoleArgList& args);
@@ -144,9 +208,13 @@ namespace TFE_MidiPlayer
 
 		CCMD("setMusicVolume", setMusicVolumeConsole, 1, "Sets the music volume, range is 0.0 to 1.0");
 		CCMD("getMusicVolume", getMusicVolumeConsole, 0, "Get the current music volume where 0 = silent, 1 = maximum.");
+		TFE_COUNTER(s_eventQueueDepth, "Midi Event Queue Depth");
+		TFE_COUNTER(s_eventsDropped, "Midi Events Dropped");
+		TFE_COUNTER(s_cacheBlocks, "Midi Cached Blocks");
 
 		TFE_Settings_Sound* soundSettings = TFE_Settings::getSoundSettings();
 		setVolume(soundSettings->musicVolume);
+		setCacheEnabled(soundSettings->midiCache);
 		setMaximumNoteLength();
 
 		return res && s_thread;
@@ -161,6 +229,14 @@ namespace TFE_MidiPlayer
 		s_runMusicThread.store(false);
 		SDL_WaitThread(s_thread, &i);
 
+		// The audio thread no longer plays cached takes once the midi thread is gone.
+		s_cachePlay = {};
+		freeTake(s_take.cached);
+		freeTake(s_retiredTake);
+		s_take.cached = nullptr;
+		s_retiredTake = nullptr;
+		TFE_MidiCache::destroy();
+
 		delete s_midiDevice;
 
 		SDL_DestroyMutex(s_midiThreadMutex);
@@ -254,6 +330,11 @@ namespace TFE_MidiPlayer
 		s_maxNoteLength = f64(dt);
 	}
 
+	void setCacheEnabled(bool enable)
+	{
+		s_cacheEnabled.store(enable);
+	}
+
 	void pauseThread()
 	{
 		if (!s_tPaused && s_midiThreadMutex)
@@ -305,6 +386,69 @@ namespace TFE_MidiPlayer
 		SDL_UnlockMutex(s_midiThreadMutex);
 	}
 
+	// Play the cached take instead of rendering, if there is one. The switch to and from live synthesis is crossfaded
+	// over one block and happens while at least one more block of the take is left.
+	// Called by the audio thread with s_deviceChangeMutex locked.
+	bool synthesizeCached(f32* buffer, u32 sampleCount)
+	{
+		CachePlayback& play = s_cachePlay;
+		if (!play.take) { return false; }
+
+		const u64 pos = s_midiDevice->getRenderPosition();
+		const u64 end = play.start + play.take->sampleCount;
+		const bool inRange = pos >= play.start && pos + sampleCount * 2 <= end;
+		const f32 gain = s_midiDevice->getQueuedVolume() / (c_cacheRenderVolume * 32767.0f);
+		const f32 fadeStep = 1.0f / f32(sampleCount);
+		const s16* src = inRange ? &play.take->samples[(pos - play.start) * 2] : nullptr;
+
+		if (!play.playing)
+		{
+			// The take was found before its first sample was rendered.
+			if (!play.stop && pos < play.start) { return false; }
+			if (play.stop || !inRange)
+			{
+				// The take was stopped or missed before it started.
+				play.take = nullptr;
+				return false;
+			}
+			s_midiDevice->render(buffer, sampleCount);
+			for (u32 i = 0; i < sampleCount; i++, buffer += 2, src += 2)
+			{
+				const f32 w = f32(i + 1) * fadeStep;
+				buffer[0] = buffer[0] * (1.0f - w) + f32(src[0]) * gain * w;
+				buffer[1] = buffer[1] * (1.0f - w) + f32(src[1]) * gain * w;
+			}
+			// The take plays the notes from here on.
+			s_midiDevice->releaseHeldNotes();
+			play.playing = true;
+			return true;
+		}
+
+		if (play.stop || !inRange)
+		{
+			// Back to live synthesis, the notes held in the take start again.
+			s_midiDevice->restoreHeldNotes();
+			s_midiDevice->render(buffer, sampleCount);
+			for (u32 i = 0; src && i < sampleCount; i++, buffer += 2, src += 2)
+			{
+				const f32 w = f32(i + 1) * fadeStep;
+				buffer[0] = buffer[0] * w + f32(src[0]) * gain * (1.0f - w);
+				buffer[1] = buffer[1] * w + f32(src[1]) * gain * (1.0f - w);
+			}
+			play.take = nullptr;
+			play.playing = false;
+			return true;
+		}
+
+		s_midiDevice->skipEvents(sampleCount);
+		for (u32 i = 0; i < sampleCount * 2; i++)
+		{
+			buffer[i] = f32(src[i]) * gain;
+		}
+		s_cacheBlocks++;
+		return true;
+	}
+
 	void synthesizeMidi(f32* buffer, u32 stereoSampleCount, bool updateBuffer)
 	{
 		// In some cases, such as when using the System Midi Device, the midi audio is generated externally so
@@ -322,7 +466,10 @@ namespace TFE_MidiPlayer
 			}
 
 			// The midi device takes the number of stereo samples.
-			s_midiDevice->render(s_sampleBufferPtr, stereoSampleCount);
+			if (!synthesizeCached(s_sampleBufferPtr, stereoSampleCount))
+			{
+				s_midiDevice->render(s_sampleBufferPtr, stereoSampleCount);
+			}
 			// Accumulate midi samples with existing audio samples (from soundFX).
 			if (updateBuffer)
 			{
@@ -367,17 +514,75 @@ namespace TFE_MidiPlayer
 	//////////////////////////////////////////////////
 	// Internal
 	//////////////////////////////////////////////////
+	// Keep the event time inside of [renderPos, renderPos + 3 blocks], resyncing to one block ahead if it drifts out.
+	// This happens on the first message, when the audio thread stalls or stops rendering (pause) and on slow clock drift.
+	void syncEventTime()
+	{
+		if (!s_midiDevice || !s_midiDevice->canRender()) { return; }
+
+		const f64 renderPos = f64(s_midiDevice->getRenderPosition());
+		const f64 blockSize = f64(s_midiDevice->getRenderBlockSize());
+		if (s_eventTime < renderPos || s_eventTime > renderPos + blockSize * 3.0)
+		{
+			s_eventTime = renderPos + blockSize;
+		}
+		s_eventQueueDepth = s32(s_midiDevice->getQueuedEventCount());
+	}
+
+	void deviceMessage(const u8* msg, u32 len)
+	{
+		if (!s_midiDevice) { return; }
+		if (!s_midiDevice->canRender())
+		{
+			s_midiDevice->message(msg, len);
+			return;
+		}
+		// Check the message against the cached take before it is queued, so the audio thread is back to live synthesis first.
+		cacheMessage(msg, len);
+		if (!s_midiDevice->queueMessage(u64(s_eventTime), msg, len))
+		{
+			s_eventsDropped++;
+		}
+	}
+
+	void deviceNoteAllOff()
+	{
+		if (!s_midiDevice) { return; }
+		if (!s_midiDevice->canRender())
+		{
+			s_midiDevice->noteAllOff();
+		}
+		else if (!s_midiDevice->queueNoteAllOff(u64(s_eventTime)))
+		{
+			s_eventsDropped++;
+		}
+	}
+
+	void deviceSetVolume(f32 volume)
+	{
+		if (!s_midiDevice) { return; }
+		if (!s_midiDevice->canRender())
+		{
+			s_midiDevice->setVolume(volume);
+		}
+		else if (!s_midiDevice->queueVolume(u64(s_eventTime), volume))
+		{
+			s_eventsDropped++;
+		}
+	}
+
 	void changeVolume()
 	{
 		if (s_midiDevice && s_midiDevice->hasGlobalVolumeCtrl())
 		{
-			s_midiDevice->setVolume(s_masterVolumeScaled);
+			deviceSetVolume(s_masterVolumeScaled);
 		}
 		else if (s_midiDevice)
 		{
 			for (u32 i = 0; i < MIDI_CHANNEL_COUNT; i++)
 			{
-				s_midiDevice->message(MID_CONTROL_CHANGE + i, MID_VOLUME_MSB, u8(s_channelSrcVolume[i] * s_masterVolumeScaled));
+				const u8 msg[] = { u8(MID_CONTROL_CHANGE + i), MID_VOLUME_MSB, u8(s_channelSrcVolume[i] * s_masterVolumeScaled) };
+				deviceMessage(msg, 3);
 			}
 		}
 	}
@@ -397,7 +602,8 @@ namespace TFE_MidiPlayer
 				if (s_instrOn[i].channelMask & channelMask)
 				{
 					// Turn off the note.
-					if (s_midiDevice) { s_midiDevice->message(MID_NOTE_OFF | c, i); }
+					const u8 msg[] = { u8(MID_NOTE_OFF | c), u8(i), 0 };
+					deviceMessage(msg, 3);
 
 					// Reset the instrument channel information.
 					s_instrOn[i].channelMask &= ~channelMask;
@@ -406,10 +612,267 @@ namespace TFE_MidiPlayer
 			}
 		}
 
-		if (s_midiDevice) { s_midiDevice->noteAllOff(); }
+		deviceNoteAllOff();
 		memset(s_instrOn, 0, sizeof(Instrument) * MIDI_INSTRUMENT_COUNT);
 		s_curNoteTime = 0.0;
 	}
+
+	//////////////////////////////////////////////////
+	// Music Cache
+	// Called from the midi thread.
+	//////////////////////////////////////////////////
+	void cacheResetChannelState()
+	{
+		for (u32 c = 0; c < MIDI_CHANNEL_COUNT; c++)
+		{
+			s_channelState[c].program = -1;
+			s_channelState[c].pitchBend = -1;
+			for (s32 i = 0; i < MID_ALL_SOUND_OFF; i++)
+			{
+				s_channelState[c].control[i] = -1;
+			}
+		}
+	}
+
+	void cacheTrackChannelState(const u8* msg, u32 len)
+	{
+		ChannelState* state = &s_channelState[msg[0] & 0x0f];
+		switch (msg[0] & 0xf0)
+		{
+			case MID_CONTROL_CHANGE:
+			{
+				if (len < 3) { break; }
+				if (msg[1] == MID_ALL_CTRL_OFF)
+				{
+					for (s32 i = 0; i < MID_ALL_SOUND_OFF; i++)
+					{
+						state->control[i] = -1;
+					}
+				}
+				else if (msg[1] < MID_ALL_SOUND_OFF)
+				{
+					state->control[msg[1]] = msg[2];
+				}
+			} break;
+			case MID_PROGRAM_CHANGE:
+			{
+				state->program = msg[1];
+			} break;
+			case MID_PITCH_BEND:
+			{
+				if (len < 3) { break; }
+				state->pitchBend = s16(msg[1] | (msg[2] << 7));
+			} break;
+		}
+	}
+
+	CacheEvent cacheGetEvent(u32 time, const u8* msg, u32 len)
+	{
+		CacheEvent evt = {};
+		evt.time = time;
+		evt.type = MIDI_EVENT_MESSAGE;
+		evt.len  = u8(std::min(len, 3u));
+		for (u32 i = 0; i < evt.len; i++)
+		{
+			evt.msg[i] = msg[i];
+		}
+		return evt;
+	}
+
+	void cacheBeginTake()
+	{
+		s_take.active = true;
+		s_take.recording = true;
+		s_take.keyed = false;
+		s_take.time = 0.0;
+		s_take.result = CACHE_PENDING;
+		s_take.prelude.clear();
+		s_take.events.clear();
+		s_take.cached = nullptr;
+		s_take.published = false;
+		s_take.matched = 0;
+
+		// The channel state left by earlier takes, a new device rendering the take starts with the parts it depends on.
+		for (u32 c = 0; c < MIDI_CHANNEL_COUNT; c++)
+		{
+			const ChannelState* state = &s_channelState[c];
+			for (s32 i = 0; i < MID_ALL_SOUND_OFF; i++)
+			{
+				if (state->control[i] < 0) { continue; }
+				const u8 msg[] = { u8(MID_CONTROL_CHANGE | c), u8(i), u8(state->control[i]) };
+				s_take.prelude.push_back(cacheGetEvent(0, msg, 3));
+			}
+			if (state->program >= 0)
+			{
+				const u8 msg[] = { u8(MID_PROGRAM_CHANGE | c), u8(state->program) };
+				s_take.prelude.push_back(cacheGetEvent(0, msg, 2));
+			}
+			if (state->pitchBend >= 0)
+			{
+				const u8 msg[] = { u8(MID_PITCH_BEND | c), u8(state->pitchBend & 0x7f), u8(state->pitchBend >> 7) };
+				s_take.prelude.push_back(cacheGetEvent(0, msg, 3));
+			}
+		}
+	}
+
+	void cacheEndTake(bool render)
+	{
+		if (!s_take.active) { return; }
+		s_take.active = false;
+
+		if (s_take.cached)
+		{
+			bool freeNow = true;
+			if (s_take.published)
+			{
+				SDL_LockMutex(s_deviceChangeMutex);
+				if (s_cachePlay.take == s_take.cached)
+				{
+					// The audio thread fades the take out and then lets go of it.
+					if (s_cachePlay.playing) { s_cachePlay.stop = true; freeNow = false; }
+					else { s_cachePlay.take = nullptr; }
+				}
+				SDL_UnlockMutex(s_deviceChangeMutex);
+			}
+			if (freeNow) { freeTake(s_take.cached); }
+			else { s_retiredTake = s_take.cached; }
+			s_take.cached = nullptr;
+			s_take.published = false;
+		}
+
+		const u64 length = std::min(u64(s_take.time), u64(CACHE_MAX_TAKE_SAMPLES));
+		if (render && s_take.recording && s_take.result == CACHE_MISSING && length >= CACHE_MIN_TAKE_SAMPLES && s_midiDevice)
+		{
+			renderTake(s_take.key, s_midiDevice, std::move(s_take.prelude), std::move(s_take.events), u32(length));
+		}
+		s_take.prelude.clear();
+		s_take.events.clear();
+		s_take.recording = false;
+	}
+
+	void cacheMessage(const u8* msg, u32 len)
+	{
+		// A new device starts from the default state.
+		if (s_midiDevice != s_stateDevice)
+		{
+			if (s_take.active)
+			{
+				cacheEndTake(false);
+				s_takeArmed = false;
+			}
+			cacheResetChannelState();
+			s_stateDevice = s_midiDevice;
+		}
+		// Devices without global volume control scale the channel volume messages, so the takes would depend on the volume.
+		if (!s_cacheEnabled.load() || !s_midiDevice->hasGlobalVolumeCtrl())
+		{
+			cacheEndTake(false);
+			cacheTrackChannelState(msg, len);
+			return;
+		}
+		if (!s_take.active && s_takeArmed)
+		{
+			s_takeArmed = false;
+			cacheBeginTake();
+		}
+		cacheTrackChannelState(msg, len);
+		if (!s_take.active) { return; }
+
+		if (s_take.time >= f64(CACHE_MAX_TAKE_SAMPLES))
+		{
+			// The take is longer than the cache stores.
+			cacheEndTake(true);
+			return;
+		}
+
+		const CacheEvent evt = cacheGetEvent(u32(s_take.time), msg, len);
+		if (s_take.cached)
+		{
+			if (s_take.matched >= s_take.cached->events.size() || !eventsMatch(s_take.cached->events[s_take.matched], evt))
+			{
+				// The music went another way (hooks, fades, triggers), continue with live synthesis.
+				cacheEndTake(false);
+				return;
+			}
+			s_take.matched++;
+		}
+		if (s_take.recording)
+		{
+			s_take.events.push_back(evt);
+			if (!s_take.keyed && s_take.events.size() >= CACHE_KEY_EVENTS)
+			{
+				s_take.key = getKey(s_midiDevice, s_take.events.data(), u32(s_take.events.size()));
+				s_take.keyed = true;
+				requestTake(s_take.key);
+			}
+		}
+	}
+
+	void cacheUpdate()
+	{
+		if (s_retiredTake)
+		{
+			SDL_LockMutex(s_deviceChangeMutex);
+			const bool released = s_cachePlay.take != s_retiredTake;
+			SDL_UnlockMutex(s_deviceChangeMutex);
+			if (released)
+			{
+				freeTake(s_retiredTake);
+				s_retiredTake = nullptr;
+			}
+		}
+		if (!s_take.active) { return; }
+		if (!s_cacheEnabled.load())
+		{
+			cacheEndTake(false);
+			return;
+		}
+
+		if (s_take.keyed && s_take.result == CACHE_PENDING)
+		{
+			CachedTake* cached = nullptr;
+			s_take.result = receiveTake(s_take.key, &cached);
+			if (s_take.result == CACHE_READY)
+			{
+				// The key only covers the first events, check everything played so far.
+				const size_t count = s_take.events.size();
+				bool match = count <= cached->events.size() && preludeMatches(cached, s_take.prelude);
+				for (size_t i = 0; i < count && match; i++)
+				{
+					match = eventsMatch(s_take.events[i], cached->events[i]);
+				}
+				if (match)
+				{
+					s_take.cached = cached;
+					s_take.matched = u32(count);
+				}
+				else
+				{
+					freeTake(cached);
+				}
+				// Either way the key is taken, so this take is not rendered.
+				s_take.recording = false;
+				s_take.prelude.clear();
+				s_take.events.clear();
+			}
+		}
+
+		// Hand the take to the audio thread, once the previous one is released.
+		if (s_take.cached && !s_take.published && !s_retiredTake)
+		{
+			SDL_LockMutex(s_deviceChangeMutex);
+			if (!s_cachePlay.take)
+			{
+				s_cachePlay.take = s_take.cached;
+				// Map the take onto the current event time, the audio thread goes back to live synthesis if it drifts.
+				s_cachePlay.start = u64(s_eventTime) - std::min(u64(s_take.time), u64(s_eventTime));
+				s_cachePlay.stop = false;
+				s_cachePlay.playing = false;
+				s_take.published = true;
+			}
+			SDL_UnlockMutex(s_deviceChangeMutex);
+		}
+	}
 		
 	void sendMessageDirect(u8 type, u8 arg1, u8 arg2)
 	{
@@ -425,7 +888,7 @@ namespace TFE_MidiPlayer
 			s_channelSrcVolume[channelIndex] = arg2;
 			msg[2] = u8(s_channelSrcVolume[channelIndex] * s_masterVolumeScaled);
 		}
-		if (s_midiDevice) { s_midiDevice->message(msg, len); }
+		deviceMessage(msg, len);
 
 		// Record currently playing instruments and the note-on times.
 		if (msgType == MID_NOTE_OFF || msgType == MID_NOTE_ON)
@@ -480,9 +943,11 @@ namespace TFE_MidiPlayer
 		u64 localTime = 0;
 		u64 localTimeCallback = 0;
 		f64 dt = 0.0;
+		TFE_Profiler::setThreadName("MIDI");
 		while (runThread)
 		{
 			SDL_LockMutex(s_midiThreadMutex);
+			syncEventTime();
 						
 			// Read from the command buffer.
 			MidiCmd* midiCmd = s_midiCmdBuffer;
@@ -495,6 +960,9 @@ namespace TFE_MidiPlayer
 						localTimeCallback = 0;
 						isPaused = true;
 						stopAllNotes();
+						// Music resumes in the middle of the take, which is not worth caching.
+						cacheEndTake(false);
+						s_takeArmed = false;
 					} break;
 					case MIDI_RESUME:
 					{
@@ -509,6 +977,8 @@ namespace TFE_MidiPlayer
 					case MIDI_STOP_NOTES:
 					{
 						stopAllNotes();
+						cacheEndTake(true);
+						s_takeArmed = true;
 						// Reset callback time.
 						localTimeCallback = 0;
 						s_midiCallback.accumulator = 0.0;
@@ -523,14 +993,20 @@ namespace TFE_MidiPlayer
 				s_midiCallback.accumulator += TFE_System::updateThreadLocal(&localTimeCallback);
 				while (s_midiCallback.callback && s_midiCallback.accumulator >= s_midiCallback.timeStep)
 				{
+					TFE_ZONE("Midi Callback");
 					s_midiCallback.callback();
 					s_midiCallback.accumulator -= s_midiCallback.timeStep;
 					s_curNoteTime += s_midiCallback.timeStep;
+					// Messages from the next callback land one time step later, even if several callbacks run back to back.
+					s_eventTime += s_midiCallback.timeStep * c_midiSampleRate;
+					s_take.time += s_midiCallback.timeStep * c_midiSampleRate;
+					syncEventTime();
 				}
 
 				// Check for hanging notes.
 				detectHangingNotes();
 			}
+			cacheUpdate();
 
 			SDL_UnlockMutex(s_midiThreadMutex);
 			runThread = s_runMusicThread.load();
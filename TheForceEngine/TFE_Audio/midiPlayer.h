@@ -23,6 +23,8 @@ namespace TFE_MidiPlayer
 	void setVolume(f32 volume);
 	// Set the maximum length in seconds that a note is allowed to play for in seconds.
 	void setMaximumNoteLength(f32 dt = 16.0f);
+	// Play synthesized music from the disk cache when possible, and add music that is not cached (see midiCache.h).
+	void setCacheEnabled(bool enable);
 
 	// Send a direct midi message.
 	// Note: this should be called from the midi thread.
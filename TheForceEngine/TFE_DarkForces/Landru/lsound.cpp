@@ -280,28 +280,29 @@ namespace TFE_DarkForces
 		}
 	}
 
-	u8* readVocFileData(const char* name, u32* sizeOut)
+	bool findVocFile(const char* name, FilePath* path)
 	{
-		FilePath path;
 		if (strstr(name, ".voc") || strstr(name, ".VOC"))
 		{
-			if (!TFE_Paths::getFilePath(name, &path))
-			{
-				return nullptr;
-			}
+			return TFE_Paths::getFilePath(name, path);
 		}
-		else
+
+		char fileName[TFE_MAX_PATH];
+		sprintf(fileName, "%s.VOIC", name);	// Prefer the version of a sound from the LFD.
+		if (!TFE_Paths::getFilePath(fileName, path))
 		{
-			char fileName[TFE_MAX_PATH];
-			sprintf(fileName, "%s.VOIC", name);	// Prefer the version of a sound from the LFD.
-			if (!TFE_Paths::getFilePath(fileName, &path))
-			{
-				sprintf(fileName, "%s.VOC", name);
-				if (!TFE_Paths::getFilePath(fileName, &path))
-				{
-					return nullptr;
-				}
-			}
+			sprintf(fileName, "%s.VOC", name);
+			return TFE_Paths::getFilePath(fileName, path);
+		}
+		return true;
+	}
+
+	u8* readVocFileData(const char* name, u32* sizeOut)
+	{
+		FilePath path;
+		if (!findVocFile(name, &path))
+		{
+			return nullptr;
 		}
 		FileStream file;
 		if (!file.open(&path, Stream::MODE_READ))
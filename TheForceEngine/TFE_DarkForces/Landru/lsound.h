@@ -56,6 +56,8 @@ struct LSound
 	u8* data;
 };
 
+struct FilePath;
+
 namespace TFE_DarkForces
 {
 	// System
@@ -92,4 +94,5 @@ namespace TFE_DarkForces
 	void  setSoundName(LSound* sound, u32 type, const char* name);
 
 	u8* readVocFileData(const char* name, u32* size = nullptr);
+	bool findVocFile(const char* name, FilePath* path);
 }  // namespace TFE_Jedi
\ No newline at end of file
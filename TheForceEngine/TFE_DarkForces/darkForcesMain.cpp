@@ -475,6 +475,11 @@ namespace TFE_DarkForces
 		strcpy(modList, s_sharedState.customGobName);
 	}
 
+	void DarkForces::showMessage(const char* msg)
+	{
+		hud_sendTextMessage(msg, 0);
+	}
+
 	/**********The basic structure of the Dark Forces main loop is as follows:***************
 	while (1)  // <- This will be replaced by the function call from the main TFE loop.
 	{
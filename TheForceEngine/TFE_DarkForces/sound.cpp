@@ -14,7 +14,13 @@
 #include <TFE_Jedi/Memory/allocator.h>
 #include <TFE_Jedi/Serialization/serialization.h>
 #include <TFE_DarkForces/time.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/paths.h>
 #include <TFE_System/system.h>
+#include <TFE_System/parallel.h>
+#include <TFE_System/profiler.h>
+#include <string>
+#include <unordered_map>
 
 namespace TFE_DarkForces
 {
@@ -54,6 +60,17 @@ namespace TFE_DarkForces
 	static SoundState sound_state = {};
 	s32 s_lastMaintainVolume;
 
+	// TFE: Sound data read ahead of time by sound_preload().
+	struct StagedSound
+	{
+		const u8* fileView;		// File data in a memory mapped archive, copied into 'data' on the worker threads.
+		u8* data;
+		u32 size;
+	};
+	typedef std::unordered_map<std::string, s32> StagedSoundTable;
+	static std::vector<StagedSound> s_stagedSounds;
+	static StagedSoundTable s_stagedSoundTable;
+
 	SoundEffectId soundInstance(SoundSourceId soundId, s32 instance);
 	GameSound* getSoundPtr(SoundSourceId id);
 	void soundCalculateCue(GameSound* sound, fixed16_16 x, fixed16_16 y, fixed16_16 z, s32* vol, s32* pan);
@@ -193,7 +210,21 @@ namespace TFE_DarkForces
 		}
 
 		u32 size = 0;
-		u8* data = readVocFileData(fileName, &size);
+		u8* data = nullptr;
+		// TFE: Use the result of sound_preload() if available.
+		StagedSoundTable::iterator iStaged = s_stagedSoundTable.find(fileName);
+		if (iStaged != s_stagedSoundTable.end())
+		{
+			StagedSound* staged = &s_stagedSounds[iStaged->second];
+			data = staged->data;
+			size = staged->size;
+			staged->data = nullptr;
+			s_stagedSoundTable.erase(iStaged);
+		}
+		else
+		{
+			data = readVocFileData(fileName, &size);
+		}
 		if (data)
 		{
 			sound = (GameSound*)allocator_newItem(sound_state.gameSoundList);
@@ -213,6 +244,77 @@ namespace TFE_DarkForces
 		return newId;
 	}
 
+	static void sound_preloadTask(s32 index, void* userData)
+	{
+		StagedSound* staged = &s_stagedSounds[index];
+		if (staged->fileView)
+		{
+			memcpy(staged->data, staged->fileView, staged->size);
+		}
+	}
+
+	void sound_preload(const char* const* names, s32 count)
+	{
+		TFE_ZONE("Sound Preload");
+		sound_clearPreloaded();
+
+		for (s32 i = 0; i < count; i++)
+		{
+			const char* name = names[i];
+			if (s_stagedSoundTable.find(name) != s_stagedSoundTable.end()) { continue; }
+
+			GameSound* sound = (GameSound*)allocator_getHead(sound_state.gameSoundList);
+			while (sound && strcasecmp(name, sound->name))
+			{
+				sound = (GameSound*)allocator_getNext(sound_state.gameSoundList);
+			}
+			if (sound) { continue; }
+
+			FilePath filePath;
+			if (!findVocFile(name, &filePath))
+			{
+				continue;
+			}
+			// The memory is allocated here since the game region is not thread safe, only the copy is done on the workers.
+			// Archives that are not memory mapped can only be read serially, so those are read directly.
+			StagedSound staged = {};
+			size_t size = 0;
+			staged.fileView = FileStream::getMappedContents(&filePath, &size);
+			if (staged.fileView)
+			{
+				staged.size = (u32)size;
+				staged.data = (u8*)game_alloc(size);
+			}
+			else
+			{
+				staged.data = readVocFileData(name, &staged.size);
+			}
+			if (!staged.data)
+			{
+				continue;
+			}
+
+			s_stagedSoundTable[name] = (s32)s_stagedSounds.size();
+			s_stagedSounds.push_back(staged);
+		}
+		TFE_Parallel::run((s32)s_stagedSounds.size(), sound_preloadTask, nullptr);
+	}
+
+	void sound_clearPreloaded()
+	{
+		// Free anything that was read but never loaded.
+		const size_t count = s_stagedSounds.size();
+		for (size_t i = 0; i < count; i++)
+		{
+			if (s_stagedSounds[i].data)
+			{
+				game_free(s_stagedSounds[i].data);
+			}
+		}
+		s_stagedSounds.clear();
+		s_stagedSoundTable.clear();
+	}
+
 	void sound_free(SoundSourceId id)
 	{
 		if (id)
@@ -65,6 +65,9 @@ namespace TFE_DarkForces
 
 	// Load a sound source from disk.
 	SoundSourceId sound_load(const char* sound, u32 priority = SOUND_PRIORITY_MED0);
+	// TFE: Read sound files from memory mapped archives on the worker threads, sound_load() then uses the data.
+	void sound_preload(const char* const* names, s32 count);
+	void sound_clearPreloaded();
 	void sound_free(SoundSourceId id);
 	// Change the sound source base volume, range: [0, 127]
 	void sound_setBaseVolume(SoundSourceId soundId, s32 volume);
@@ -30,6 +30,7 @@ namespace LevelEditor
 {
 	static char s_scriptBuffer[4096];
 	static std::vector<std::string> s_scriptsToRun;
+	static std::vector<std::string> s_scriptsToPrecompile;
 
 	bool s_levelScriptRegistered = false;
 	bool s_execFromOutput = false;
@@ -104,6 +105,11 @@ namespace LevelEditor
 		s_scriptsToRun.push_back(scriptName);
 	}
 
+	void precompileLevelScript(const char* scriptName)
+	{
+		s_scriptsToPrecompile.push_back(scriptName);
+	}
+
 	void showLevelScript(const char* scriptName)
 	{
 		char scriptPath[TFE_MAX_PATH];
@@ -141,6 +147,22 @@ namespace LevelEditor
 			}
 		}
 		s_scriptsToRun.clear();
+
+		const s32 precompileCount = (s32)s_scriptsToPrecompile.size();
+		scriptName = s_scriptsToPrecompile.data();
+		for (s32 i = 0; i < precompileCount; i++, scriptName++)
+		{
+			sprintf(scriptPath, "EditorDef/Scripts/%s.fs", scriptName->c_str());
+			if (TFE_ForceScript::precompileModule(scriptPath))
+			{
+				infoPanelAddMsg(LE_MSG_INFO, "Precompiled script '%s'.", scriptName->c_str());
+			}
+			else
+			{
+				infoPanelAddMsg(LE_MSG_ERROR, "Failed to precompile script '%s'.", scriptName->c_str());
+			}
+		}
+		s_scriptsToPrecompile.clear();
 	}
 }
 #else
@@ -151,6 +173,7 @@ namespace LevelEditor
 	void executeLine(const char* line) {}
 	void runLevelScript(const char* scriptName) {}
 	void showLevelScript(const char* scriptName) {}
+	void precompileLevelScript(const char* scriptName) {}
 
 	void levelScript_update() {}
 }
@@ -15,6 +15,8 @@ namespace LevelEditor
 	void executeLine(const char* line);
 	void runLevelScript(const char* scriptName);
 	void showLevelScript(const char* scriptName);
+	// Save the script bytecode as "EditorDef/Scripts/<scriptName>.fsb", which is loaded in place of the source.
+	void precompileLevelScript(const char* scriptName);
 
 	void levelScript_update();
 }
@@ -173,6 +173,11 @@ namespace LevelEditor
 		showLevelScript(scriptName.c_str());
 	}
 
+	void LS_System::precompileScript(std::string& scriptName)
+	{
+		precompileLevelScript(scriptName.c_str());
+	}
+
 	bool LS_System::scriptRegister(asIScriptEngine* engine)
 	{
 		s32 res = 0;
@@ -200,6 +205,7 @@ namespace LevelEditor
 		res = engine->RegisterObjectMethod("System", "void clearOutput()", asMETHOD(LS_System, clearOutput), asCALL_THISCALL);  assert(res >= 0);
 		res = engine->RegisterObjectMethod("System", "void runScript(const string &in)", asMETHOD(LS_System, runScript), asCALL_THISCALL);  assert(res >= 0);
 		res = engine->RegisterObjectMethod("System", "void showScript(const string &in)", asMETHOD(LS_System, showScript), asCALL_THISCALL);  assert(res >= 0);
+		res = engine->RegisterObjectMethod("System", "void precompileScript(const string &in)", asMETHOD(LS_System, precompileScript), asCALL_THISCALL);  assert(res >= 0);
 
 		// Script variable.
 		res = engine->RegisterGlobalProperty("System system", this);  assert(res >= 0);
@@ -27,6 +27,7 @@ namespace LevelEditor
 		void clearOutput();
 		void runScript(std::string& scriptName);
 		void showScript(std::string& scriptName);
+		void precompileScript(std::string& scriptName);
 		// System
 		bool scriptRegister(asIScriptEngine* engine) override;
 	};
@@ -462,7 +462,7 @@ namespace LevelEditor
 		return true;
 	}
 
-	void writeVariableValueBinary(const EntityVar* var, FileStream* file)
+	void writeVariableValueBinary(const EntityVar* var, Stream* file)
 	{
 		const EntityVarDef* def = &s_varDefList[var->defId];
 		switch (def->type)
@@ -530,7 +530,7 @@ namespace LevelEditor
 	}
 
 	// Write entity data out to a binary buffer.
-	bool writeEntityVarListBinary(const std::vector<EntityVar>* varList, FileStream* file)
+	bool writeEntityVarListBinary(const std::vector<EntityVar>* varList, Stream* file)
 	{
 		if (!varList || !file) { return false; }
 
@@ -563,7 +563,7 @@ namespace LevelEditor
 		return true;
 	}
 
-	bool writeEntityDataBinary(const Entity* entity, FileStream* file)
+	bool writeEntityDataBinary(const Entity* entity, Stream* file)
 	{
 		file->write(&entity->name);
 		s32 type = s32(entity->type);
@@ -182,7 +182,7 @@ namespace LevelEditor
 	bool loadLogicData(const char* localDir);
 
 	bool writeEntityDataToString(const Entity* entity, char* buffer, size_t bufferSize);
-	bool writeEntityDataBinary(const Entity* entity, FileStream* file);
+	bool writeEntityDataBinary(const Entity* entity, Stream* file);
 	bool readEntityDataBinary(FileStream* file, Entity* entity, s32 version);
 
 	void saveProjectEntityList();
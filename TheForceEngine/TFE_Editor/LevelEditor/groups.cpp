@@ -138,7 +138,7 @@ namespace LevelEditor
 		groups_buildIndexMap();
 	}
 
-	void groups_saveBinary(FileStream& file)
+	void groups_saveBinary(Stream& file)
 	{
 		const u32 count = (u32)s_groups.size();
 		file.write(&s_groupCurrent);
@@ -34,7 +34,7 @@ namespace LevelEditor
 
 	void groups_init();
 	void groups_loadBinary(FileStream& file, u32 version);
-	void groups_saveBinary(FileStream& file);
+	void groups_saveBinary(Stream& file);
 	void groups_swapSectorGroupID(u32 srcId, u32 dstId);
 
 	void groups_loadFromSnapshot();
@@ -23,6 +23,7 @@
 #include "editNotes.h"
 #include "editTransforms.h"
 #include "userPreferences.h"
+#include "sectorBvh.h"
 #include <TFE_FrontEndUI/frontEndUi.h>
 #include <TFE_Editor/AssetBrowser/assetBrowser.h>
 #include <TFE_Asset/imageAsset.h>
@@ -164,6 +165,10 @@ namespace LevelEditor
 	};
 	static TextureGpu* s_boolToolbarData = nullptr;
 	static TextureGpu* s_levelNoteIcon = nullptr;
+	// Autosave
+	static f64 s_lastAutosaveTime = 0.0;
+	static u32 s_autosaveHistoryCount = 0;
+	static s32 s_autosaveHistoryPos = 0;
 
 	////////////////////////////////////////////////////////
 	// Forward Declarations
@@ -490,6 +495,7 @@ namespace LevelEditor
 
 		// Then erase the sector.
 		s_level.sectors.erase(s_level.sectors.begin() + sectorId);
+		sectorBvh_invalidate();
 
 		// Finally fix-up any references.
 		sectorCount = (s32)s_level.sectors.size();
@@ -2103,6 +2109,36 @@ namespace LevelEditor
 	{
 		s_outputHeight = infoPanelOutput(s_viewportSize.x + 16);
 	}
+
+	void updateAutosave()
+	{
+		const f64 time = TFE_System::getTime();
+		if (s_lastAutosaveTime == 0.0)
+		{
+			s_lastAutosaveTime = time;
+			s_autosaveHistoryCount = history_getItemCount();
+			s_autosaveHistoryPos = history_getPos();
+			return;
+		}
+		if (s_editorConfig.autosaveInterval <= 0 || time - s_lastAutosaveTime < f64(s_editorConfig.autosaveInterval))
+		{
+			return;
+		}
+		s_lastAutosaveTime = time;
+
+		// Only autosave if the level has changed since the last autosave.
+		const u32 historyCount = history_getItemCount();
+		const s32 historyPos = history_getPos();
+		if (historyCount == s_autosaveHistoryCount && historyPos == s_autosaveHistoryPos)
+		{
+			return;
+		}
+		if (autosaveLevel())
+		{
+			s_autosaveHistoryCount = historyCount;
+			s_autosaveHistoryPos = historyPos;
+		}
+	}
 	
 	void edit_setEditMode(LevelEditMode mode)
 	{
@@ -2132,6 +2168,8 @@ namespace LevelEditor
 		updateWindowControls();
 		handleEditorActions();
 		updateOutput();
+		updateSaveStatus();
+		updateAutosave();
 
 		u32 viewportRenderFlags = 0u;
 		if (s_drawActions & DRAW_ACTION_CURVE)
@@ -6,6 +6,7 @@
 #include "error.h"
 #include "shell.h"
 #include "levelEditorInf.h"
+#include "sectorBvh.h"
 #include "sharedState.h"
 #include <TFE_Editor/snapshotReaderWriter.h>
 #include <TFE_Editor/history.h>
@@ -33,7 +34,9 @@
 #include <TFE_System/system.h>
 #include <TFE_Settings/settings.h>
 #include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/filewriterAsync.h>
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/memorystream.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_Archive/archive.h>
 #include <TFE_RenderBackend/renderBackend.h>
@@ -42,10 +45,12 @@
 #include <TFE_Ui/ui.h>
 
 #include <climits>
+#include <cstdio>
 #include <algorithm>
 #include <vector>
 #include <string>
 #include <map>
+#include <mutex>
 
 using namespace TFE_Editor;
 using namespace TFE_Jedi;
@@ -91,6 +96,7 @@ namespace LevelEditor
 
 	static s32 s_curSnapshotId = -1;
 	static EditorLevel s_curSnapshot;
+	static std::vector<s32> s_bvhCandidates;
 
 	EditorLevel s_level = {};
 
@@ -514,6 +520,7 @@ namespace LevelEditor
 
 		// Clear notes.
 		s_level.notes.clear();
+		sectorBvh_invalidate();
 
 		// First check to see if there is a "tfl" version of the level.
 		if (loadFromTFL(slotName))
@@ -877,6 +884,8 @@ namespace LevelEditor
 		}
 		char filePath[TFE_MAX_PATH];
 		sprintf(filePath, "%s/%s.tfl", project->path, name);
+		// Make sure a pending save has been written.
+		FileWriterAsync::flush();
 
 		// Then try to open it based on the path, if it fails load the LEV file.
 		FileStream file;
@@ -1088,27 +1097,9 @@ namespace LevelEditor
 		return true;
 	}
 			
-	// Save in the binary editor format.
-	bool saveLevel()
+	// Serialize the level in the binary editor format.
+	static void writeLevelBinary(Stream& file)
 	{
-		Project* project = project_get();
-		if (!project)
-		{
-			LE_ERROR("Cannot save if no project is open.");
-			return false;
-		}
-
-		char filePath[TFE_MAX_PATH];
-		sprintf(filePath, "%s/%s.tfl", project->path, s_level.slot.c_str());
-		LE_INFO("Saving level to '%s'", filePath);
-
-		FileStream file;
-		if (!file.open(filePath, FileStream::MODE_WRITE))
-		{
-			LE_ERROR("Cannot open '%s' for writing.", filePath);
-			return false;
-		}
-
 		// Version.
 		const u32 version = LEF_CurVersion;
 		file.write(&version);
@@ -1237,10 +1228,121 @@ namespace LevelEditor
 			file.write(&guideline->minHeight);
 			file.write(&guideline->maxSnapRange);
 		}
+	}
+
+	// The result of a save written on the file writer thread, reported to the info panel by updateSaveStatus().
+	struct SaveResult
+	{
+		char path[TFE_MAX_PATH];
+		u32 errorCode;
+	};
+	static std::mutex s_saveResultMutex;
+	static std::vector<SaveResult> s_saveResults;
+
+	// Called on the file writer thread.
+	static void saveComplete(size_t bytesWritten, void* userData, u32 errorCode)
+	{
+		SaveResult* result = (SaveResult*)userData;
+		result->errorCode = errorCode;
+		{
+			std::lock_guard<std::mutex> lock(s_saveResultMutex);
+			s_saveResults.push_back(*result);
+		}
+		delete result;
+	}
+
+	// Save in the binary editor format.
+	bool saveLevel()
+	{
+		Project* project = project_get();
+		if (!project)
+		{
+			LE_ERROR("Cannot save if no project is open.");
+			return false;
+		}
+
+		char filePath[TFE_MAX_PATH];
+		sprintf(filePath, "%s/%s.tfl", project->path, s_level.slot.c_str());
+		LE_INFO("Saving level to '%s'", filePath);
+
+		// Serialize into memory, the file itself is written on the file writer thread.
+		MemoryStream file;
+		file.open(Stream::MODE_WRITE);
+		writeLevelBinary(file);
+		file.close();
+
+		SaveResult* result = new SaveResult;
+		strcpy(result->path, filePath);
+		if (!FileWriterAsync::writeFileToDisk(filePath, (u8*)file.data(), file.getSize(), saveComplete, result))
+		{
+			delete result;
+			LE_ERROR("Cannot open '%s' for writing.", filePath);
+			return false;
+		}
+		return true;
+	}
+
+	void updateSaveStatus()
+	{
+		std::lock_guard<std::mutex> lock(s_saveResultMutex);
+		for (size_t i = 0; i < s_saveResults.size(); i++)
+		{
+			const SaveResult* result = &s_saveResults[i];
+			if (result->errorCode == AFW_SUCCESS)
+			{
+				LE_INFO("Save Complete");
+			}
+			else if (result->errorCode == AFW_ERROR_OPEN)
+			{
+				LE_ERROR("Cannot open '%s' for writing.", result->path);
+			}
+			else
+			{
+				LE_ERROR("Failed to write '%s', the file may be incomplete.", result->path);
+			}
+		}
+		s_saveResults.clear();
+	}
+
+	struct AutosavePaths
+	{
+		char tempPath[TFE_MAX_PATH];
+		char path[TFE_MAX_PATH];
+	};
+
+	// Called on the file writer thread, only replace the previous autosave once the new one is complete.
+	static void autosaveComplete(size_t bytesWritten, void* userData, u32 errorCode)
+	{
+		AutosavePaths* paths = (AutosavePaths*)userData;
+		if (errorCode == AFW_SUCCESS)
+		{
+			FileUtil::replaceFile(paths->tempPath, paths->path);
+		}
+		delete paths;
+	}
 
+	bool autosaveLevel()
+	{
+		Project* project = project_get();
+		if (!project || !project->active)
+		{
+			return false;
+		}
+
+		AutosavePaths* paths = new AutosavePaths;
+		sprintf(paths->path, "%s/%s.tfl.autosave", project->path, s_level.slot.c_str());
+		sprintf(paths->tempPath, "%s.tmp", paths->path);
+
+		MemoryStream file;
+		file.open(Stream::MODE_WRITE);
+		writeLevelBinary(file);
 		file.close();
 
-		LE_INFO("Save Complete");
+		if (!FileWriterAsync::writeFileToDisk(paths->tempPath, (u8*)file.data(), file.getSize(), autosaveComplete, paths))
+		{
+			delete paths;
+			return false;
+		}
 		return true;
 	}
 
@@ -1953,6 +2055,7 @@ namespace LevelEditor
 		sector->bounds[1] = { poly.bounds[1].x, 0.0f, poly.bounds[1].z };
 		sector->bounds[0].y = min(sector->floorHeight, sector->ceilHeight);
 		sector->bounds[1].y = max(sector->floorHeight, sector->ceilHeight);
+		sectorBvh_markDirty(sector->id);
 	}
 
 	// Update the sector itself from the sector's polygon.
@@ -2234,8 +2337,6 @@ namespace LevelEditor
 	{
 		EditorLevel* level = &s_level;
 		if (level->sectors.empty()) { return false; }
-		const s32 sectorCount = (s32)level->sectors.size();
-		EditorSector* sector = level->sectors.data();
 
 		f32 maxDist  = ray->maxDist;
 		Vec3f origin = ray->origin;
@@ -2251,14 +2352,14 @@ namespace LevelEditor
 		hitInfo->hitPos = { 0 };
 		hitInfo->dist = FLT_MAX;
 
-		// Loop through sectors in the world.
-		for (s32 s = 0; s < sectorCount; s++, sector++)
+		// Only sectors whose XZ bounds overlap the ray segment can be hit, walls and flats alike.
+		sectorBvh_querySegment(p0xz, p1xz, &s_bvhCandidates);
+		const s32 candidateCount = (s32)s_bvhCandidates.size();
+		for (s32 c = 0; c < candidateCount; c++)
 		{
+			EditorSector* sector = &level->sectors[s_bvhCandidates[c]];
 			if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 
-			// Check the bounds.
-			//if (!rayHitAABB(ray, sector->bounds)) { continue; }
-
 			// Now check against the walls.
 			const u32 wallCount = (u32)sector->walls.size();
 			const EditorWall* wall = sector->walls.data();
@@ -2621,16 +2722,19 @@ namespace LevelEditor
 		return closestId;
 	}
 
-	// TODO: Spatial data structure to handle cases where there are 10k, 100k, etc. sectors.
 	bool getOverlappingSectorsPt(const Vec3f* pos, SectorList* result, f32 padding)
 	{
 		if (!pos || !result) { return false; }
 
 		result->clear();
-		const s32 count = (s32)s_level.sectors.size();
-		EditorSector* sector = s_level.sectors.data();
-		for (s32 i = 0; i < count; i++, sector++)
+		const Vec2f bmin = { pos->x - padding, pos->z - padding };
+		const Vec2f bmax = { pos->x + padding, pos->z + padding };
+		sectorBvh_queryBounds(bmin, bmax, &s_bvhCandidates);
+
+		const s32 count = (s32)s_bvhCandidates.size();
+		for (s32 i = 0; i < count; i++)
 		{
+			EditorSector* sector = &s_level.sectors[s_bvhCandidates[i]];
 			if (!sector_isInteractable(sector) || !sector_onActiveLayer(sector)) { continue; }
 			// The position has to be within the bounds of the sector.
 			// TODO: Increase the bounds range?
@@ -2653,10 +2757,14 @@ namespace LevelEditor
 
 		result->clear();
 		const f32 padding = 0.1f;
-		const s32 count = (s32)s_level.sectors.size();
-		EditorSector* sector = s_level.sectors.data();
-		for (s32 i = 0; i < count; i++, sector++)
+		const Vec2f bmin = { bounds[0].x - padding, bounds[0].z - padding };
+		const Vec2f bmax = { bounds[1].x + padding, bounds[1].z + padding };
+		sectorBvh_queryBounds(bmin, bmax, &s_bvhCandidates);
+
+		const s32 count = (s32)s_bvhCandidates.size();
+		for (s32 i = 0; i < count; i++)
 		{
+			EditorSector* sector = &s_level.sectors[s_bvhCandidates[i]];
 			if (boundsOverlap3D(sector->bounds, bounds, padding)) // Add padding for sectors that are just touching.
 			{
 				result->push_back(sector);
@@ -3290,9 +3398,11 @@ namespace LevelEditor
 		}
 
 		// Sectors.
+		// Each sector and entity is its own history record, so only the ones that change are stored again.
 		const EditorSector* sector = s_level.sectors.data();
 		for (u32 s = 0; s < sectorCount; s++, sector++)
 		{
+			history_markSnapshotRecord(buffer);
 			writeSectorToSnapshot(sector);
 		}
 
@@ -3300,10 +3410,12 @@ namespace LevelEditor
 		const Entity* entity = s_level.entities.data();
 		for (u32 e = 0; e < entityCount; e++, entity++)
 		{
+			history_markSnapshotRecord(buffer);
 			writeEntityToSnapshot(entity);
 		}
 
 		// Level Notes.
+		history_markSnapshotRecord(buffer);
 		const LevelNote* note = s_level.notes.data();
 		for (u32 n = 0; n < levelNoteCount; n++, note++)
 		{
@@ -3311,6 +3423,7 @@ namespace LevelEditor
 		}
 
 		// Guidelines.
+		history_markSnapshotRecord(buffer);
 		const Guideline* guideline = s_level.guidelines.data();
 		for (u32 g = 0; g < guidelineCount; g++, guideline++)
 		{
@@ -3395,6 +3508,7 @@ namespace LevelEditor
 		}
 		// Then copy the snapshot to the level data itself. Its the new state.
 		s_level = s_curSnapshot;
+		sectorBvh_invalidate();
 
 		// For now until the way snapshot memory is handled is refactored, to avoid duplicate code that will be removed later.
 		// TODO: Handle edit state properly here too.
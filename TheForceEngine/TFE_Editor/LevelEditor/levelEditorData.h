@@ -242,7 +242,12 @@ namespace LevelEditor
 	TFE_Editor::AssetHandle loadPalette(const char* paletteName);
 	TFE_Editor::AssetHandle loadColormap(const char* colormapName);
 	
+	// Serialize the level and write it in the background, the result is reported by updateSaveStatus().
 	bool saveLevel();
+	// Report completed saves to the info panel, called from the editor thread.
+	void updateSaveStatus();
+	// Write '<slot>.tfl.autosave' in the background, the previous autosave is only replaced once the write completes.
+	bool autosaveLevel();
 	bool exportLevel(const char* path, const char* name, const StartPoint* start);
 	void sectorToPolygon(EditorSector* sector);
 	void polygonToSector(EditorSector* sector);
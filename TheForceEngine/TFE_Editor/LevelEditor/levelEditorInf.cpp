@@ -4623,7 +4623,7 @@ namespace LevelEditor
 		return index;
 	}
 
-	void editor_saveInfBinary(FileStream& file)
+	void editor_saveInfBinary(Stream& file)
 	{
 		// version >= LEF_InfV1
 		const s32 itemCount = (s32)s_levelInf.item.size();
@@ -307,7 +307,7 @@ namespace LevelEditor
 	void editor_writeInfItem(std::string& outStr, const Editor_InfItem* item, const char* curTab);
 
 	void editor_loadInfBinary(FileStream& file, u32 version);
-	void editor_saveInfBinary(FileStream& file);
+	void editor_saveInfBinary(Stream& file);
 
 	void editor_handleSelection(EditorSector* sector, s32 wallIndex = -1);
 	void editor_handleSelection(Vec3f pos);
@@ -0,0 +1,289 @@
+#include "sectorBvh.h"
+#include "levelEditorData.h"
+#include "sharedState.h"
+#include <TFE_System/profiler.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace LevelEditor
+{
+	enum BvhConst
+	{
+		BVH_LEAF_SIZE = 4,
+		BVH_MAX_DEPTH = 64,
+	};
+	// Small padding so segments that just touch the bounds are not rejected.
+	static const f32 c_bvhPadding = 0.001f;
+
+	struct BvhNode
+	{
+		Vec2f bounds[2];
+		s32 parent;
+		s32 right;	// The left child immediately follows the node.
+		s32 first;	// First item, leaves only.
+		s32 count;	// Item count, 0 for interior nodes.
+	};
+
+	static std::vector<BvhNode> s_nodes;
+	static std::vector<s32> s_items;		// Sector indices, referenced by the leaves.
+	static std::vector<s32> s_sectorLeaf;	// Leaf node for each sector.
+	static std::vector<s32> s_dirty;
+	static std::vector<u8> s_dirtyFlag;
+	static std::vector<Vec2f> s_centers;
+	static size_t s_sectorCount = 0;
+	static s32 s_refitCount = 0;	// Sectors refit since the last build.
+	static bool s_rebuild = true;
+
+	void sectorBvh_invalidate()
+	{
+		s_rebuild = true;
+	}
+
+	void sectorBvh_markDirty(s32 sectorId)
+	{
+		if (s_rebuild) { return; }
+		if (sectorId < 0 || sectorId >= (s32)s_sectorLeaf.size())
+		{
+			s_rebuild = true;
+			return;
+		}
+		if (!s_dirtyFlag[sectorId])
+		{
+			s_dirtyFlag[sectorId] = 1;
+			s_dirty.push_back(sectorId);
+		}
+	}
+
+	static void getSectorBounds(s32 sectorId, Vec2f* bounds)
+	{
+		const EditorSector* sector = &s_level.sectors[sectorId];
+		bounds[0] = { sector->bounds[0].x, sector->bounds[0].z };
+		bounds[1] = { sector->bounds[1].x, sector->bounds[1].z };
+	}
+
+	static void computeLeafBounds(BvhNode* node)
+	{
+		node->bounds[0] = {  FLT_MAX,  FLT_MAX };
+		node->bounds[1] = { -FLT_MAX, -FLT_MAX };
+		for (s32 i = 0; i < node->count; i++)
+		{
+			Vec2f bounds[2];
+			getSectorBounds(s_items[node->first + i], bounds);
+			node->bounds[0].x = std::min(node->bounds[0].x, bounds[0].x);
+			node->bounds[0].z = std::min(node->bounds[0].z, bounds[0].z);
+			node->bounds[1].x = std::max(node->bounds[1].x, bounds[1].x);
+			node->bounds[1].z = std::max(node->bounds[1].z, bounds[1].z);
+		}
+	}
+
+	static void computeInteriorBounds(s32 nodeId)
+	{
+		BvhNode* node = &s_nodes[nodeId];
+		const BvhNode* left = &s_nodes[nodeId + 1];
+		const BvhNode* right = &s_nodes[node->right];
+		node->bounds[0] = { std::min(left->bounds[0].x, right->bounds[0].x), std::min(left->bounds[0].z, right->bounds[0].z) };
+		node->bounds[1] = { std::max(left->bounds[1].x, right->bounds[1].x), std::max(left->bounds[1].z, right->bounds[1].z) };
+	}
+
+	// Split the items at the median of the longest axis of their centers.
+	static s32 buildNode(s32 parent, s32 first, s32 count, s32 depth)
+	{
+		const s32 nodeId = (s32)s_nodes.size();
+		s_nodes.push_back({});
+		s_nodes[nodeId].parent = parent;
+
+		if (count <= BVH_LEAF_SIZE || depth >= BVH_MAX_DEPTH - 1)
+		{
+			BvhNode* node = &s_nodes[nodeId];
+			node->right = -1;
+			node->first = first;
+			node->count = count;
+			computeLeafBounds(node);
+			for (s32 i = 0; i < count; i++)
+			{
+				s_sectorLeaf[s_items[first + i]] = nodeId;
+			}
+			return nodeId;
+		}
+
+		Vec2f cmin = {  FLT_MAX,  FLT_MAX };
+		Vec2f cmax = { -FLT_MAX, -FLT_MAX };
+		for (s32 i = 0; i < count; i++)
+		{
+			const Vec2f& c = s_centers[s_items[first + i]];
+			cmin.x = std::min(cmin.x, c.x);
+			cmin.z = std::min(cmin.z, c.z);
+			cmax.x = std::max(cmax.x, c.x);
+			cmax.z = std::max(cmax.z, c.z);
+		}
+		const bool splitX = (cmax.x - cmin.x) >= (cmax.z - cmin.z);
+		const s32 half = count / 2;
+		std::nth_element(s_items.begin() + first, s_items.begin() + first + half, s_items.begin() + first + count, [splitX](s32 a, s32 b)
+		{
+			return splitX ? s_centers[a].x < s_centers[b].x : s_centers[a].z < s_centers[b].z;
+		});
+
+		buildNode(nodeId, first, half, depth + 1);
+		const s32 right = buildNode(nodeId, first + half, count - half, depth + 1);
+
+		BvhNode* node = &s_nodes[nodeId];
+		node->right = right;
+		node->first = 0;
+		node->count = 0;
+		computeInteriorBounds(nodeId);
+		return nodeId;
+	}
+
+	static void rebuild()
+	{
+		TFE_ZONE("Sector BVH Build");
+		s_sectorCount = s_level.sectors.size();
+		const s32 count = (s32)s_sectorCount;
+
+		s_nodes.clear();
+		s_items.resize(count);
+		s_sectorLeaf.resize(count);
+		s_centers.resize(count);
+		s_dirtyFlag.assign(count, 0);
+		s_dirty.clear();
+		for (s32 i = 0; i < count; i++)
+		{
+			Vec2f bounds[2];
+			getSectorBounds(i, bounds);
+			s_items[i] = i;
+			s_centers[i] = { (bounds[0].x + bounds[1].x) * 0.5f, (bounds[0].z + bounds[1].z) * 0.5f };
+		}
+		if (count > 0)
+		{
+			s_nodes.reserve(2 * (count / BVH_LEAF_SIZE + 1));
+			buildNode(-1, 0, count, 0);
+		}
+		s_refitCount = 0;
+		s_rebuild = false;
+	}
+
+	static void refit()
+	{
+		const s32 dirtyCount = (s32)s_dirty.size();
+		if (dirtyCount * 4 >= (s32)s_sectorCount)
+		{
+			// Refit the whole tree bottom up, children always follow their parents.
+			for (s32 n = (s32)s_nodes.size() - 1; n >= 0; n--)
+			{
+				if (s_nodes[n].count) { computeLeafBounds(&s_nodes[n]); }
+				else { computeInteriorBounds(n); }
+			}
+		}
+		else
+		{
+			for (s32 i = 0; i < dirtyCount; i++)
+			{
+				s32 nodeId = s_sectorLeaf[s_dirty[i]];
+				computeLeafBounds(&s_nodes[nodeId]);
+				for (nodeId = s_nodes[nodeId].parent; nodeId >= 0; nodeId = s_nodes[nodeId].parent)
+				{
+					computeInteriorBounds(nodeId);
+				}
+			}
+		}
+
+		for (s32 i = 0; i < dirtyCount; i++)
+		{
+			s_dirtyFlag[s_dirty[i]] = 0;
+		}
+		s_dirty.clear();
+		s_refitCount += dirtyCount;
+	}
+
+	static void update()
+	{
+		// Refitting keeps the tree valid, but the quality degrades as sectors move around.
+		if (s_rebuild || s_sectorCount != s_level.sectors.size() || s_refitCount > (s32)s_sectorCount)
+		{
+			rebuild();
+		}
+		else if (!s_dirty.empty())
+		{
+			refit();
+		}
+	}
+
+	static bool segmentOverlap(const Vec2f* bounds, const Vec2f& p0, const Vec2f& delta)
+	{
+		f32 tmin = 0.0f, tmax = 1.0f;
+		for (s32 a = 0; a < 2; a++)
+		{
+			const f32 origin = a == 0 ? p0.x : p0.z;
+			const f32 dir = a == 0 ? delta.x : delta.z;
+			const f32 lo = (a == 0 ? bounds[0].x : bounds[0].z) - c_bvhPadding;
+			const f32 hi = (a == 0 ? bounds[1].x : bounds[1].z) + c_bvhPadding;
+			if (fabsf(dir) < FLT_EPSILON)
+			{
+				if (origin < lo || origin > hi) { return false; }
+				continue;
+			}
+			const f32 scale = 1.0f / dir;
+			f32 t0 = (lo - origin) * scale;
+			f32 t1 = (hi - origin) * scale;
+			if (t0 > t1) { std::swap(t0, t1); }
+			tmin = std::max(tmin, t0);
+			tmax = std::min(tmax, t1);
+			if (tmin > tmax) { return false; }
+		}
+		return true;
+	}
+
+	static bool boundsOverlap(const Vec2f* bounds, const Vec2f& bmin, const Vec2f& bmax)
+	{
+		return bounds[0].x <= bmax.x && bounds[1].x >= bmin.x &&
+			bounds[0].z <= bmax.z && bounds[1].z >= bmin.z;
+	}
+
+	template <typename TestFunc>
+	static void query(std::vector<s32>* result, TestFunc test)
+	{
+		result->clear();
+		update();
+		if (s_nodes.empty()) { return; }
+
+		s32 stack[BVH_MAX_DEPTH];
+		s32 stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize > 0)
+		{
+			const s32 nodeId = stack[--stackSize];
+			const BvhNode* node = &s_nodes[nodeId];
+			if (!test(node->bounds)) { continue; }
+
+			if (node->count)
+			{
+				for (s32 i = 0; i < node->count; i++)
+				{
+					const s32 sectorId = s_items[node->first + i];
+					Vec2f bounds[2];
+					getSectorBounds(sectorId, bounds);
+					if (test(bounds)) { result->push_back(sectorId); }
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node->right;
+				stack[stackSize++] = nodeId + 1;
+			}
+		}
+		// Callers expect the same order as a linear walk over the sectors.
+		std::sort(result->begin(), result->end());
+	}
+
+	void sectorBvh_querySegment(const Vec2f& p0, const Vec2f& p1, std::vector<s32>* result)
+	{
+		const Vec2f delta = { p1.x - p0.x, p1.z - p0.z };
+		query(result, [&](const Vec2f* bounds) { return segmentOverlap(bounds, p0, delta); });
+	}
+
+	void sectorBvh_queryBounds(const Vec2f& bmin, const Vec2f& bmax, std::vector<s32>* result)
+	{
+		query(result, [&](const Vec2f* bounds) { return boundsOverlap(bounds, bmin, bmax); });
+	}
+}
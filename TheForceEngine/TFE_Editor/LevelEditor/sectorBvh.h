@@ -0,0 +1,31 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// The Force Engine Editor
+// A system built to view and edit Dark Forces data files.
+// The viewing aspect needs to be put in place at the beginning
+// in order to properly test elements in isolation without having
+// to "play" the game as intended.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <vector>
+
+// Bounding volume hierarchy over the XZ bounds of the level sectors, used
+// to find candidate sectors for ray traces and overlap queries without
+// visiting every sector. Heights are not stored since they change often
+// without the sector polygon being rebuilt, callers do the exact tests.
+//
+// The hierarchy is rebuilt when the sector count changes or it is
+// invalidated, and refit when individual sectors are marked dirty
+// (sectorToPolygon() does this for every geometry edit and snapshot).
+namespace LevelEditor
+{
+	// Force a full rebuild on the next query (level load, sectors removed).
+	void sectorBvh_invalidate();
+	// The sector bounds have changed, refit before the next query.
+	void sectorBvh_markDirty(s32 sectorId);
+
+	// Get the sectors whose XZ bounds intersect the segment p0 -> p1, sorted by index.
+	void sectorBvh_querySegment(const Vec2f& p0, const Vec2f& p1, std::vector<s32>* result);
+	// Get the sectors whose XZ bounds overlap the rectangle [bmin, bmax], sorted by index.
+	void sectorBvh_queryBounds(const Vec2f& bmin, const Vec2f& bmax, std::vector<s32>* result);
+}
@@ -9,6 +9,7 @@
 #include <TFE_FileSystem/paths.h>
 #include <TFE_Archive/archive.h>
 #include <TFE_Ui/ui.h>
+#include <algorithm>
 
 namespace TFE_Editor
 {
@@ -114,6 +115,7 @@ namespace TFE_Editor
 		// Level Editor
 		TFE_IniParser::writeKeyValue_Int(configFile, "Interface_Flags", s_editorConfig.interfaceFlags);
 		TFE_IniParser::writeKeyValue_Float(configFile, "Curve_SegmentSize", s_editorConfig.curve_segmentSize);
+		TFE_IniParser::writeKeyValue_Int(configFile, "Autosave_Interval", s_editorConfig.autosaveInterval);
 
 		// Recent files.
 		std::vector<RecentProject>* recentProjects = getRecentProjects();
@@ -198,6 +200,13 @@ namespace TFE_Editor
 
 			fontScaleControl();
 			thumbnailSizeControl();
+
+			ImGui::Text("Autosave (sec):"); ImGui::SameLine(UI_SCALE(120));
+			ImGui::SetNextItemWidth(UI_SCALE(128));
+			if (ImGui::InputInt("##AutosaveInterval", &s_editorConfig.autosaveInterval))
+			{
+				s_editorConfig.autosaveInterval = std::max(0, s_editorConfig.autosaveInterval);
+			}
 			ImGui::Separator();
 
 			if (ImGui::Button("Save Config"))
@@ -278,6 +287,10 @@ namespace TFE_Editor
 		{
 			s_editorConfig.curve_segmentSize = TFE_IniParser::parseFloat(value);
 		}
+		else if (strcasecmp(key, "Autosave_Interval") == 0)
+		{
+			s_editorConfig.autosaveInterval = TFE_IniParser::parseInt(value);
+		}
 		else if (strncasecmp(key, "Recent", strlen("Recent")) == 0)
 		{
 			addToRecents(value);
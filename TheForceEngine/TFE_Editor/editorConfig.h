@@ -23,6 +23,7 @@ namespace TFE_Editor
 		// Level editor
 		s32 interfaceFlags = 0;
 		f32 curve_segmentSize = 2.0f;
+		s32 autosaveInterval = 300;	// Seconds between autosaves, 0 = disabled.
 	};
 	enum EditorFontConst
 	{
@@ -4,22 +4,56 @@
 #include <TFE_System/system.h>
 #include <assert.h>
 #include <algorithm>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 namespace TFE_Editor
 {
 	enum
 	{
 		CMD_MAX_DEPTH = 64,
+		CHUNK_MAX_DIFF_DEPTH = 16,	// A changed record is stored whole (a keyframe) once its diff chain would exceed this.
+		CHUNK_MIN_COMPRESS_SIZE = 64,
 	};
 
+	// Snapshots are split into records (sectors, entities, ...) by the client.
+	// Each record is stored once in a content addressed chunk store, so unchanged records are shared between snapshots.
 	struct Snapshot
 	{
 		std::string name;
 		u32 uncompressedSize;
-		u32 compressedSize; // if zero, then uncompressed.
-		std::vector<u8> compressedData;
+		s32 firstChunk;				// Chunks at or after this index were added by this snapshot.
+		std::vector<s32> records;	// Chunk index of each record, in order.
+	};
+
+	struct HistoryChunk
+	{
+		u64 hash;
+		u32 size;			// Uncompressed size.
+		s32 base;			// Chunk this is stored as a diff against, or -1 if stored whole.
+		u32 depth;			// Number of diffs applied to rebuild the chunk.
+		bool compressed;	// Whole chunks are zstd compressed in the background, until then the data is stored as-is.
+		std::vector<u8> data;
+	};
+
+	// Chunks waiting to be compressed on the history thread, or compressed and waiting to be published.
+	struct CompressJob
+	{
+		s32 chunk;
+		u32 generation;
+		std::vector<u8> data;
+	};
+
+	// Changed records are stored as the bytes between the common prefix and suffix of the base record.
+	struct ChunkDiffHeader
+	{
+		u32 prefix;
+		u32 suffix;
 	};
 
 	struct CommandHeader
@@ -41,10 +75,261 @@ namespace TFE_Editor
 	std::vector<u8> s_historyBuffer;
 	std::vector<u8> s_snapshotBuffer;
 
+	std::vector<HistoryChunk> s_chunks;
+	std::unordered_map<u64, s32> s_chunkMap;
+	std::vector<u32> s_snapshotRecords;		// Record offsets in the snapshot being created.
+	std::vector<u8> s_chunkScratch;
+
+	std::thread s_compressThread;
+	std::mutex s_compressMutex;
+	std::condition_variable s_compressWake;
+	std::deque<CompressJob> s_compressJobs;
+	std::deque<CompressJob> s_compressDone;
+	bool s_compressQuit = false;
+	u32 s_chunkGeneration = 0;	// Incremented when chunks are discarded, so stale results are ignored.
+
+	// The last snapshot created, records are compared against it before searching the chunk store.
+	std::vector<u8> s_prevData;
+	std::vector<u32> s_prevRecords;			// Offsets, including the end of the data.
+	std::vector<s32> s_prevChunks;
+	std::unordered_map<u64, s32> s_prevRecordMap;
+
 	u32 s_curPosInHistory = 0;
 	u32 s_curBufferAddr = 0;
 	u32 s_curSnapshot = 0;
 
+	/////////////////////////////////////////////////
+	// Background Compression
+	/////////////////////////////////////////////////
+	void history_compressLoop()
+	{
+		std::unique_lock<std::mutex> lock(s_compressMutex);
+		while (1)
+		{
+			s_compressWake.wait(lock, [] { return s_compressQuit || !s_compressJobs.empty(); });
+			if (s_compressQuit) { break; }
+
+			CompressJob job = std::move(s_compressJobs.front());
+			s_compressJobs.pop_front();
+
+			lock.unlock();
+			std::vector<u8> compressed;
+			const u32 size = (u32)job.data.size();
+			const bool smaller = zstd_compress(compressed, job.data.data(), size, 4) && compressed.size() < size;
+			lock.lock();
+
+			// Only publish results that save memory.
+			if (smaller)
+			{
+				job.data.swap(compressed);
+				s_compressDone.push_back(std::move(job));
+			}
+		}
+	}
+
+	void history_queueCompression(s32 index, const u8* data, u32 size)
+	{
+		std::lock_guard<std::mutex> lock(s_compressMutex);
+		CompressJob job;
+		job.chunk = index;
+		job.generation = s_chunkGeneration;
+		job.data.assign(data, data + size);
+		s_compressJobs.push_back(std::move(job));
+
+		// The compression thread is started on demand.
+		if (!s_compressThread.joinable())
+		{
+			s_compressQuit = false;
+			s_compressThread = std::thread(history_compressLoop);
+		}
+		s_compressWake.notify_one();
+	}
+
+	// Swap in the chunks compressed since the last call, done on the editor thread so the chunk store is never shared.
+	void history_publishCompressedChunks()
+	{
+		std::lock_guard<std::mutex> lock(s_compressMutex);
+		while (!s_compressDone.empty())
+		{
+			CompressJob& job = s_compressDone.front();
+			if (job.generation == s_chunkGeneration && job.chunk < (s32)s_chunks.size())
+			{
+				HistoryChunk* chunk = &s_chunks[job.chunk];
+				assert(!chunk->compressed && chunk->base < 0);
+				chunk->data.swap(job.data);
+				chunk->compressed = true;
+			}
+			s_compressDone.pop_front();
+		}
+	}
+
+	// Called when the chunks at or after 'firstChunk' are removed, pending work on those chunks is dropped.
+	// The chunk being compressed cannot be recalled, so it is ignored by bumping the generation.
+	void history_discardCompression(s32 firstChunk)
+	{
+		std::lock_guard<std::mutex> lock(s_compressMutex);
+		s_chunkGeneration++;
+		std::deque<CompressJob>* queues[] = { &s_compressJobs, &s_compressDone };
+		for (s32 q = 0; q < 2; q++)
+		{
+			std::deque<CompressJob>& queue = *queues[q];
+			queue.erase(std::remove_if(queue.begin(), queue.end(), [firstChunk](const CompressJob& job) { return job.chunk >= firstChunk; }), queue.end());
+			for (size_t i = 0; i < queue.size(); i++)
+			{
+				queue[i].generation = s_chunkGeneration;
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////
+	// Chunk Store
+	/////////////////////////////////////////////////
+	void history_clearPrevSnapshot()
+	{
+		s_prevData.clear();
+		s_prevRecords.clear();
+		s_prevChunks.clear();
+		s_prevRecordMap.clear();
+	}
+
+	u64 history_hashRecord(const u8* data, u32 size)
+	{
+		// FNV-1a
+		u64 hash = 14695981039346656037ull;
+		for (u32 i = 0; i < size; i++)
+		{
+			hash = (hash ^ data[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// Rebuild the chunk contents into 'output', which must hold chunk->size bytes.
+	void history_readChunk(s32 index, u8* output)
+	{
+		const HistoryChunk* chunk = &s_chunks[index];
+		if (chunk->base < 0)
+		{
+			if (chunk->compressed)
+			{
+				zstd_decompress(output, chunk->size, chunk->data.data(), (u32)chunk->data.size());
+			}
+			else
+			{
+				memcpy(output, chunk->data.data(), chunk->size);
+			}
+			return;
+		}
+
+		// Diff chains are bounded by CHUNK_MAX_DIFF_DEPTH.
+		const HistoryChunk* base = &s_chunks[chunk->base];
+		std::vector<u8> baseData(base->size);
+		history_readChunk(chunk->base, baseData.data());
+
+		ChunkDiffHeader diff;
+		memcpy(&diff, chunk->data.data(), sizeof(ChunkDiffHeader));
+		const u32 midSize = chunk->size - diff.prefix - diff.suffix;
+		memcpy(output, baseData.data(), diff.prefix);
+		memcpy(output + diff.prefix, chunk->data.data() + sizeof(ChunkDiffHeader), midSize);
+		memcpy(output + diff.prefix + midSize, baseData.data() + base->size - diff.suffix, diff.suffix);
+	}
+
+	bool history_chunkMatches(s32 index, const u8* data, u32 size)
+	{
+		if (s_chunks[index].size != size) { return false; }
+		std::vector<u8>& chunkData = s_chunkScratch;
+		chunkData.resize(size);
+		history_readChunk(index, chunkData.data());
+		return memcmp(chunkData.data(), data, size) == 0;
+	}
+
+	s32 history_addChunk(const u8* data, u32 size, u64 hash, s32 baseIndex, const u8* baseData)
+	{
+		HistoryChunk chunk = {};
+		chunk.hash = hash;
+		chunk.size = size;
+		chunk.base = -1;
+
+		// Try storing the record as a diff against the matching record in the previous snapshot.
+		const HistoryChunk* base = baseIndex >= 0 ? &s_chunks[baseIndex] : nullptr;
+		if (base && base->depth < CHUNK_MAX_DIFF_DEPTH)
+		{
+			const u32 maxCommon = std::min(size, base->size);
+			u32 prefix = 0;
+			while (prefix < maxCommon && data[prefix] == baseData[prefix]) { prefix++; }
+			u32 suffix = 0;
+			while (suffix < maxCommon - prefix && data[size - suffix - 1] == baseData[base->size - suffix - 1]) { suffix++; }
+
+			const u32 midSize = size - prefix - suffix;
+			if (sizeof(ChunkDiffHeader) + midSize < size / 2)
+			{
+				const ChunkDiffHeader diff = { prefix, suffix };
+				chunk.base = baseIndex;
+				chunk.depth = base->depth + 1;
+				chunk.data.resize(sizeof(ChunkDiffHeader) + midSize);
+				memcpy(chunk.data.data(), &diff, sizeof(ChunkDiffHeader));
+				memcpy(chunk.data.data() + sizeof(ChunkDiffHeader), data + prefix, midSize);
+			}
+		}
+
+		// Otherwise store it whole, it is compressed later.
+		const s32 index = (s32)s_chunks.size();
+		if (chunk.base < 0)
+		{
+			chunk.data.assign(data, data + size);
+			if (size >= CHUNK_MIN_COMPRESS_SIZE)
+			{
+				history_queueCompression(index, data, size);
+			}
+		}
+
+		s_chunks.push_back(std::move(chunk));
+		// The first chunk with a given hash is the one found by later snapshots.
+		s_chunkMap.insert({ hash, index });
+		return index;
+	}
+
+	// Find or add the chunk holding the record, 'recordIndex' is the index of the record in the snapshot.
+	s32 history_storeRecord(const u8* data, u32 size, s32 recordIndex)
+	{
+		const u64 hash = history_hashRecord(data, size);
+
+		// 1. The record is usually unchanged from the previous snapshot.
+		std::unordered_map<u64, s32>::iterator iPrev = s_prevRecordMap.find(hash);
+		if (iPrev != s_prevRecordMap.end())
+		{
+			const s32 prevRecord = iPrev->second;
+			const u32 prevSize = s_prevRecords[prevRecord + 1] - s_prevRecords[prevRecord];
+			if (prevSize == size && memcmp(&s_prevData[s_prevRecords[prevRecord]], data, size) == 0)
+			{
+				return s_prevChunks[prevRecord];
+			}
+		}
+
+		// 2. Search the whole store, for example when undoing and then repeating an edit.
+		std::unordered_map<u64, s32>::iterator iChunk = s_chunkMap.find(hash);
+		if (iChunk != s_chunkMap.end() && history_chunkMatches(iChunk->second, data, size))
+		{
+			return iChunk->second;
+		}
+
+		// 3. Add a new chunk, diffed against the record in the same position of the previous snapshot.
+		const s32 prevRecordCount = (s32)s_prevChunks.size();
+		if (recordIndex < prevRecordCount)
+		{
+			return history_addChunk(data, size, hash, s_prevChunks[recordIndex], &s_prevData[s_prevRecords[recordIndex]]);
+		}
+		return history_addChunk(data, size, hash, -1, nullptr);
+	}
+
+	void history_markSnapshotRecord(const SnapshotBuffer* buffer)
+	{
+		const u32 offset = (u32)buffer->size();
+		if (s_snapshotRecords.empty() || s_snapshotRecords.back() != offset)
+		{
+			s_snapshotRecords.push_back(offset);
+		}
+	}
+
 	void history_init(UnpackSnapshotFunc snapshotUnpackFunc, CreateSnapshotFunc createSnapshotFunc)
 	{
 		s_snapshotUnpack = snapshotUnpackFunc;
@@ -60,6 +345,16 @@ namespace TFE_Editor
 
 	void history_destroy()
 	{
+		if (s_compressThread.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(s_compressMutex);
+				s_compressQuit = true;
+			}
+			s_compressWake.notify_one();
+			s_compressThread.join();
+		}
+		history_discardCompression(0);
 	}
 
 	void history_clear()
@@ -68,6 +363,10 @@ namespace TFE_Editor
 		s_snapShots.clear();
 		s_history.clear();
 		s_historyBuffer.clear();
+		history_discardCompression(0);
+		s_chunks.clear();
+		s_chunkMap.clear();
+		history_clearPrevSnapshot();
 		s_curPosInHistory = 0;
 		s_curBufferAddr = 0;
 		s_curSnapshot = 0;
@@ -155,25 +454,40 @@ namespace TFE_Editor
 	{
 		u16 parentId = u16(s_curPosInHistory);
 
+		history_publishCompressedChunks();
+
 		Snapshot snapshot = {};
 		snapshot.uncompressedSize = size;
+		snapshot.firstChunk = (s32)s_chunks.size();
 
-		bool useUncompressed = true;
-		if (zstd_compress(snapshot.compressedData, (u8*)data, size, 4))
+		// Split the snapshot into records, the data before the first marked record is a record as well.
+		if (s_snapshotRecords.empty() || s_snapshotRecords[0] != 0)
 		{
-			if (snapshot.compressedData.size() < size)
-			{
-				useUncompressed = false;
-				snapshot.compressedSize = (u32)snapshot.compressedData.size();
-			}
+			s_snapshotRecords.insert(s_snapshotRecords.begin(), 0);
+		}
+		if (s_snapshotRecords.back() != size)
+		{
+			s_snapshotRecords.push_back(size);
 		}
-		if (useUncompressed)
+		const s32 recordCount = (s32)s_snapshotRecords.size() - 1;
+		snapshot.records.resize(recordCount);
+		for (s32 r = 0; r < recordCount; r++)
 		{
-			snapshot.compressedSize = size;
-			snapshot.compressedData.resize(size);
-			memcpy(snapshot.compressedData.data(), data, size);
+			const u32 offset = s_snapshotRecords[r];
+			snapshot.records[r] = history_storeRecord((u8*)data + offset, s_snapshotRecords[r + 1] - offset, r);
 		}
 
+		// This becomes the previous snapshot for the next one.
+		s_prevData.assign((u8*)data, (u8*)data + size);
+		s_prevRecords.swap(s_snapshotRecords);
+		s_prevChunks = snapshot.records;
+		s_prevRecordMap.clear();
+		for (s32 r = 0; r < recordCount; r++)
+		{
+			s_prevRecordMap.insert({ s_chunks[snapshot.records[r]].hash, r });
+		}
+		s_snapshotRecords.clear();
+
 		if (name)
 		{
 			snapshot.name = name;
@@ -205,6 +519,7 @@ namespace TFE_Editor
 	{
 		// Callback setup by the client.
 		s_snapshotBuffer.clear();
+		s_snapshotRecords.clear();
 		s_snapshotCreate(&s_snapshotBuffer);
 		history_createSnapshotInternal((u32)s_snapshotBuffer.size(), s_snapshotBuffer.data(), name);
 	}
@@ -216,9 +531,7 @@ namespace TFE_Editor
 		if (prevHeader.depth >= CMD_MAX_DEPTH)
 		{
 			// Callback setup by the client.
-			s_snapshotBuffer.clear();
-			s_snapshotCreate(&s_snapshotBuffer);
-			history_createSnapshotInternal((u32)s_snapshotBuffer.size(), s_snapshotBuffer.data(), s_cmdName[name].c_str());
+			history_createSnapshot(s_cmdName[name].c_str());
 			// Return false to let the caller know a snapshot was created instead of the command.
 			return false;
 		}
@@ -329,6 +642,8 @@ namespace TFE_Editor
 	{
 		assert(pos >= 0 && pos < (s32)s_history.size());
 		s_curPosInHistory = pos;
+		// Chunks that are still being compressed are read from their uncompressed data, so this never waits.
+		history_publishCompressedChunks();
 
 		// 1. Traverse backward through the parentIds until a snapshot is reached.
 		u16 cmdList[257], listCount = 0;
@@ -353,19 +668,18 @@ namespace TFE_Editor
 			if (cmdHeader->cmdId == CMD_SNAPSHOT)
 			{
 				const s32 id = cmdHeader->cmdName;
-				Snapshot* snapshot = &s_snapShots[id];
-				if (snapshot->uncompressedSize > snapshot->compressedSize)
-				{
-					s_snapshotBuffer.resize(snapshot->uncompressedSize);
-					if (zstd_decompress(s_snapshotBuffer.data(), snapshot->uncompressedSize, snapshot->compressedData.data(), snapshot->compressedSize))
-					{
-						s_snapshotUnpack(id, snapshot->uncompressedSize, s_snapshotBuffer.data());
-					}
-				}
-				else
+				const Snapshot* snapshot = &s_snapShots[id];
+				// Rebuild the snapshot from its records.
+				s_snapshotBuffer.resize(snapshot->uncompressedSize);
+				u8* output = s_snapshotBuffer.data();
+				const s32 recordCount = (s32)snapshot->records.size();
+				for (s32 r = 0; r < recordCount; r++)
 				{
-					s_snapshotUnpack(id, snapshot->compressedSize, snapshot->compressedData.data());
+					const s32 chunkIndex = snapshot->records[r];
+					history_readChunk(chunkIndex, output);
+					output += s_chunks[chunkIndex].size;
 				}
+				s_snapshotUnpack(id, snapshot->uncompressedSize, s_snapshotBuffer.data());
 			}
 			else
 			{
@@ -427,7 +741,20 @@ namespace TFE_Editor
 		// Then resize the snapshots.
 		if (snapShotMin < 0xffff)
 		{
+			// Chunks only reference older chunks, so the chunks added by the removed snapshots can be discarded.
+			const s32 firstChunk = s_snapShots[snapShotMin].firstChunk;
+			history_discardCompression(firstChunk);
+			for (s32 c = (s32)s_chunks.size() - 1; c >= firstChunk; c--)
+			{
+				std::unordered_map<u64, s32>::iterator iChunk = s_chunkMap.find(s_chunks[c].hash);
+				if (iChunk != s_chunkMap.end() && iChunk->second == c)
+				{
+					s_chunkMap.erase(iChunk);
+				}
+			}
+			s_chunks.resize(firstChunk);
 			s_snapShots.resize(snapShotMin);
+			history_clearPrevSnapshot();
 		}
 		// Clear the previous snapshot index.
 		s_snapshotUnpack(-1, 0, nullptr);
@@ -461,16 +788,24 @@ namespace TFE_Editor
 
 	u32 history_getSize()
 	{
+		history_publishCompressedChunks();
 		const s32 snapshotCount = (s32)s_snapShots.size();
 		const Snapshot* snapshot = s_snapShots.data();
 
 		u32 size = (u32)s_historyBuffer.size();
 		for (s32 i = 0; i < snapshotCount; i++, snapshot++)
 		{
-			size += (u32)snapshot->compressedData.size();
+			size += (u32)(snapshot->records.size() * sizeof(s32));
 			size += (u32)snapshot->name.length();
 			size += sizeof(Snapshot);
 		}
+		const s32 chunkCount = (s32)s_chunks.size();
+		const HistoryChunk* chunk = s_chunks.data();
+		for (s32 i = 0; i < chunkCount; i++, chunk++)
+		{
+			size += (u32)chunk->data.size();
+			size += sizeof(HistoryChunk);
+		}
 		size += (u32)s_history.size() * sizeof(u32);
 		return size;
 	}
@@ -45,6 +45,9 @@ namespace TFE_Editor
 		
 	// Create new commands and snapshots.
 	void history_createSnapshot(const char* name=nullptr);
+	// Called by the snapshot create callback at the start of each record (such as a sector), so records that
+	// did not change are shared with earlier snapshots and changed records are stored as diffs.
+	void history_markSnapshotRecord(const SnapshotBuffer* buffer);
 	bool history_createCommand(u16 cmd, u16 name);
 	void history_step(s32 count);
 	void history_setPos(s32 pos);
@@ -1,4 +1,5 @@
 #include "filestream.h"
+#include "pathIndex.h"
 #include <TFE_Archive/archive.h>
 #include <cassert>
 #include <cstring>
@@ -36,6 +37,11 @@ bool FileStream::open(const char* filename, AccessMode mode)
 	m_file = fopen(filename, modeStrings[mode]);
 	m_mode = mode;
 
+	// Writing may create new files, so cached path lookups are no longer valid.
+	if (m_file && mode != MODE_READ)
+	{
+		TFE_PathIndex::invalidateAll();
+	}
 	return m_file != nullptr;
 }
 
@@ -144,6 +150,18 @@ u32 FileStream::readContents(const FilePath* filePath, void* output, size_t size
 	return 0;
 }
 
+const u8* FileStream::getMappedContents(const FilePath* filePath, size_t* size)
+{
+	if (!filePath->archive || filePath->index == INVALID_FILE) { return nullptr; }
+
+	const u8* data = filePath->archive->getFileData(filePath->index);
+	if (data)
+	{
+		*size = filePath->archive->getFileLength(filePath->index);
+	}
+	return data;
+}
+
 //derived from Stream
 bool FileStream::seek(s32 offset, Origin origin/*=ORIGIN_START*/)
 {
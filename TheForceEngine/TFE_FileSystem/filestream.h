@@ -2,6 +2,7 @@
 #include <TFE_FileSystem/stream.h>
 #include <TFE_FileSystem/paths.h>
 #include <cassert>
+#include <vector>
 
 ////////////////////////////////////////////////////
 // TODO: FileStream directly accesses arhive data.
@@ -24,6 +25,25 @@ public:
 	static u32 readContents(const char* filePath, void* output, size_t size);
 	static u32 readContents(const FilePath* filePath, void** output);
 	static u32 readContents(const FilePath* filePath, void* output, size_t size);
+
+	// Get a read-only view of a file stored in a memory mapped archive, or nullptr if it cannot be read in place.
+	static const u8* getMappedContents(const FilePath* filePath, size_t* size);
+	// Get a read-only view of the file contents, files in memory mapped archives are not copied.
+	// Otherwise the contents are read into 'buffer', which must outlive the view. Returns nullptr on failure.
+	template <typename T>
+	static const T* readView(const FilePath* filePath, std::vector<T>& buffer, size_t* size)
+	{
+		const u8* mapped = getMappedContents(filePath, size);
+		if (mapped) { return (const T*)mapped; }
+
+		FileStream file;
+		if (!file.open(filePath, MODE_READ)) { return nullptr; }
+		*size = file.getSize();
+		buffer.resize(*size);
+		file.readBuffer(buffer.data(), u32(*size));
+		file.close();
+		return buffer.data();
+	}
 	
 	//derived functions.
 	bool seek(s32 offset, Origin origin=ORIGIN_START) override;
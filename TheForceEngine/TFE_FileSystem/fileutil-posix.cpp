@@ -12,6 +12,7 @@
 #include <TFE_System/system.h>
 #include "fileutil.h"
 #include "filestream.h"
+#include "pathIndex.h"
 
 // implement TFE FileUtil for Linux and compatibles.
 namespace FileUtil
@@ -58,6 +59,33 @@ namespace FileUtil
 		closedir(d);
 	}
 
+	void readDirectoryFiles(const char *dir, FileList& fileList)
+	{
+		char buf[PATH_MAX];
+		struct dirent *de;
+		struct stat st;
+		int ret;
+		DIR *d;
+
+		d = opendir(dir);
+		if (!d) {
+			// Search paths that do not exist are expected.
+			if (errno != ENOENT && errno != ENOTDIR)
+				TFE_System::logWrite(LOG_WARNING, "readDirectoryFiles", "opendir(%s) failed with %d\n", dir, errno);
+			return;
+		}
+
+		while (NULL != (de = readdir(d))) {
+			memset(buf, 0, PATH_MAX);
+			snprintf(buf, PATH_MAX - 1, "%s%s", dir, de->d_name);
+			ret = stat(buf, &st);
+			if (ret || !S_ISREG(st.st_mode))
+				continue;
+			fileList.push_back(string(de->d_name));
+		}
+		closedir(d);
+	}
+
 	void readSubdirectories(const char *dir, FileList& dirList)
 	{
 		char *dn, fp[PATH_MAX];
@@ -209,6 +237,7 @@ namespace FileUtil
 			close(s);
 			return;
 		}
+		TFE_PathIndex::invalidateAll();
 
 		do {
 			rd = read(s, buf, 1024);
@@ -225,11 +254,20 @@ namespace FileUtil
 	void deleteFile(const char *fn)
 	{
 		int ret = unlink(fn);
+		TFE_PathIndex::invalidateAll();
 		if (ret) {
 			TFE_System::logWrite(LOG_WARNING, "deleteFile", "unlink(%s) failed with %d\n", fn, errno);
 		}
 	}
 
+	bool replaceFile(const char* srcFile, const char* dstFile)
+	{
+		// rename() replaces the destination atomically.
+		const bool res = rename(srcFile, dstFile) == 0;
+		TFE_PathIndex::invalidateAll();
+		return res;
+	}
+
 	bool directoryExits(const char *path, char *outPath)
 	{
 		char *ret;
@@ -366,6 +404,16 @@ namespace FileUtil
 		return mtim;
 	}
 
+	u64 getFileSize(const char *path)
+	{
+		struct stat st;
+		if (stat(path, &st))
+		{
+			return 0;
+		}
+		return (u64)st.st_size;
+	}
+
 	void fixupPath(char *path)
 	{
 		char *c = path;
@@ -1,6 +1,7 @@
 #pragma once
 #include "fileutil.h"
 #include "filestream.h"
+#include "pathIndex.h"
 
 #include <assert.h>
 #include <stdio.h>
@@ -30,6 +31,26 @@ namespace FileUtil
 		}
 	}
 
+	void readDirectoryFiles(const char* dir, FileList& fileList)
+	{
+		char searchStr[TFE_MAX_PATH];
+		_finddata_t fileInfo;
+
+		sprintf(searchStr, "%s*", dir);
+		intptr_t hFile = _findfirst(searchStr, &fileInfo);
+		if (hFile != -1)
+		{
+			do
+			{
+				if (!(fileInfo.attrib & _A_SUBDIR))
+				{
+					fileList.push_back( string(fileInfo.name) );
+				}
+			} while ( _findnext(hFile, &fileInfo) == 0 );
+			_findclose(hFile);
+		}
+	}
+
 	void readSubdirectories(const char* dir, FileList& dirList)
 	{
 		#ifdef _WIN32
@@ -214,11 +235,20 @@ namespace FileUtil
 	void copyFile(const char* srcFile, const char* dstFile)
 	{
 		CopyFile(srcFile, dstFile, FALSE);
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void deleteFile(const char* srcFile)
 	{
 		DeleteFile(srcFile);
+		TFE_PathIndex::invalidateAll();
+	}
+
+	bool replaceFile(const char* srcFile, const char* dstFile)
+	{
+		const bool res = MoveFileExA(srcFile, dstFile, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+		TFE_PathIndex::invalidateAll();
+		return res;
 	}
 
 	bool directoryExits(const char* path, char* outPath)
@@ -256,6 +286,16 @@ namespace FileUtil
 		return modTime;
 	}
 
+	u64 getFileSize(const char* path)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA fileData;
+		if (!GetFileAttributesExA(path, GetFileExInfoStandard, &fileData))
+		{
+			return 0;
+		}
+		return u64(fileData.nFileSizeHigh) << 32ULL | u64(fileData.nFileSizeLow);
+	}
+
 	void fixupPath(char* path)
 	{
 		const size_t len = strlen(path);
@@ -9,6 +9,8 @@ typedef vector<string> FileList;
 namespace FileUtil
 {
 	void readDirectory(const char* dir, const char* ext, FileList& fileList);
+	// Read the names of all regular files in a directory (no subdirectories).
+	void readDirectoryFiles(const char* dir, FileList& fileList);
 	bool makeDirectory(const char* dir);
 	void getCurrentDirectory(char* dir);
 	void getExecutionDirectory(char* dir);
@@ -22,10 +24,14 @@ namespace FileUtil
 
 	void copyFile(const char* srcFile, const char* dstFile);
 	void deleteFile(const char* srcFile);
+	// Move 'srcFile' to 'dstFile', atomically replacing 'dstFile' if it exists.
+	bool replaceFile(const char* srcFile, const char* dstFile);
 
 	bool exists(const char* path);
 	bool directoryExits(const char* path, char* outPath = nullptr);
 	u64  getModifiedTime(const char* path);
+	// Returns 0 if the file does not exist.
+	u64  getFileSize(const char* path);
 
 	void fixupPath(char* path);
 	void convertToOSPath(const char* path, char* pathOS);
@@ -1,99 +1,144 @@
 #include "filewriterAsync.h"
+#include "filestream.h"
+#include <TFE_System/profiler.h>
 #include <assert.h>
-#include <stdio.h>
-#include <stdarg.h>
-#include <vector>
-
-#ifdef _WIN32
-#define WIN32_LEAN_AND_MEAN 1
-#include <Windows.h>
-#endif
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
 
 namespace FileWriterAsync
 {
-#ifdef _WIN32
-	#define MAX_REQUEST_COUNT 32
+	enum WriterConstants
+	{
+		MAX_REQUEST_COUNT = 32,
+	};
 
 	struct WriteRequest
 	{
+		std::string path;
 		std::vector<u8> buffer;
-		OVERLAPPED file;
 
 		FileWriteCompletionCallback callback;
 		void* userData;
 	};
-	WriteRequest s_requests[MAX_REQUEST_COUNT];
-	s32 s_freeRequests[MAX_REQUEST_COUNT];
-	s32 s_processRequest[MAX_REQUEST_COUNT];
 
-	std::atomic<s32> s_requestCount = 0;
-	std::atomic<s32> s_freeRequestCount = 0;
-	std::atomic<s32> s_processRequestCount = 0;
+	static std::thread s_writer;
+	static std::mutex s_mutex;
+	static std::condition_variable s_wake;
+	static std::condition_variable s_done;
+	static std::deque<WriteRequest> s_requests;
+	// Requests that have been queued but not completed, including the one being written.
+	static s32 s_pendingCount = 0;
+	static bool s_quit = false;
 
-	void CALLBACK fileWrittenCallback(DWORD dwErrorCode, DWORD dwBytesTransferred, LPOVERLAPPED lpOverlapped)
+	static void writeRequest(WriteRequest& request)
 	{
-		// Note that this won't be called unless the calling thread is waiting in an "alertable" state.
-		const size_t id = (size_t)lpOverlapped->hEvent;
-		WriteRequest& request = s_requests[id];
+		u32 errorCode = AFW_SUCCESS;
+		size_t bytesWritten = 0;
 
-		if (dwErrorCode == 0 && request.callback)	// Success
+		FileStream file;
+		if (file.open(request.path.c_str(), Stream::MODE_WRITE))
 		{
-			request.callback(size_t(dwBytesTransferred), request.userData, u32(dwErrorCode));
+			file.writeBuffer(request.buffer.data(), u32(request.buffer.size()));
+			bytesWritten = file.getLoc();
+			file.close();
+
+			if (bytesWritten != request.buffer.size())
+			{
+				TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot write file: %s", request.path.c_str());
+				errorCode = AFW_ERROR_WRITE;
+			}
 		}
-		else if (request.callback)  // Failure
+		else
 		{
-			request.callback(0, request.userData, u32(dwErrorCode));
+			TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot open file for writing: %s", request.path.c_str());
+			errorCode = AFW_ERROR_OPEN;
 		}
 
-		request.buffer.clear();
-		s_freeRequests[s_freeRequestCount++] = id;
+		if (request.callback)
+		{
+			request.callback(bytesWritten, request.userData, errorCode);
+		}
 	}
 
-	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback, void* userData)
+	static void writerLoop()
 	{
-		size_t index = 0;
-		if (s_freeRequestCount)
+		TFE_Profiler::setThreadName("File Writer");
+		std::unique_lock<std::mutex> lock(s_mutex);
+		while (1)
 		{
-			index = s_freeRequests[s_freeRequestCount - 1];
-			s_freeRequestCount--;
-		}
-		else if (s_requestCount < MAX_REQUEST_COUNT)
-		{
-			index = s_requestCount;
-			s_requestCount++;
-		}
-		else
-		{
-			return false;
-		}
+			s_wake.wait(lock, [] { return s_quit || !s_requests.empty(); });
+			if (s_requests.empty()) { break; }
 
-		WriteRequest* request = &s_requests[index];
-		request->buffer.resize(dataSize);
-		memcpy(request->buffer.data(), data, dataSize);
+			WriteRequest request = std::move(s_requests.front());
+			s_requests.pop_front();
 
-		request->callback = completionCallback;
-		request->userData = userData;
+			lock.unlock();
+			writeRequest(request);
+			lock.lock();
 
-		HANDLE hFile = CreateFile(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_FLAG_OVERLAPPED, NULL);
-		if (hFile == INVALID_HANDLE_VALUE)
-		{
-			TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot create file handle for: %s", path);
-			return false;
+			s_pendingCount--;
+			if (s_pendingCount == 0)
+			{
+				s_done.notify_all();
+			}
 		}
+	}
 
-		memset(&request->file, 0, sizeof(OVERLAPPED));
-		request->file.Offset = 0;
-		request->file.OffsetHigh = 0;
-		request->file.hEvent = HANDLE(index);
+	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback, void* userData)
+	{
+		return writeFileToDisk(path, std::vector<u8>(data, data + dataSize), completionCallback, userData);
+	}
 
-		if (!WriteFileEx(hFile, request->buffer.data(), DWORD(dataSize), &request->file, fileWrittenCallback))
+	bool writeFileToDisk(const char* path, std::vector<u8>&& data, FileWriteCompletionCallback completionCallback, void* userData)
+	{
+		if (!path || data.size() > 0xffffffffu) { return false; }
 		{
-			TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Cannot write file: %s", path);
-			return false;
-		}
+			std::lock_guard<std::mutex> lock(s_mutex);
+			if (s_pendingCount >= MAX_REQUEST_COUNT)
+			{
+				TFE_System::logWrite(LOG_ERROR, "AsyncFileWrite", "Too many queued writes, cannot write file: %s", path);
+				return false;
+			}
 
-		CloseHandle(hFile);
+			WriteRequest request;
+			request.path = path;
+			request.buffer = std::move(data);
+			request.callback = completionCallback;
+			request.userData = userData;
+			s_requests.push_back(std::move(request));
+			s_pendingCount++;
+
+			// The writer thread is started on demand.
+			if (!s_writer.joinable())
+			{
+				s_quit = false;
+				s_writer = std::thread(writerLoop);
+			}
+		}
+		s_wake.notify_one();
 		return true;
 	}
-#endif
+
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+		s_done.wait(lock, [] { return s_pendingCount == 0; });
+	}
+
+	void shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_quit = true;
+		}
+		s_wake.notify_all();
+		// The writer thread finishes the queued requests before exiting.
+		if (s_writer.joinable())
+		{
+			s_writer.join();
+		}
+	}
 };
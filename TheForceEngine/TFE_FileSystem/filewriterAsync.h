@@ -1,15 +1,32 @@
 #pragma once
+//////////////////////////////////////////////////////////////////////
+// Asynchronous file writer
+// Files are written by a background thread so that the game loop
+// never waits on the disk. Requests are written in the order they
+// are queued.
+//////////////////////////////////////////////////////////////////////
 #include <TFE_System/system.h>
+#include <vector>
 
-// TODO: Flesh out error codes.
 enum AsyncFileWriteCodes
 {
 	AFW_SUCCESS = 0,
+	AFW_ERROR_OPEN,		// The file could not be opened for writing.
+	AFW_ERROR_WRITE,	// Writing the data failed, the file may be incomplete.
 };
 
+// Called from the writer thread once the file has been written or has failed to write.
 typedef void(*FileWriteCompletionCallback)(size_t bytesWritten, void* userData, u32 errorCode);
 
 namespace FileWriterAsync
 {
+	// Queue a copy of 'data' to be written to 'path', returns false if the request cannot be queued.
 	bool writeFileToDisk(const char* path, u8* data, size_t dataSize, FileWriteCompletionCallback completionCallback = nullptr, void* userData = nullptr);
+	// Same as above, but takes ownership of the data instead of copying it.
+	bool writeFileToDisk(const char* path, std::vector<u8>&& data, FileWriteCompletionCallback completionCallback = nullptr, void* userData = nullptr);
+
+	// Blocks until all queued writes have completed, call before reading back a file that may still be queued.
+	void flush();
+	// Completes the queued writes and stops the writer thread.
+	void shutdown();
 };
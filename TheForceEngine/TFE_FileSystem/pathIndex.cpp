@@ -0,0 +1,116 @@
+#include <cstring>
+#include <cctype>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "pathIndex.h"
+#include "fileutil.h"
+#include <TFE_Archive/archive.h>
+
+namespace TFE_PathIndex
+{
+	struct CachedPath
+	{
+		bool found;
+		Archive* archive;
+		u32 index;
+		std::string path;
+	};
+	typedef std::unordered_map<std::string, CachedPath> PathMap;
+	typedef std::unordered_set<std::string> FileNameSet;
+	typedef std::unordered_map<std::string, FileNameSet> DirectoryMap;
+
+	// getFilePath() may be called from the loading or editor threads, so access is guarded.
+	static std::mutex s_mutex;
+	static PathMap s_results;
+	static DirectoryMap s_directories;
+
+	static void toLowerKey(const char* name, std::string& key)
+	{
+		const size_t len = strlen(name);
+		key.resize(len);
+		for (size_t i = 0; i < len; i++)
+		{
+			key[i] = (char)tolower((u8)name[i]);
+		}
+	}
+
+	void invalidateAll()
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		s_results.clear();
+		s_directories.clear();
+	}
+
+	bool getCachedResult(const char* fileName, FilePath* outPath, bool* found)
+	{
+		std::string key;
+		toLowerKey(fileName, key);
+
+		std::lock_guard<std::mutex> lock(s_mutex);
+		PathMap::const_iterator iPath = s_results.find(key);
+		if (iPath == s_results.end())
+		{
+			return false;
+		}
+
+		const CachedPath& cached = iPath->second;
+		*found = cached.found;
+		if (cached.found)
+		{
+			outPath->archive = cached.archive;
+			outPath->index = cached.index;
+			strncpy(outPath->path, cached.path.c_str(), TFE_MAX_PATH - 1);
+			outPath->path[TFE_MAX_PATH - 1] = 0;
+		}
+		return true;
+	}
+
+	void cacheResult(const char* fileName, const FilePath* path, bool found)
+	{
+		CachedPath cached;
+		cached.found = found;
+		cached.archive = found ? path->archive : nullptr;
+		cached.index = found ? path->index : INVALID_FILE;
+		if (found) { cached.path = path->path; }
+
+		std::string key;
+		toLowerKey(fileName, key);
+
+		std::lock_guard<std::mutex> lock(s_mutex);
+		s_results[key] = cached;
+	}
+
+	bool directoryContainsFile(const char* dir, const char* fileName, bool* exists)
+	{
+		// Only plain file names can be answered from the listing.
+		if (strchr(fileName, '/') || strchr(fileName, '\\'))
+		{
+			return false;
+		}
+
+		std::string key;
+		toLowerKey(fileName, key);
+
+		std::lock_guard<std::mutex> lock(s_mutex);
+		DirectoryMap::iterator iDir = s_directories.find(dir);
+		if (iDir == s_directories.end())
+		{
+			FileList fileList;
+			FileUtil::readDirectoryFiles(dir, fileList);
+
+			FileNameSet& names = s_directories[dir];
+			std::string lowerName;
+			for (size_t i = 0; i < fileList.size(); i++)
+			{
+				toLowerKey(fileList[i].c_str(), lowerName);
+				names.insert(lowerName);
+			}
+			iDir = s_directories.find(dir);
+		}
+
+		*exists = iDir->second.find(key) != iDir->second.end();
+		return true;
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Path Index
+// Caches the results of TFE_Paths::getFilePath() so that repeated
+// lookups skip the search path probes and archive directory scans,
+// and caches directory listings of the loose-file search paths.
+//
+// Everything, including directory listings, is invalidated whenever
+// search paths, archives or file mappings change, when archives are
+// freed or have files added, and whenever TFE creates, replaces or
+// deletes a file (FileStream writes and the FileUtil file operations).
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include "paths.h"
+
+namespace TFE_PathIndex
+{
+	// Clear cached results and directory listings.
+	void invalidateAll();
+
+	// Returns true if a result is cached for 'fileName', in which case 'found' and 'outPath' are filled in.
+	bool getCachedResult(const char* fileName, FilePath* outPath, bool* found);
+	// Store the result of a getFilePath() search.
+	void cacheResult(const char* fileName, const FilePath* path, bool found);
+
+	// Returns true if the directory listing can answer the query, in which case 'exists' is set.
+	// File names with path separators cannot be answered from the listing.
+	bool directoryContainsFile(const char* dir, const char* fileName, bool* exists);
+}
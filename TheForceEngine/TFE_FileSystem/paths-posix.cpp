@@ -3,6 +3,7 @@
 #include "paths.h"
 #include "fileutil.h"
 #include "filestream.h"
+#include "pathIndex.h"
 #include <TFE_System/system.h>
 #include <TFE_Archive/archive.h>
 #include <algorithm>
@@ -209,6 +210,7 @@ namespace TFE_Paths
 			}
 		}
 		s_searchPaths.push_back(workpath);
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void addSearchPathToHead(const char *fullPath)
@@ -227,12 +229,14 @@ namespace TFE_Paths
 			}
 		}
 		s_searchPaths.push_front(workpath);
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void clearSearchPaths(void)
 	{
 		s_searchPaths.clear();
 		s_fileMappings.clear();
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void clearLocalArchives(void)
@@ -240,6 +244,7 @@ namespace TFE_Paths
 		std::for_each(s_localArchives.begin(), s_localArchives.end(),
 				[](Archive *a) { Archive::freeArchive(a); });
 		s_localArchives.clear();
+		TFE_PathIndex::invalidateAll();
 	}
 
 	// Add a single file that can be referenced by 'fileName' even though the real name may be different.
@@ -255,6 +260,7 @@ namespace TFE_Paths
 
 		FileMapping mapping = { fileNameLC, filePathFixed };
 		s_fileMappings.push_back(mapping);
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void addLocalSearchPath(const char *locpath)
@@ -287,31 +293,31 @@ namespace TFE_Paths
 	void addLocalArchiveToFront(Archive *a)
 	{
 		s_localArchives.push_front(a);
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void removeFirstArchive(void)
 	{
 		s_localArchives.pop_front();
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void addLocalArchive(Archive *a)
 	{
 		s_localArchives.push_back(a);
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void removeLastArchive(void)
 	{
 		s_localArchives.pop_back();
+		TFE_PathIndex::invalidateAll();
 	}
 
-	bool getFilePath(const char *fileName, FilePath *outPath)
+	static bool getFilePathUncached(const char *fileName, FilePath *outPath)
 	{
 		char fullname[TFE_MAX_PATH];
 
-		outPath->archive = nullptr;
-		outPath->index = INVALID_FILE;
-		outPath->path[0] = 0;
-
 		// Search for any filemappings.
 		// This is usually only used with mods and usually limited to 0-3 files.
 		for (auto it = s_fileMappings.begin(); it != s_fileMappings.end(); it++) {
@@ -324,7 +330,11 @@ namespace TFE_Paths
 		// Search in the local search paths before local archives: s_searchPaths.
 		for (auto it = s_searchPaths.begin(); it != s_searchPaths.end(); it++) {
 			sprintf(fullname, "%s%s", it->c_str(), fileName);
-			if (FileUtil::existsNoCase(fullname)) {
+			// Use the cached directory listing when possible, existsNoCase() scans the whole directory.
+			bool exists = false;
+			if (!TFE_PathIndex::directoryContainsFile(it->c_str(), fileName, &exists))
+				exists = FileUtil::existsNoCase(fullname);
+			if (exists) {
 				strncpy(outPath->path, fullname, TFE_MAX_PATH);
 				return true;
 			}
@@ -344,6 +354,22 @@ namespace TFE_Paths
 		return false;
 	}
 
+	bool getFilePath(const char *fileName, FilePath *outPath)
+	{
+		bool found = false;
+
+		outPath->archive = nullptr;
+		outPath->index = INVALID_FILE;
+		outPath->path[0] = 0;
+
+		if (TFE_PathIndex::getCachedResult(fileName, outPath, &found))
+			return found;
+
+		found = getFilePathUncached(fileName, outPath);
+		TFE_PathIndex::cacheResult(fileName, outPath, found);
+		return found;
+	}
+
 	// Return true if we want to use a "portable" install - 
 	// aka all data such as screenshots, settings, etc. are stored in the
 	// TFE directory.
@@ -2,6 +2,7 @@
 #include "paths.h"
 #include "fileutil.h"
 #include "filestream.h"
+#include "pathIndex.h"
 #include <TFE_System/system.h>
 #include <TFE_Archive/archive.h>
 #include <string>
@@ -200,6 +201,7 @@ namespace TFE_Paths
 			}
 
 			s_searchPaths.push_back(fullPath);
+			TFE_PathIndex::invalidateAll();
 		}
 	}
 
@@ -219,6 +221,7 @@ namespace TFE_Paths
 			}
 
 			s_searchPaths.insert(s_searchPaths.begin(), fullPath);
+			TFE_PathIndex::invalidateAll();
 		}
 	}
 
@@ -226,6 +229,7 @@ namespace TFE_Paths
 	{
 		s_searchPaths.clear();
 		s_fileMappings.clear();
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void clearLocalArchives()
@@ -237,6 +241,7 @@ namespace TFE_Paths
 			Archive::freeArchive(archive[i]);
 		}
 		s_localArchives.clear();
+		TFE_PathIndex::invalidateAll();
 	}
 
 	// Add a single file that can be referenced by 'fileName' even though the real name may be different.
@@ -252,6 +257,7 @@ namespace TFE_Paths
 
 		FileMapping mapping = { fileNameLC, filePathFixed };
 		s_fileMappings.push_back(mapping);
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void addLocalSearchPath(const char* localSearchPath)
@@ -284,29 +290,29 @@ namespace TFE_Paths
 	void addLocalArchiveToFront(Archive* archive)
 	{
 		s_localArchives.insert(s_localArchives.begin(), archive);
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void removeFirstArchive()
 	{
 		s_localArchives.erase(s_localArchives.begin());
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void addLocalArchive(Archive* archive)
 	{
 		s_localArchives.push_back(archive);
+		TFE_PathIndex::invalidateAll();
 	}
 
 	void removeLastArchive()
 	{
 		s_localArchives.pop_back();
+		TFE_PathIndex::invalidateAll();
 	}
 
-	bool getFilePath(const char* fileName, FilePath* outPath)
+	static bool getFilePathUncached(const char* fileName, FilePath* outPath)
 	{
-		outPath->archive = nullptr;
-		outPath->index = INVALID_FILE;
-		outPath->path[0] = 0;
-
 		// Search for any filemappings.
 		// This is usually only used with mods and usually limited to 0-3 files.
 		const size_t mappingCount  = s_fileMappings.size();
@@ -329,8 +335,14 @@ namespace TFE_Paths
 			char fullName[TFE_MAX_PATH];
 			sprintf(fullName, "%s%s", localPath->c_str(), fileName);
 
-			FileStream file;
-			if (file.exists(fullName))
+			// Use the cached directory listing when possible to avoid a filesystem probe.
+			bool exists = false;
+			if (!TFE_PathIndex::directoryContainsFile(localPath->c_str(), fileName, &exists))
+			{
+				FileStream file;
+				exists = file.exists(fullName);
+			}
+			if (exists)
 			{
 				strncpy(outPath->path, fullName, TFE_MAX_PATH);
 				return true;
@@ -356,6 +368,22 @@ namespace TFE_Paths
 		// Finally admit defeat.
 		return false;
 	}
+
+	bool getFilePath(const char* fileName, FilePath* outPath)
+	{
+		outPath->archive = nullptr;
+		outPath->index = INVALID_FILE;
+		outPath->path[0] = 0;
+
+		bool found = false;
+		if (TFE_PathIndex::getCachedResult(fileName, outPath, &found))
+		{
+			return found;
+		}
+		found = getFilePathUncached(fileName, outPath);
+		TFE_PathIndex::cacheResult(fileName, outPath, found);
+		return found;
+	}
 		
 	bool insertString(char* text, const char* newFragment, const char* pattern)
 	{
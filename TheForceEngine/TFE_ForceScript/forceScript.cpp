@@ -1,10 +1,19 @@
 #include "forceScript.h"
 #include "float2.h"
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
 #include <TFE_FrontEndUI/frontEndUi.h>
+#include <TFE_FrontEndUI/console.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/mappedFile.h>
+#include <TFE_FileSystem/paths.h>
 #include <stdint.h>
 #include <cstring>
 #include <algorithm>
+#include <string>
+#include <vector>
+#include <unordered_set>
 #include <assert.h>
 
 #ifdef ENABLE_FORCE_SCRIPT
@@ -17,19 +26,142 @@
 namespace TFE_ForceScript
 {
 	const asPWORD ThreadId = 1002;
+	// TFE: Compiled modules are cached as bytecode, see createModule().
+	const u32 ScriptCacheMagic = 0x43425346;	// "FSBC"
+	const u32 ScriptCacheVersion = 2;		// 2: precompiled files record their includes.
+	const char* c_precompiledExt = "fsb";
+	const u64 HashSeed = 14695981039346656037ull;
 	
+	// TFE: Script threads share a per-frame time budget, see update().
+	// The clock is only read every LineCheckInterval line callbacks (must be a power of 2).
+	const u32 LineCheckInterval = 16;
+	// The first thread to run each frame always gets at least this long, so scripts make progress on slow frames.
+	const f64 MinSliceSeconds = 0.0002;
+
 	struct ScriptThread
 	{
 		asIScriptContext* asContext;
 		f32 delay;
+		// Scheduling.
+		s32 priority;
+		u32 order;			// Start order, keeps the schedule stable within a priority.
+		u32 waitFrames;		// Frames spent ready to run but held back by the budget, so threads take turns.
+		// Stats.
+		const char* name;	// Interned function declaration.
+		u64 frameTicks;		// CPU time during the last update.
+		u64 totalTicks;
+		u32 runFrames;
+		u32 preemptCount;
+	};
+
+	struct ScriptCacheHeader
+	{
+		u32 magic;
+		u32 version;
+		u64 engineHash;			// AngelScript version and build options.
+		u64 apiHash;			// Every registered function, type and property.
+		u64 sourceHash;			// Contents of the root script section.
+		u32 dependencyCount;	// Files pulled in by #include, stored as: u32 length, path, u64 hash.
+		u32 byteCodeSize;
+	};
+
+	struct ScriptDependency
+	{
+		std::string path;
+		u64 hash;
+	};
+
+	// Counts used to detect when more of the API has been registered, so the API hash is only rebuilt when needed.
+	struct ScriptApiShape
+	{
+		asUINT globalFuncCount;
+		asUINT globalPropCount;
+		asUINT typeCount;
+		asUINT typeMemberCount;
+		asUINT enumCount;
+		asUINT funcdefCount;
+		asUINT typedefCount;
+	};
+
+	class ByteCodeWriter : public asIBinaryStream
+	{
+	public:
+		std::vector<u8> data;
+
+		int Read(void* ptr, asUINT size) override { return asERROR; }
+		int Write(const void* ptr, asUINT size) override
+		{
+			data.insert(data.end(), (const u8*)ptr, (const u8*)ptr + size);
+			return asSUCCESS;
+		}
+	};
+
+	class ByteCodeReader : public asIBinaryStream
+	{
+	public:
+		ByteCodeReader(const u8* data, u32 size) : m_data(data), m_size(size), m_offset(0) {}
+
+		int Read(void* ptr, asUINT size) override
+		{
+			if (size > m_size - m_offset)
+			{
+				memset(ptr, 0, size);
+				return asERROR;
+			}
+			memcpy(ptr, m_data + m_offset, size);
+			m_offset += size;
+			return asSUCCESS;
+		}
+		int Write(const void* ptr, asUINT size) override { return asERROR; }
+
+	private:
+		const u8* m_data;
+		u32 m_size;
+		u32 m_offset;
 	};
 
 	static asIScriptEngine* s_engine = nullptr;
 	static std::vector<ScriptThread> s_scriptThreads;
 	static std::vector<s32> s_freeThreads;
+	static std::vector<s32> s_runQueue;
+	static std::unordered_set<std::string> s_threadNames;
+	static u32 s_threadOrder = 0;
 	ScriptMessageCallback s_msgCallback = nullptr;
 
+	// Scheduler state.
+	static f32 s_frameBudgetMs = 0.0f;	// 0 = no limit, so scripts run to completion unless a budget is set.
+	static u64 s_sliceDeadline = 0;	// 0 = no limit.
+	static u32 s_lineCount = 0;
+	static bool s_preempted = false;
+	static s32 s_activeScripts = 0;
+	static s32 s_preemptedScripts = 0;
+
 	static s32 s_typeId[FSTYPE_COUNT] = { 0 };
+	static u64 s_engineHash = 0;
+	static u64 s_apiHash = 0;
+	static ScriptApiShape s_apiShape = { 0 };
+
+	// FNV-1a
+	static u64 hashData(u64 hash, const void* data, size_t size)
+	{
+		const u8* bytes = (const u8*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static u64 hashString(u64 hash, const char* str)
+	{
+		// Include the terminator so adjacent strings cannot run together.
+		return str ? hashData(hash, str, strlen(str) + 1) : hashData(hash, "", 1);
+	}
+
+	static u64 hashValue(u64 hash, s64 value)
+	{
+		return hashData(hash, &value, sizeof(value));
+	}
 
 	// Script message callback.
 	void messageCallback(const asSMessageInfo* msg, void* param)
@@ -63,6 +195,58 @@ namespace TFE_ForceScript
 		s_scriptThreads[id].delay = 0.0f;
 	}
 
+	// Called by AngelScript at each statement, suspends the script once its time slice is spent.
+	void lineCallback(asIScriptContext* context, void* param)
+	{
+		if (++s_lineCount & (LineCheckInterval - 1)) { return; }
+		if (TFE_System::getCurrentTimeInTicks() >= s_sliceDeadline)
+		{
+			s_preempted = true;
+			context->Suspend();
+		}
+	}
+
+	void scriptStatsConsole(const ConsoleArgList& args)
+	{
+		char line[256];
+		TFE_Console::addToHistory("------------------------------------------------------------------------");
+		TFE_Console::addToHistory("  Id | Priority | Frame (ms) | Average (ms) | Preempted | Function");
+		TFE_Console::addToHistory("------------------------------------------------------------------------");
+		const s32 count = (s32)s_scriptThreads.size();
+		for (s32 i = 0; i < count; i++)
+		{
+			const ScriptThread* thread = &s_scriptThreads[i];
+			if (!thread->asContext) { continue; }
+
+			const f64 frameMs = TFE_System::convertFromTicksToSeconds(thread->frameTicks) * 1000.0;
+			const f64 aveMs = thread->runFrames ? TFE_System::convertFromTicksToSeconds(thread->totalTicks) * 1000.0 / f64(thread->runFrames) : 0.0;
+			sprintf(line, "%4d | %8d | %10.3f | %12.3f | %9u | %s", i, thread->priority, frameMs, aveMs, thread->preemptCount, thread->name);
+			TFE_Console::addToHistory(line);
+		}
+		TFE_Console::addToHistory("------------------------------------------------------------------------");
+	}
+
+	// Lets mods precompile scripts without the editor, with the API registered by the running game.
+	void scriptPrecompileConsole(const ConsoleArgList& args)
+	{
+		if (args.size() < 2)
+		{
+			TFE_Console::addToHistory("Usage: scriptPrecompile scriptPath [outputPath]");
+			return;
+		}
+		const char* outputPath = args.size() >= 3 ? args[2].c_str() : nullptr;
+		char msg[TFE_MAX_PATH + 64];
+		if (precompileModule(args[1].c_str(), outputPath))
+		{
+			sprintf(msg, "Precompiled script '%s'.", args[1].c_str());
+		}
+		else
+		{
+			sprintf(msg, "Failed to precompile script '%s', see the log for details.", args[1].c_str());
+		}
+		TFE_Console::addToHistory(msg);
+	}
+
 	s32 getObjectTypeId(FS_BuiltInType type)
 	{
 		return s_typeId[type];
@@ -86,6 +270,17 @@ namespace TFE_ForceScript
 
 		registerScriptMath_float2(s_engine);
 		s_typeId[FSTYPE_FLOAT2] = getFloat2ObjectId();
+
+		// Bytecode is only portable between identical AngelScript builds.
+		s_engineHash = hashString(HashSeed, asGetLibraryVersion());
+		s_engineHash = hashString(s_engineHash, asGetLibraryOptions());
+		s_apiHash = 0;
+
+		CVAR_FLOAT(s_frameBudgetMs, "d_scriptFrameBudget", CVFLAG_NONE, "Maximum time in milliseconds that scripts may run each frame before being suspended until the next frame, 0 = no limit.");
+		CCMD("scriptStats", scriptStatsConsole, 0, "Lists the running script functions with their priority and CPU time.");
+		CCMD("scriptPrecompile", scriptPrecompileConsole, 1, "Compiles a script to bytecode, written beside it as <name>.fsb unless an output path is given - scriptPrecompile scriptPath [outputPath]");
+		TFE_COUNTER(s_activeScripts, "Scripts Active");
+		TFE_COUNTER(s_preemptedScripts, "Scripts Preempted");
 	}
 
 	void destroy()
@@ -104,32 +299,101 @@ namespace TFE_ForceScript
 		s_msgCallback = callback;
 	}
 
+	static bool runsBefore(s32 a, s32 b)
+	{
+		const ScriptThread& threadA = s_scriptThreads[a];
+		const ScriptThread& threadB = s_scriptThreads[b];
+		if (threadA.priority != threadB.priority) { return threadA.priority > threadB.priority; }
+		if (threadA.waitFrames != threadB.waitFrames) { return threadA.waitFrames > threadB.waitFrames; }
+		return threadA.order < threadB.order;
+	}
+
+	// Script threads run in priority order until the frame budget is spent. A thread still running when the budget
+	// runs out is suspended from the line callback and resumed next frame, threads that did not get to run at all go
+	// first within their priority.
 	void update()
 	{
+		TFE_ZONE("Script Update");
 		const f32 dt = (f32)TFE_System::getDeltaTime();
 		const s32 count = (s32)s_scriptThreads.size();
-		ScriptThread* thread = s_scriptThreads.data();
+		s_runQueue.clear();
+		s_activeScripts = 0;
+		s_preemptedScripts = 0;
 		for (s32 i = 0; i < count; i++)
 		{
 			// Allow for holes to keep IDs consistent.
 			// Fill holes with new threads.
-			if (thread[i].asContext == nullptr) { continue; }
+			ScriptThread* thread = &s_scriptThreads[i];
+			if (thread->asContext == nullptr) { continue; }
 
-			thread[i].delay = std::max(0.0f, thread[i].delay - dt);
-			if (thread[i].delay == 0.0f)
+			s_activeScripts++;
+			thread->frameTicks = 0;
+			thread->delay = std::max(0.0f, thread->delay - dt);
+			if (thread->delay == 0.0f)
 			{
-				asIScriptContext* context = thread[i].asContext;
-				s32 res = context->Execute();
-				if (res != asEXECUTION_SUSPENDED)
+				s_runQueue.push_back(i);
+			}
+		}
+		std::sort(s_runQueue.begin(), s_runQueue.end(), runsBefore);
+
+		const f64 ticksPerSecond = 1.0 / TFE_System::convertFromTicksToSeconds(1);
+		const u64 frameStart = TFE_System::getCurrentTimeInTicks();
+		const u64 frameDeadline = s_frameBudgetMs > 0.0f ? frameStart + u64(f64(s_frameBudgetMs) * 0.001 * ticksPerSecond) : 0;
+		const u64 minSliceTicks = u64(MinSliceSeconds * ticksPerSecond);
+
+		const s32 runCount = (s32)s_runQueue.size();
+		for (s32 r = 0; r < runCount; r++)
+		{
+			// Index instead of holding a pointer, scripts may start new threads while executing.
+			const s32 id = s_runQueue[r];
+			const u64 start = TFE_System::getCurrentTimeInTicks();
+			if (frameDeadline && r > 0 && start >= frameDeadline)
+			{
+				s_scriptThreads[id].waitFrames++;
+				continue;
+			}
+			s_sliceDeadline = (frameDeadline && r == 0) ? std::max(frameDeadline, start + minSliceTicks) : frameDeadline;
+			s_preempted = false;
+
+			asIScriptContext* context = s_scriptThreads[id].asContext;
+			// The line callback is only needed to enforce the budget, without one scripts run at full speed.
+			// The budget can change between frames, so the callback is set or cleared for every slice.
+			if (s_sliceDeadline)
+			{
+				context->SetLineCallback(asFUNCTION(lineCallback), nullptr, asCALL_CDECL);
+			}
+			else
+			{
+				context->ClearLineCallback();
+			}
+			TFE_ZONE_BEGIN(scriptZone, s_scriptThreads[id].name);
+			s32 res = context->Execute();
+			TFE_ZONE_END(scriptZone);
+
+			ScriptThread* thread = &s_scriptThreads[id];
+			const u64 ticks = TFE_System::getCurrentTimeInTicks() - start;
+			thread->frameTicks += ticks;
+			thread->totalTicks += ticks;
+			thread->runFrames++;
+			thread->waitFrames = 0;
+			if (res == asEXECUTION_SUSPENDED)
+			{
+				if (s_preempted)
 				{
-					// Finally done!
-					s_engine->ReturnContext(context);
-					thread[i].asContext = nullptr;
-					thread[i].delay = 0.0f;
-					s_freeThreads.push_back(i);
+					thread->preemptCount++;
+					s_preemptedScripts++;
 				}
 			}
+			else
+			{
+				// Finally done!
+				s_engine->ReturnContext(context);
+				thread->asContext = nullptr;
+				thread->delay = 0.0f;
+				s_freeThreads.push_back(id);
+			}
 		}
+		s_sliceDeadline = 0;
 	}
 
 	void stopAllFunc()
@@ -159,36 +423,268 @@ namespace TFE_ForceScript
 		return s_engine;
 	}
 		
-	ModuleHandle createModule(const char* moduleName, const char* filePath)
+	/////////////////////////////////////////////////
+	// Bytecode Cache
+	/////////////////////////////////////////////////
+	static ScriptApiShape getApiShape()
 	{
-		CScriptBuilder builder;
-		s32 res = builder.StartNewModule(s_engine, moduleName);
-		if (res < 0)
+		ScriptApiShape shape = { 0 };
+		shape.globalFuncCount = s_engine->GetGlobalFunctionCount();
+		shape.globalPropCount = s_engine->GetGlobalPropertyCount();
+		shape.typeCount = s_engine->GetObjectTypeCount();
+		for (asUINT i = 0; i < shape.typeCount; i++)
+		{
+			const asITypeInfo* type = s_engine->GetObjectTypeByIndex(i);
+			shape.typeMemberCount += type->GetMethodCount() + type->GetPropertyCount() + type->GetBehaviourCount() + type->GetFactoryCount();
+		}
+		shape.enumCount = s_engine->GetEnumCount();
+		shape.funcdefCount = s_engine->GetFuncdefCount();
+		shape.typedefCount = s_engine->GetTypedefCount();
+		return shape;
+	}
+
+	// Bytecode refers to the application API by declaration, so it can only be loaded into an engine with the same API.
+	// Systems register their API lazily (such as the editor), so the hash is rebuilt whenever the API has grown.
+	static u64 getApiHash()
+	{
+		const ScriptApiShape shape = getApiShape();
+		if (s_apiHash && memcmp(&shape, &s_apiShape, sizeof(ScriptApiShape)) == 0)
+		{
+			return s_apiHash;
+		}
+
+		u64 hash = HashSeed;
+		for (asUINT i = 0; i < shape.globalFuncCount; i++)
+		{
+			const asIScriptFunction* func = s_engine->GetGlobalFunctionByIndex(i);
+			if (func) { hash = hashString(hash, func->GetDeclaration(true, true, true)); }
+		}
+		for (asUINT i = 0; i < shape.globalPropCount; i++)
+		{
+			const char* name = nullptr;
+			const char* nameSpace = nullptr;
+			s32 typeId = 0;
+			bool isConst = false;
+			s_engine->GetGlobalPropertyByIndex(i, &name, &nameSpace, &typeId, &isConst);
+			hash = hashString(hash, name);
+			hash = hashString(hash, nameSpace);
+			hash = hashString(hash, s_engine->GetTypeDeclaration(typeId, true));
+			hash = hashValue(hash, isConst);
+		}
+		for (asUINT i = 0; i < shape.typeCount; i++)
+		{
+			const asITypeInfo* type = s_engine->GetObjectTypeByIndex(i);
+			hash = hashString(hash, type->GetName());
+			hash = hashString(hash, type->GetNamespace());
+			hash = hashValue(hash, type->GetFlags());
+			hash = hashValue(hash, type->GetSize());
+			for (asUINT m = 0; m < type->GetFactoryCount(); m++)
+			{
+				hash = hashString(hash, type->GetFactoryByIndex(m)->GetDeclaration(true, true, true));
+			}
+			for (asUINT m = 0; m < type->GetBehaviourCount(); m++)
+			{
+				asEBehaviours behaviour;
+				const asIScriptFunction* func = type->GetBehaviourByIndex(m, &behaviour);
+				hash = hashValue(hash, behaviour);
+				hash = hashString(hash, func ? func->GetDeclaration(true, true, true) : nullptr);
+			}
+			for (asUINT m = 0; m < type->GetMethodCount(); m++)
+			{
+				hash = hashString(hash, type->GetMethodByIndex(m)->GetDeclaration(true, true, true));
+			}
+			for (asUINT m = 0; m < type->GetPropertyCount(); m++)
+			{
+				hash = hashString(hash, type->GetPropertyDeclaration(m, true));
+			}
+		}
+		for (asUINT i = 0; i < shape.enumCount; i++)
+		{
+			const asITypeInfo* type = s_engine->GetEnumByIndex(i);
+			hash = hashString(hash, type->GetName());
+			hash = hashString(hash, type->GetNamespace());
+			for (asUINT v = 0; v < type->GetEnumValueCount(); v++)
+			{
+				s32 value = 0;
+				hash = hashString(hash, type->GetEnumValueByIndex(v, &value));
+				hash = hashValue(hash, value);
+			}
+		}
+		for (asUINT i = 0; i < shape.funcdefCount; i++)
+		{
+			const asITypeInfo* type = s_engine->GetFuncdefByIndex(i);
+			hash = hashString(hash, type->GetFuncdefSignature()->GetDeclaration(true, true, true));
+		}
+		for (asUINT i = 0; i < shape.typedefCount; i++)
+		{
+			const asITypeInfo* type = s_engine->GetTypedefByIndex(i);
+			hash = hashString(hash, type->GetName());
+			hash = hashString(hash, s_engine->GetTypeDeclaration(type->GetTypedefTypeId(), true));
+		}
+
+		s_apiShape = shape;
+		s_apiHash = hash;
+		return hash;
+	}
+
+	static bool readScriptFile(const char* filePath, std::vector<char>& contents)
+	{
+		FileStream file;
+		if (!file.open(filePath, Stream::MODE_READ))
+		{
+			return false;
+		}
+		contents.resize(file.getSize());
+		if (!contents.empty())
+		{
+			file.readBuffer(contents.data(), u32(contents.size()));
+		}
+		file.close();
+		return true;
+	}
+
+	static void getCachePath(const char* sectionName, u64 sourceHash, char* cachePath, bool createDir)
+	{
+		char cacheDir[TFE_MAX_PATH];
+		sprintf(cacheDir, "%sScriptCache/", TFE_Paths::getPath(PATH_PROGRAM_DATA));
+		if (createDir && !FileUtil::directoryExits(cacheDir))
+		{
+			FileUtil::makeDirectory(cacheDir);
+		}
+
+		// Section names end up in the debug info, so they are part of the key.
+		u64 key = hashString(sourceHash, sectionName);
+		key = hashValue(key, s64(s_engineHash));
+		key = hashValue(key, s64(getApiHash()));
+		sprintf(cachePath, "%s%016llx.fsc", cacheDir, (unsigned long long)key);
+	}
+
+	// Every section the builder loaded from disk, so edits to included files invalidate the bytecode.
+	static bool getDependencies(CScriptBuilder& builder, std::vector<ScriptDependency>& dependencies)
+	{
+		std::vector<char> contents;
+		const u32 count = builder.GetSectionCount();
+		for (u32 i = 0; i < count; i++)
+		{
+			ScriptDependency dep;
+			dep.path = builder.GetSectionName(i);
+			if (!readScriptFile(dep.path.c_str(), contents))
+			{
+				return false;
+			}
+			dep.hash = hashData(HashSeed, contents.data(), contents.size());
+			dependencies.push_back(dep);
+		}
+		return true;
+	}
+
+	// Dependencies that cannot be read make the bytecode stale if requireDependencies is set, otherwise they are skipped.
+	// Precompiled files are loaded without them, since mods do not need to ship the included files.
+	static asIScriptModule* loadByteCode(const char* moduleName, const char* path, const u64* sourceHash, bool requireDependencies)
+	{
+		MappedFile file;
+		if (!file.open(path))
 		{
 			return nullptr;
 		}
-		res = builder.AddSectionFromFile(filePath);
-		if (res < 0)
+
+		// Validate everything before the module is touched so that a stale entry simply falls back to the compiler.
+		const u8* data = file.getData();
+		const size_t size = file.getSize();
+		ScriptCacheHeader header;
+		if (size < sizeof(ScriptCacheHeader))
 		{
 			return nullptr;
 		}
-		res = builder.BuildModule();
-		if (res < 0)
+		memcpy(&header, data, sizeof(ScriptCacheHeader));
+		if (header.magic != ScriptCacheMagic || header.version != ScriptCacheVersion || header.engineHash != s_engineHash ||
+			header.apiHash != getApiHash() || (sourceHash && header.sourceHash != *sourceHash))
 		{
 			return nullptr;
 		}
-		return builder.GetModule();
+
+		std::vector<char> contents;
+		size_t offset = sizeof(ScriptCacheHeader);
+		for (u32 i = 0; i < header.dependencyCount; i++)
+		{
+			u32 len;
+			u64 hash;
+			if (offset + sizeof(u32) > size) { return nullptr; }
+			memcpy(&len, data + offset, sizeof(u32));
+			offset += sizeof(u32);
+			if (len > size - offset || sizeof(u64) > size - offset - len) { return nullptr; }
+			const std::string depPath((const char*)data + offset, len);
+			memcpy(&hash, data + offset + len, sizeof(u64));
+			offset += len + sizeof(u64);
+
+			if (!readScriptFile(depPath.c_str(), contents))
+			{
+				if (requireDependencies) { return nullptr; }
+			}
+			else if (hashData(HashSeed, contents.data(), contents.size()) != hash)
+			{
+				return nullptr;
+			}
+		}
+		if (offset + header.byteCodeSize != size)
+		{
+			return nullptr;
+		}
+
+		asIScriptModule* mod = s_engine->GetModule(moduleName, asGM_ALWAYS_CREATE);
+		ByteCodeReader reader(data + offset, header.byteCodeSize);
+		if (!mod || mod->LoadByteCode(&reader) < 0)
+		{
+			if (mod) { mod->Discard(); }
+			return nullptr;
+		}
+		return mod;
 	}
-					
-	ModuleHandle createModule(const char* moduleName, const char* sectionName, const char* srcCode)
+
+	static bool writeByteCode(asIScriptModule* mod, const char* path, u64 sourceHash, const std::vector<ScriptDependency>& dependencies)
+	{
+		ByteCodeWriter writer;
+		if (mod->SaveByteCode(&writer) < 0)
+		{
+			return false;
+		}
+
+		FileStream file;
+		if (!file.open(path, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_WARNING, "Script", "Cannot write script bytecode '%s'.", path);
+			return false;
+		}
+		ScriptCacheHeader header;
+		header.magic = ScriptCacheMagic;
+		header.version = ScriptCacheVersion;
+		header.engineHash = s_engineHash;
+		header.apiHash = getApiHash();
+		header.sourceHash = sourceHash;
+		header.dependencyCount = u32(dependencies.size());
+		header.byteCodeSize = u32(writer.data.size());
+		file.writeBuffer(&header, sizeof(ScriptCacheHeader));
+		for (size_t i = 0; i < dependencies.size(); i++)
+		{
+			const u32 len = u32(dependencies[i].path.length());
+			file.writeBuffer(&len, sizeof(u32));
+			file.writeBuffer(dependencies[i].path.data(), len);
+			file.writeBuffer(&dependencies[i].hash, sizeof(u64));
+		}
+		file.writeBuffer(writer.data.data(), header.byteCodeSize);
+		file.close();
+		return true;
+	}
+
+	// Compile with the script builder, which resolves #include and then runs the AngelScript compiler.
+	static asIScriptModule* buildModule(CScriptBuilder& builder, const char* moduleName, const char* filePath, const char* sectionName, const char* srcCode)
 	{
-		CScriptBuilder builder;
 		s32 res = builder.StartNewModule(s_engine, moduleName);
 		if (res < 0)
 		{
 			return nullptr;
 		}
-		res = builder.AddSectionFromMemory(sectionName, srcCode);
+		res = filePath ? builder.AddSectionFromFile(filePath) : builder.AddSectionFromMemory(sectionName, srcCode);
 		if (res < 0)
 		{
 			return nullptr;
@@ -201,6 +697,84 @@ namespace TFE_ForceScript
 		return builder.GetModule();
 	}
 
+	// Modules are restored from bytecode when possible, which skips the parser and compiler entirely.
+	// Scripts may have a precompiled file beside them (see precompileModule()), which is used as long as the source
+	// and any included files that exist are unchanged; otherwise the bytecode cache in ProgramData is checked before compiling.
+	ModuleHandle createModule(const char* moduleName, const char* filePath)
+	{
+		std::vector<char> source;
+		const bool hasSource = readScriptFile(filePath, source);
+		const u64 sourceHash = hashData(HashSeed, source.data(), source.size());
+
+		char byteCodePath[TFE_MAX_PATH];
+		FileUtil::replaceExtension(filePath, c_precompiledExt, byteCodePath);
+		asIScriptModule* mod = loadByteCode(moduleName, byteCodePath, hasSource ? &sourceHash : nullptr, false);
+		CScriptBuilder builder;
+		if (mod || !hasSource)
+		{
+			// Without a source file, let the builder report the error.
+			return mod ? mod : buildModule(builder, moduleName, filePath, nullptr, nullptr);
+		}
+
+		char cachePath[TFE_MAX_PATH];
+		getCachePath(filePath, sourceHash, cachePath, false);
+		mod = loadByteCode(moduleName, cachePath, &sourceHash, true);
+		if (mod)
+		{
+			return mod;
+		}
+
+		mod = buildModule(builder, moduleName, filePath, nullptr, nullptr);
+		std::vector<ScriptDependency> dependencies;
+		if (mod && getDependencies(builder, dependencies))
+		{
+			getCachePath(filePath, sourceHash, cachePath, true);
+			writeByteCode(mod, cachePath, sourceHash, dependencies);
+		}
+		return mod;
+	}
+
+	// Memory modules are usually one-offs, such as console lines, so they are always compiled rather than cached.
+	ModuleHandle createModule(const char* moduleName, const char* sectionName, const char* srcCode)
+	{
+		CScriptBuilder builder;
+		return buildModule(builder, moduleName, nullptr, sectionName, srcCode);
+	}
+
+	bool precompileModule(const char* filePath, const char* outputPath)
+	{
+		std::vector<char> source;
+		if (!readScriptFile(filePath, source))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Script", "Cannot open script '%s' to precompile.", filePath);
+			return false;
+		}
+		CScriptBuilder builder;
+		asIScriptModule* mod = buildModule(builder, "Precompile", filePath, nullptr, nullptr);
+		if (!mod)
+		{
+			return false;
+		}
+
+		char byteCodePath[TFE_MAX_PATH];
+		if (!outputPath)
+		{
+			FileUtil::replaceExtension(filePath, c_precompiledExt, byteCodePath);
+			outputPath = byteCodePath;
+		}
+		// Included files are compiled in, so mods do not need to ship them. Their hashes are still recorded,
+		// so that the precompiled file is rejected after any of them that exist are edited.
+		std::vector<ScriptDependency> dependencies;
+		const u64 sourceHash = hashData(HashSeed, source.data(), source.size());
+		const bool res = getDependencies(builder, dependencies) && writeByteCode(mod, outputPath, sourceHash, dependencies);
+		mod->Discard();
+		if (res)
+		{
+			TFE_System::logWrite(LOG_MSG, "Script", "Precompiled '%s' to '%s'.", filePath, outputPath);
+		}
+		return res;
+	}
+
 	FunctionHandle findScriptFunc(ModuleHandle modHandle, const char* funcName)
 	{
 		if (!modHandle) { return nullptr; }
@@ -227,7 +801,7 @@ namespace TFE_ForceScript
 	}
 		
 	// Add a script function to be executed during the update.
-	s32 execFunc(FunctionHandle funcHandle)
+	s32 execFunc(FunctionHandle funcHandle, s32 priority)
 	{
 		s32 id = -1;
 		if (!funcHandle) { return id; }
@@ -259,8 +833,13 @@ namespace TFE_ForceScript
 			id = (s32)s_scriptThreads.size();
 			s_scriptThreads.push_back({});
 		}
-		s_scriptThreads[id].asContext = context;
-		s_scriptThreads[id].delay = 0.0f;
+		ScriptThread* thread = &s_scriptThreads[id];
+		*thread = {};
+		thread->asContext = context;
+		thread->delay = 0.0f;
+		thread->priority = priority;
+		thread->order = s_threadOrder++;
+		thread->name = s_threadNames.insert(func->GetDeclaration()).first->c_str();
 		context->SetUserData((void*)((intptr_t)id), ThreadId);
 
 		return id;
@@ -286,6 +865,7 @@ namespace TFE_ForceScript
 	// Compile module.
 	ModuleHandle createModule(const char* moduleName, const char* sectionName, const char* srcCode) { return nullptr; }
 	ModuleHandle createModule(const char* moduleName, const char* filePath) { return nullptr; }
+	bool precompileModule(const char* filePath, const char* outputPath) { return false; }
 	// Find a specific script function in a module.
 	FunctionHandle findScriptFunc(ModuleHandle modHandle, const char* funcName) { return nullptr; }
 
@@ -297,7 +877,7 @@ namespace TFE_ForceScript
 	// ---------------------------------------
 	// Returns -1 on failure or id on success.
 	// Note id is only valid as long as the function is running.
-	s32 execFunc(FunctionHandle funcHandle) { return -1; }
+	s32 execFunc(FunctionHandle funcHandle, s32 priority) { return -1; }
 	// Resume a suspended script function given by id.
 	void resume(s32 id) { return; }
 }
@@ -24,7 +24,8 @@ namespace TFE_ForceScript
 	void init();
 	void destroy();
 	void overrideCallback(ScriptMessageCallback callback = nullptr);
-	// Run any active script functions.
+	// Run any active script functions, in priority order, until the frame budget (d_scriptFrameBudget, off by default) is spent.
+	// Functions still running when it runs out are suspended and continue next frame.
 	void update();
 	// Stop all running script functions.
 	void stopAllFunc();
@@ -33,8 +34,14 @@ namespace TFE_ForceScript
 	void* getEngine();
 
 	// Compile module.
+	// Modules compiled from memory are not cached, since they are usually one-offs such as console lines.
 	ModuleHandle createModule(const char* moduleName, const char* sectionName, const char* srcCode);
+	// Compiled bytecode is cached, keyed by the source, the AngelScript version and the registered API.
 	ModuleHandle createModule(const char* moduleName, const char* filePath);
+	// Compile a script file and save its bytecode to outputPath, or beside the script as "name.fsb" by default.
+	// createModule() loads the precompiled file instead of compiling, so mods can ship scripts ready to run.
+	// The bytecode is only valid with the same API, so scripts must be precompiled after that API is registered.
+	bool precompileModule(const char* filePath, const char* outputPath = nullptr);
 	// Find a specific script function in a module.
 	FunctionHandle findScriptFunc(ModuleHandle modHandle, const char* funcName);
 
@@ -46,7 +53,8 @@ namespace TFE_ForceScript
 	// ---------------------------------------
 	// Returns -1 on failure or id on success.
 	// Note id is only valid as long as the function is running.
-	s32 execFunc(FunctionHandle funcHandle);
+	// Functions with a higher priority run first each frame.
+	s32 execFunc(FunctionHandle funcHandle, s32 priority = 0);
 	// Resume a suspended script function given by id.
 	void resume(s32 id);
 }  // TFE_ForceScript
\ No newline at end of file
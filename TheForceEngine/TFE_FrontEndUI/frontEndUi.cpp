@@ -1198,6 +1198,12 @@ namespace TFE_FrontEndUI
 			gameSettings->df_solidWallFlagFix = solidWallFlagFix;
 		}
 
+		bool collisionBroadphase = gameSettings->df_collisionBroadphase;
+		if (ImGui::Checkbox("Fast explosion and proximity checks (disable for the original search order)", &collisionBroadphase))
+		{
+			gameSettings->df_collisionBroadphase = collisionBroadphase;
+		}
+
 		if (s_drawNoGameDataMsg)
 		{
 			ImGui::Separator();
@@ -1480,6 +1486,7 @@ namespace TFE_FrontEndUI
 	static TextureGpu* s_saveImageView = nullptr;
 	static s32 s_selectedSave = -1;
 	static s32 s_selectedSaveSlot = -1;
+	static s32 s_pendingSaveImage = -1;
 	static bool s_hasQuicksave = false;
 
 	static char s_newSaveName[256];
@@ -1490,14 +1497,29 @@ namespace TFE_FrontEndUI
 
 	void clearSaveImage()
 	{
+		s_pendingSaveImage = -1;
 		u32 zero[TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT];
 		memset(zero, 0, sizeof(u32) * TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT);
 		s_saveImageView->update(zero, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
 	}
 
+	// The image is decoded in the background, the previous image is kept until it is ready.
 	void updateSaveImage(s32 index)
 	{
-		s_saveImageView->update(s_saveDir[index].imageData, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
+		s_pendingSaveImage = index;
+		TFE_SaveSystem::requestSaveImage(s_saveDir[index].fileName);
+	}
+
+	void pollSaveImage()
+	{
+		if (s_pendingSaveImage < 0 || s_pendingSaveImage >= (s32)s_saveDir.size()) { return; }
+
+		const u32* image = TFE_SaveSystem::getSaveImage(s_saveDir[s_pendingSaveImage].fileName);
+		if (image)
+		{
+			s_saveImageView->update(image, TFE_SaveSystem::SAVE_IMAGE_WIDTH * TFE_SaveSystem::SAVE_IMAGE_HEIGHT * 4);
+			s_pendingSaveImage = -1;
+		}
 	}
 
 	void openLoadConfirmPopup()
@@ -1564,14 +1586,11 @@ namespace TFE_FrontEndUI
 		TFE_SaveSystem::populateSaveDirectory(s_saveDir);
 		s_hasQuicksave = (!s_saveDir.empty() && strcasecmp(s_saveDir[0].saveName, "Quicksave") == 0);
 
+		clearSaveImage();
 		if (!s_saveDir.empty() && (s_selectedSave > 0 || !save))
 		{
 			updateSaveImage(s_selectedSave);
 		}
-		else
-		{
-			clearSaveImage();
-		}
 
 		s_popupOpen = false;
 		s_saveLoadSetupRequired = false;
@@ -1584,6 +1603,7 @@ namespace TFE_FrontEndUI
 		{
 			configSaveLoadBegin(save);
 		}
+		pollSaveImage();
 
 		// Create the current display info to adjust menu sizes.
 		DisplayInfo displayInfo;
@@ -2850,6 +2870,13 @@ namespace TFE_FrontEndUI
 			sound->disableSoundInMenus = disableSoundInMenus;
 		}
 
+		bool midiCache = sound->midiCache;
+		if (ImGui::Checkbox("Cache Synthesized Music (less CPU once cached)", &midiCache))
+		{
+			sound->midiCache = midiCache;
+			TFE_MidiPlayer::setCacheEnabled(midiCache);
+		}
+
 		TFE_Audio::setVolume(sound->soundFxVolume * sound->masterVolume);
 		TFE_MidiPlayer::setVolume(sound->musicVolume * sound->masterVolume);
 	}
@@ -3238,6 +3265,7 @@ namespace TFE_FrontEndUI
 				gameSettings->df_smoothVUEs = true;
 				gameSettings->df_pitchLimit = (temp == TEMPLATE_MODERN) ? PITCH_MAXIMUM : PITCH_VANILLA_PLUS;
 				gameSettings->df_solidWallFlagFix = true;
+				gameSettings->df_collisionBroadphase = true;
 				// Graphics
 				graphicsSettings->rendererIndex = RENDERER_HARDWARE;
 				graphicsSettings->skyMode = SKYMODE_CYLINDER;
@@ -3287,6 +3315,7 @@ namespace TFE_FrontEndUI
 				gameSettings->df_bobaFettFacePlayer = false;
 				gameSettings->df_smoothVUEs = false;
 				gameSettings->df_solidWallFlagFix = false;
+				gameSettings->df_collisionBroadphase = false;
 				// Graphics
 				graphicsSettings->rendererIndex = RENDERER_SOFTWARE;
 				graphicsSettings->widescreen = false;
@@ -9,15 +9,39 @@
 #include <TFE_Ui/ui.h>
 #include <TFE_Ui/markdown.h>
 #include <TFE_System/parser.h>
+#include "console.h"
 
 #include <algorithm>
 
 namespace TFE_ProfilerView
 {
 	static bool s_open = false;
+	static s32 s_captureFrames = 60;
+
+	void captureTraceConsole(const ConsoleArgList& args);
+
+	// Traces are written to "Traces/" in the user documents directory.
+	static bool startTraceCapture(s32 frameCount)
+	{
+		char traceDir[TFE_MAX_PATH];
+		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "Traces/", traceDir);
+		if (!FileUtil::directoryExits(traceDir))
+		{
+			FileUtil::makeDirectory(traceDir);
+		}
+
+		char tracePath[TFE_MAX_PATH];
+		for (u32 i = 0; ; i++)
+		{
+			sprintf(tracePath, "%stfe_trace_%u.json", traceDir, i);
+			if (!FileUtil::exists(tracePath)) { break; }
+		}
+		return TFE_Profiler::captureTrace(u32(std::max(1, frameCount)), tracePath);
+	}
 
 	bool init()
 	{
+		CCMD("profilerCapture", captureTraceConsole, 0, "Captures profiler zones on all threads for a number of frames (default 60) and writes a Chrome/Perfetto trace - profilerCapture [frameCount]");
 		return true;
 	}
 
@@ -33,6 +57,32 @@ namespace TFE_ProfilerView
 		ImGui::SetNextWindowSize(ImVec2(800, 768));
 		ImGui::Begin("Profiler View", &s_open);
 
+		ImGui::LabelText("##Label", "Trace Capture");
+		ImGui::Separator();
+		ImGui::Indent();
+		if (TFE_Profiler::isCapturingTrace())
+		{
+			ImGui::Text("Capturing...");
+		}
+		else
+		{
+			ImGui::SetNextItemWidth(96.0f);
+			ImGui::InputInt("Frames##TraceFrames", &s_captureFrames);
+			s_captureFrames = std::max(1, std::min(s_captureFrames, 10000));
+			ImGui::SameLine();
+			if (ImGui::Button("Capture Trace"))
+			{
+				startTraceCapture(s_captureFrames);
+			}
+		}
+		const char* lastTrace = TFE_Profiler::getLastTracePath();
+		if (lastTrace[0])
+		{
+			ImGui::Text("Last trace: %s", lastTrace);
+		}
+		ImGui::Unindent();
+
+		ImGui::Spacing();
 		ImGui::LabelText("##Label", "Counters");
 		ImGui::Separator();
 		u32 counterCount = TFE_Profiler::getCounterCount();
@@ -92,4 +142,17 @@ namespace TFE_ProfilerView
 	{
 		s_open = enable;
 	}
+
+	void captureTraceConsole(const ConsoleArgList& args)
+	{
+		const s32 frameCount = args.size() >= 2 ? atoi(args[1].c_str()) : 60;
+		if (startTraceCapture(frameCount))
+		{
+			TFE_Console::addToHistory("Trace capture started, the trace is written to Traces/ when it completes.");
+		}
+		else
+		{
+			TFE_Console::addToHistory("A trace capture is already in progress.");
+		}
+	}
 }
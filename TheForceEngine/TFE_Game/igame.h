@@ -31,6 +31,8 @@ struct IGame
 	virtual bool isPaused() { return false; }
 	virtual void getLevelName(char* name) {};
 	virtual void getModList(char* modList) {};
+	// Show a short message to the player, such as a HUD message.
+	virtual void showMessage(const char* msg) {};
 
 	GameID id;
 };
@@ -0,0 +1,359 @@
+#include "inputRecorder.h"
+#include <TFE_Input/input.h>
+#include <TFE_Jedi/Task/task.h>
+#include <TFE_System/system.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/filewriterAsync.h>
+#include <TFE_FileSystem/memorystream.h>
+#include <TFE_FileSystem/paths.h>
+#include <TFE_Archive/zstdCompression.h>
+#include <cstring>
+#include <vector>
+
+using namespace TFE_Input;
+
+namespace TFE_InputRecorder
+{
+	enum RecorderConst : u32
+	{
+		REPLAY_MAGIC = 0x52454654,	// "TFER"
+		REPLAY_VERSION = 2,
+		REPLAY_COMPRESSION_LEVEL = 4,
+	};
+	static const char* c_replayDir = "Replays/";
+
+	// The file header is followed by the compressed game state and frame data.
+	struct ReplayHeader
+	{
+		u32 magic;
+		u32 version;
+		u32 gameId;
+		u32 frameCount;
+		f64 startTime;	// System time when the recording started.
+		u64 stateHash;
+		u32 stateSize;
+		u32 frameDataSize;
+		u32 compressedSize;
+	};
+
+	// Each frame stores the frame time, u8 frame flags, followed by the input state as a list of bytes that changed
+	// since the previous frame: u16 changeCount, then changeCount x { u16 offset, u8 value }.
+	struct FrameTime
+	{
+		f64 time;
+		f64 dt;
+	};
+
+	enum FrameFlags : u8
+	{
+		// The game was paused when the frame ran, including pauses from outside of the game such as the console.
+		FRAME_PAUSED = (1 << 0),
+	};
+
+	static_assert(sizeof(InputState) <= 0xffff, "InputState offsets must fit in 16 bits.");
+
+	static bool s_recording = false;
+	static bool s_replaying = false;
+	static char s_recordPath[TFE_MAX_PATH];
+
+	static ReplayHeader s_header = {};
+	static std::vector<u8> s_state;
+	static std::vector<u8> s_frames;
+	static size_t s_readOffset = 0;
+	static u32 s_frame = 0;
+	static InputState s_prevInput;
+
+	static void writeFrameData(const void* data, size_t size)
+	{
+		const size_t offset = s_frames.size();
+		s_frames.resize(offset + size);
+		memcpy(s_frames.data() + offset, data, size);
+	}
+
+	static bool readFrameData(void* data, size_t size)
+	{
+		if (s_readOffset + size > s_frames.size()) { return false; }
+		memcpy(data, s_frames.data() + s_readOffset, size);
+		s_readOffset += size;
+		return true;
+	}
+
+	static bool serializeState(IGame* game, MemoryStream* state)
+	{
+		// Passing a null filename skips the "game saved" message.
+		return state->open(Stream::MODE_WRITE) && game->serializeGameState(state, nullptr, true);
+	}
+
+	static u64 hashBuffer(const u8* data, size_t size)
+	{
+		// FNV-1a
+		u64 hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ data[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	void getReplayPath(const char* filename, char* path)
+	{
+		if (strchr(filename, '/') || strchr(filename, '\\') || strchr(filename, ':'))
+		{
+			strcpy(path, filename);
+		}
+		else
+		{
+			char dir[TFE_MAX_PATH];
+			TFE_Paths::appendPath(PATH_USER_DOCUMENTS, c_replayDir, dir);
+			if (!FileUtil::directoryExits(dir))
+			{
+				FileUtil::makeDirectory(dir);
+			}
+			sprintf(path, "%s%s", dir, filename);
+		}
+
+		char name[TFE_MAX_PATH], ext[TFE_MAX_PATH];
+		FileUtil::getFileNameFromPath(path, name, true);
+		FileUtil::getFileExtension(name, ext);
+		if (!ext[0])
+		{
+			strcat(path, ".tfr");
+		}
+	}
+
+	/////////////////////////////////////////////////
+	// Recording
+	/////////////////////////////////////////////////
+	bool startRecording(IGame* game, const char* filename)
+	{
+		if (s_recording || s_replaying || !game || !game->canSave()) { return false; }
+
+		// Restart the task time step so the replay can start from the same point.
+		TFE_Jedi::task_updateTime();
+
+		MemoryStream state;
+		if (!serializeState(game, &state))
+		{
+			TFE_System::logWrite(LOG_ERROR, "InputRecorder", "Cannot snapshot the game state, recording not started.");
+			return false;
+		}
+		s_state.assign((const u8*)state.data(), (const u8*)state.data() + state.getSize());
+
+		getReplayPath(filename, s_recordPath);
+		s_header = {};
+		s_header.magic = REPLAY_MAGIC;
+		s_header.version = REPLAY_VERSION;
+		s_header.gameId = u32(game->id);
+		s_header.startTime = TFE_System::getTime();
+		s_frames.clear();
+		memset(&s_prevInput, 0, sizeof(InputState));
+		s_recording = true;
+
+		TFE_System::logWrite(LOG_MSG, "InputRecorder", "Recording input to '%s'.", s_recordPath);
+		return true;
+	}
+
+	void stopRecording(IGame* game)
+	{
+		if (!s_recording) { return; }
+		s_recording = false;
+
+		s_header.stateHash = game ? computeStateHash(game) : 0;
+		s_header.stateSize = u32(s_state.size());
+		s_header.frameDataSize = u32(s_frames.size());
+
+		std::vector<u8> body;
+		body.reserve(s_state.size() + s_frames.size());
+		body.insert(body.end(), s_state.begin(), s_state.end());
+		body.insert(body.end(), s_frames.begin(), s_frames.end());
+
+		std::vector<u8> compressed;
+		if (!zstd_compress(compressed, body.data(), u32(body.size()), REPLAY_COMPRESSION_LEVEL))
+		{
+			TFE_System::logWrite(LOG_ERROR, "InputRecorder", "Cannot compress the recording '%s'.", s_recordPath);
+			return;
+		}
+		s_header.compressedSize = u32(compressed.size());
+
+		std::vector<u8> file(sizeof(ReplayHeader) + compressed.size());
+		memcpy(file.data(), &s_header, sizeof(ReplayHeader));
+		memcpy(file.data() + sizeof(ReplayHeader), compressed.data(), compressed.size());
+		FileWriterAsync::writeFileToDisk(s_recordPath, std::move(file));
+
+		TFE_System::logWrite(LOG_MSG, "InputRecorder", "Recorded %u frames to '%s'.", s_header.frameCount, s_recordPath);
+		s_state.clear();
+		s_frames.clear();
+	}
+
+	bool isRecording()
+	{
+		return s_recording;
+	}
+
+	void recordFrame(IGame* game)
+	{
+		if (!s_recording) { return; }
+
+		const FrameTime frameTime = { TFE_System::getTime(), TFE_System::getDeltaTimeRaw() };
+		const u8 flags = game->isPaused() ? FRAME_PAUSED : 0;
+		writeFrameData(&frameTime, sizeof(FrameTime));
+		writeFrameData(&flags, sizeof(u8));
+
+		InputState input;
+		getInputState(&input);
+		const u8* cur = (const u8*)&input;
+		const u8* prev = (const u8*)&s_prevInput;
+
+		const size_t countOffset = s_frames.size();
+		u16 changeCount = 0;
+		writeFrameData(&changeCount, sizeof(u16));
+		for (u32 i = 0; i < sizeof(InputState); i++)
+		{
+			if (cur[i] == prev[i]) { continue; }
+			const u16 offset = u16(i);
+			writeFrameData(&offset, sizeof(u16));
+			writeFrameData(&cur[i], sizeof(u8));
+			changeCount++;
+		}
+		memcpy(s_frames.data() + countOffset, &changeCount, sizeof(u16));
+
+		s_prevInput = input;
+		s_header.frameCount++;
+	}
+
+	/////////////////////////////////////////////////
+	// Replay
+	/////////////////////////////////////////////////
+	static bool readReplay(const char* path)
+	{
+		FileStream file;
+		if (!file.open(path, Stream::MODE_READ))
+		{
+			TFE_System::logWrite(LOG_ERROR, "InputRecorder", "Cannot open recording '%s'.", path);
+			return false;
+		}
+
+		bool valid = file.readBuffer(&s_header, sizeof(ReplayHeader)) == sizeof(ReplayHeader) &&
+			s_header.magic == REPLAY_MAGIC && s_header.version == REPLAY_VERSION;
+		if (!valid)
+		{
+			TFE_System::logWrite(LOG_ERROR, "InputRecorder", "'%s' is not a valid recording.", path);
+			return false;
+		}
+
+		std::vector<u8> compressed(s_header.compressedSize);
+		std::vector<u8> body(size_t(s_header.stateSize) + s_header.frameDataSize);
+		valid = file.readBuffer(compressed.data(), s_header.compressedSize) == s_header.compressedSize &&
+			zstd_decompress(body.data(), u32(body.size()), compressed.data(), s_header.compressedSize);
+		file.close();
+		if (!valid)
+		{
+			TFE_System::logWrite(LOG_ERROR, "InputRecorder", "Cannot decompress recording '%s'.", path);
+			return false;
+		}
+
+		s_state.assign(body.begin(), body.begin() + s_header.stateSize);
+		s_frames.assign(body.begin() + s_header.stateSize, body.end());
+		return true;
+	}
+
+	bool startReplay(IGame* game, const char* filename)
+	{
+		if (s_recording || s_replaying || !game) { return false; }
+
+		char path[TFE_MAX_PATH];
+		getReplayPath(filename, path);
+		if (!readReplay(path)) { return false; }
+		if (s_header.gameId != u32(game->id))
+		{
+			TFE_System::logWrite(LOG_ERROR, "InputRecorder", "Recording '%s' was made with a different game.", path);
+			return false;
+		}
+
+		MemoryStream state;
+		if (!state.load(s_state.size(), s_state.data()) || !state.open(Stream::MODE_READ) ||
+			!game->serializeGameState(&state, nullptr, false))
+		{
+			TFE_System::logWrite(LOG_ERROR, "InputRecorder", "Cannot restore the game state from '%s'.", path);
+			return false;
+		}
+		TFE_System::setFrameTimeOverride(s_header.startTime, 0.0);
+		TFE_Jedi::task_updateTime();
+
+		memset(&s_prevInput, 0, sizeof(InputState));
+		s_readOffset = 0;
+		s_frame = 0;
+		s_replaying = true;
+		TFE_System::logWrite(LOG_MSG, "InputRecorder", "Replaying %u frames from '%s'.", s_header.frameCount, path);
+		return true;
+	}
+
+	void stopReplay()
+	{
+		if (!s_replaying) { return; }
+		s_replaying = false;
+		TFE_System::clearFrameTimeOverride();
+		s_state.clear();
+		s_frames.clear();
+	}
+
+	bool isReplaying()
+	{
+		return s_replaying;
+	}
+
+	bool replayFrame(IGame* game)
+	{
+		if (!s_replaying || s_frame >= s_header.frameCount) { return false; }
+
+		FrameTime frameTime;
+		u8 flags;
+		u16 changeCount;
+		if (!readFrameData(&frameTime, sizeof(FrameTime)) || !readFrameData(&flags, sizeof(u8)) || !readFrameData(&changeCount, sizeof(u16)))
+		{
+			return false;
+		}
+
+		u8* input = (u8*)&s_prevInput;
+		for (u32 i = 0; i < changeCount; i++)
+		{
+			u16 offset;
+			u8 value;
+			if (!readFrameData(&offset, sizeof(u16)) || !readFrameData(&value, sizeof(u8)) || offset >= sizeof(InputState))
+			{
+				TFE_System::logWrite(LOG_ERROR, "InputRecorder", "Corrupt frame %u in the recording.", s_frame);
+				return false;
+			}
+			input[offset] = value;
+		}
+
+		setInputState(&s_prevInput);
+		TFE_System::setFrameTimeOverride(frameTime.time, frameTime.dt);
+		// The console pauses the game from outside, so the pause state is restored instead of replayed.
+		const bool paused = (flags & FRAME_PAUSED) != 0;
+		if (game->isPaused() != paused)
+		{
+			game->pauseGame(paused);
+		}
+		s_frame++;
+		return true;
+	}
+
+	u32 getFrameCount()
+	{
+		return s_header.frameCount;
+	}
+
+	u64 getRecordedStateHash()
+	{
+		return s_header.stateHash;
+	}
+
+	u64 computeStateHash(IGame* game)
+	{
+		MemoryStream state;
+		if (!game || !serializeState(game, &state)) { return 0; }
+		return hashBuffer((const u8*)state.data(), state.getSize());
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Input Recorder
+// Records the raw input and frame time of every game frame, starting
+// from a snapshot of the game state. Replaying the recording restores
+// the snapshot and feeds the same input and time back into the game,
+// which is used for deterministic benchmarks and regression checks.
+//
+// Recordings are compressed and stored in "Replays/" in the user
+// documents directory.
+//////////////////////////////////////////////////////////////////////
+#include "igame.h"
+
+namespace TFE_InputRecorder
+{
+	// Snapshots the current game state and starts recording frames.
+	bool startRecording(IGame* game, const char* filename);
+	// Stops recording and writes the recording to disk, including the hash of the final game state.
+	void stopRecording(IGame* game);
+	bool isRecording();
+	// Call before every game frame, after TFE_System::update(), to record the current input, frame time and pause state.
+	void recordFrame(IGame* game);
+
+	// Loads the recording and restores the game state, 'game' must be created but not running.
+	bool startReplay(IGame* game, const char* filename);
+	void stopReplay();
+	bool isReplaying();
+	// Call once per game frame, before the input mapping is updated. Restores the recorded input and pause
+	// state and overrides the frame time, returns false once all frames have been replayed.
+	bool replayFrame(IGame* game);
+
+	u32 getFrameCount();
+	// The hash of the final game state saved with the recording, 0 if unknown.
+	u64 getRecordedStateHash();
+	// Hash of the serialized game state, matching hashes mean the replay did not diverge.
+	u64 computeStateHash(IGame* game);
+
+	// Resolves a recording filename, relative names are placed in the replay directory.
+	void getReplayPath(const char* filename, char* path);
+}
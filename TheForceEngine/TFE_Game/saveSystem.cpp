@@ -1,13 +1,23 @@
 #include "saveSystem.h"
 #include <TFE_Input/inputMapping.h>
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/tfeMessage.h>
 #include <TFE_Settings/gameSourceData.h>
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/filewriterAsync.h>
+#include <TFE_FileSystem/memorystream.h>
+#include <TFE_Archive/zstdCompression.h>
 
 #include <TFE_RenderBackend/renderBackend.h>
 #include <TFE_Asset/imageAsset.h>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 using namespace TFE_Input;
 
@@ -23,7 +33,31 @@ namespace TFE_SaveSystem
 	enum SaveMasterVersion
 	{
 		SVER_INIT = 1,
-		SVER_CUR = SVER_INIT
+		SVER_COMPRESSED,	// Game state is preceded by SaveStateFlags and sizes, and may be compressed.
+		SVER_CUR = SVER_COMPRESSED
+	};
+
+	enum SaveStateFlags
+	{
+		SSTATE_NONE = 0,
+		SSTATE_COMPRESSED = FLAG_BIT(0),
+	};
+
+	enum SaveConst
+	{
+		SAVE_COMPRESSION_LEVEL = 4,
+		SAVE_INDEX_VERSION = 1,
+	};
+	static const char* c_saveIndexName = "saveIndex.dat";
+
+	// Save directory index entry, headers are only re-read if the file size or modified time change.
+	struct SaveIndexEntry
+	{
+		SaveHeader header;
+		u64 size;
+		u64 modifiedTime;
+		bool pendingWrite;	// Saved this session, the modified time is read once the write completes.
+		bool found;
 	};
 
 	static SaveRequest s_req = SF_REQ_NONE;
@@ -33,8 +67,38 @@ namespace TFE_SaveSystem
 	static IGame* s_game = nullptr;
 	static s32 s_saveDelay = 0;
 
+	// Buffer 0 is used by the game thread, buffer 1 by the thumbnail thread.
 	static u32* s_imageBuffer[2] = { nullptr, nullptr };
 	static size_t s_imageBufferSize[2] = { 0 };
+	static std::vector<u8> s_compressedState;
+
+	static std::unordered_map<std::string, SaveIndexEntry> s_saveIndex;
+	static bool s_saveIndexLoaded = false;
+	static bool s_saveIndexDirty = false;
+
+	// Thumbnails are decoded on demand by the thumbnail thread, only the latest request is kept.
+	static std::thread s_thumbnailThread;
+	static std::mutex s_thumbnailMutex;
+	static std::condition_variable s_thumbnailWake;
+	static bool s_thumbnailQuit = false;
+	static char s_thumbnailRequest[TFE_MAX_PATH] = { 0 };
+	static char s_thumbnailResultName[TFE_MAX_PATH] = { 0 };
+	static bool s_thumbnailReady = false;
+	static u32  s_thumbnailDecode[SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT];	// Thumbnail thread only.
+	static u32  s_thumbnailResult[SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT];
+	static u32  s_thumbnail[SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT];
+
+	// Saves are written to a temporary file which replaces the save once it is complete,
+	// so a failed write never destroys the previous save.
+	struct SaveWrite
+	{
+		char fileName[TFE_MAX_PATH];
+		char filePath[TFE_MAX_PATH];
+		char tempPath[TFE_MAX_PATH];
+	};
+	// Saves that failed to write, filled in by the file writer thread.
+	static std::mutex s_failedSaveMutex;
+	static std::vector<std::string> s_failedSaves;
 
 	void saveHeader(Stream* stream, const char* saveName)
 	{
@@ -101,19 +165,24 @@ namespace TFE_SaveSystem
 		free(png);
 	}
 
-	void loadHeader(Stream* stream, SaveHeader* header, const char* fileName)
+	// Reads the header, leaving the stream at the start of the game state, and returns the master version of the save.
+	// The thumbnail is only decoded if 'imageData' is not null, which is done on the thumbnail thread.
+	u32 loadHeader(Stream* stream, SaveHeader* header, const char* fileName, u32* imageData = nullptr)
 	{
 		// Master version.
-		u32 version;
+		u32 version = 0;
 		stream->read(&version);
 
-		// Save Name.
+		// Save Name, names that are too long (invalid saves) are cut to fit.
 		u8 len;
 		stream->read(&len);
-		stream->readBuffer(header->saveName, len);
-		header->saveName[len] = 0;
-		// Fix existing invalid save names.
-		header->saveName[SAVE_MAX_NAME_LEN - 1] = 0;
+		const u32 nameLen = std::min(u32(len), u32(SAVE_MAX_NAME_LEN - 1));
+		stream->readBuffer(header->saveName, nameLen);
+		header->saveName[nameLen] = 0;
+		if (nameLen < len)
+		{
+			stream->seek(s32(len - nameLen), Stream::ORIGIN_CURRENT);
+		}
 
 		// Handle the case when there is no save name.
 		if (header->saveName[0] == 0 || header->saveName[0] == ' ')
@@ -136,40 +205,339 @@ namespace TFE_SaveSystem
 		stream->readBuffer(header->modNames, len);
 		header->modNames[len] = 0;
 
-		// Image, re-use buffer 0 for the PNG.
-		u32 pngSize;
+		// Image.
+		u32 pngSize = 0;
 		stream->read(&pngSize);
-		if (pngSize > s_imageBufferSize[0])
+		if (!imageData)
 		{
-			s_imageBuffer[0] = (u32*)realloc(s_imageBuffer[0], pngSize);
-			s_imageBufferSize[0] = pngSize;
+			stream->seek(s32(pngSize), Stream::ORIGIN_CURRENT);
+			return version;
 		}
-		stream->readBuffer(s_imageBuffer[0], pngSize);
 
-		SDL_Surface* image;
-		TFE_Image::readImageFromMemory(&image, pngSize, s_imageBuffer[0]);
+		// Re-use buffer 1 for the PNG.
+		if (pngSize > s_imageBufferSize[1])
+		{
+			s_imageBuffer[1] = (u32*)realloc(s_imageBuffer[1], pngSize);
+			s_imageBufferSize[1] = pngSize;
+		}
+		stream->readBuffer(s_imageBuffer[1], pngSize);
+
+		SDL_Surface* image = nullptr;
+		TFE_Image::readImageFromMemory(&image, pngSize, s_imageBuffer[1]);
 		if (image)
 		{
 			const u32 sz = SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * sizeof(u32);
-			memcpy(header->imageData, image->pixels, sz);
+			memcpy(imageData, image->pixels, sz);
 			TFE_Image::free(image);
 		}
+		else
+		{
+			memset(imageData, 0, SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT * sizeof(u32));
+		}
+		return version;
+	}
+
+	/////////////////////////////////////////////////
+	// Save Index
+	/////////////////////////////////////////////////
+	static void writeIndexString(Stream* stream, const char* str)
+	{
+		const u8 len = (u8)std::min(strlen(str), size_t(255));
+		stream->write(&len);
+		stream->writeBuffer(str, len);
+	}
+
+	// Strings longer than the destination are cut to fit, the rest of the string is skipped.
+	static void readIndexString(Stream* stream, char* str, size_t size)
+	{
+		u8 len = 0;
+		stream->read(&len);
+		const size_t readLen = std::min(size_t(len), size - 1);
+		stream->readBuffer(str, u32(readLen));
+		str[readLen] = 0;
+		if (readLen < len)
+		{
+			stream->seek(s32(len - readLen), Stream::ORIGIN_CURRENT);
+		}
+	}
+
+	static void loadSaveIndex()
+	{
+		if (s_saveIndexLoaded) { return; }
+		s_saveIndexLoaded = true;
+		s_saveIndexDirty = false;
+		s_saveIndex.clear();
+
+		char indexPath[TFE_MAX_PATH];
+		sprintf(indexPath, "%s%s", s_gameSavePath, c_saveIndexName);
+		FileStream stream;
+		if (!stream.open(indexPath, Stream::MODE_READ)) { return; }
+
+		u32 version = 0, count = 0;
+		stream.read(&version);
+		stream.read(&count);
+		if (version != SAVE_INDEX_VERSION)
+		{
+			// The index will be rebuilt from the save headers.
+			stream.close();
+			return;
+		}
+
+		for (u32 i = 0; i < count && stream.getLoc() < stream.getSize(); i++)
+		{
+			SaveIndexEntry entry = {};
+			readIndexString(&stream, entry.header.fileName, sizeof(entry.header.fileName));
+			readIndexString(&stream, entry.header.saveName, sizeof(entry.header.saveName));
+			readIndexString(&stream, entry.header.dateTime, sizeof(entry.header.dateTime));
+			readIndexString(&stream, entry.header.levelName, sizeof(entry.header.levelName));
+			readIndexString(&stream, entry.header.modNames, sizeof(entry.header.modNames));
+			stream.read(&entry.size);
+			stream.read(&entry.modifiedTime);
+			s_saveIndex[entry.header.fileName] = entry;
+		}
+		stream.close();
+	}
+
+	static void writeSaveIndex()
+	{
+		if (!s_saveIndexDirty) { return; }
+		s_saveIndexDirty = false;
+
+		MemoryStream stream;
+		if (!stream.open(Stream::MODE_WRITE)) { return; }
+
+		u32 version = SAVE_INDEX_VERSION;
+		u32 count = 0;
+		for (auto& it : s_saveIndex)
+		{
+			if (!it.second.pendingWrite) { count++; }
+		}
+		stream.write(&version);
+		stream.write(&count);
+		for (auto& it : s_saveIndex)
+		{
+			const SaveIndexEntry& entry = it.second;
+			if (entry.pendingWrite) { continue; }
+
+			writeIndexString(&stream, entry.header.fileName);
+			writeIndexString(&stream, entry.header.saveName);
+			writeIndexString(&stream, entry.header.dateTime);
+			writeIndexString(&stream, entry.header.levelName);
+			writeIndexString(&stream, entry.header.modNames);
+			stream.write(&entry.size);
+			stream.write(&entry.modifiedTime);
+		}
+
+		char indexPath[TFE_MAX_PATH];
+		sprintf(indexPath, "%s%s", s_gameSavePath, c_saveIndexName);
+		FileWriterAsync::writeFileToDisk(indexPath, (u8*)stream.data(), stream.getSize());
+	}
+
+	// Saves written this session are added to the index when saved, the file time is filled in once the write has completed.
+	static void handleFailedSaves();
+
+	static void resolvePendingWrites()
+	{
+		handleFailedSaves();
+		bool pending = false;
+		for (auto& it : s_saveIndex)
+		{
+			pending |= it.second.pendingWrite;
+		}
+		if (!pending) { return; }
+
+		FileWriterAsync::flush();
+		handleFailedSaves();
+		for (auto& it : s_saveIndex)
+		{
+			SaveIndexEntry& entry = it.second;
+			if (!entry.pendingWrite) { continue; }
+
+			char filePath[TFE_MAX_PATH];
+			sprintf(filePath, "%s%s", s_gameSavePath, entry.header.fileName);
+			entry.size = FileUtil::getFileSize(filePath);
+			entry.modifiedTime = FileUtil::getModifiedTime(filePath);
+			entry.pendingWrite = false;
+			s_saveIndexDirty = true;
+		}
+	}
+
+	/////////////////////////////////////////////////
+	// Thumbnails
+	/////////////////////////////////////////////////
+	static void thumbnailThread()
+	{
+		TFE_Profiler::setThreadName("Save Thumbnails");
+		char fileName[TFE_MAX_PATH];
+		std::unique_lock<std::mutex> lock(s_thumbnailMutex);
+		while (1)
+		{
+			s_thumbnailWake.wait(lock, [] { return s_thumbnailQuit || s_thumbnailRequest[0]; });
+			if (s_thumbnailQuit) { break; }
+
+			strcpy(fileName, s_thumbnailRequest);
+			s_thumbnailRequest[0] = 0;
+			lock.unlock();
+
+			char filePath[TFE_MAX_PATH];
+			sprintf(filePath, "%s%s", s_gameSavePath, fileName);
+			FileStream stream;
+			SaveHeader header;
+			if (stream.open(filePath, Stream::MODE_READ))
+			{
+				loadHeader(&stream, &header, fileName, s_thumbnailDecode);
+				stream.close();
+			}
+			else
+			{
+				memset(s_thumbnailDecode, 0, sizeof(s_thumbnailDecode));
+			}
+
+			lock.lock();
+			memcpy(s_thumbnailResult, s_thumbnailDecode, sizeof(s_thumbnailResult));
+			strcpy(s_thumbnailResultName, fileName);
+			s_thumbnailReady = true;
+		}
+	}
+
+	void requestSaveImage(const char* filename)
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_thumbnailMutex);
+			strcpy(s_thumbnailRequest, filename);
+			s_thumbnailReady = false;
+			if (!s_thumbnailThread.joinable())
+			{
+				s_thumbnailQuit = false;
+				s_thumbnailThread = std::thread(thumbnailThread);
+			}
+		}
+		s_thumbnailWake.notify_one();
+	}
+
+	const u32* getSaveImage(const char* filename)
+	{
+		std::lock_guard<std::mutex> lock(s_thumbnailMutex);
+		if (!s_thumbnailReady || strcmp(s_thumbnailResultName, filename) != 0)
+		{
+			return nullptr;
+		}
+		memcpy(s_thumbnail, s_thumbnailResult, sizeof(s_thumbnail));
+		s_thumbnailReady = false;
+		return s_thumbnail;
 	}
 
+	// Called from the file writer thread.
+	static void saveWriteComplete(size_t bytesWritten, void* userData, u32 errorCode)
+	{
+		SaveWrite* write = (SaveWrite*)userData;
+		bool saved = false;
+		if (errorCode != AFW_SUCCESS)
+		{
+			TFE_System::logWrite(LOG_ERROR, "Save", "Failed to write save game '%s', error %u.", write->tempPath, errorCode);
+		}
+		else if (!FileUtil::replaceFile(write->tempPath, write->filePath))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Save", "Failed to replace save game '%s'.", write->filePath);
+		}
+		else
+		{
+			saved = true;
+		}
+
+		if (!saved)
+		{
+			if (FileUtil::exists(write->tempPath))
+			{
+				FileUtil::deleteFile(write->tempPath);
+			}
+			std::lock_guard<std::mutex> lock(s_failedSaveMutex);
+			s_failedSaves.push_back(write->fileName);
+		}
+		delete write;
+	}
+
+	static void reportSaveFailure()
+	{
+		const char* msg = TFE_System::getMessage(TFE_MSG_SAVE_FAILED);
+		if (s_game && msg)
+		{
+			s_game->showMessage(msg);
+		}
+	}
+
+	// Failed saves are removed from the index, so the previous save (if any) is read again, and reported to the player.
+	static void handleFailedSaves()
+	{
+		std::vector<std::string> failedSaves;
+		{
+			std::lock_guard<std::mutex> lock(s_failedSaveMutex);
+			failedSaves.swap(s_failedSaves);
+		}
+		if (failedSaves.empty()) { return; }
+
+		for (size_t i = 0; i < failedSaves.size(); i++)
+		{
+			s_saveIndex.erase(failedSaves[i]);
+		}
+		s_saveIndexDirty = true;
+		reportSaveFailure();
+	}
+
+	// Headers are read from the save index, only new or modified saves are opened.
 	void populateSaveDirectory(std::vector<SaveHeader>& dir)
 	{
 		dir.clear();
+		loadSaveIndex();
+		resolvePendingWrites();
+
 		FileList fileList;
 		FileUtil::readDirectory(s_gameSavePath, "tfe", fileList);
-		size_t saveCount = fileList.size();
-		dir.resize(saveCount);
+		const size_t saveCount = fileList.size();
+		dir.reserve(saveCount);
+
+		for (auto& it : s_saveIndex)
+		{
+			it.second.found = false;
+		}
 
 		const std::string* filenames = fileList.data();
-		SaveHeader* headers = dir.data();
 		for (size_t i = 0; i < saveCount; i++)
 		{
-			loadGameHeader(filenames[i].c_str(), &headers[i]);
+			char filePath[TFE_MAX_PATH];
+			sprintf(filePath, "%s%s", s_gameSavePath, filenames[i].c_str());
+			const u64 size = FileUtil::getFileSize(filePath);
+			const u64 modifiedTime = FileUtil::getModifiedTime(filePath);
+
+			auto it = s_saveIndex.find(filenames[i]);
+			if (it == s_saveIndex.end() || it->second.size != size || it->second.modifiedTime != modifiedTime)
+			{
+				SaveIndexEntry entry = {};
+				if (!loadGameHeader(filenames[i].c_str(), &entry.header)) { continue; }
+				entry.size = size;
+				entry.modifiedTime = modifiedTime;
+				s_saveIndex[filenames[i]] = entry;
+				it = s_saveIndex.find(filenames[i]);
+				s_saveIndexDirty = true;
+			}
+			it->second.found = true;
+			dir.push_back(it->second.header);
 		}
+
+		// Remove deleted saves from the index.
+		for (auto it = s_saveIndex.begin(); it != s_saveIndex.end();)
+		{
+			if (!it->second.found)
+			{
+				it = s_saveIndex.erase(it);
+				s_saveIndexDirty = true;
+			}
+			else
+			{
+				++it;
+			}
+		}
+		writeSaveIndex();
 	}
 
 	void init()
@@ -178,6 +546,24 @@ namespace TFE_SaveSystem
 
 	void destroy()
 	{
+		{
+			std::lock_guard<std::mutex> lock(s_thumbnailMutex);
+			s_thumbnailQuit = true;
+		}
+		s_thumbnailWake.notify_all();
+		if (s_thumbnailThread.joinable())
+		{
+			s_thumbnailThread.join();
+		}
+
+		if (s_saveIndexLoaded)
+		{
+			resolvePendingWrites();
+			writeSaveIndex();
+		}
+		FileWriterAsync::flush();
+		s_compressedState.clear();
+		s_compressedState.shrink_to_fit();
 		for (s32 i = 0; i < 2; i++)
 		{
 			free(s_imageBuffer[i]);
@@ -186,34 +572,115 @@ namespace TFE_SaveSystem
 		}
 	}
 
+	// The game is serialized to memory and compressed, then written to disk in the background.
+	// Returns false if the save cannot be queued, write failures are reported once the write completes.
 	bool saveGame(const char* filename, const char* saveName)
 	{
-		char filePath[TFE_MAX_PATH];
-		sprintf(filePath, "%s%s", s_gameSavePath, filename);
+		MemoryStream file;
+		MemoryStream state;
+		if (!file.open(Stream::MODE_WRITE) || !state.open(Stream::MODE_WRITE))
+		{
+			return false;
+		}
+		saveHeader(&file, saveName);
+		if (!s_game->serializeGameState(&state, filename, true))
+		{
+			return false;
+		}
 
-		bool ret = false;
-		FileStream stream;
-		if (stream.open(filePath, Stream::MODE_WRITE))
+		const u32 stateSize = (u32)state.getSize();
+		const u8* stateData = (const u8*)state.data();
+		u32 flags = SSTATE_NONE;
+		u32 dataSize = stateSize;
+		if (zstd_compress(s_compressedState, stateData, stateSize, SAVE_COMPRESSION_LEVEL))
 		{
-			saveHeader(&stream, saveName);
-			ret = s_game->serializeGameState(&stream, filename, true);
-			stream.close();
+			flags |= SSTATE_COMPRESSED;
+			stateData = s_compressedState.data();
+			dataSize = (u32)s_compressedState.size();
 		}
-		return ret;
+
+		file.write(&flags);
+		file.write(&stateSize);
+		file.write(&dataSize);
+		file.writeBuffer(stateData, dataSize);
+
+		SaveWrite* write = new SaveWrite;
+		strcpy(write->fileName, filename);
+		sprintf(write->filePath, "%s%s", s_gameSavePath, filename);
+		sprintf(write->tempPath, "%s.tmp", write->filePath);
+		if (!FileWriterAsync::writeFileToDisk(write->tempPath, (u8*)file.data(), file.getSize(), saveWriteComplete, write))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Save", "Cannot queue the save game '%s'.", write->filePath);
+			delete write;
+			return false;
+		}
+
+		// Update the save index from the header that was just written.
+		loadSaveIndex();
+		SaveIndexEntry entry = {};
+		file.open(Stream::MODE_READ);
+		loadHeader(&file, &entry.header, filename);
+		strcpy(entry.header.fileName, filename);
+		entry.pendingWrite = true;
+		s_saveIndex[filename] = entry;
+		return true;
+	}
+
+	// Reads the game state that follows the header (SVER_COMPRESSED and later) into 'state'.
+	static bool loadGameState(Stream* stream, MemoryStream* state)
+	{
+		u32 flags, stateSize, dataSize;
+		stream->read(&flags);
+		stream->read(&stateSize);
+		stream->read(&dataSize);
+		if (!state->allocate(stateSize)) { return false; }
+
+		if (flags & SSTATE_COMPRESSED)
+		{
+			s_compressedState.resize(dataSize);
+			if (stream->readBuffer(s_compressedState.data(), dataSize) != dataSize ||
+				!zstd_decompress((u8*)state->data(), stateSize, s_compressedState.data(), dataSize))
+			{
+				return false;
+			}
+		}
+		else if (stream->readBuffer(state->data(), stateSize) != stateSize)
+		{
+			return false;
+		}
+		return state->open(Stream::MODE_READ);
 	}
 
 	bool loadGame(const char* filename)
 	{
 		char filePath[TFE_MAX_PATH];
 		sprintf(filePath, "%s%s", s_gameSavePath, filename);
+		// The save may still be queued, for example a quickload right after a quicksave.
+		FileWriterAsync::flush();
 
 		bool ret = false;
 		FileStream stream;
 		if (stream.open(filePath, Stream::MODE_READ))
 		{
 			SaveHeader header;
-			loadHeader(&stream, &header, filename);
-			ret = s_game->serializeGameState(&stream, filename, false);
+			const u32 version = loadHeader(&stream, &header, filename);
+			if (version < SVER_COMPRESSED)
+			{
+				// Older saves store the uncompressed game state directly after the header.
+				ret = s_game->serializeGameState(&stream, filename, false);
+			}
+			else
+			{
+				MemoryStream state;
+				if (loadGameState(&stream, &state))
+				{
+					ret = s_game->serializeGameState(&state, filename, false);
+				}
+				else
+				{
+					TFE_System::logWrite(LOG_ERROR, "Save", "Cannot read the game state from save '%s'.", filename);
+				}
+			}
 			stream.close();
 		}
 		return ret;
@@ -223,6 +690,7 @@ namespace TFE_SaveSystem
 	{
 		char filePath[TFE_MAX_PATH];
 		sprintf(filePath, "%s%s", s_gameSavePath, filename);
+		FileWriterAsync::flush();
 
 		bool ret = false;
 		FileStream stream;
@@ -285,6 +753,14 @@ namespace TFE_SaveSystem
 
 	void setCurrentGame(GameID id)
 	{
+		// The index is per game, so write out any changes before switching.
+		if (s_saveIndexLoaded)
+		{
+			resolvePendingWrites();
+			writeSaveIndex();
+			s_saveIndexLoaded = false;
+		}
+
 		char relativeBasePath[TFE_MAX_PATH];
 		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, "Saves/", relativeBasePath);
 		if (!FileUtil::directoryExits(s_gameSavePath))
@@ -316,14 +792,15 @@ namespace TFE_SaveSystem
 		const char* saveFilename = saveRequestFilename();
 
 		bool canSave = !lastState && s_game->canSave();
+		handleFailedSaves();
 		if (saveFilename && canSave)
 		{
-			saveGame(saveFilename, s_reqSavename);
+			if (!saveGame(saveFilename, s_reqSavename)) { reportSaveFailure(); }
 			lastState = 1;
 		}
 		else if (inputMapping_getActionState(IAS_QUICK_SAVE) == STATE_PRESSED && canSave)
 		{
-			saveGame(c_quickSaveName, "Quicksave");
+			if (!saveGame(c_quickSaveName, "Quicksave")) { reportSaveFailure(); }
 			lastState = 1;
 		}
 		else if (inputMapping_getActionState(IAS_QUICK_LOAD) == STATE_PRESSED && !lastState)
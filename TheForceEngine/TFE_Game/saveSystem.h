@@ -21,7 +21,6 @@ namespace TFE_SaveSystem
 		char dateTime[256];
 		char levelName[256];
 		char modNames[256];
-		u32  imageData[SAVE_IMAGE_WIDTH * SAVE_IMAGE_HEIGHT];
 	};
 
 	void init();
@@ -32,8 +31,13 @@ namespace TFE_SaveSystem
 	void update();
 	bool saveGame(const char* filename, const char* saveName);
 	bool loadGame(const char* filename);
-	// Load only the header for UI.
+	// Load only the header for UI, without the image.
 	bool loadGameHeader(const char* filename, SaveHeader* header);
+	// Images are decoded in the background, only for the saves that the UI shows.
+	void requestSaveImage(const char* filename);
+	// Returns the requested image (SAVE_IMAGE_WIDTH x SAVE_IMAGE_HEIGHT, RGBA) once it has been decoded, otherwise null.
+	// The pointer is valid until the next call.
+	const u32* getSaveImage(const char* filename);
 
 	void postLoadRequest(const char* filename);
 	void postSaveRequest(const char* filename, const char* saveName, s32 delay = 0);
@@ -8,8 +8,6 @@
 
 namespace TFE_Input
 {
-	#define BUFFERED_TEXT_LEN 64
-
 	////////////////////////////////////////////////////////
 	// Input State
 	////////////////////////////////////////////////////////
@@ -353,6 +351,43 @@ namespace TFE_Input
 		return s_bufferedKey[key];
 	}
 
+	// Record/Replay
+	void getInputState(InputState* state)
+	{
+		memcpy(state->axis, s_axis, sizeof(s_axis));
+		memcpy(state->buttonDown, s_buttonDown, sizeof(s_buttonDown));
+		memcpy(state->buttonPressed, s_buttonPressed, sizeof(s_buttonPressed));
+		memcpy(state->keyDown, s_keyDown, sizeof(s_keyDown));
+		memcpy(state->keyPressed, s_keyPressed, sizeof(s_keyPressed));
+		memcpy(state->keyPressedRepeat, s_keyPressedRepeat, sizeof(s_keyPressedRepeat));
+		memcpy(state->bufferedText, s_bufferedText, sizeof(s_bufferedText));
+		memcpy(state->bufferedKey, s_bufferedKey, sizeof(s_bufferedKey));
+		memcpy(state->mouseDown, s_mouseDown, sizeof(s_mouseDown));
+		memcpy(state->mousePressed, s_mousePressed, sizeof(s_mousePressed));
+		memcpy(state->mouseWheel, s_mouseWheel, sizeof(s_mouseWheel));
+		memcpy(state->mouseMove, s_mouseMove, sizeof(s_mouseMove));
+		memcpy(state->mouseMoveAccum, s_mouseMoveAccum, sizeof(s_mouseMoveAccum));
+		memcpy(state->mousePos, s_mousePos, sizeof(s_mousePos));
+	}
+
+	void setInputState(const InputState* state)
+	{
+		memcpy(s_axis, state->axis, sizeof(s_axis));
+		memcpy(s_buttonDown, state->buttonDown, sizeof(s_buttonDown));
+		memcpy(s_buttonPressed, state->buttonPressed, sizeof(s_buttonPressed));
+		memcpy(s_keyDown, state->keyDown, sizeof(s_keyDown));
+		memcpy(s_keyPressed, state->keyPressed, sizeof(s_keyPressed));
+		memcpy(s_keyPressedRepeat, state->keyPressedRepeat, sizeof(s_keyPressedRepeat));
+		memcpy(s_bufferedText, state->bufferedText, sizeof(s_bufferedText));
+		memcpy(s_bufferedKey, state->bufferedKey, sizeof(s_bufferedKey));
+		memcpy(s_mouseDown, state->mouseDown, sizeof(s_mouseDown));
+		memcpy(s_mousePressed, state->mousePressed, sizeof(s_mousePressed));
+		memcpy(s_mouseWheel, state->mouseWheel, sizeof(s_mouseWheel));
+		memcpy(s_mouseMove, state->mouseMove, sizeof(s_mouseMove));
+		memcpy(s_mouseMoveAccum, state->mouseMoveAccum, sizeof(s_mouseMoveAccum));
+		memcpy(s_mousePos, state->mousePos, sizeof(s_mousePos));
+	}
+
 	bool loadKeyNames(const char* path)
 	{
 		FileStream file;
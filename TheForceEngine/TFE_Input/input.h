@@ -14,6 +14,31 @@
 
 typedef void(*KeyBindingCallback)(f32 value);
 
+#define BUFFERED_TEXT_LEN 64
+
+// TFE: A copy of the raw input state, used to record and replay input.
+struct InputState
+{
+	f32 axis[AXIS_COUNT];
+	u8 buttonDown[CONTROLLER_BUTTON_COUNT];
+	u8 buttonPressed[CONTROLLER_BUTTON_COUNT];
+
+	u8 keyDown[KEY_COUNT];
+	u8 keyPressed[KEY_COUNT];
+	u8 keyPressedRepeat[KEY_COUNT];
+
+	char bufferedText[BUFFERED_TEXT_LEN];
+	u8 bufferedKey[KEY_COUNT];
+
+	u8 mouseDown[MBUTTON_COUNT];
+	u8 mousePressed[MBUTTON_COUNT];
+
+	s32 mouseWheel[2];
+	s32 mouseMove[2];
+	s32 mouseMoveAccum[2];
+	s32 mousePos[2];
+};
+
 namespace TFE_Input
 {
 	// Call this once at the end of each frame
@@ -63,6 +88,10 @@ namespace TFE_Input
 	const char* getBufferedText();
 	bool bufferedKeyDown(KeyboardCode key);
 
+	// Record/Replay
+	void getInputState(InputState* state);
+	void setInputState(const InputState* state);
+
 	KeyboardCode getKeyPressed();
 	KeyModifier  getKeyModifierDown();
 	Button getControllerButtonPressed();
@@ -4,10 +4,13 @@
 #include <TFE_Jedi/Level/rwall.h>
 #include <TFE_Jedi/Level/robject.h>
 #include <TFE_Jedi/Level/rtexture.h>
+#include <TFE_Jedi/Level/sectorIndex.h>
 #include <TFE_Jedi/Math/core_math.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 // Merge player collision into collision
 #include <TFE_DarkForces/playerCollision.h>
+#include <TFE_Settings/settings.h>
+#include <vector>
 using namespace TFE_DarkForces;
 
 // These will be moved over from player collision.
@@ -127,6 +130,15 @@ namespace TFE_Jedi
 	
 	static s32 s_colObjCount;
 	fixed16_16 s_colObjOverlap;
+
+	// TFE: Range query broadphase.
+	// Effect functions can start another range query, so each nesting level gets its own sector list.
+	enum
+	{
+		COL_RANGE_QUERY_MAX_DEPTH = 4,
+	};
+	static std::vector<s32> s_rangeQuerySectors[COL_RANGE_QUERY_MAX_DEPTH];
+	static s32 s_rangeQueryDepth = 0;
 	
 	////////////////////////////////////////////////////////
 	// Forward Declarations
@@ -432,6 +444,37 @@ namespace TFE_Jedi
 		return (sector == sector1) ? JTRUE : JFALSE;
 	}
 
+	// TFE: Get the sectors that a range query needs to visit.
+	// The original code visits every sector in the level, which is what happens when this returns nullptr (broadphase disabled or
+	// the sector index is not available). Otherwise the list only holds sectors with objects that overlap the query bounds, in
+	// ascending order, so objects are still visited in the original order. Every call must be paired with collision_endRangeQuery().
+	// The bounds are expanded by the largest object radius, since an object may be slightly outside of its sector bounds.
+	static const std::vector<s32>* collision_beginRangeQuery(fixed16_16 x0, fixed16_16 z0, fixed16_16 x1, fixed16_16 z1)
+	{
+		std::vector<s32>* list = nullptr;
+		if (s_rangeQueryDepth < COL_RANGE_QUERY_MAX_DEPTH && TFE_Settings::getGameSettings()->df_collisionBroadphase)
+		{
+			const fixed16_16 radius = sectorIndex_getMaxObjectRadius();
+			list = &s_rangeQuerySectors[s_rangeQueryDepth];
+			if (!sectorIndex_getObjectSectorsInRange(x0 - radius, z0 - radius, x1 + radius, z1 + radius, *list))
+			{
+				list = nullptr;
+			}
+		}
+		s_rangeQueryDepth++;
+		return list;
+	}
+
+	static void collision_endRangeQuery()
+	{
+		s_rangeQueryDepth--;
+	}
+
+	static RSector* collision_getRangeQuerySector(const std::vector<s32>* list, s32 index)
+	{
+		return list ? &s_levelState.sectors[(*list)[index]] : &s_levelState.sectors[index];
+	}
+
 	// Determines if an object with the correct entityFlag(s) is in range (radius) of (x,y,z) in sector and is not skipObj.
 	// Note only objects with a clear line-of-sight are accepted.
 	JBool collision_isAnyObjectInRange(RSector* sector, fixed16_16 radius, vec3_fixed origin, SecObject* skipObj, u32 entityFlags)
@@ -450,29 +493,22 @@ namespace TFE_Jedi
 		fixed16_16 z1 = origin.z + radius;
 
 		fixed16_16 secHeightThreshold = origin.y - COL_SEC_HEIGHT_OFFSET;
-		RSector* curSector = s_levelState.sectors;
-
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, curSector++)
+		// TFE: The original code tested the start sector bounds and floor inside of the sector loop. The sector contains
+		// the origin, so the bounds always overlap, and the floor test does not depend on the loop.
+		fixed16_16 floorHeight, ceilHeight;
+		sector_calculateFloor(sector, origin.y, &floorHeight, &ceilHeight);
+		if (floorHeight < y0 || ceilHeight > y1)
 		{
-			///////////////////////////////////////////////
-			// These tests should only happen once I think,
-			// unless x0, x1, z0, z1 change over time.
-			///////////////////////////////////////////////
-			if (x0 > sector->boundsMax.x || x1 < sector->boundsMin.x || z0 > sector->boundsMax.z || z1 < sector->boundsMin.z)
-			{
-				continue;
-			}
+			return JFALSE;
+		}
 
-			fixed16_16 floorHeight, ceilHeight;
-			sector_calculateFloor(sector, origin.y, &floorHeight, &ceilHeight);
-			if (floorHeight < y0 || ceilHeight > y1)
-			{
-				continue;
-			}
-			/////////////////////////////////////////////
-			// End of checks to pull out of the loop.
-			/////////////////////////////////////////////
+		const std::vector<s32>* rangeSectors = collision_beginRangeQuery(x0, z0, x1, z1);
+		const s32 rangeSectorCount = rangeSectors ? s32(rangeSectors->size()) : s32(s_levelState.sectorCount);
+		JBool objInRange = JFALSE;
 
+		for (s32 i = 0; i < rangeSectorCount && !objInRange; i++)
+		{
+			RSector* curSector = collision_getRangeQuerySector(rangeSectors, i);
 			s32 objCapacity = curSector->objectCapacity;
 			s32 objCount = curSector->objectCount;
 			for (s32 objListIndex = 0, objIndex = 0; objIndex < objCount && objListIndex < objCapacity; objListIndex++)
@@ -505,11 +541,13 @@ namespace TFE_Jedi
 
 				if (curSector == obj->sector)
 				{
-					return JTRUE;
+					objInRange = JTRUE;
+					break;
 				}
 			}
 		}
-		return JFALSE;
+		collision_endRangeQuery();
+		return objInRange;
 	}
 		
 	// Call the effectFunc() for each object within 'range' of point (x,y,z). This will only be called for objects in range and that have a valid collision path.
@@ -525,19 +563,14 @@ namespace TFE_Jedi
 		const fixed16_16 z1 = origin.z + range;
 
 		const fixed16_16 secHeightThreshold = origin.y - COL_SEC_HEIGHT_OFFSET;
-		RSector* sector = s_levelState.sectors;
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		const std::vector<s32>* rangeSectors = collision_beginRangeQuery(x0, z0, x1, z1);
+		const s32 rangeSectorCount = rangeSectors ? s32(rangeSectors->size()) : s32(s_levelState.sectorCount);
+		for (s32 i = 0; i < rangeSectorCount; i++)
 		{
-			// Checks the start sector, should be pulled out of the loop.
-			if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
-			{
-				continue;
-			}
-
+			RSector* sector = collision_getRangeQuerySector(rangeSectors, i);
 			fixed16_16 floor, ceil;
 			sector_calculateFloor(sector, origin.y, &floor, &ceil);
 			if (y0 > floor || y1 < ceil) { continue; }
-			// End of start sector check.
 
 			for (s32 objIndex = 0, objListIndex = 0; objIndex < sector->objectCount && objListIndex < sector->objectCapacity; objListIndex++)
 			{
@@ -565,6 +598,7 @@ namespace TFE_Jedi
 				}
 			}  // Object Loop.
 		}  // Sector loop.
+		collision_endRangeQuery();
 	}
 
 	// Call the effectFunc() for each object within 'range' of point (x,y,z). This will only be called for objects in range and that have a valid collision path.
@@ -585,22 +619,20 @@ namespace TFE_Jedi
 		const fixed16_16 z1 = origin.z + range;
 
 		const fixed16_16 secHeightThreshold = origin.y - COL_SEC_HEIGHT_OFFSET;
-		RSector* sector = s_levelState.sectors;
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// TFE: The original code tested the start sector bounds and floor inside of the sector loop. The sector contains
+		// the origin, so the bounds always overlap, and the floor test does not depend on the loop.
+		fixed16_16 floor, ceil;
+		sector_calculateFloor(startSector, origin.y, &floor, &ceil);
+		if (y0 > floor || y1 < ceil)
 		{
-			// Checks the start sector, should be pulled out of the loop.
-			if (x0 > startSector->boundsMax.x || x1 < startSector->boundsMin.x || z0 > startSector->boundsMax.z || z1 < startSector->boundsMin.z)
-			{
-				continue;
-			}
-			fixed16_16 floor, ceil;
-			sector_calculateFloor(startSector, origin.y, &floor, &ceil);
-			if (y0 > floor || y1 < ceil)
-			{
-				continue;
-			}
-			// End of start sector check.
+			return;
+		}
 
+		const std::vector<s32>* rangeSectors = collision_beginRangeQuery(x0, z0, x1, z1);
+		const s32 rangeSectorCount = rangeSectors ? s32(rangeSectors->size()) : s32(s_levelState.sectorCount);
+		for (s32 i = 0; i < rangeSectorCount; i++)
+		{
+			RSector* sector = collision_getRangeQuerySector(rangeSectors, i);
 			for (s32 objIndex = 0, objListIndex = 0; objIndex < sector->objectCount && objListIndex < sector->objectCapacity; objListIndex++)
 			{
 				SecObject* obj = sector->objectList[objListIndex];
@@ -649,6 +681,7 @@ namespace TFE_Jedi
 				}
 			}  // Object Loop.
 		}  // Sector Loop.
+		collision_endRangeQuery();
 	}
 		
 	static RSector*   s_hcolSector;
@@ -6,10 +6,14 @@
 #include "imList.h"
 #include <TFE_Jedi/Math/core_math.h>
 #include <TFE_System/system.h>
+#include <TFE_System/simd.h>
 #include <TFE_Audio/midi.h>
 #include <TFE_Audio/audioSystem.h>
+#include <TFE_FrontEndUI/console.h>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <vector>
 
 namespace TFE_Jedi
 {
@@ -80,6 +84,20 @@ namespace TFE_Jedi
 	static s16 s_audioOut[AUDIO_BUFFER_SIZE + IM_AUDIO_OVERSAMPLE*2];	// Add 2 stereo samples from the next frame for interpolation.
 	static s32 s_audioOutSize;
 	static u8* s_audioData;
+
+	// Mixing and output conversion kernels, selected at the start of each update.
+	typedef void(*ImMixStereoFunc)(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size);
+	typedef void(*ImConvertOutputFunc)(f32* driverOut, const s16* audioOut, s32 count, f32 systemVolume);
+	static ImMixStereoFunc     s_mixStereo;
+	static ImConvertOutputFunc s_convertOutput;
+
+	// Each row of s_audioVolumeToSignedMapping[] is a rounded linear scale of the centered sample:
+	//   mapping[(vol << 8) + sample] == ((sample - 128) * ImVolumeToGain(vol) + 1024) >> 11
+	// The vector kernels use this to scale samples directly, giving the same results as the table lookups.
+	static inline s32 ImVolumeToGain(s32 volume)
+	{
+		return volume ? volume * 129 - 16 : 0;
+	}
 			
 	extern s32 ImWrapValue(s32 value, s32 a, s32 b);
 	extern s32 ImGetGroupVolume(s32 group);
@@ -95,6 +113,8 @@ namespace TFE_Jedi
 	s32 ImStartDigitalSoundIntern(ImSoundId soundId, s32 priority, s32 chunkIndex);
 	s32 audioPlaySoundFrame(ImWaveSound* sound);
 	s32 audioWriteToDriver(f32 systemVolume);
+	void ImSelectMixKernels();
+	void imuseMixCheckConsole(const ConsoleArgList& args);
 		
 	/////////////////////////////////////////////////////////// 
 	// API
@@ -136,6 +156,7 @@ namespace TFE_Jedi
 		}
 
 		TFE_Audio::setAudioThreadCallback(ImUpdateWave);
+		CCMD("imuseMixCheck", imuseMixCheckConsole, 0, "Run test data through the SIMD and table iMuse digital sound kernels and compare the output bit-for-bit.");
 
 		return ImComputeAudioNormalizationInit(initData);
 	}
@@ -197,6 +218,7 @@ namespace TFE_Jedi
 		s_audioOutSize = bufferSize;
 		assert(bufferSize * 2 <= AUDIO_BUFFER_SIZE);
 		memset(s_audioOut, 0, 2*(bufferSize + IM_AUDIO_OVERSAMPLE) * sizeof(s16));
+		ImSelectMixKernels();
 
 		// Write sounds to s_audioOut.
 		ImWaveSound* sound = s_imWaveSoundList;
@@ -251,6 +273,17 @@ namespace TFE_Jedi
 
 	s32 ImComputeAudioNormalizationInit(iMuseInitData* initData)
 	{
+	#ifdef _DEBUG
+		// The vector mixing kernels rely on the volume mapping rows being linear in the sample value.
+		for (s32 vol = 0; vol <= 16; vol++)
+		{
+			const s8* mapping = (s8*)&s_audioVolumeToSignedMapping[vol << 8];
+			for (s32 sample = 0; sample < 256; sample++)
+			{
+				assert(mapping[sample] == (((sample - 128) * ImVolumeToGain(vol) + 1024) >> 11));
+			}
+		}
+	#endif
 		s_imDigitalData = initData;
 		return ImComputeAudioNormalization(initData->waveMixCount);
 	}
@@ -677,6 +710,176 @@ namespace TFE_Jedi
 		}
 	}
 
+	void digitalAudioOutput_StereoVolume(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size)
+	{
+		// Map [0,255] sample values to signed output values based on volume.
+		const s8* leftMapping  = (s8*)&s_audioVolumeToSignedMapping[leftVolume  << 8];
+		const s8* rightMapping = (s8*)&s_audioVolumeToSignedMapping[rightVolume << 8];
+		digitalAudioOutput_Stereo(audioOut, sndData, leftMapping, rightMapping, size);
+	}
+
+	void audioConvertOutput(f32* driverOut, const s16* audioOut, s32 count, f32 systemVolume)
+	{
+		for (s32 i = 0; i < count; i++)
+		{
+			driverOut[i] = s_audioNormalization[audioOut[i]] * systemVolume;
+		}
+	}
+
+	// The SIMD mixing kernels compute 8 samples at a time as (sample - 128, 1) . (gain, 1024) >> 11, which
+	// matches the volume mapping tables exactly. Accumulation wraps in 16 bits, like the scalar version.
+#ifdef TFE_SIMD_SSE2
+	void digitalAudioOutput_Stereo_SSE2(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size)
+	{
+		const s16 leftGain  = (s16)ImVolumeToGain(leftVolume);
+		const s16 rightGain = (s16)ImVolumeToGain(rightVolume);
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one  = _mm_set1_epi16(1);
+		const __m128i center = _mm_set1_epi16(128);
+		const __m128i gain = _mm_setr_epi16(leftGain, 1024, rightGain, 1024, leftGain, 1024, rightGain, 1024);
+
+		s32 i = 0;
+		for (; i + 8 <= size; i += 8, sndData += 8, audioOut += 16)
+		{
+			const __m128i sample = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)sndData), zero), center);
+			// (sample, 1) pairs, each repeated for the left and right channels.
+			const __m128i lo = _mm_unpacklo_epi16(sample, one);
+			const __m128i hi = _mm_unpackhi_epi16(sample, one);
+			const __m128i s0 = _mm_srai_epi32(_mm_madd_epi16(_mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 1, 0, 0)), gain), 11);
+			const __m128i s1 = _mm_srai_epi32(_mm_madd_epi16(_mm_shuffle_epi32(lo, _MM_SHUFFLE(3, 3, 2, 2)), gain), 11);
+			const __m128i s2 = _mm_srai_epi32(_mm_madd_epi16(_mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 1, 0, 0)), gain), 11);
+			const __m128i s3 = _mm_srai_epi32(_mm_madd_epi16(_mm_shuffle_epi32(hi, _MM_SHUFFLE(3, 3, 2, 2)), gain), 11);
+
+			__m128i* out = (__m128i*)audioOut;
+			_mm_storeu_si128(out,     _mm_add_epi16(_mm_loadu_si128(out),     _mm_packs_epi32(s0, s1)));
+			_mm_storeu_si128(out + 1, _mm_add_epi16(_mm_loadu_si128(out + 1), _mm_packs_epi32(s2, s3)));
+		}
+		digitalAudioOutput_StereoVolume(audioOut, sndData, leftVolume, rightVolume, size - i);
+	}
+#endif
+
+#ifdef TFE_SIMD_AVX2
+	// The normalization curve is not linear, so it is still a table lookup, done with a gather.
+	TFE_TARGET_AVX2 static void audioConvertOutput_AVX2(f32* driverOut, const s16* audioOut, s32 count, f32 systemVolume)
+	{
+		const __m256 volume = _mm256_set1_ps(systemVolume);
+		s32 i = 0;
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m256i index = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(audioOut + i)));
+			_mm256_storeu_ps(driverOut + i, _mm256_mul_ps(_mm256_i32gather_ps(s_audioNormalization, index, 4), volume));
+		}
+		audioConvertOutput(driverOut + i, audioOut + i, count - i, systemVolume);
+	}
+#endif
+
+#ifdef TFE_SIMD_NEON
+	void digitalAudioOutput_Stereo_NEON(s16* audioOut, const u8* sndData, s32 leftVolume, s32 rightVolume, s32 size)
+	{
+		const s16 leftGain  = (s16)ImVolumeToGain(leftVolume);
+		const s16 rightGain = (s16)ImVolumeToGain(rightVolume);
+		const int16x8_t center = vdupq_n_s16(128);
+		const int32x4_t round  = vdupq_n_s32(1024);
+
+		s32 i = 0;
+		for (; i + 8 <= size; i += 8, sndData += 8, audioOut += 16)
+		{
+			const int16x8_t sample = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(sndData))), center);
+			const int16x4_t sampleLo = vget_low_s16(sample);
+			const int16x4_t sampleHi = vget_high_s16(sample);
+			const int16x8_t left  = vcombine_s16(vshrn_n_s32(vmlal_n_s16(round, sampleLo, leftGain), 11),  vshrn_n_s32(vmlal_n_s16(round, sampleHi, leftGain), 11));
+			const int16x8_t right = vcombine_s16(vshrn_n_s32(vmlal_n_s16(round, sampleLo, rightGain), 11), vshrn_n_s32(vmlal_n_s16(round, sampleHi, rightGain), 11));
+
+			int16x8x2_t out = vld2q_s16(audioOut);
+			out.val[0] = vaddq_s16(out.val[0], left);
+			out.val[1] = vaddq_s16(out.val[1], right);
+			vst2q_s16(audioOut, out);
+		}
+		digitalAudioOutput_StereoVolume(audioOut, sndData, leftVolume, rightVolume, size - i);
+	}
+#endif
+
+	static void ImGetMixKernels(ImMixStereoFunc& mixStereo, ImConvertOutputFunc& convertOutput)
+	{
+		mixStereo = digitalAudioOutput_StereoVolume;
+		convertOutput = audioConvertOutput;
+	#ifdef TFE_SIMD_SSE2
+		if (TFE_Simd::hasFeature(SIMD_SSE2)) { mixStereo = digitalAudioOutput_Stereo_SSE2; }
+	#endif
+	#ifdef TFE_SIMD_AVX2
+		if (TFE_Simd::hasFeature(SIMD_AVX2)) { convertOutput = audioConvertOutput_AVX2; }
+	#endif
+	#ifdef TFE_SIMD_NEON
+		if (TFE_Simd::hasFeature(SIMD_NEON)) { mixStereo = digitalAudioOutput_Stereo_NEON; }
+	#endif
+	}
+
+	void ImSelectMixKernels()
+	{
+		ImGetMixKernels(s_mixStereo, s_convertOutput);
+	}
+
+	// Golden output check: runs synthetic data through the table kernels and the selected kernels and compares the results.
+	// Every volume pair is mixed into a partially filled buffer, with an odd length so the scalar tails are exercised,
+	// and every normalization table entry is converted. This runs on the calling thread and does not touch the live mixer state.
+	void imuseMixCheckConsole(const ConsoleArgList& args)
+	{
+		ImMixStereoFunc mixStereo;
+		ImConvertOutputFunc convertOutput;
+		ImGetMixKernels(mixStereo, convertOutput);
+
+		const s32 sampleCount = 1031;
+		std::vector<u8> sndData(sampleCount);
+		std::vector<s16> baseOut(sampleCount * 2);
+		for (s32 i = 0; i < sampleCount; i++)
+		{
+			const u32 hash = u32(i) * 2654435761u;
+			sndData[i] = u8(hash >> 24u);
+			// Existing output, large enough that some sums wrap.
+			baseOut[i * 2 + 0] = s16(hash >> 16u);
+			baseOut[i * 2 + 1] = s16(hash >> 8u);
+		}
+
+		s32 mixMismatchCount = 0;
+		std::vector<s16> tableOut, simdOut;
+		for (s32 leftVolume = 0; leftVolume <= 16; leftVolume++)
+		{
+			for (s32 rightVolume = 0; rightVolume <= 16; rightVolume++)
+			{
+				tableOut = baseOut;
+				simdOut = baseOut;
+				digitalAudioOutput_StereoVolume(tableOut.data(), sndData.data(), leftVolume, rightVolume, sampleCount);
+				mixStereo(simdOut.data(), sndData.data(), leftVolume, rightVolume, sampleCount);
+				if (memcmp(tableOut.data(), simdOut.data(), sizeof(s16) * tableOut.size()) != 0) { mixMismatchCount++; }
+			}
+		}
+
+		// The normalization table covers [-tableSize, tableSize) for the current channel count.
+		const s32 tableSize = s_imWaveMixCount << 7;
+		std::vector<s16> audioOut(tableSize * 2 + 3);
+		for (s32 i = 0; i < s32(audioOut.size()); i++)
+		{
+			audioOut[i] = s16(std::min(i - tableSize, tableSize - 1));
+		}
+		const s32 count = s32(audioOut.size());
+		std::vector<f32> tableDriverOut(count), simdDriverOut(count);
+		audioConvertOutput(tableDriverOut.data(), audioOut.data(), count, 0.75f);
+		convertOutput(simdDriverOut.data(), audioOut.data(), count, 0.75f);
+		s32 convertMismatchCount = 0;
+		for (s32 i = 0; i < count; i++)
+		{
+			if (memcmp(&tableDriverOut[i], &simdDriverOut[i], sizeof(f32)) != 0) { convertMismatchCount++; }
+		}
+
+		const bool simdMix = mixStereo != digitalAudioOutput_StereoVolume;
+		const bool simdConvert = convertOutput != audioConvertOutput;
+		char res[256];
+		sprintf(res, "iMuse mix: %s, %d of 289 volume pairs differ. Convert: %s, %d of %d samples differ.",
+			simdMix ? "SIMD" : "table only", mixMismatchCount, simdConvert ? "SIMD" : "table only", convertMismatchCount, count);
+		TFE_Console::addToHistory(res);
+		TFE_System::logWrite((mixMismatchCount || convertMismatchCount) ? LOG_ERROR : LOG_MSG, "iMuse", "Digital sound kernel check: %s", res);
+	}
+
 	void audioProcessFrame(u8* audioFrame, s32 size, s32 outOffset, s32 vol, s32 pan)
 	{
 		s32 vTop = vol >> 3;
@@ -698,11 +901,7 @@ namespace TFE_Jedi
 		// Calculate where the in panVolume mapping channel to read from for each channel.
 		s32 leftVolume  = s_audioPanVolumeTable[8 - panTop + vTop*17];
 		s32 rightVolume = s_audioPanVolumeTable[8 + panTop + vTop*17];
-		// Map [0,255] sample values to signed output values based on volume.
-		const s8* leftMapping  = (s8*)&s_audioVolumeToSignedMapping[leftVolume  << 8];
-		const s8* rightMapping = (s8*)&s_audioVolumeToSignedMapping[rightVolume << 8];
-
-		digitalAudioOutput_Stereo(&s_audioOut[outOffset * 2], audioFrame, leftMapping, rightMapping, size);
+		s_mixStereo(&s_audioOut[outOffset * 2], audioFrame, leftVolume, rightVolume, size);
 	}
 
 	s32 audioPlaySoundFrame(ImWaveSound* sound)
@@ -750,12 +949,7 @@ namespace TFE_Jedi
 		}
 
 		s32 bufferSize = 2*(s_audioOutSize + IM_AUDIO_OVERSAMPLE);
-		s16* audioOut  = s_audioOut;
-		f32* driverOut = s_audioDriverOut;
-		for (s32 i = 0; i < bufferSize; i++, audioOut++, driverOut++)
-		{
-			*driverOut = s_audioNormalization[*audioOut] * systemVolume;
-		}
+		s_convertOutput(s_audioDriverOut, s_audioOut, bufferSize, systemVolume);
 		return imSuccess;
 	}
 
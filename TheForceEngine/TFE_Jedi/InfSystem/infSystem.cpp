@@ -1232,20 +1232,18 @@ namespace TFE_Jedi
 			TFE_System::logWrite(LOG_ERROR, "level_loadINF", "Cannot find level INF '%s'.", levelPath);
 			return JFALSE;
 		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
+		// Parse in place when the file is in a memory mapped archive.
+		size_t len = 0;
+		const char* fileData = FileStream::readView(&filePath, s_buffer, &len);
+		if (!fileData)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadINF", "Cannot open level INF '%s'.", levelPath);
 			return JFALSE;
 		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
 
 		TFE_Parser parser;
 		size_t bufferPos = 0;
-		parser.init(s_buffer.data(), s_buffer.size());
+		parser.init(fileData, len);
 		parser.enableBlockComments();
 		parser.addCommentString("//");
 		parser.convertToUpperCase(true);
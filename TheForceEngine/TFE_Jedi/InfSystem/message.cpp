@@ -13,6 +13,8 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <algorithm>
+#include <cctype>
+#include <vector>
 
 namespace TFE_Jedi
 {
@@ -23,9 +25,66 @@ namespace TFE_Jedi
 	u32 s_msgArg2;
 	u32 s_msgEvent;
 
+	// TFE: Open addressing hash table over the message addresses, so INF loading and dispatch
+	// do not have to walk the full address list for every lookup. Names are compared
+	// case-insensitively over the first 16 characters, like the original search.
+	enum
+	{
+		MSG_ADDR_NAME_LEN = 16,
+		MSG_ADDR_MIN_TABLE_SIZE = 256,
+	};
+	static std::vector<MessageAddress*> s_addrTable;
+	static s32 s_addrCount = 0;
+
+	static u32 message_hashName(const char* name)
+	{
+		u32 hash = 2166136261u;
+		for (s32 i = 0; i < MSG_ADDR_NAME_LEN && name[i]; i++)
+		{
+			hash ^= (u32)toupper((u8)name[i]);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
+	// Insert the address unless another one already uses the name, the first address added wins.
+	static void message_insertAddress(MessageAddress* msgAddr)
+	{
+		const u32 mask = u32(s_addrTable.size()) - 1;
+		for (u32 slot = message_hashName(msgAddr->name) & mask; ; slot = (slot + 1) & mask)
+		{
+			if (!s_addrTable[slot])
+			{
+				s_addrTable[slot] = msgAddr;
+				s_addrCount++;
+				return;
+			}
+			if (strncasecmp(msgAddr->name, s_addrTable[slot]->name, MSG_ADDR_NAME_LEN) == 0)
+			{
+				return;
+			}
+		}
+	}
+
+	static void message_growTable()
+	{
+		std::vector<MessageAddress*> prevTable;
+		prevTable.swap(s_addrTable);
+		s_addrTable.assign(std::max(prevTable.size() * 2, size_t(MSG_ADDR_MIN_TABLE_SIZE)), nullptr);
+		s_addrCount = 0;
+
+		const size_t prevSize = prevTable.size();
+		for (size_t i = 0; i < prevSize; i++)
+		{
+			if (prevTable[i]) { message_insertAddress(prevTable[i]); }
+		}
+	}
+
 	void message_free()
 	{
 		s_messageAddr = nullptr;
+		s_addrTable.clear();
+		s_addrCount = 0;
 	}
 
 	void message_addAddress(const char* name, s32 param0, s32 param1, RSector* sector)
@@ -44,18 +103,27 @@ namespace TFE_Jedi
 		msgAddr->param0 = param0;
 		msgAddr->param1 = param1;
 		msgAddr->sector = sector;
+
+		// Keep the load factor at or below 1/2.
+		if (2 * (s_addrCount + 1) > (s32)s_addrTable.size())
+		{
+			message_growTable();
+		}
+		message_insertAddress(msgAddr);
 	}
 
 	MessageAddress* message_getAddress(const char* name)
 	{
-		MessageAddress* msgAddr = (MessageAddress*)allocator_getHead(s_messageAddr);
-		while (msgAddr)
+		if (!s_addrTable.empty())
 		{
-			if (strncasecmp(name, msgAddr->name, 16) == 0)
+			const u32 mask = u32(s_addrTable.size()) - 1;
+			for (u32 slot = message_hashName(name) & mask; s_addrTable[slot]; slot = (slot + 1) & mask)
 			{
-				return msgAddr;
+				if (strncasecmp(name, s_addrTable[slot]->name, MSG_ADDR_NAME_LEN) == 0)
+				{
+					return s_addrTable[slot];
+				}
 			}
-			msgAddr = (MessageAddress*)allocator_getNext(s_messageAddr);
 		}
 
 		TFE_System::logWrite(LOG_ERROR, "INF", "Message_GetAddress: ADDRESS NOT FOUND: %s", name);
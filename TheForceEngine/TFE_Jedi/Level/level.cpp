@@ -6,6 +6,7 @@
 #include "levelData.h"
 #include "rwall.h"
 #include "rtexture.h"
+#include "sectorIndex.h"
 #include <TFE_Game/igame.h>
 #include <TFE_Asset/assetSystem.h>
 #include <TFE_Asset/dfKeywords.h>
@@ -16,6 +17,7 @@
 #include <TFE_FileSystem/filestream.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_System/parser.h>
+#include <TFE_System/profiler.h>
 #include <TFE_System/system.h>
 #include <TFE_Settings/settings.h>
 
@@ -47,6 +49,18 @@ namespace TFE_Jedi
 	static char s_readBuffer[256];
 	static std::vector<char> s_buffer;
 
+	// TFE: Level start asset preloading.
+	static std::vector<std::string> s_preloadNames;
+	static std::vector<const char*> s_preloadNamePtrs;
+	// TFE: Asset names from the object file tables, the assets are loaded together once the tables have been read.
+	static std::vector<std::string> s_podNames;
+	static std::vector<std::string> s_spriteNames;
+	static std::vector<std::string> s_frameNames;
+	static std::vector<std::string> s_soundNames;
+	// TFE: Names that are not stored in the runtime level data, used to write the level cache.
+	static std::vector<std::string> s_cacheTextureNames;
+	static std::vector<std::string> s_cacheSectorNames;
+
 	JBool level_loadGeometry(const char* levelName);
 	JBool level_loadObjects(const char* levelName, u8 difficulty);
 	JBool level_loadGoals(const char* levelName);
@@ -72,6 +86,8 @@ namespace TFE_Jedi
 		level_loadObjects(levelName, difficulty);
 		inf_load(levelName);
 		level_loadGoals(levelName);
+		// TFE: The object radii are known now.
+		sectorIndex_updateObjectRadius();
 
 		return JTRUE;
 	}
@@ -140,6 +156,105 @@ namespace TFE_Jedi
 		// Setup the control sector.
 		s_levelState.controlSector->id = s_levelState.sectorCount;
 		s_levelState.controlSector->index = s_levelState.controlSector->id;
+
+		// TFE: Build the sector point-location index now that the bounds are known.
+		sectorIndex_build();
+	}
+
+	// Read the texture names ahead of the texture list so they can be decoded in parallel.
+	// A separate parser is used so the block comment state of the main parser is not affected.
+	static void level_preloadTextures(const char* fileData, size_t len, size_t bufferPos, s32 textureCount)
+	{
+		TFE_Parser parser;
+		parser.init(fileData, len);
+		parser.addCommentString("#");
+		parser.convertToUpperCase(true);
+
+		s_preloadNames.clear();
+		s_preloadNamePtrs.clear();
+		s_preloadNames.push_back("default.bm");
+		for (s32 i = 0; i < textureCount; i++)
+		{
+			const char* line = parser.readLine(bufferPos);
+			char textureName[256];
+			if (!line || sscanf(line, " TEXTURE: %s ", textureName) != 1)
+			{
+				break;
+			}
+			if (strcasecmp(textureName, "<NoTexture>") != 0)
+			{
+				s_preloadNames.push_back(textureName);
+			}
+		}
+		for (size_t i = 0; i < s_preloadNames.size(); i++)
+		{
+			s_preloadNamePtrs.push_back(s_preloadNames[i].c_str());
+		}
+		bitmap_preload(s_preloadNamePtrs.data(), (s32)s_preloadNamePtrs.size(), 1);
+	}
+
+	static void level_getNamePtrs(const std::vector<std::string>& names, std::vector<const char*>& ptrs)
+	{
+		ptrs.clear();
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			if (!names[i].empty()) { ptrs.push_back(names[i].c_str()); }
+		}
+	}
+
+	// Decode the models' textures, sprites, frames and sounds on the worker threads, then commit them in file order on this thread.
+	static void level_loadObjectAssets()
+	{
+		TFE_ZONE("Object Assets");
+		std::vector<const char*> frameNamePtrs;
+		level_getNamePtrs(s_podNames, s_preloadNamePtrs);
+		TFE_Model_Jedi::preload(s_preloadNamePtrs.data(), (s32)s_preloadNamePtrs.size());
+		level_getNamePtrs(s_spriteNames, s_preloadNamePtrs);
+		level_getNamePtrs(s_frameNames, frameNamePtrs);
+		TFE_Sprite_Jedi::preload(s_preloadNamePtrs.data(), (s32)s_preloadNamePtrs.size(), frameNamePtrs.data(), (s32)frameNamePtrs.size());
+		level_getNamePtrs(s_soundNames, s_preloadNamePtrs);
+		sound_preload(s_preloadNamePtrs.data(), (s32)s_preloadNamePtrs.size());
+
+		for (s32 p = 0; p < (s32)s_podNames.size(); p++)
+		{
+			if (s_podNames[p].empty()) { continue; }
+			s_levelIntState.pods[p] = TFE_Model_Jedi::get(s_podNames[p].c_str());
+			if (!s_levelIntState.pods[p])
+			{
+				s_levelIntState.pods[p] = TFE_Model_Jedi::get("default.3do");
+			}
+		}
+		for (s32 s = 0; s < (s32)s_spriteNames.size(); s++)
+		{
+			if (s_spriteNames[s].empty()) { continue; }
+			s_levelIntState.sprites[s] = TFE_Sprite_Jedi::getWax(s_spriteNames[s].c_str());
+			if (!s_levelIntState.sprites[s])
+			{
+				s_levelIntState.sprites[s] = TFE_Sprite_Jedi::getWax("default.wax");
+			}
+		}
+		for (s32 f = 0; f < (s32)s_frameNames.size(); f++)
+		{
+			if (s_frameNames[f].empty()) { continue; }
+			s_levelIntState.frames[f] = TFE_Sprite_Jedi::getFrame(s_frameNames[f].c_str());
+			if (!s_levelIntState.frames[f])
+			{
+				s_levelIntState.frames[f] = TFE_Sprite_Jedi::getFrame("default.fme");
+			}
+		}
+		for (s32 s = 0; s < (s32)s_soundNames.size(); s++)
+		{
+			if (s_soundNames[s].empty()) { continue; }
+			s_levelIntState.soundIds[s] = sound_load(s_soundNames[s].c_str(), SOUND_PRIORITY_LOW2);
+		}
+
+		bitmap_clearPreloaded();
+		TFE_Sprite_Jedi::clearPreloaded();
+		sound_clearPreloaded();
+		s_podNames.clear();
+		s_spriteNames.clear();
+		s_frameNames.clear();
+		s_soundNames.clear();
 	}
 
 	JBool level_loadGeometry(const char* levelName)
@@ -149,6 +264,7 @@ namespace TFE_Jedi
 		s_levelState.minLayer = INT_MAX;
 		s_levelState.maxLayer = INT_MIN;
 		message_free();
+		sectorIndex_clear();
 
 		// Try loading as an LVB
 		if (level_loadGeometryBin(levelName, s_buffer))
@@ -167,20 +283,26 @@ namespace TFE_Jedi
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot find level geometry '%s'.", levelName);
 			return false;
 		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
+		// Parse in place when the file is in a memory mapped archive.
+		size_t len = 0;
+		const char* fileData = FileStream::readView(&filePath, s_buffer, &len);
+		if (!fileData)
 		{
 			TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot open level geometry '%s'.", levelName);
 			return false;
 		}
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
+
+		// TFE: Load the compiled LVB if this LEV has been loaded before.
+		if (level_loadGeometryCache(levelName, fileData, len))
+		{
+			return JTRUE;
+		}
+		s_cacheTextureNames.clear();
+		s_cacheSectorNames.clear();
 
 		TFE_Parser parser;
 		size_t bufferPos = 0;
-		parser.init(s_buffer.data(), s_buffer.size());
+		parser.init(fileData, len);
 		parser.addCommentString("#");
 		parser.convertToUpperCase(true);
 
@@ -247,6 +369,9 @@ namespace TFE_Jedi
 		s_levelState.textures = (TextureData**)level_alloc(2 * s_levelState.textureCount * sizeof(TextureData**));
 		memset(s_levelState.textures, 0, 2 * s_levelState.textureCount * sizeof(TextureData**));
 
+		// TFE: Decode the level textures on the worker threads before loading them in order.
+		level_preloadTextures(fileData, len, bufferPos, s_levelState.textureCount);
+
 		// Load Textures.
 		TextureData** texture = s_levelState.textures;
 		TextureData** texBase = s_levelState.textures + s_levelState.textureCount;
@@ -259,8 +384,12 @@ namespace TFE_Jedi
 				TFE_System::logWrite(LOG_ERROR, "level_loadGeometry", "Cannot read texture name.");
 				*texture = bitmap_load("default.bm", 1);
 				(*texture)->flags |= ENABLE_MIP_MAPS;
+				s_cacheTextureNames.push_back("default.bm");
+				continue;
 			}
-			else if (strcasecmp(textureName, "<NoTexture>") == 0)
+			s_cacheTextureNames.push_back(textureName);
+
+			if (strcasecmp(textureName, "<NoTexture>") == 0)
 			{
 				*texture = nullptr;
 			}
@@ -291,6 +420,7 @@ namespace TFE_Jedi
 				}
 			}
 		}
+		bitmap_clearPreloaded();
 
 		// Load Sectors.
 		line = parser.readLine(bufferPos);
@@ -321,8 +451,11 @@ namespace TFE_Jedi
 			// Sectors missing a name are valid but do not get "addresses" - and thus cannot be
 			// used by the INF system (except in the case of doors and exploding walls, see the flags section below).
 			char name[256];
+			s_cacheSectorNames.push_back("");
 			if (sscanf(line, " NAME %s", name) == 1)
 			{
+				s_cacheSectorNames.back() = name;
+
 				// Add the sector "address" for later use by the INF system.
 				message_addAddress(name, 0, 0, sector);
 
@@ -577,6 +710,8 @@ namespace TFE_Jedi
 			}
 		}
 
+		// TFE: Write the cache before post-processing, which modifies the wall flags.
+		level_writeGeometryCache(fileData, len, s_cacheTextureNames, s_cacheSectorNames);
 		level_postProcessGeometry();
 
 		return true;
@@ -729,21 +864,18 @@ namespace TFE_Jedi
 			TFE_System::logWrite(LOG_ERROR, "Level Load", "Cannot find level objects '%s'.", levelName);
 			return false;
 		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
+		// Parse in place when the file is in a memory mapped archive.
+		size_t len = 0;
+		const char* fileData = FileStream::readView(&filePath, s_buffer, &len);
+		if (!fileData)
 		{
 			TFE_System::logWrite(LOG_ERROR, "Level Load", "Cannot open level objects '%s'.", levelName);
 			return false;
 		}
 
-		size_t len = file.getSize();
-		s_buffer.resize(len);
-		file.readBuffer(s_buffer.data(), u32(len));
-		file.close();
-
 		TFE_Parser parser;
 		size_t bufferPos = 0;
-		parser.init(s_buffer.data(), s_buffer.size());
+		parser.init(fileData, len);
 		parser.enableBlockComments();
 		parser.addCommentString("//");
 		parser.addCommentString("#");
@@ -759,14 +891,24 @@ namespace TFE_Jedi
 			return false;
 		}
 
-		while (nullptr != (line = parser.readLine(bufferPos)))
+		// TFE: The asset tables are read from the whole file first and the assets are loaded together,
+		// then the objects are created in a second pass over the file.
+		s_podNames.clear();
+		s_spriteNames.clear();
+		s_frameNames.clear();
+		s_soundNames.clear();
+
+		TFE_Parser tableParser = parser;
+		size_t tablePos = bufferPos;
+		while (nullptr != (line = tableParser.readLine(tablePos)))
 		{
 			if (sscanf(line, "PODS %d", &s_levelIntState.podCount) == 1)
 			{
 				s_levelIntState.pods = (JediModel**)level_alloc(sizeof(JediModel*)*s_levelIntState.podCount);
+				s_podNames.assign(s_levelIntState.podCount, std::string());
 				for (s32 p = 0; p < s_levelIntState.podCount; p++)
 				{
-					line = parser.readLine(bufferPos);
+					line = tableParser.readLine(tablePos);
 					s_levelIntState.pods[p] = nullptr;
 
 					if (line)
@@ -774,11 +916,7 @@ namespace TFE_Jedi
 						char podName[32];
 						if (sscanf(line, " POD: %s", podName) == 1)
 						{
-							s_levelIntState.pods[p] = TFE_Model_Jedi::get(podName);
-							if (!s_levelIntState.pods[p])
-							{
-								s_levelIntState.pods[p] = TFE_Model_Jedi::get("default.3do");
-							}
+							s_podNames[p] = podName;
 						}
 						else
 						{
@@ -790,9 +928,10 @@ namespace TFE_Jedi
 			else if (sscanf(line, "SPRS %d", &s_levelIntState.spriteCount) == 1)
 			{
 				s_levelIntState.sprites = (JediWax**)level_alloc(sizeof(JediWax*)*s_levelIntState.spriteCount);
+				s_spriteNames.assign(s_levelIntState.spriteCount, std::string());
 				for (s32 s = 0; s < s_levelIntState.spriteCount; s++)
 				{
-					line = parser.readLine(bufferPos);
+					line = tableParser.readLine(tablePos);
 					s_levelIntState.sprites[s] = nullptr;
 
 					if (line)
@@ -800,11 +939,7 @@ namespace TFE_Jedi
 						char name[32];
 						if (sscanf(line, " SPR: %s ", name) == 1)
 						{
-							s_levelIntState.sprites[s] = TFE_Sprite_Jedi::getWax(name);
-							if (!s_levelIntState.sprites[s])
-							{
-								s_levelIntState.sprites[s] = TFE_Sprite_Jedi::getWax("default.wax");
-							}
+							s_spriteNames[s] = name;
 						}
 						else
 						{
@@ -816,9 +951,10 @@ namespace TFE_Jedi
 			else if (sscanf(line, "FMES %d", &s_levelIntState.fmeCount) == 1)
 			{
 				s_levelIntState.frames = (JediFrame**)level_alloc(sizeof(JediFrame*)*s_levelIntState.fmeCount);
+				s_frameNames.assign(s_levelIntState.fmeCount, std::string());
 				for (s32 f = 0; f < s_levelIntState.fmeCount; f++)
 				{
-					line = parser.readLine(bufferPos);
+					line = tableParser.readLine(tablePos);
 					s_levelIntState.frames[f] = nullptr;
 
 					if (line)
@@ -826,11 +962,7 @@ namespace TFE_Jedi
 						char name[32];
 						if (sscanf(line, " FME: %s ", name) == 1)
 						{
-							s_levelIntState.frames[f] = TFE_Sprite_Jedi::getFrame(name);
-							if (!s_levelIntState.frames[f])
-							{
-								s_levelIntState.frames[f] = TFE_Sprite_Jedi::getFrame("default.fme");
-							}
+							s_frameNames[f] = name;
 						}
 						else
 						{
@@ -842,9 +974,10 @@ namespace TFE_Jedi
 			else if (sscanf(line, "SOUNDS %d", &s_levelIntState.soundCount) == 1)
 			{
 				s_levelIntState.soundIds = (SoundSourceId*)level_alloc(sizeof(SoundSourceId)*s_levelIntState.soundCount);
+				s_soundNames.assign(s_levelIntState.soundCount, std::string());
 				for (s32 s = 0; s < s_levelIntState.soundCount; s++)
 				{
-					line = parser.readLine(bufferPos);
+					line = tableParser.readLine(tablePos);
 					s_levelIntState.soundIds[s] = NULL_SOUND;
 
 					if (line)
@@ -852,7 +985,7 @@ namespace TFE_Jedi
 						char name[32];
 						if (sscanf(line, " SOUND: %s ", name) == 1)
 						{
-							s_levelIntState.soundIds[s] = sound_load(name, SOUND_PRIORITY_LOW2);
+							s_soundNames[s] = name;
 						}
 						else
 						{
@@ -861,6 +994,21 @@ namespace TFE_Jedi
 					}
 				}
 			}
+		}
+		level_loadObjectAssets();
+
+		while (nullptr != (line = parser.readLine(bufferPos)))
+		{
+			s32 tableCount;
+			if (sscanf(line, "PODS %d", &tableCount) == 1 || sscanf(line, "SPRS %d", &tableCount) == 1 ||
+				sscanf(line, "FMES %d", &tableCount) == 1 || sscanf(line, "SOUNDS %d", &tableCount) == 1)
+			{
+				// Already read, skip the table entries.
+				for (s32 i = 0; i < tableCount && line; i++)
+				{
+					line = parser.readLine(bufferPos);
+				}
+			}
 			else if (sscanf(line, "OBJECTS %d", &s_levelIntState.objectCount) == 1)
 			{
 				s32 count = s_levelIntState.objectCount;
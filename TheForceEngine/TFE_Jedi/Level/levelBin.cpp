@@ -7,6 +7,8 @@
 #include "rtexture.h"
 #include <TFE_Game/igame.h>
 #include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/mappedFile.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_System/system.h>
 
@@ -49,10 +51,14 @@ namespace TFE_Jedi
 		LvbVertexInfoSig  = CHUNK_SIG('V', 'R', 'T'),
 		LvbWallListSig    = CHUNK_SIG('W', 'L', 'S'),
 		LvbWallCountSig   = CHUNK_SIG('W', 'N', 'O'),
+		LvbWallSig        = CHUNK_SIG('W', 'A', 'L'),
+		LvbTexNameSig     = CHUNK_SIG('T', 'N', 'A'),
+		LvbSourceSig      = CHUNK_SIG('S', 'R', 'C'),	// TFE: Hash of the LEV file a cached LVB was compiled from.
 		// Other Constants.
-		LvbVersionMax = 20,
+		LvbVersionMax = 21,
 		LvbVersionMin = 19,
 		LvbVersion_Layers_WallLight = 20,
+		LvbVersion_Cache = 21,		// TFE: LVB compiled from a text LEV, stores sector ids and full 32-bit flags.
 		LvbChunkSizeMask   = 0xf0,
 		LvbChunkSize16bits = 0xf2,
 		LvbChunkSize32bits = 0xf4,
@@ -80,6 +86,11 @@ namespace TFE_Jedi
 		WallFlags2   = 53,
 		WallFlags3   = 55,
 		WallLight    = 57,
+		// TFE: LvbVersion_Cache
+		WallFlags1Full = 59,
+		WallFlags2Full = 63,
+		WallFlags3Full = 67,
+		WallPartSize   = 71,
 	};
 	// Offsets to the sector part data.
 	enum SectorPartOffset
@@ -100,6 +111,12 @@ namespace TFE_Jedi
 		SectorFlags2       = 38,
 		SectorFlags3       = 40,
 		SectorLayer        = 42,
+		// TFE: LvbVersion_Cache
+		SectorId           = 44,
+		SectorFlags1Full   = 48,
+		SectorFlags2Full   = 52,
+		SectorFlags3Full   = 56,
+		SectorPartSize     = 60,
 	};
 
 	// Helper macros to make the code a little more clear.
@@ -112,6 +129,8 @@ namespace TFE_Jedi
 	#define BufferReadFixed16(offset) *((fixed16_16*)&buffer[offset])
 	#define BufferReadS16(offset) *((s16*)&buffer[offset])
 	#define BufferReadU16(offset) *((u16*)&buffer[offset])
+	#define BufferReadS32(offset) *((s32*)&buffer[offset])
+	#define BufferReadU32(offset) *((u32*)&buffer[offset])
 
 	static s32 s_lvbVersion = 0;
 
@@ -200,6 +219,21 @@ namespace TFE_Jedi
 		s_levelState.textures = (TextureData**)level_alloc(2 * s_levelState.textureCount * sizeof(TextureData**));
 		memset(s_levelState.textures, 0, 2 * s_levelState.textureCount * sizeof(TextureData**));
 
+		// TFE: Decode the level textures on the worker threads before loading them in order.
+		std::vector<const char*> textureNames;
+		textureNames.push_back("default.bm");
+		for (u32 texOffset = offset; texOffset < dataEnd;)
+		{
+			ChunkHeader texHeader;
+			loadChunkHeader(data, texOffset, &texHeader);
+			if (strcasecmp((const char*)&data[texOffset], "<NoTexture>") != 0)
+			{
+				textureNames.push_back((const char*)&data[texOffset]);
+			}
+			texOffset += texHeader.size;
+		}
+		bitmap_preload(textureNames.data(), (s32)textureNames.size(), 1);
+
 		// Load Textures.
 		TextureData** texture = s_levelState.textures;
 		TextureData** texBase = s_levelState.textures + s_levelState.textureCount;
@@ -233,12 +267,13 @@ namespace TFE_Jedi
 				*texBase = tex;
 
 				// Setup an animated texture.
-				if (tex->uvWidth == BM_ANIMATED_TEXTURE)
+				if (tex->uvWidth == BM_ANIMATED_TEXTURE && !tex->animSetup)
 				{
 					bitmap_setupAnimatedTexture(texture, i);
 				}
 			}
 		}
+		bitmap_clearPreloaded();
 		return 0;
 	}
 		
@@ -324,6 +359,12 @@ namespace TFE_Jedi
 			{
 				wall->wallLight = intToFixed16(BufferReadS16(WallLight));
 			}
+			if (s_lvbVersion >= LvbVersion_Cache)
+			{
+				wall->flags1 = BufferReadU32(WallFlags1Full);
+				wall->flags2 = BufferReadU32(WallFlags2Full);
+				wall->flags3 = BufferReadU32(WallFlags3Full);
+			}
 		}
 
 		return 0;
@@ -417,6 +458,13 @@ namespace TFE_Jedi
 			{
 				sector->layer = BufferReadS16(SectorLayer);
 			}
+			if (s_lvbVersion >= LvbVersion_Cache)
+			{
+				sector->id = BufferReadS32(SectorId);
+				sector->flags1 = BufferReadU32(SectorFlags1Full);
+				sector->flags2 = BufferReadU32(SectorFlags2Full);
+				sector->flags3 = BufferReadU32(SectorFlags3Full);
+			}
 
 			// Create a door if needed.
 			if (sector->flags1 & SEC_FLAGS1_DOOR)
@@ -476,31 +524,9 @@ namespace TFE_Jedi
 	/////////////////////////////////////////////////
 	// Public API
 	/////////////////////////////////////////////////
-	bool level_loadGeometryBin(const char* levelName, std::vector<char>& buffer)
+	static bool level_parseGeometryBin(const char* levelName, const u8* data, u32 len)
 	{
-		char levelPath[TFE_MAX_PATH];
-		strcpy(levelPath, levelName);
-		strcat(levelPath, ".LVB");
-
-		// Do not warn if an LVB cannot be loaded,
-		// the final game doesn't use LVB files.
-		FilePath filePath;
-		if (!TFE_Paths::getFilePath(levelPath, &filePath))
-		{
-			return false;
-		}
-		FileStream file;
-		if (!file.open(&filePath, Stream::MODE_READ))
-		{
-			return false;
-		}
-		u32 len = (u32)file.getSize();
-		buffer.resize(len);
-		file.readBuffer(buffer.data(), len);
-		file.close();
-
 		u32 offset = 0u;
-		const u8* data = (u8*)buffer.data();
 
 		// File Header.
 		ChunkHeader header;
@@ -548,13 +574,17 @@ namespace TFE_Jedi
 					s_levelState.levelPaletteName[header.size] = 0;
 
 					// HACK!
-					if (strcasecmp(s_levelState.levelPaletteName, "agamar.pal") == 0)
+					// TFE: Cached levels keep the palette from the LEV file.
+					if (s_lvbVersion < LvbVersion_Cache)
 					{
-						strcpy(s_levelState.levelPaletteName, "TALAY.PAL");
-					}
-					else
-					{
-						strcpy(s_levelState.levelPaletteName, "SECBASE.PAL");
+						if (strcasecmp(s_levelState.levelPaletteName, "agamar.pal") == 0)
+						{
+							strcpy(s_levelState.levelPaletteName, "TALAY.PAL");
+						}
+						else
+						{
+							strcpy(s_levelState.levelPaletteName, "SECBASE.PAL");
+						}
 					}
 
 					level_loadPalette();
@@ -583,4 +613,304 @@ namespace TFE_Jedi
 
 		return true;
 	}
+
+	/////////////////////////////////////////////////
+	// Level Cache
+	/////////////////////////////////////////////////
+	struct LevelSourceKey
+	{
+		u64 hash;
+		u32 size;
+	};
+
+	// Set when the cache cannot be written, so later loads do not keep retrying and warning.
+	static bool s_cacheWriteFailed = false;
+
+	static u64 level_hashBytes(u64 hash, const char* data, size_t len)
+	{
+		// FNV-1a
+		for (size_t i = 0; i < len; i++)
+		{
+			hash = (hash ^ u8(data[i])) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	static LevelSourceKey level_getSourceKey(const char* source, size_t sourceLen)
+	{
+		// The engine version is part of the key, so fixes to the LEV parser are not hidden by stale caches.
+		const char* version = TFE_System::getVersionString();
+		u64 hash = 14695981039346656037ull;
+		hash = level_hashBytes(hash, version, strlen(version));
+		hash = level_hashBytes(hash, source, sourceLen);
+		return { hash, u32(sourceLen) };
+	}
+
+	static void level_getCachePath(const LevelSourceKey& key, char* cachePath, bool createDir)
+	{
+		char cacheDir[TFE_MAX_PATH];
+		sprintf(cacheDir, "%sLevelCache/", TFE_Paths::getPath(PATH_PROGRAM_DATA));
+		if (createDir && !FileUtil::directoryExits(cacheDir))
+		{
+			FileUtil::makeDirectory(cacheDir);
+		}
+		sprintf(cachePath, "%s%016llx.LVB", cacheDir, (unsigned long long)key.hash);
+	}
+
+	static void chunkWrite(std::vector<u8>& out, u32 sig, const void* data, u32 size)
+	{
+		out.push_back(u8(sig));
+		out.push_back(u8(sig >> 8));
+		out.push_back(u8(sig >> 16));
+		if (size < LvbChunkSizeMask)
+		{
+			out.push_back(u8(size));
+		}
+		else
+		{
+			out.push_back(LvbChunkSize32bits);
+			out.insert(out.end(), (const u8*)&size, (const u8*)&size + 4);
+		}
+		out.insert(out.end(), (const u8*)data, (const u8*)data + size);
+	}
+
+	static void chunkWriteNumber(std::vector<u8>& out, u32 sig, s32 value)
+	{
+		chunkWrite(out, sig, &value, sizeof(s32));
+	}
+
+	static void chunkWriteString(std::vector<u8>& out, u32 sig, const char* str)
+	{
+		// Names are read in place, so include the terminator.
+		chunkWrite(out, sig, str, u32(strlen(str) + 1));
+	}
+
+	// Begin a chunk that contains other chunks, the size is filled in by chunkEnd().
+	static size_t chunkBegin(std::vector<u8>& out, u32 sig)
+	{
+		const u32 size = 0;
+		chunkWrite(out, sig, nullptr, 0);
+		out.back() = LvbChunkSize32bits;
+		out.insert(out.end(), (const u8*)&size, (const u8*)&size + 4);
+		return out.size();
+	}
+
+	static void chunkEnd(std::vector<u8>& out, size_t start)
+	{
+		const u32 size = u32(out.size() - start);
+		memcpy(&out[start - 4], &size, 4);
+	}
+
+	#define BufferWrite(offset, type, value) { type _v = type(value); memcpy(&buffer[offset], &_v, sizeof(type)); }
+
+	static s32 level_getTextureIndex(TextureData** tex)
+	{
+		return tex ? s32(tex - s_levelState.textures) : -1;
+	}
+
+	static void level_writeSectorsBin(std::vector<u8>& out, const std::vector<std::string>& sectorNames)
+	{
+		u8 buffer[s32(WallPartSize) > s32(SectorPartSize) ? s32(WallPartSize) : s32(SectorPartSize)];
+
+		const size_t sectorList = chunkBegin(out, LvbSectorListSig);
+		chunkWriteNumber(out, LvbSectorCountSig, s_levelState.sectorCount);
+		for (u32 i = 0; i < s_levelState.sectorCount; i++)
+		{
+			const RSector* sector = &s_levelState.sectors[i];
+			const size_t sectorChunk = chunkBegin(out, LvbSectorSig);
+			if (!sectorNames[i].empty())
+			{
+				chunkWriteString(out, LvbSectorNameSig, sectorNames[i].c_str());
+			}
+
+			memset(buffer, 0, sizeof(buffer));
+			BufferWrite(SectorFloorTex, s16, level_getTextureIndex(sector->floorTex));
+			BufferWrite(SectorFloorX, fixed16_16, sector->floorOffset.x);
+			BufferWrite(SectorFloorZ, fixed16_16, sector->floorOffset.z);
+			BufferWrite(SectorCeilTex, s16, level_getTextureIndex(sector->ceilTex));
+			BufferWrite(SectorCeilX, fixed16_16, sector->ceilOffset.x);
+			BufferWrite(SectorCeilZ, fixed16_16, sector->ceilOffset.z);
+			BufferWrite(SectorFloorHeight, fixed16_16, sector->floorHeight);
+			BufferWrite(SectorCeilHeight, fixed16_16, sector->ceilingHeight);
+			BufferWrite(SectorSecondHeight, fixed16_16, sector->secHeight);
+			BufferWrite(SectorAmbient, s16, floor16(sector->ambient));
+			BufferWrite(SectorFlags1, u16, sector->flags1);
+			BufferWrite(SectorFlags2, u16, sector->flags2);
+			BufferWrite(SectorFlags3, u16, sector->flags3);
+			BufferWrite(SectorLayer, s16, sector->layer);
+			BufferWrite(SectorId, s32, sector->id);
+			BufferWrite(SectorFlags1Full, u32, sector->flags1);
+			BufferWrite(SectorFlags2Full, u32, sector->flags2);
+			BufferWrite(SectorFlags3Full, u32, sector->flags3);
+			chunkWrite(out, LvbSectorInfoSig, buffer, SectorPartSize);
+
+			chunkWriteNumber(out, LvbVertexCountSig, sector->vertexCount);
+			for (s32 v = 0; v < sector->vertexCount; v++)
+			{
+				chunkWrite(out, LvbVertexInfoSig, &sector->verticesWS[v], sizeof(fixed16_16) * 2);
+			}
+
+			const size_t wallList = chunkBegin(out, LvbWallListSig);
+			chunkWriteNumber(out, LvbWallCountSig, sector->wallCount);
+			const RWall* wall = sector->walls;
+			for (s32 w = 0; w < sector->wallCount; w++, wall++)
+			{
+				memset(buffer, 0, sizeof(buffer));
+				BufferWrite(WallMidTex, s16, level_getTextureIndex(wall->midTex));
+				BufferWrite(WallTopTex, s16, level_getTextureIndex(wall->topTex));
+				BufferWrite(WallBotTex, s16, level_getTextureIndex(wall->botTex));
+				BufferWrite(WallSignTex, s16, level_getTextureIndex(wall->signTex));
+				// Offsets are only read when the matching texture is set.
+				if (wall->midTex)
+				{
+					BufferWrite(WallMidX, fixed16_16, wall->midOffset.x);
+					BufferWrite(WallMidZ, fixed16_16, wall->midOffset.z);
+				}
+				if (wall->topTex)
+				{
+					BufferWrite(WallTopX, fixed16_16, wall->topOffset.x);
+					BufferWrite(WallTopZ, fixed16_16, wall->topOffset.z);
+				}
+				if (wall->botTex)
+				{
+					BufferWrite(WallBotX, fixed16_16, wall->botOffset.x);
+					BufferWrite(WallBotZ, fixed16_16, wall->botOffset.z);
+				}
+				if (wall->signTex)
+				{
+					BufferWrite(WallSignX, fixed16_16, wall->signOffset.x);
+					BufferWrite(WallSignZ, fixed16_16, wall->signOffset.z);
+				}
+				BufferWrite(WallLeftId, s16, wall->w0 - sector->verticesWS);
+				BufferWrite(WallRightId, s16, wall->w1 - sector->verticesWS);
+				BufferWrite(WallAdjoinId, s16, wall->nextSector ? s32(wall->nextSector - s_levelState.sectors) : -1);
+				BufferWrite(WallMirrorId, s16, wall->mirror);
+				BufferWrite(WallFlags1, u16, wall->flags1);
+				BufferWrite(WallFlags2, u16, wall->flags2);
+				BufferWrite(WallFlags3, u16, wall->flags3);
+				BufferWrite(WallLight, s16, floor16(wall->wallLight));
+				BufferWrite(WallFlags1Full, u32, wall->flags1);
+				BufferWrite(WallFlags2Full, u32, wall->flags2);
+				BufferWrite(WallFlags3Full, u32, wall->flags3);
+				chunkWrite(out, LvbWallSig, buffer, WallPartSize);
+			}
+			chunkEnd(out, wallList);
+			chunkEnd(out, sectorChunk);
+		}
+		chunkEnd(out, sectorList);
+	}
+
+	/////////////////////////////////////////////////
+	// Public API
+	/////////////////////////////////////////////////
+	bool level_loadGeometryBin(const char* levelName, std::vector<char>& buffer)
+	{
+		char levelPath[TFE_MAX_PATH];
+		strcpy(levelPath, levelName);
+		strcat(levelPath, ".LVB");
+
+		// Do not warn if an LVB cannot be loaded,
+		// the final game doesn't use LVB files.
+		FilePath filePath;
+		if (!TFE_Paths::getFilePath(levelPath, &filePath))
+		{
+			return false;
+		}
+		FileStream file;
+		if (!file.open(&filePath, Stream::MODE_READ))
+		{
+			return false;
+		}
+		u32 len = (u32)file.getSize();
+		buffer.resize(len);
+		file.readBuffer(buffer.data(), len);
+		file.close();
+
+		return level_parseGeometryBin(levelName, (u8*)buffer.data(), len);
+	}
+
+	bool level_loadGeometryCache(const char* levelName, const char* source, size_t sourceLen)
+	{
+		const LevelSourceKey key = level_getSourceKey(source, sourceLen);
+		char cachePath[TFE_MAX_PATH];
+		level_getCachePath(key, cachePath, false);
+
+		MappedFile cache;
+		if (!cache.open(cachePath))
+		{
+			return false;
+		}
+
+		// Validate the header before any level state is touched, so a stale or partially written cache
+		// falls back to the LEV file.
+		const u8* data = cache.getData();
+		const u32 len = u32(cache.getSize());
+		u32 offset = 0u;
+		ChunkHeader header;
+		if (len < 32 || loadChunkHeader(data, offset, &header) < 0 || header.sig != LvbRootSig || offset + header.size != len)
+		{
+			return false;
+		}
+		loadChunkHeader(data, offset, &header);
+		if (header.sig != LvbVersionSig || loadChunkNumber(&header, data, offset) != LvbVersion_Cache)
+		{
+			return false;
+		}
+		loadChunkHeader(data, offset, &header);
+		LevelSourceKey cachedKey;
+		if (header.sig != LvbSourceSig || header.size != sizeof(u64) + sizeof(u32))
+		{
+			return false;
+		}
+		memcpy(&cachedKey.hash, &data[offset], sizeof(u64));
+		memcpy(&cachedKey.size, &data[offset + sizeof(u64)], sizeof(u32));
+		if (cachedKey.hash != key.hash || cachedKey.size != key.size)
+		{
+			return false;
+		}
+
+		return level_parseGeometryBin(levelName, data, len);
+	}
+
+	void level_writeGeometryCache(const char* source, size_t sourceLen, const std::vector<std::string>& textureNames, const std::vector<std::string>& sectorNames)
+	{
+		if (s_cacheWriteFailed) { return; }
+		const LevelSourceKey key = level_getSourceKey(source, sourceLen);
+		std::vector<u8> out;
+		out.reserve(sourceLen);
+
+		const size_t root = chunkBegin(out, LvbRootSig);
+		chunkWriteNumber(out, LvbVersionSig, LvbVersion_Cache);
+		u8 keyData[sizeof(u64) + sizeof(u32)];
+		memcpy(keyData, &key.hash, sizeof(u64));
+		memcpy(keyData + sizeof(u64), &key.size, sizeof(u32));
+		chunkWrite(out, LvbSourceSig, keyData, sizeof(keyData));
+
+		chunkWriteString(out, LvbPalFileSig, s_levelState.levelPaletteName);
+		fixed16_16 parallax[] = { s_levelState.parallax0, s_levelState.parallax1 };
+		chunkWrite(out, LvbLevelInfoSig, parallax, sizeof(parallax));
+
+		const size_t texList = chunkBegin(out, LvbTexListSig);
+		chunkWriteNumber(out, LvbTexCountSig, s_levelState.textureCount);
+		for (size_t i = 0; i < textureNames.size(); i++)
+		{
+			chunkWriteString(out, LvbTexNameSig, textureNames[i].c_str());
+		}
+		chunkEnd(out, texList);
+
+		level_writeSectorsBin(out, sectorNames);
+		chunkEnd(out, root);
+
+		char cachePath[TFE_MAX_PATH];
+		level_getCachePath(key, cachePath, true);
+		FileStream file;
+		if (!file.open(cachePath, Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_WARNING, "level_writeGeometryCache", "Cannot write level cache '%s', the cache is disabled until restart.", cachePath);
+			s_cacheWriteFailed = true;
+			return;
+		}
+		file.writeBuffer(out.data(), u32(out.size()));
+		file.close();
+	}
 }
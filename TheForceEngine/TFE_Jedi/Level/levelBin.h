@@ -3,11 +3,21 @@
 // LevelBin
 // Handles loading of LVB versions of levels, to handle the
 // Dark Forces demo or other sources of LVB files.
+// Also caches the geometry of text LEV files as LVB files. The cache
+// covers LEV geometry only: the INF and O loaders create elevators,
+// triggers and logics while they parse, so they are not cached.
 //////////////////////////////////////////////////////////////////////
 #include <TFE_System/types.h>
+#include <string>
 #include <vector>
 
 namespace TFE_Jedi
 {
 	bool level_loadGeometryBin(const char* levelName, std::vector<char>& buffer);
+
+	// TFE: Text LEV files are compiled into LVB files in the program data directory the first time they are loaded.
+	// The cache is keyed by a hash of the LEV contents and the engine version, so edited levels and parser changes
+	// simply compile again.
+	bool level_loadGeometryCache(const char* levelName, const char* source, size_t sourceLen);
+	void level_writeGeometryCache(const char* source, size_t sourceLen, const std::vector<std::string>& textureNames, const std::vector<std::string>& sectorNames);
 }
@@ -6,6 +6,7 @@
 #include "robject.h"
 #include "level.h"
 #include "levelData.h"
+#include "sectorIndex.h"
 #include <TFE_Game/igame.h>
 #include <TFE_System/system.h>
 #include <TFE_DarkForces/player.h>
@@ -212,6 +213,9 @@ namespace TFE_Jedi
 		sector->boundsMax.x = maxX;
 		sector->boundsMin.z = minZ;
 		sector->boundsMax.z = maxZ;
+
+		// TFE: Keep the point-location index in sync with moving and rotating walls.
+		sectorIndex_update(sector);
 	}
 
 	fixed16_16 sector_getMaxObjectHeight(RSector* sector)
@@ -419,6 +423,11 @@ namespace TFE_Jedi
 				obj->index = i;
 				obj->sector = sector;
 				sector->objectCount++;
+				sectorIndex_addObject(obj);
+				if (sector->objectCount == 1)
+				{
+					sectorIndex_updateObjects(sector);
+				}
 				break;
 			}
 		}
@@ -485,6 +494,10 @@ namespace TFE_Jedi
 		SecObject** objList = sector->objectList;
 		objList[obj->index] = nullptr;
 		sector->objectCount--;
+		if (sector->objectCount == 0)
+		{
+			sectorIndex_updateObjects(sector);
+		}
 
 		if (!((obj->entityFlags & ETFLAG_PLAYER) && s_playerDying))
 		{
@@ -513,13 +526,18 @@ namespace TFE_Jedi
 		fixed16_16 iz = dz;
 		fixed16_16 y = dy;
 		
-		RSector* sector = s_levelState.sectors;
 		RSector* foundSector = nullptr;
 		s32 sectorUnitArea = 0;
 		s32 prevSectorUnitArea = INT_MAX;
 
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// TFE: Only visit the sectors whose bounds may contain the point, in sector list order.
+		const s32* candidates = nullptr;
+		s32 candidateCount = s32(s_levelState.sectorCount);
+		sectorIndex_getCandidates(ix, iz, &candidates, &candidateCount);
+
+		for (s32 i = 0; i < candidateCount; i++)
 		{
+			RSector* sector = &s_levelState.sectors[candidates ? candidates[i] : i];
 			if (y >= sector->ceilingHeight && y <= sector->floorHeight)
 			{
 				const fixed16_16 sectorMaxX = sector->boundsMax.x;
@@ -552,13 +570,18 @@ namespace TFE_Jedi
 		fixed16_16 ix = dx;
 		fixed16_16 iz = dz;
 
-		RSector* sector = s_levelState.sectors;
 		RSector* foundSector = nullptr;
 		s32 sectorUnitArea = 0;
 		s32 prevSectorUnitArea = INT_MAX;
 
-		for (u32 i = 0; i < s_levelState.sectorCount; i++, sector++)
+		// TFE: Only visit the sectors whose bounds may contain the point, in sector list order.
+		const s32* candidates = nullptr;
+		s32 candidateCount = s32(s_levelState.sectorCount);
+		sectorIndex_getCandidates(ix, iz, &candidates, &candidateCount);
+
+		for (s32 i = 0; i < candidateCount; i++)
 		{
+			RSector* sector = &s_levelState.sectors[candidates ? candidates[i] : i];
 			if (sector->layer == layer)
 			{
 				const fixed16_16 sectorMaxX = sector->boundsMax.x;
@@ -11,6 +11,8 @@
 #include <TFE_Jedi/Task/task.h>
 #include <TFE_Jedi/Serialization/serialization.h>
 #include <TFE_System/math.h>
+#include <TFE_System/parallel.h>
+#include <TFE_System/profiler.h>
 #include <TFE_Settings/settings.h>
 #include <unordered_map>
 
@@ -49,6 +51,33 @@ namespace TFE_Jedi
 
 	static std::vector<std::string> s_coreAchiveNames;
 
+	// TFE: Bitmaps read and decoded ahead of time by bitmap_preload().
+	enum BitmapDecodeResult
+	{
+		BM_DECODE_OK = 0,
+		BM_DECODE_INVALID,
+		BM_DECODE_BAD_VERSION,
+	};
+
+	struct StagedBitmap
+	{
+		FilePath filePath = {};
+		const u8* fileView = nullptr;	// File data in a memory mapped archive.
+		std::vector<u8> fileData;		// File data read up front when it cannot be mapped.
+		size_t fileSize = 0;
+		u32 decompress = 0;
+
+		bool decoded = false;
+		BitmapDecodeResult result = BM_DECODE_OK;
+		u8 version = 0;
+		TextureData header = {};		// Image and column pointers are not set until the bitmap is committed.
+		std::vector<u8> image;
+		std::vector<u32> columns;
+	};
+	typedef std::unordered_map<std::string, s32> StagedTable;
+	static std::vector<StagedBitmap> s_stagedBitmaps;
+	static StagedTable s_stagedTable;
+
 	void decompressColumn_Type1(const u8* src, u8* dst, s32 pixelCount);
 	void decompressColumn_Type2(const u8* src, u8* dst, s32 pixelCount);
 	void textureAnimationTaskFunc(MessageType msg);
@@ -108,6 +137,7 @@ namespace TFE_Jedi
 	{
 		s_textureList[POOL_LEVEL].clear();
 		s_textureTable[POOL_LEVEL].clear();
+		bitmap_clearPreloaded();
 	}
 
 	void bitmap_clearAll()
@@ -118,6 +148,7 @@ namespace TFE_Jedi
 			s_textureList[p].clear();
 			s_textureTable[p].clear();
 		}
+		bitmap_clearPreloaded();
 	}
 
 	bool bitmap_getTextureIndex(TextureData* tex, s32* index, AssetPool* pool)
@@ -307,52 +338,28 @@ namespace TFE_Jedi
 		return true;
 	}
 
-	TextureData* bitmap_load(const char* name, u32 decompress, AssetPool pool, bool addToCache)
+	// Read the BM header and image data into 'staged', this only touches the staged bitmap so it can run on any thread.
+	static BitmapDecodeResult bitmap_decode(const u8* data, size_t size, u32 decompress, StagedBitmap* staged)
 	{
-		// TFE: Keep track of per-level texture state for serialization.
-		// This is also useful for handling per-level GPU texture mirrors.
-		TextureTable::iterator iTex = s_textureTable[pool].find(name);
-		if (iTex != s_textureTable[pool].end())
-		{
-			return s_textureList[pool][iTex->second].texture;
-		}
-
-		FilePath filepath;
-		if (!TFE_Paths::getFilePath(name, &filepath))
-		{
-			return nullptr;
-		}
-
-		FileStream file;
-		if (!file.open(&filepath, Stream::MODE_READ))
-		{
-			return nullptr;
-		}
-
-		size_t size = file.getSize();
-		s_buffer.resize(size);
-		file.readBuffer(s_buffer.data(), (u32)size);
-		file.close();
-
-		TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData));
+		TextureData* texture = &staged->header;
 		memset(texture, 0, sizeof(TextureData));
+		staged->image.clear();
+		staged->columns.clear();
 
-		const u8* data = s_buffer.data();
 		const u8* end = data + size;
 		const u8* fheader = data;
 		data += 3;
 
-		if (strncmp((char*)fheader, "BM ", 3))
+		if (size < 4 || strncmp((char*)fheader, "BM ", 3))
 		{
-			TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' is not a valid BM file.", filepath);
-			return nullptr;
+			return BM_DECODE_INVALID;
 		}
 
 		u8 version = readByte(data);
 		if (version != DF_BM_VERSION)
 		{
-			TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' has invalid BM version '%u'.", filepath, version);
-			return nullptr;
+			staged->version = version;
+			return BM_DECODE_BAD_VERSION;
 		}
 
 		texture->width = readUShort(data);
@@ -380,7 +387,7 @@ namespace TFE_Jedi
 			if (decompress & 1)
 			{
 				texture->dataSize = texture->width * texture->height;
-				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+				staged->image.resize(texture->dataSize);
 
 				const u8* inBuffer = data;
 				data += inSize;
@@ -391,7 +398,7 @@ namespace TFE_Jedi
 
 				if (texture->compressed == 1)
 				{
-					u8* dst = texture->image;
+					u8* dst = staged->image.data();
 					for (s32 i = 0; i < texture->width; i++, dst += texture->height)
 					{
 						const u8* src = &inBuffer[columns[i]];
@@ -400,7 +407,7 @@ namespace TFE_Jedi
 				}
 				else if (texture->compressed == 2)
 				{
-					u8* dst = texture->image;
+					u8* dst = staged->image.data();
 					for (s32 i = 0; i < texture->width; i++, dst += texture->height)
 					{
 						const u8* src = &inBuffer[columns[i]];
@@ -408,18 +415,15 @@ namespace TFE_Jedi
 					}
 				}
 				texture->compressed = 0;
-				texture->columns = nullptr;
 			}
 			else
 			{
 				texture->dataSize = inSize;
-				texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
-				memcpy(texture->image, data, texture->dataSize);
+				staged->image.assign(data, data + texture->dataSize);
 				data += texture->dataSize;
 				assert(data <= end);
 
-				texture->columns = (u32*)region_alloc(s_texState.memoryRegion, texture->width * sizeof(u32));
-				memcpy(texture->columns, data, texture->width * sizeof(u32));
+				staged->columns.assign((const u32*)data, (const u32*)data + texture->width);
 				data += texture->width * sizeof(u32);
 				assert(data <= end);
 			}
@@ -429,19 +433,44 @@ namespace TFE_Jedi
 			texture->dataSize = texture->width * texture->height;
 			// Datasize, ignored.
 			data += 4;
-			texture->columns = nullptr;
 			assert(data <= end);
 
 			// Padding, ignored.
 			data += 12;
 			assert(data <= end);
 
-			// Allocate and read the BM image.
-			texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
-			memcpy(texture->image, data, texture->dataSize);
+			// Read the BM image.
+			staged->image.assign(data, data + texture->dataSize);
 			data += texture->dataSize;
 			assert(data <= end);
 		}
+		return BM_DECODE_OK;
+	}
+
+	// Copy a decoded bitmap into the texture memory region and register it, main thread only.
+	static TextureData* bitmap_commit(const char* name, const FilePath* filepath, const StagedBitmap* staged, AssetPool pool, bool addToCache)
+	{
+		if (staged->result == BM_DECODE_INVALID)
+		{
+			TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' is not a valid BM file.", name);
+			return nullptr;
+		}
+		else if (staged->result == BM_DECODE_BAD_VERSION)
+		{
+			TFE_System::logWrite(LOG_ERROR, "bitmap_load", "File '%s' has invalid BM version '%u'.", name, staged->version);
+			return nullptr;
+		}
+
+		TextureData* texture = (TextureData*)region_alloc(s_texState.memoryRegion, sizeof(TextureData));
+		*texture = staged->header;
+
+		texture->image = (u8*)region_alloc(s_texState.memoryRegion, texture->dataSize);
+		memcpy(texture->image, staged->image.data(), texture->dataSize);
+		if (!staged->columns.empty())
+		{
+			texture->columns = (u32*)region_alloc(s_texState.memoryRegion, texture->width * sizeof(u32));
+			memcpy(texture->columns, staged->columns.data(), texture->width * sizeof(u32));
+		}
 
 		// Add the texture to the level texture cache if appropriate.
 		if (addToCache)
@@ -453,9 +482,9 @@ namespace TFE_Jedi
 
 		// Determine if a texture is "custom" or not, custom textures do not use HD Assets.
 		bool isCustomAsset = false;
-		if (filepath.archive)
+		if (filepath->archive)
 		{
-			const char* path = filepath.archive->getPath();
+			const char* path = filepath->archive->getPath();
 			// Memory archive, from a zip file.
 			if (!path || path[0] == 0)
 			{
@@ -464,7 +493,7 @@ namespace TFE_Jedi
 			// Regular archive path.
 			else
 			{
-				isCustomAsset = isAssetCustom(filepath.archive->getName());
+				isCustomAsset = isAssetCustom(filepath->archive->getName());
 			}
 		}
 		if (!isCustomAsset)
@@ -480,6 +509,101 @@ namespace TFE_Jedi
 		return texture;
 	}
 
+	TextureData* bitmap_load(const char* name, u32 decompress, AssetPool pool, bool addToCache)
+	{
+		// TFE: Keep track of per-level texture state for serialization.
+		// This is also useful for handling per-level GPU texture mirrors.
+		TextureTable::iterator iTex = s_textureTable[pool].find(name);
+		if (iTex != s_textureTable[pool].end())
+		{
+			return s_textureList[pool][iTex->second].texture;
+		}
+
+		// TFE: Use the result of bitmap_preload() if available, textures are still committed in load order.
+		StagedTable::iterator iStaged = s_stagedTable.find(name);
+		if (iStaged != s_stagedTable.end())
+		{
+			StagedBitmap* staged = &s_stagedBitmaps[iStaged->second];
+			if (staged->decoded && staged->decompress == decompress)
+			{
+				s_stagedTable.erase(iStaged);
+				TextureData* texture = bitmap_commit(name, &staged->filePath, staged, pool, addToCache);
+				// Release the staging memory early, the whole level may not fit twice.
+				std::vector<u8>().swap(staged->image);
+				std::vector<u32>().swap(staged->columns);
+				return texture;
+			}
+		}
+
+		FilePath filepath;
+		if (!TFE_Paths::getFilePath(name, &filepath))
+		{
+			return nullptr;
+		}
+
+		// Parse in place when the file is in a memory mapped archive.
+		size_t size = 0;
+		const u8* data = FileStream::readView(&filepath, s_buffer, &size);
+		if (!data)
+		{
+			return nullptr;
+		}
+
+		static StagedBitmap s_loadStaging;
+		s_loadStaging.result = bitmap_decode(data, size, decompress, &s_loadStaging);
+		return bitmap_commit(name, &filepath, &s_loadStaging, pool, addToCache);
+	}
+
+	static void bitmap_preloadTask(s32 index, void* userData)
+	{
+		StagedBitmap* staged = &s_stagedBitmaps[index];
+		const u8* data = staged->fileView ? staged->fileView : staged->fileData.data();
+		staged->result = bitmap_decode(data, staged->fileSize, staged->decompress, staged);
+		staged->decoded = true;
+		std::vector<u8>().swap(staged->fileData);
+	}
+
+	void bitmap_preload(const char* const* names, s32 count, u32 decompress, AssetPool pool)
+	{
+		TFE_ZONE("Bitmap Preload");
+		bitmap_clearPreloaded();
+
+		// Gather the file data on the calling thread, archives that are not memory mapped can only be read serially.
+		s_stagedBitmaps.reserve(count);
+		for (s32 i = 0; i < count; i++)
+		{
+			const char* name = names[i];
+			if (s_textureTable[pool].find(name) != s_textureTable[pool].end() || s_stagedTable.find(name) != s_stagedTable.end())
+			{
+				continue;
+			}
+
+			StagedBitmap staged;
+			if (!TFE_Paths::getFilePath(name, &staged.filePath))
+			{
+				continue;
+			}
+			staged.fileView = FileStream::getMappedContents(&staged.filePath, &staged.fileSize);
+			if (!staged.fileView && !FileStream::readView(&staged.filePath, staged.fileData, &staged.fileSize))
+			{
+				continue;
+			}
+			staged.decompress = decompress;
+
+			s_stagedTable[name] = (s32)s_stagedBitmaps.size();
+			s_stagedBitmaps.push_back(std::move(staged));
+		}
+
+		// Decode on the worker threads, decoding only touches the staged bitmap.
+		TFE_Parallel::run((s32)s_stagedBitmaps.size(), bitmap_preloadTask, nullptr);
+	}
+
+	void bitmap_clearPreloaded()
+	{
+		s_stagedBitmaps.clear();
+		s_stagedTable.clear();
+	}
+
 	TextureData* bitmap_loadFromMemory(const u8* data, size_t size, u32 decompress)
 	{
 		TextureData* texture = (TextureData*)malloc(sizeof(TextureData));
@@ -104,6 +104,11 @@ namespace TFE_Jedi
 	// if levelTexture is false, then textures are not serialized and not cleared at level end.
 	TextureData* bitmap_load(const char* name, u32 decompress, AssetPool pool = POOL_LEVEL, bool addToCache = true);
 	bool bitmap_setupAnimatedTexture(TextureData** texture, s32 index);
+	// TFE: Read and decode the listed bitmaps on the worker threads ahead of time, bitmap_load() then commits
+	// the staged result in the order the textures are requested. Staged bitmaps that are never loaded are freed
+	// by bitmap_clearPreloaded().
+	void bitmap_preload(const char* const* names, s32 count, u32 decompress, AssetPool pool = POOL_LEVEL);
+	void bitmap_clearPreloaded();
 
 	Allocator* bitmap_getAnimatedTextures();
 	TextureData** bitmap_getTextures(s32* textureCount, AssetPool pool);
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <vector>
+
+#include "sectorIndex.h"
+#include "rsector.h"
+#include "levelData.h"
+#include "robject.h"
+
+namespace TFE_Jedi
+{
+	enum SectorIndexConstants
+	{
+		SINDEX_MAX_DIM       = 128,	// Maximum number of cells along each axis.
+		SINDEX_MIN_CELL_SHFT = 19,	// Minimum cell size = 8 units (fixed16_16).
+		SINDEX_MAX_CELL_SHFT = 30,
+	};
+
+	struct CellRect
+	{
+		s32 x0, z0;
+		s32 x1, z1;
+	};
+
+	static JBool s_indexBuilt = JFALSE;
+	static fixed16_16 s_originX = 0;
+	static fixed16_16 s_originZ = 0;
+	static s32 s_cellShift = SINDEX_MIN_CELL_SHFT;
+	static s32 s_width = 0;
+	static s32 s_height = 0;
+	static std::vector<std::vector<s32>> s_cells;
+	static std::vector<std::vector<s32>> s_objectCells;	// Same layout as s_cells but only sectors with objects.
+	static std::vector<CellRect> s_sectorRect;
+	static std::vector<u8> s_sectorHasObjects;
+	static fixed16_16 s_maxObjectRadius = 0;
+
+	/////////////////////////////////////////////////
+	// Internal
+	/////////////////////////////////////////////////
+	// Points and bounds outside of the grid are clamped to the edge cells, so a sector that has grown past the
+	// original level bounds (moving walls) is still found by queries outside of the grid.
+	static s32 sectorIndex_cellX(fixed16_16 x)
+	{
+		const s64 cx = (s64(x) - s64(s_originX)) >> s_cellShift;
+		return s32(std::max(s64(0), std::min(s64(s_width - 1), cx)));
+	}
+
+	static s32 sectorIndex_cellZ(fixed16_16 z)
+	{
+		const s64 cz = (s64(z) - s64(s_originZ)) >> s_cellShift;
+		return s32(std::max(s64(0), std::min(s64(s_height - 1), cz)));
+	}
+
+	static CellRect sectorIndex_computeRect(RSector* sector)
+	{
+		CellRect rect;
+		rect.x0 = sectorIndex_cellX(sector->boundsMin.x);
+		rect.z0 = sectorIndex_cellZ(sector->boundsMin.z);
+		rect.x1 = sectorIndex_cellX(sector->boundsMax.x);
+		rect.z1 = sectorIndex_cellZ(sector->boundsMax.z);
+		return rect;
+	}
+
+	static void sectorIndex_insert(std::vector<std::vector<s32>>& cells, s32 index, const CellRect& rect)
+	{
+		for (s32 z = rect.z0; z <= rect.z1; z++)
+		{
+			std::vector<s32>* cell = &cells[z * s_width + rect.x0];
+			for (s32 x = rect.x0; x <= rect.x1; x++, cell++)
+			{
+				// Keep the cell sorted so that candidates are visited in the same order as the original sector list.
+				std::vector<s32>::iterator it = std::lower_bound(cell->begin(), cell->end(), index);
+				if (it == cell->end() || *it != index)
+				{
+					cell->insert(it, index);
+				}
+			}
+		}
+	}
+
+	static void sectorIndex_remove(std::vector<std::vector<s32>>& cells, s32 index, const CellRect& rect)
+	{
+		for (s32 z = rect.z0; z <= rect.z1; z++)
+		{
+			std::vector<s32>* cell = &cells[z * s_width + rect.x0];
+			for (s32 x = rect.x0; x <= rect.x1; x++, cell++)
+			{
+				std::vector<s32>::iterator it = std::lower_bound(cell->begin(), cell->end(), index);
+				if (it != cell->end() && *it == index)
+				{
+					cell->erase(it);
+				}
+			}
+		}
+	}
+
+	/////////////////////////////////////////////////
+	// API Implementation
+	/////////////////////////////////////////////////
+	void sectorIndex_build()
+	{
+		sectorIndex_clear();
+
+		const s32 sectorCount = s32(s_levelState.sectorCount);
+		RSector* sector = s_levelState.sectors;
+		if (!sector || !sectorCount) { return; }
+
+		fixed16_16 minX = sector->boundsMin.x, maxX = sector->boundsMax.x;
+		fixed16_16 minZ = sector->boundsMin.z, maxZ = sector->boundsMax.z;
+		sector++;
+		for (s32 i = 1; i < sectorCount; i++, sector++)
+		{
+			minX = min(minX, sector->boundsMin.x);
+			minZ = min(minZ, sector->boundsMin.z);
+			maxX = max(maxX, sector->boundsMax.x);
+			maxZ = max(maxZ, sector->boundsMax.z);
+		}
+
+		// Pick the smallest power of two cell size that keeps the grid within SINDEX_MAX_DIM cells on each axis.
+		const s64 extent = std::max(s64(maxX) - s64(minX), s64(maxZ) - s64(minZ));
+		s_cellShift = SINDEX_MIN_CELL_SHFT;
+		while (s_cellShift < SINDEX_MAX_CELL_SHFT && (extent >> s_cellShift) >= SINDEX_MAX_DIM)
+		{
+			s_cellShift++;
+		}
+
+		s_originX = minX;
+		s_originZ = minZ;
+		s_width  = s32((s64(maxX) - s64(minX)) >> s_cellShift) + 1;
+		s_height = s32((s64(maxZ) - s64(minZ)) >> s_cellShift) + 1;
+		s_cells.resize(s_width * s_height);
+		s_objectCells.resize(s_width * s_height);
+		s_sectorRect.resize(sectorCount);
+		s_sectorHasObjects.resize(sectorCount);
+
+		sector = s_levelState.sectors;
+		for (s32 i = 0; i < sectorCount; i++, sector++)
+		{
+			s_sectorRect[i] = sectorIndex_computeRect(sector);
+			sectorIndex_insert(s_cells, i, s_sectorRect[i]);
+
+			s_sectorHasObjects[i] = sector->objectCount > 0 ? 1 : 0;
+			if (s_sectorHasObjects[i])
+			{
+				sectorIndex_insert(s_objectCells, i, s_sectorRect[i]);
+			}
+		}
+		s_indexBuilt = JTRUE;
+	}
+
+	void sectorIndex_clear()
+	{
+		s_indexBuilt = JFALSE;
+		s_width = 0;
+		s_height = 0;
+		s_cells.clear();
+		s_objectCells.clear();
+		s_sectorRect.clear();
+		s_sectorHasObjects.clear();
+	}
+
+	void sectorIndex_update(RSector* sector)
+	{
+		if (!s_indexBuilt || !sector) { return; }
+		const s32 index = s32(sector - s_levelState.sectors);
+		if (index < 0 || index >= s32(s_sectorRect.size())) { return; }
+
+		const CellRect rect = sectorIndex_computeRect(sector);
+		const CellRect& prev = s_sectorRect[index];
+		if (rect.x0 == prev.x0 && rect.z0 == prev.z0 && rect.x1 == prev.x1 && rect.z1 == prev.z1)
+		{
+			return;
+		}
+		sectorIndex_remove(s_cells, index, prev);
+		sectorIndex_insert(s_cells, index, rect);
+		if (s_sectorHasObjects[index])
+		{
+			sectorIndex_remove(s_objectCells, index, prev);
+			sectorIndex_insert(s_objectCells, index, rect);
+		}
+		s_sectorRect[index] = rect;
+	}
+
+	JBool sectorIndex_getCandidates(fixed16_16 x, fixed16_16 z, const s32** list, s32* count)
+	{
+		if (!s_indexBuilt) { return JFALSE; }
+
+		const std::vector<s32>& cell = s_cells[sectorIndex_cellZ(z) * s_width + sectorIndex_cellX(x)];
+		*list = cell.data();
+		*count = s32(cell.size());
+		return JTRUE;
+	}
+
+	void sectorIndex_updateObjects(RSector* sector)
+	{
+		if (!s_indexBuilt || !sector) { return; }
+		const s32 index = s32(sector - s_levelState.sectors);
+		if (index < 0 || index >= s32(s_sectorRect.size())) { return; }
+
+		const u8 hasObjects = sector->objectCount > 0 ? 1 : 0;
+		if (hasObjects == s_sectorHasObjects[index]) { return; }
+
+		if (hasObjects)
+		{
+			sectorIndex_insert(s_objectCells, index, s_sectorRect[index]);
+		}
+		else
+		{
+			sectorIndex_remove(s_objectCells, index, s_sectorRect[index]);
+		}
+		s_sectorHasObjects[index] = hasObjects;
+	}
+
+	JBool sectorIndex_getObjectSectorsInRange(fixed16_16 x0, fixed16_16 z0, fixed16_16 x1, fixed16_16 z1, std::vector<s32>& list)
+	{
+		list.clear();
+		if (!s_indexBuilt) { return JFALSE; }
+
+		const s32 cx0 = sectorIndex_cellX(x0), cx1 = sectorIndex_cellX(x1);
+		const s32 cz0 = sectorIndex_cellZ(z0), cz1 = sectorIndex_cellZ(z1);
+		for (s32 z = cz0; z <= cz1; z++)
+		{
+			const std::vector<s32>* cell = &s_objectCells[z * s_width + cx0];
+			for (s32 x = cx0; x <= cx1; x++, cell++)
+			{
+				for (size_t i = 0; i < cell->size(); i++)
+				{
+					const RSector* sector = &s_levelState.sectors[(*cell)[i]];
+					if (x0 > sector->boundsMax.x || x1 < sector->boundsMin.x || z0 > sector->boundsMax.z || z1 < sector->boundsMin.z)
+					{
+						continue;
+					}
+					list.push_back((*cell)[i]);
+				}
+			}
+		}
+
+		// Sectors that span several cells show up more than once, and the results must be in sector order.
+		std::sort(list.begin(), list.end());
+		list.erase(std::unique(list.begin(), list.end()), list.end());
+		return JTRUE;
+	}
+
+	void sectorIndex_addObject(const SecObject* obj)
+	{
+		s_maxObjectRadius = max(s_maxObjectRadius, obj->worldWidth);
+	}
+
+	// Object radii are often set after the object is added to its sector, so they are gathered again once the level
+	// objects are loaded.
+	void sectorIndex_updateObjectRadius()
+	{
+		s_maxObjectRadius = 0;
+		const s32 sectorCount = s32(s_levelState.sectorCount);
+		RSector* sector = s_levelState.sectors;
+		for (s32 i = 0; sector && i < sectorCount; i++, sector++)
+		{
+			for (s32 objIndex = 0, objListIndex = 0; objIndex < sector->objectCount && objListIndex < sector->objectCapacity; objListIndex++)
+			{
+				const SecObject* obj = sector->objectList[objListIndex];
+				if (!obj) { continue; }
+				objIndex++;
+				sectorIndex_addObject(obj);
+			}
+		}
+	}
+
+	fixed16_16 sectorIndex_getMaxObjectRadius()
+	{
+		return s_maxObjectRadius;
+	}
+}
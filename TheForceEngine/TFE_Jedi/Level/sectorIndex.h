@@ -0,0 +1,51 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Sector Index
+// Added for TFE: a uniform 2D grid over sector bounds used to speed
+// up point-location queries (sector_which3D(), sector_which3D_Map()).
+//
+// Each cell stores the indices of every sector whose XZ bounds
+// overlap the cell, in ascending sector order. Queries then walk the
+// cell list exactly like the original code walks the full sector
+// list, so the result (smallest containing sector, ties going to the
+// lowest index) is identical to the original linear search.
+//
+// A second set of cell lists only holds sectors that currently
+// contain objects. It is kept up to date as objects are added to and
+// removed from sectors and is used as the broadphase for object range
+// queries (explosions, mines, weapon wakeup).
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include <vector>
+#include <TFE_Jedi/Math/core_math.h>
+
+struct RSector;
+struct SecObject;
+
+namespace TFE_Jedi
+{
+	// Build the index from the current sector bounds, must be called after sector bounds are computed.
+	void sectorIndex_build();
+	// Free the index, queries fall back to the full sector list until it is built again.
+	void sectorIndex_clear();
+	// Update a single sector after its bounds have changed (moving or rotating walls).
+	// This is a no-op if the index has not been built.
+	void sectorIndex_update(RSector* sector);
+
+	// Get the list of sector indices (in ascending order) that may contain the point (x, z).
+	// Returns JFALSE if the index is not built, in which case the caller must search all sectors.
+	JBool sectorIndex_getCandidates(fixed16_16 x, fixed16_16 z, const s32** list, s32* count);
+
+	// Called when a sector gains its first object or loses its last one.
+	// This is a no-op if the index has not been built.
+	void sectorIndex_updateObjects(RSector* sector);
+	// Get the indices (in ascending order) of the sectors that contain objects and whose bounds overlap [x0,x1]x[z0,z1].
+	// Returns JFALSE if the index is not built, in which case the caller must search all sectors.
+	JBool sectorIndex_getObjectSectorsInRange(fixed16_16 x0, fixed16_16 z0, fixed16_16 x1, fixed16_16 z1, std::vector<s32>& list);
+
+	// An object's position may be up to its radius outside of its sector bounds, so range queries are expanded by the
+	// largest object radius. It is tracked as objects are added to sectors and recomputed once the objects are loaded.
+	void sectorIndex_addObject(const SecObject* obj);
+	void sectorIndex_updateObjectRadius();
+	fixed16_16 sectorIndex_getMaxObjectRadius();
+}
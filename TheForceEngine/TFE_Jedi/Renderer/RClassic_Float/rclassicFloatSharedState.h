@@ -10,8 +10,12 @@
 #include <TFE_Jedi/Renderer/rlimits.h>
 #include <TFE_Jedi/Renderer/rwallSegment.h>
 
+struct SecObject;
+
 namespace TFE_Jedi
 {
+	// TFE: Each screen strip drawn in parallel has its own heap allocated state, which copies the view
+	// (everything before 'flatEdge') from the main thread and keeps its own traversal state.
 	struct RClassicFloatState
 	{
 		// Resolution
@@ -61,6 +65,14 @@ namespace TFE_Jedi
 		RWallSegmentFloat   wallSegListDst[MAX_SEG_EXT];
 		RWallSegmentFloat   wallSegListSrc[MAX_SEG_EXT];
 		RWallSegmentFloat** adjoinSegment;
+
+		// TFE: Per-thread traversal state.
+		s32* wallDrawFrame;		// Frame an adjoin wall is being drawn through, indexed by WallCached::index.
+		s32  stripMinX;			// Range of columns drawn by this thread.
+		s32  stripMaxX;
+		SecObject** drawnObj;	// Drawn 3D objects, normally s_drawnObj.
+		s32* drawnObjCount;
 	};
-	extern RClassicFloatState s_rcfltState;
+	// The state used by the current thread, this is the main state unless the thread is drawing a strip.
+	extern thread_local RClassicFloatState* s_rcfltState;
 }  // TFE_Jedi
\ No newline at end of file
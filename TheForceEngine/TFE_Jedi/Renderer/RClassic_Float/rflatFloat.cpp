@@ -4,6 +4,7 @@
 #include "rflatFloat.h"
 #include "rlightingFloat.h"
 #include "redgePairFloat.h"
+#include "rrasterFloat.h"
 #include "rclassicFloat.h"
 #include "rclassicFloatSharedState.h"
 #include "fixedPoint20.h"
@@ -18,23 +19,23 @@ namespace TFE_Jedi
 
 namespace RClassic_Float
 {
-	static s32 s_scanlineX0;
-
-	static fixed44_20 s_scanlineU0;
-	static fixed44_20 s_scanlineV0;
-	static fixed44_20 s_scanline_dUdX;
-	static fixed44_20 s_scanline_dVdX;
-
-	static s32 s_scanlineWidth;
-	static const u8* s_scanlineLight;
-	static u8* s_scanlineOut;
-
-	static u8* s_ftexImage;
-	static s32 s_ftexDataEnd;
-	static s32 s_ftexHeight;
-	static s32 s_ftexWidthMask;
-	static s32 s_ftexHeightMask;
-	static s32 s_ftexHeightLog2;
+	static thread_local s32 s_scanlineX0;
+
+	static thread_local fixed44_20 s_scanlineU0;
+	static thread_local fixed44_20 s_scanlineV0;
+	static thread_local fixed44_20 s_scanline_dUdX;
+	static thread_local fixed44_20 s_scanline_dVdX;
+
+	static thread_local s32 s_scanlineWidth;
+	static thread_local const u8* s_scanlineLight;
+	static thread_local u8* s_scanlineOut;
+
+	static thread_local u8* s_ftexImage;
+	static thread_local s32 s_ftexDataEnd;
+	static thread_local s32 s_ftexHeight;
+	static thread_local s32 s_ftexWidthMask;
+	static thread_local s32 s_ftexHeightMask;
+	static thread_local s32 s_ftexHeightLog2;
 		
 	void flat_addEdges(s32 length, s32 x0, f32 dyFloor_dx, f32 yFloor, f32 dyCeil_dx, f32 yCeil)
 	{
@@ -53,15 +54,15 @@ namespace RClassic_Float
 				yFloor1 += dyFloor_dx * lengthFlt;
 			}
 
-			edgePair_setup(length, x0, dyFloor_dx, yFloor1, yFloor, dyCeil_dx, yCeil, yCeil1, s_rcfltState.flatEdge);
+			edgePair_setup(length, x0, dyFloor_dx, yFloor1, yFloor, dyCeil_dx, yCeil, yCeil1, s_rcfltState->flatEdge);
 
-			if (s_rcfltState.flatEdge->yPixel_C1 - 1 > s_wallMaxCeilY)
+			if (s_rcfltState->flatEdge->yPixel_C1 - 1 > s_wallMaxCeilY)
 			{
-				s_wallMaxCeilY = s_rcfltState.flatEdge->yPixel_C1 - 1;
+				s_wallMaxCeilY = s_rcfltState->flatEdge->yPixel_C1 - 1;
 			}
-			if (s_rcfltState.flatEdge->yPixel_F1 + 1 < s_wallMinFloorY)
+			if (s_rcfltState->flatEdge->yPixel_F1 + 1 < s_wallMinFloorY)
 			{
-				s_wallMinFloorY = s_rcfltState.flatEdge->yPixel_F1 + 1;
+				s_wallMinFloorY = s_rcfltState->flatEdge->yPixel_F1 + 1;
 			}
 			if (s_wallMaxCeilY < s_windowMinY_Pixels)
 			{
@@ -72,15 +73,29 @@ namespace RClassic_Float
 				s_wallMinFloorY = s_windowMaxY_Pixels;
 			}
 
-			s_rcfltState.flatEdge++;
+			s_rcfltState->flatEdge++;
 			s_flatCount++;
 		}
 	}
 				
+	// TFE: Draw the current scanline with the batched (SIMD) kernels if available.
+	// Returns false if the scalar reference loop must be used instead.
+	static bool drawScanline_Batched(const u8* light, bool trans)
+	{
+		const RasterScanlineFunc func = trans ? s_rasterKernels.scanlineTrans : s_rasterKernels.scanline;
+		if (!func) { return false; }
+
+		const RasterScanline scanline = { s_scanlineOut, s_scanlineWidth, s_ftexImage, light, s_scanlineU0, s_scanlineV0, s_scanline_dUdX, s_scanline_dVdX, s_ftexDataEnd };
+		func(&scanline);
+		return true;
+	}
+
 	// This produces functionally identical results to the original but splits apart the U/V and dUdx/dVdx into seperate variables
 	// to account for C vs ASM differences.
 	void drawScanline()
 	{
+		if (drawScanline_Batched(s_scanlineLight, false)) { return; }
+
 		const fixed44_20 dVdX = s_scanline_dVdX;
 		const fixed44_20 dUdX = s_scanline_dUdX;
 		fixed44_20 V = s_scanlineV0;
@@ -97,6 +112,8 @@ namespace RClassic_Float
 
 	void drawScanline_Fullbright()
 	{
+		if (drawScanline_Batched(nullptr, false)) { return; }
+
 		const fixed44_20 dVdX = s_scanline_dVdX;
 		const fixed44_20 dUdX = s_scanline_dUdX;
 		fixed44_20 V = s_scanlineV0;
@@ -113,6 +130,8 @@ namespace RClassic_Float
 
 	void drawScanline_Trans()
 	{
+		if (drawScanline_Batched(s_scanlineLight, true)) { return; }
+
 		const fixed44_20 dVdX = s_scanline_dVdX;
 		const fixed44_20 dUdX = s_scanline_dUdX;
 		fixed44_20 V = s_scanlineV0;
@@ -131,6 +150,8 @@ namespace RClassic_Float
 
 	void drawScanline_Fullbright_Trans()
 	{
+		if (drawScanline_Batched(nullptr, true)) { return; }
+
 		const fixed44_20 dVdX = s_scanline_dVdX;
 		const fixed44_20 dUdX = s_scanline_dUdX;
 		fixed44_20 V = s_scanlineV0;
@@ -163,15 +184,15 @@ namespace RClassic_Float
 	
 	void flat_drawCeiling(SectorCached* sectorCached, EdgePairFloat* edges, s32 count)
 	{
-		f32 textureOffsetU = s_rcfltState.cameraPos.x - sectorCached->ceilOffset.x;
-		f32 textureOffsetV = sectorCached->ceilOffset.z - s_rcfltState.cameraPos.z;
+		f32 textureOffsetU = s_rcfltState->cameraPos.x - sectorCached->ceilOffset.x;
+		f32 textureOffsetV = sectorCached->ceilOffset.z - s_rcfltState->cameraPos.z;
 
-		f32 relCeil          = sectorCached->ceilingHeight - s_rcfltState.eyeHeight;
-		f32 scaledRelCeil    =  relCeil * s_rcfltState.focalLenAspect;
-		f32 cosScaledRelCeil =  scaledRelCeil * s_rcfltState.cosYaw;
-		f32 negSinRelCeil    = -relCeil * s_rcfltState.sinYaw;
-		f32 sinScaledRelCeil =  scaledRelCeil * s_rcfltState.sinYaw;
-		f32 negCosRelCeil    = -relCeil * s_rcfltState.cosYaw;
+		f32 relCeil          = sectorCached->ceilingHeight - s_rcfltState->eyeHeight;
+		f32 scaledRelCeil    =  relCeil * s_rcfltState->focalLenAspect;
+		f32 cosScaledRelCeil =  scaledRelCeil * s_rcfltState->cosYaw;
+		f32 negSinRelCeil    = -relCeil * s_rcfltState->sinYaw;
+		f32 sinScaledRelCeil =  scaledRelCeil * s_rcfltState->sinYaw;
+		f32 negCosRelCeil    = -relCeil * s_rcfltState->cosYaw;
 
 		if (!flat_setTexture(*sectorCached->sector->ceilTex)) { return; }
 
@@ -200,14 +221,14 @@ namespace RClassic_Float
 					s_scanlineOut = &s_display[left + yOffset];
 
 					const f32 worldToTexelScale = 8.0f;
-					f32 rightClip = f32(right - s_screenXMid) * s_rcfltState.aspectScaleX;
+					f32 rightClip = f32(right - s_screenXMid) * s_rcfltState->aspectScaleX;
 					f32 v0 = (cosScaledRelCeil - (negSinRelCeil*rightClip)) * yRcp;
 					f32 u0 = (sinScaledRelCeil + (negCosRelCeil*rightClip)) * yRcp;
 
 					s_scanlineV0 = floatToFixed20((v0 - textureOffsetV) * worldToTexelScale);
 					s_scanlineU0 = floatToFixed20((u0 - textureOffsetU) * worldToTexelScale);
 
-					const f32 worldTexelScaleAspect = yRcp * worldToTexelScale * s_rcfltState.aspectScaleY;
+					const f32 worldTexelScaleAspect = yRcp * worldToTexelScale * s_rcfltState->aspectScaleY;
 					s_scanline_dVdX =  floatToFixed20(negSinRelCeil * worldTexelScaleAspect);
 					s_scanline_dUdX = -floatToFixed20(negCosRelCeil * worldTexelScaleAspect);
 					s_scanlineLight =  computeLighting(z, 0);
@@ -227,16 +248,16 @@ namespace RClassic_Float
 		
 	void flat_drawFloor(SectorCached* sectorCached, EdgePairFloat* edges, s32 count)
 	{
-		f32 textureOffsetU = s_rcfltState.cameraPos.x - sectorCached->floorOffset.x;
-		f32 textureOffsetV = sectorCached->floorOffset.z - s_rcfltState.cameraPos.z;
+		f32 textureOffsetU = s_rcfltState->cameraPos.x - sectorCached->floorOffset.x;
+		f32 textureOffsetV = sectorCached->floorOffset.z - s_rcfltState->cameraPos.z;
 
-		f32 relFloor       = sectorCached->floorHeight - s_rcfltState.eyeHeight;
-		f32 scaledRelFloor = relFloor * s_rcfltState.focalLenAspect;
+		f32 relFloor       = sectorCached->floorHeight - s_rcfltState->eyeHeight;
+		f32 scaledRelFloor = relFloor * s_rcfltState->focalLenAspect;
 
-		f32 cosScaledRelFloor = scaledRelFloor * s_rcfltState.cosYaw;
-		f32 negSinRelFloor    =-relFloor * s_rcfltState.sinYaw;
-		f32 sinScaledRelFloor = scaledRelFloor * s_rcfltState.sinYaw;
-		f32 negCosRelFloor    =-relFloor * s_rcfltState.cosYaw;
+		f32 cosScaledRelFloor = scaledRelFloor * s_rcfltState->cosYaw;
+		f32 negSinRelFloor    =-relFloor * s_rcfltState->sinYaw;
+		f32 sinScaledRelFloor = scaledRelFloor * s_rcfltState->sinYaw;
+		f32 negCosRelFloor    =-relFloor * s_rcfltState->cosYaw;
 
 		if (!flat_setTexture(*sectorCached->sector->floorTex)) { return; }
 
@@ -268,13 +289,13 @@ namespace RClassic_Float
 					s_scanlineOut = &s_display[left + yOffset];
 
 					const f32 worldToTexelScale = 8.0f;
-					f32 rightClip = f32(right - s_screenXMid) * s_rcfltState.aspectScaleX;
+					f32 rightClip = f32(right - s_screenXMid) * s_rcfltState->aspectScaleX;
 					f32 v0 = (cosScaledRelFloor - (negSinRelFloor * rightClip)) * yRcp;
 					f32 u0 = (sinScaledRelFloor + (negCosRelFloor * rightClip)) * yRcp;
 					s_scanlineV0 = floatToFixed20((v0 - textureOffsetV) * worldToTexelScale);
 					s_scanlineU0 = floatToFixed20((u0 - textureOffsetU) * worldToTexelScale);
 
-					const f32 worldTexelScaleAspect = yRcp * worldToTexelScale * s_rcfltState.aspectScaleY;
+					const f32 worldTexelScaleAspect = yRcp * worldToTexelScale * s_rcfltState->aspectScaleY;
 					s_scanline_dVdX =  floatToFixed20(negSinRelFloor * worldTexelScaleAspect);
 					s_scanline_dUdX = -floatToFixed20(negCosRelFloor * worldTexelScaleAspect);
 					s_scanlineLight = computeLighting(z, 0);
@@ -304,27 +325,27 @@ namespace RClassic_Float
 		drawScanline_Fullbright_Trans
 	};
 
-	static f32 s_poly_offsetX;
-	static f32 s_poly_offsetZ;
+	static thread_local f32 s_poly_offsetX;
+	static thread_local f32 s_poly_offsetZ;
 
-	static f32 s_poly_scaledHOffset;
-	static f32 s_poly_sinYawHOffset;
-	static f32 s_poly_cosYawHOffset;
+	static thread_local f32 s_poly_scaledHOffset;
+	static thread_local f32 s_poly_sinYawHOffset;
+	static thread_local f32 s_poly_cosYawHOffset;
 
-	static f32 s_poly_cosYawScaledHOffset;
-	static f32 s_poly_sinYawScaledHOffset;
+	static thread_local f32 s_poly_cosYawScaledHOffset;
+	static thread_local f32 s_poly_sinYawScaledHOffset;
 		
 	void flat_preparePolygon(f32 heightOffset, f32 offsetX, f32 offsetZ, TextureData* texture)
 	{
-		s_poly_offsetX = s_rcfltState.cameraPos.x - offsetX;
-		s_poly_offsetZ = offsetZ - s_rcfltState.cameraPos.z;
+		s_poly_offsetX = s_rcfltState->cameraPos.x - offsetX;
+		s_poly_offsetZ = offsetZ - s_rcfltState->cameraPos.z;
 
-		s_poly_scaledHOffset = heightOffset * s_rcfltState.focalLenAspect;
-		s_poly_sinYawHOffset = s_rcfltState.sinYaw * heightOffset;
-		s_poly_cosYawHOffset = s_rcfltState.cosYaw * heightOffset;
+		s_poly_scaledHOffset = heightOffset * s_rcfltState->focalLenAspect;
+		s_poly_sinYawHOffset = s_rcfltState->sinYaw * heightOffset;
+		s_poly_cosYawHOffset = s_rcfltState->cosYaw * heightOffset;
 
-		s_poly_cosYawScaledHOffset = s_rcfltState.cosYaw * s_poly_scaledHOffset;
-		s_poly_sinYawScaledHOffset = s_rcfltState.sinYaw * s_poly_scaledHOffset;
+		s_poly_cosYawScaledHOffset = s_rcfltState->cosYaw * s_poly_scaledHOffset;
+		s_poly_sinYawScaledHOffset = s_rcfltState->sinYaw * s_poly_scaledHOffset;
 
 		s_ftexWidthMask  = texture->width - 1;
 		s_ftexHeightMask = texture->height - 1;
@@ -348,14 +369,14 @@ namespace RClassic_Float
 		const f32 yShear = f32(y - s_screenYMidFlt);
 		const f32 yRcp = (yShear != 0.0f) ? 1.0f/yShear : 1.0f;
 		const f32 z = s_poly_scaledHOffset * yRcp;
-		const f32 right = f32(x1 - 1 - s_screenXMid) * s_rcfltState.aspectScaleX;
+		const f32 right = f32(x1 - 1 - s_screenXMid) * s_rcfltState->aspectScaleX;
 
 		const f32 u0 = s_poly_sinYawScaledHOffset - (s_poly_cosYawHOffset*right);
 		const f32 v0 = s_poly_cosYawScaledHOffset + (s_poly_sinYawHOffset*right);
 		s_scanlineU0 = floatToFixed20((u0*yRcp - s_poly_offsetX) * 8.0f);
 		s_scanlineV0 = floatToFixed20((v0*yRcp - s_poly_offsetZ) * 8.0f);
 
-		const f32 worldTexelScaleAspect = yRcp * 8.0f * s_rcfltState.aspectScaleY;
+		const f32 worldTexelScaleAspect = yRcp * 8.0f * s_rcfltState->aspectScaleY;
 		s_scanline_dVdX = -floatToFixed20(s_poly_sinYawHOffset*worldTexelScaleAspect);
 		s_scanline_dUdX =  floatToFixed20(s_poly_cosYawHOffset*worldTexelScaleAspect);
 
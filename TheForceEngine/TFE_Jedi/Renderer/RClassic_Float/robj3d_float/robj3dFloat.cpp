@@ -16,9 +16,6 @@
 
 namespace TFE_Jedi
 {
-extern s32 s_drawnObjCount;
-extern SecObject* s_drawnObj[];
-
 namespace RClassic_Float
 {
 	void robj3d_projectVertices(vec3_float* pos, s32 count, vec3_float* out);
@@ -73,9 +70,9 @@ namespace RClassic_Float
 			robj3d_drawPolygon(polygon, polyVertexCount, obj, model);
 		}
 
-		if (drawn && s_drawnObjCount < MAX_DRAWN_OBJ_STORE)
+		if (drawn && *s_rcfltState->drawnObjCount < MAX_DRAWN_OBJ_STORE)
 		{
-			s_drawnObj[s_drawnObjCount++] = obj;
+			s_rcfltState->drawnObj[(*s_rcfltState->drawnObjCount)++] = obj;
 		}
 	}
 		
@@ -93,23 +90,23 @@ namespace RClassic_Float
 			const f32 z = vertex->z;
 			if (z <= 1.0f) { continue; }
 
-			const s32 pixel_x = roundFloat((vertex->x*s_rcfltState.focalLength)    / z + s_rcfltState.projOffsetX);
-			const s32 pixel_y = roundFloat((vertex->y*s_rcfltState.focalLenAspect) / z + s_rcfltState.projOffsetY);
+			const s32 pixel_x = roundFloat((vertex->x*s_rcfltState->focalLength)    / z + s_rcfltState->projOffsetX);
+			const s32 pixel_y = roundFloat((vertex->y*s_rcfltState->focalLenAspect) / z + s_rcfltState->projOffsetY);
 
 			// If the X position is out of view, skip the vertex.
-			if (pixel_x < s_minScreenX_Pixels || pixel_x > s_maxScreenX_Pixels)
+			if (pixel_x < s_rcfltState->stripMinX || pixel_x > s_rcfltState->stripMaxX)
 			{
 				continue;
 			}
 			// Check the 1d depth buffer and Y positon and skip if occluded.
-			if (z >= s_rcfltState.depth1d[pixel_x] || pixel_y > s_windowMaxY_Pixels || pixel_y < s_windowMinY_Pixels || pixel_y < s_windowTop[pixel_x] || pixel_y > s_windowBot[pixel_x])
+			if (z >= s_rcfltState->depth1d[pixel_x] || pixel_y > s_windowMaxY_Pixels || pixel_y < s_windowMinY_Pixels || pixel_y < s_windowTop[pixel_x] || pixel_y > s_windowBot[pixel_x])
 			{
 				continue;
 			}
 
 			for (s32 i = 0; i < area; i++)
 			{
-				const s32 x = clamp(pixel_x - halfSize + (i % size), s_minScreenX_Pixels, s_maxScreenX_Pixels);
+				const s32 x = clamp(pixel_x - halfSize + (i % size), s_rcfltState->stripMinX, s_rcfltState->stripMaxX);
 				const s32 y = clamp(pixel_y - halfSize + (i / size), s_windowMinY_Pixels, s_windowMaxY_Pixels);
 				s_display[y*s_width + x] = color;
 			}
@@ -122,8 +119,8 @@ namespace RClassic_Float
 		{
 			const f32 rcpZ = 1.0f / pos->z;
 
-			out->x = (f32)roundFloat((pos->x*s_rcfltState.focalLength)   *rcpZ + s_rcfltState.projOffsetX);
-			out->y = (f32)roundFloat((pos->y*s_rcfltState.focalLenAspect)*rcpZ + s_rcfltState.projOffsetY);
+			out->x = (f32)roundFloat((pos->x*s_rcfltState->focalLength)   *rcpZ + s_rcfltState->projOffsetX);
+			out->y = (f32)roundFloat((pos->y*s_rcfltState->focalLenAspect)*rcpZ + s_rcfltState->projOffsetY);
 			out->z = pos->z;
 		}
 	}
@@ -132,7 +129,7 @@ namespace RClassic_Float
 	{
 		JmPolygon* p0 = *((JmPolygon**)r0);
 		JmPolygon* p1 = *((JmPolygon**)r1);
-		return signZero(p1->zAvef - p0->zAvef);
+		return signZero(s_polygonZAve[p1->index] - s_polygonZAve[p0->index]);
 	}
 
 }}  // TFE_Jedi
\ No newline at end of file
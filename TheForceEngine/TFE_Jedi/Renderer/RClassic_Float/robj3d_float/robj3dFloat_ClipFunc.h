@@ -233,8 +233,8 @@ s32 robj3d_clipPolygon(vec3_float* pos, s32 count)
 	///////////////////////////////////////////////////
 	for (s32 i = 0; i < srcVertexCount; i++)
 	{
-		s_clipPlanePos0 = -s_clipPos0->z * s_rcfltState.nearPlaneHalfLen;
-		s_clipPlanePos1 = -s_clipPos1->z * s_rcfltState.nearPlaneHalfLen;
+		s_clipPlanePos0 = -s_clipPos0->z * s_rcfltState->nearPlaneHalfLen;
+		s_clipPlanePos1 = -s_clipPos1->z * s_rcfltState->nearPlaneHalfLen;
 		if (s_clipPos0->x < s_clipPlanePos0 && s_clipPos1->x < s_clipPlanePos1)
 		{
 			s_clipPos0 = s_clipPos1;
@@ -297,14 +297,14 @@ s32 robj3d_clipPolygon(vec3_float* pos, s32 count)
 			const f32 dz = s_clipPos1->z - s_clipPos0->z;
 
 			s_clipParam0 = (x0*z1) - (x1*z0);
-			s_clipParam1 = -dz*s_rcfltState.nearPlaneHalfLen - dx;
+			s_clipParam1 = -dz*s_rcfltState->nearPlaneHalfLen - dx;
 
 			s_clipIntersectZ = s_clipParam0;
 			if (s_clipParam1 != 0)
 			{
 				s_clipIntersectZ = s_clipParam0 / s_clipParam1;
 			}
-			s_clipIntersectX = -s_clipIntersectZ * s_rcfltState.nearPlaneHalfLen;
+			s_clipIntersectX = -s_clipIntersectZ * s_rcfltState->nearPlaneHalfLen;
 
 			f32 p, p0, p1;
 			if (TFE_Jedi::abs(dz) > TFE_Jedi::abs(dx))
@@ -352,8 +352,8 @@ s32 robj3d_clipPolygon(vec3_float* pos, s32 count)
 	///////////////////////////////////////////////////
 	for (s32 i = 0; i < srcVertexCount; i++)
 	{
-		s_clipPlanePos0 = s_clipPos0->z * s_rcfltState.nearPlaneHalfLen;
-		s_clipPlanePos1 = s_clipPos1->z * s_rcfltState.nearPlaneHalfLen;
+		s_clipPlanePos0 = s_clipPos0->z * s_rcfltState->nearPlaneHalfLen;
+		s_clipPlanePos1 = s_clipPos1->z * s_rcfltState->nearPlaneHalfLen;
 		if (s_clipPos0->x > s_clipPlanePos0 && s_clipPos1->x > s_clipPlanePos1)
 		{
 			s_clipPos0 = s_clipPos1;
@@ -416,14 +416,14 @@ s32 robj3d_clipPolygon(vec3_float* pos, s32 count)
 			const f32 dz = s_clipPos1->z - s_clipPos0->z;
 
 			s_clipParam0 = (x0*z1) - (x1*z0);
-			s_clipParam1 = s_rcfltState.nearPlaneHalfLen*dz - dx;
+			s_clipParam1 = s_rcfltState->nearPlaneHalfLen*dz - dx;
 
 			s_clipIntersectZ = s_clipParam0;
 			if (s_clipParam1 != 0)
 			{
 				s_clipIntersectZ = s_clipParam0 / s_clipParam1;
 			}
-			s_clipIntersectX = s_rcfltState.nearPlaneHalfLen * s_clipIntersectZ;
+			s_clipIntersectX = s_rcfltState->nearPlaneHalfLen * s_clipIntersectZ;
 
 			f32 p, p0, p1;
 			if (TFE_Jedi::abs(dz) > TFE_Jedi::abs(dx))
@@ -472,8 +472,8 @@ s32 robj3d_clipPolygon(vec3_float* pos, s32 count)
 	///////////////////////////////////////////////////
 	for (s32 i = 0; i < srcVertexCount; i++)
 	{
-		s_clipY0 = s_rcfltState.yPlaneTop * s_clipPos0->z;
-		s_clipY1 = s_rcfltState.yPlaneTop * s_clipPos1->z;
+		s_clipY0 = s_rcfltState->yPlaneTop * s_clipPos0->z;
+		s_clipY1 = s_rcfltState->yPlaneTop * s_clipPos1->z;
 
 		// If the edge is completely behind the plane, then continue.
 		if (s_clipPos0->y < s_clipY0 && s_clipPos1->y < s_clipY1)
@@ -532,14 +532,14 @@ s32 robj3d_clipPolygon(vec3_float* pos, s32 count)
 
 			const f32 dy = s_clipPos1->y - s_clipPos0->y;
 			const f32 dz = s_clipPos1->z - s_clipPos0->z;
-			s_clipParam1 = s_rcfltState.yPlaneTop*dz - dy;
+			s_clipParam1 = s_rcfltState->yPlaneTop*dz - dy;
 
 			s_clipIntersectZ = s_clipParam0;
 			if (s_clipParam1 != 0)
 			{
 				s_clipIntersectZ = s_clipParam0 / s_clipParam1;
 			}
-			s_clipIntersectY = s_rcfltState.yPlaneTop * s_clipIntersectZ;
+			s_clipIntersectY = s_rcfltState->yPlaneTop * s_clipIntersectZ;
 			const f32 aDz = TFE_Jedi::abs(s_clipPos1->z - s_clipPos0->z);
 			const f32 aDy = TFE_Jedi::abs(s_clipPos1->y - s_clipPos0->y);
 
@@ -590,8 +590,8 @@ s32 robj3d_clipPolygon(vec3_float* pos, s32 count)
 	///////////////////////////////////////////////////
 	for (s32 i = 0; i < srcVertexCount; i++)
 	{
-		s_clipY0 = s_rcfltState.yPlaneBot * s_clipPos0->z;
-		s_clipY1 = s_rcfltState.yPlaneBot * s_clipPos1->z;
+		s_clipY0 = s_rcfltState->yPlaneBot * s_clipPos0->z;
+		s_clipY1 = s_rcfltState->yPlaneBot * s_clipPos1->z;
 
 		// If the edge is completely behind the plane, then continue.
 		if (s_clipPos0->y > s_clipY0 && s_clipPos1->y > s_clipY1)
@@ -651,14 +651,14 @@ s32 robj3d_clipPolygon(vec3_float* pos, s32 count)
 
 			const f32 dy = s_clipPos1->y - s_clipPos0->y;
 			const f32 dz = s_clipPos1->z - s_clipPos0->z;
-			s_clipParam1 = s_rcfltState.yPlaneBot*dz - dy;
+			s_clipParam1 = s_rcfltState->yPlaneBot*dz - dy;
 
 			s_clipIntersectZ = s_clipParam0;
 			if (s_clipParam1 != 0)
 			{
 				s_clipIntersectZ = s_clipParam0 / s_clipParam1;
 			}
-			s_clipIntersectY = s_rcfltState.yPlaneBot * s_clipIntersectZ;
+			s_clipIntersectY = s_rcfltState->yPlaneBot * s_clipIntersectZ;
 			const f32 aDz = TFE_Jedi::abs(s_clipPos1->z - s_clipPos0->z);
 			const f32 aDy = TFE_Jedi::abs(s_clipPos1->y - s_clipPos0->y);
 
@@ -19,7 +19,10 @@ namespace RClassic_Float
 	};
 
 	// List of potentially visible polygons (after backface culling).
-	std::vector<JmPolygon*> s_visPolygons;
+	thread_local std::vector<JmPolygon*> s_visPolygons;
+	// Average view space depth of each polygon, indexed by JmPolygon::index.
+	// This is kept per thread instead of in the shared model so several threads can draw the same model.
+	thread_local std::vector<f32> s_polygonZAve;
 
 	s32 getPolygonFacing(const vec3_float* normal, const vec3_float* pos)
 	{
@@ -44,6 +47,10 @@ namespace RClassic_Float
 		{
 			s_visPolygons.resize(polygonCount * 2);
 		}
+		if (polygonCount > s_polygonZAve.size())
+		{
+			s_polygonZAve.resize(polygonCount * 2);
+		}
 
 		JmPolygon** visPolygon = s_visPolygons.data();
 		s32 visPolygonCount = 0;
@@ -66,7 +73,7 @@ namespace RClassic_Float
 				zAve += s_verticesVS[indices[v]].z;
 			}
 
-			polygon->zAvef = zAve / f32(vertexCount);
+			s_polygonZAve[polygon->index] = zAve / f32(vertexCount);
 			*visPolygon = polygon;
 			visPolygon++;
 		}
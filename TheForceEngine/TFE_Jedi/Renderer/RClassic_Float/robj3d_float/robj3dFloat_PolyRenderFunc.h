@@ -347,13 +347,14 @@ void robj3d_drawFlatColorPolygon(vec3_float* projVertices, s32 vertexCount, u8 c
 
 	if (FIND_NEXT_EDGE(minXIndex, xMin) != 0 || FIND_PREV_EDGE(minXIndex) != 0) { return; }
 
-	for (s32 foundEdge = 0; !foundEdge && s_columnX >= s_minScreenX_Pixels && s_columnX <= s_maxScreenX_Pixels; s_columnX++)
+	// TFE: Columns outside of the current screen strip still step the edges but are not drawn.
+	for (s32 foundEdge = 0; !foundEdge && s_columnX >= s_minScreenX_Pixels && s_columnX <= s_rcfltState->stripMaxX; s_columnX++)
 	{
 		const f32 edgeMinZ = min(s_edgeBot_Z0, s_edgeTop_Z0);
-		const f32 z = s_rcfltState.depth1d[s_columnX];
+		const f32 z = s_rcfltState->depth1d[s_columnX];
 
 		// Is ave edge Z occluded by walls? Is column outside of the vertical area?
-		if (edgeMinZ < z && s_edgeTopY0_Pixel <= s_windowMaxY_Pixels && s_edgeBotY0_Pixel >= s_windowMinY_Pixels)
+		if (s_columnX >= s_rcfltState->stripMinX && edgeMinZ < z && s_edgeTopY0_Pixel <= s_windowMaxY_Pixels && s_edgeBotY0_Pixel >= s_windowMinY_Pixels)
 		{
 			const s32 winTop = s_objWindowTop[s_columnX];
 			const s32 winBot = s_objWindowBot[s_columnX];
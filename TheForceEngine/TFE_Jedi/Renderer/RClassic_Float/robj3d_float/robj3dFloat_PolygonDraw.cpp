@@ -9,6 +9,7 @@
 #include "robj3dFloat_TransformAndLighting.h"
 #include "robj3dFloat_PolygonSetup.h"
 #include "robj3dFloat_Clipping.h"
+#include "robj3dFloat_Culling.h"
 #include "../fixedPoint20.h"
 #include "../rsectorFloat.h"
 #include "../rflatFloat.h"
@@ -30,70 +31,70 @@ namespace RClassic_Float
 	// Polygon Drawing
 	////////////////////////////////////////////////
 	// Polygon
-	static u8  s_polyColorIndex;
-	static s32 s_polyVertexCount;
-	static s32 s_polyMaxIndex;
-	static f32* s_polyIntensity;
-	static vec2_float* s_polyUv;
-	static vec3_float* s_polyProjVtx;
-	static const u8*   s_polyColorMap;
-	static TextureData* s_polyTexture;
+	static thread_local u8  s_polyColorIndex;
+	static thread_local s32 s_polyVertexCount;
+	static thread_local s32 s_polyMaxIndex;
+	static thread_local f32* s_polyIntensity;
+	static thread_local vec2_float* s_polyUv;
+	static thread_local vec3_float* s_polyProjVtx;
+	static thread_local const u8*   s_polyColorMap;
+	static thread_local TextureData* s_polyTexture;
 
 	// Column
-	static s32 s_columnX;
-	static s32 s_rowY;
-	static s32 s_columnHeight;
-	static s32 s_dither;
-	static u8* s_pcolumnOut;
+	static thread_local s32 s_columnX;
+	static thread_local s32 s_rowY;
+	static thread_local s32 s_columnHeight;
+	static thread_local s32 s_dither;
+	static thread_local u8* s_pcolumnOut;
 		
-	static fixed44_20 s_col_I0;
-	static fixed44_20 s_col_dIdY;
-	static vec2_fixed20 s_col_Uv0;
-	static vec2_fixed20 s_col_dUVdY;
+	static thread_local fixed44_20 s_col_I0;
+	static thread_local fixed44_20 s_col_dIdY;
+	static thread_local vec2_fixed20 s_col_Uv0;
+	static thread_local vec2_fixed20 s_col_dUVdY;
 
 	// Polygon Edges
-	static fixed44_20  s_ditherOffset;
+	static thread_local fixed44_20  s_ditherOffset;
 	// Bottom Edge
-	static f32  s_edgeBot_Z0;
-	static f32  s_edgeBot_dZdX;
-	static f32  s_edgeBot_dIdX;
-	static f32  s_edgeBot_I0;
-	static vec2_float  s_edgeBot_dUVdX;
-	static vec2_float  s_edgeBot_Uv0;
-	static f32  s_edgeBot_dYdX;
-	static f32  s_edgeBot_Y0;
+	static thread_local f32  s_edgeBot_Z0;
+	static thread_local f32  s_edgeBot_dZdX;
+	static thread_local f32  s_edgeBot_dIdX;
+	static thread_local f32  s_edgeBot_I0;
+	static thread_local vec2_float  s_edgeBot_dUVdX;
+	static thread_local vec2_float  s_edgeBot_Uv0;
+	static thread_local f32  s_edgeBot_dYdX;
+	static thread_local f32  s_edgeBot_Y0;
 	// Top Edge
-	static f32  s_edgeTop_dIdX;
-	static vec2_float  s_edgeTop_dUVdX;
-	static vec2_float  s_edgeTop_Uv0;
-	static f32  s_edgeTop_dYdX;
-	static f32  s_edgeTop_Z0;
-	static f32  s_edgeTop_Y0;
-	static f32  s_edgeTop_dZdX;
-	static f32  s_edgeTop_I0;
+	static thread_local f32  s_edgeTop_dIdX;
+	static thread_local vec2_float  s_edgeTop_dUVdX;
+	static thread_local vec2_float  s_edgeTop_Uv0;
+	static thread_local f32  s_edgeTop_dYdX;
+	static thread_local f32  s_edgeTop_Z0;
+	static thread_local f32  s_edgeTop_Y0;
+	static thread_local f32  s_edgeTop_dZdX;
+	static thread_local f32  s_edgeTop_I0;
 	// Left Edge
-	static f32  s_edgeLeft_X0;
-	static f32  s_edgeLeft_Z0;
-	static f32  s_edgeLeft_dXdY;
-	static f32  s_edgeLeft_dZmdY;
+	static thread_local f32  s_edgeLeft_X0;
+	static thread_local f32  s_edgeLeft_Z0;
+	static thread_local f32  s_edgeLeft_dXdY;
+	static thread_local f32  s_edgeLeft_dZmdY;
 	// Right Edge
-	static f32  s_edgeRight_X0;
-	static f32  s_edgeRight_Z0;
-	static f32  s_edgeRight_dXdY;
-	static f32  s_edgeRight_dZmdY;
+	static thread_local f32  s_edgeRight_X0;
+	static thread_local f32  s_edgeRight_Z0;
+	static thread_local f32  s_edgeRight_dXdY;
+	static thread_local f32  s_edgeRight_dZmdY;
 	// Edge Pixels & Indices
-	static s32 s_edgeBotY0_Pixel;
-	static s32 s_edgeTopY0_Pixel;
-	static s32 s_edgeLeft_X0_Pixel;
-	static s32 s_edgeRight_X0_Pixel;
-	static s32 s_edgeBotIndex;
-	static s32 s_edgeTopIndex;
-	static s32 s_edgeLeftIndex;
-	static s32 s_edgeRightIndex;
-	static s32 s_edgeTopLength;
-	static s32 s_edgeBotLength;
-	static s32 s_edgeLeftLength;
-	static s32 s_edgeRightLength;
+	static thread_local s32 s_edgeBotY0_Pixel;
+	static thread_local s32 s_edgeTopY0_Pixel;
+	static thread_local s32 s_edgeLeft_X0_Pixel;
+	static thread_local s32 s_edgeRight_X0_Pixel;
+	static thread_local s32 s_edgeBotIndex;
+	static thread_local s32 s_edgeTopIndex;
+	static thread_local s32 s_edgeLeftIndex;
+	static thread_local s32 s_edgeRightIndex;
+	static thread_local s32 s_edgeTopLength;
+	static thread_local s32 s_edgeBotLength;
+	static thread_local s32 s_edgeLeftLength;
+	static thread_local s32 s_edgeRightLength;
 
 	u8 robj3d_computePolygonColor(vec3_float* normal, u8 color, f32 z)
 	{
@@ -358,7 +359,7 @@ namespace RClassic_Float
 			return;
 		}
 
-		f32 heightOffset = planeY - s_rcfltState.eyeHeight;
+		f32 heightOffset = planeY - s_rcfltState->eyeHeight;
 		// TODO: Figure out why s_heightInPixels has the wrong sign here.
 		if (yMax <= s_screenYMidFlt)
 		{
@@ -417,7 +418,7 @@ namespace RClassic_Float
 				u8 color = polygon->color;
 				if (s_enableFlatShading)
 				{
-					color = robj3d_computePolygonColor(&s_polygonNormalsVS[polygon->index], color, polygon->zAvef);
+					color = robj3d_computePolygonColor(&s_polygonNormalsVS[polygon->index], color, s_polygonZAve[polygon->index]);
 				}
 				robj3d_drawFlatColorPolygon(s_polygonVerticesProj, polyVertexCount, color);
 			} break;
@@ -430,7 +431,7 @@ namespace RClassic_Float
 				u8 lightLevel = 0;
 				if (s_enableFlatShading)
 				{
-					lightLevel = robj3d_computePolygonLightLevel(&s_polygonNormalsVS[polygon->index], polygon->zAvef);
+					lightLevel = robj3d_computePolygonLightLevel(&s_polygonNormalsVS[polygon->index], s_polygonZAve[polygon->index]);
 				}
 				robj3d_drawFlatTexturePolygon(s_polygonVerticesProj, s_polygonUv, polyVertexCount, polygon->texture, lightLevel);
 			} break;
@@ -20,16 +20,16 @@ namespace RClassic_Float
 	// Vertex Processing
 	/////////////////////////////////////////////
 	// Vertex attributes transformed to viewspace.
-	std::vector<vec3_float> s_verticesVS;
-	std::vector<vec3_float> s_vertexNormalsVS;
+	thread_local std::vector<vec3_float> s_verticesVS;
+	thread_local std::vector<vec3_float> s_vertexNormalsVS;
 	// Vertex Lighting.
-	std::vector<f32> s_vertexIntensity;
+	thread_local std::vector<f32> s_vertexIntensity;
 
 	/////////////////////////////////////////////
 	// Polygon Processing
 	/////////////////////////////////////////////
 	// Polygon normals in viewspace (used for culling).
-	std::vector<vec3_float> s_polygonNormalsVS;
+	thread_local std::vector<vec3_float> s_polygonNormalsVS;
 			
 	void robj3d_transformVertices(s32 vertexCount, vec3_fixed* vtxIn, f32* xform, vec3_float* offset, vec3_float* vtxOut)
 	{
@@ -156,20 +156,20 @@ namespace RClassic_Float
 	void robj3d_transformAndLight(SecObject* obj, JediModel* model)
 	{
 		vec3_float offsetWS;
-		offsetWS.x = fixed16ToFloat(obj->posWS.x) - s_rcfltState.cameraPos.x;
-		offsetWS.y = fixed16ToFloat(obj->posWS.y) - s_rcfltState.eyeHeight;
-		offsetWS.z = fixed16ToFloat(obj->posWS.z) - s_rcfltState.cameraPos.z;
+		offsetWS.x = fixed16ToFloat(obj->posWS.x) - s_rcfltState->cameraPos.x;
+		offsetWS.y = fixed16ToFloat(obj->posWS.y) - s_rcfltState->eyeHeight;
+		offsetWS.z = fixed16ToFloat(obj->posWS.z) - s_rcfltState->cameraPos.z;
 
 		// Allocate buffers.
 		robj3d_allocateBuffers(model);
 
 		// Calculate the view space object camera offset.
 		vec3_float offsetVS;
-		rotateVectorM3x3(&offsetWS, &offsetVS, s_rcfltState.cameraMtx);
+		rotateVectorM3x3(&offsetWS, &offsetVS, s_rcfltState->cameraMtx);
 
 		// Concatenate the camera and object rotation matrices.
 		f32 xform[9];
-		robj3d_mulMatrix3x3(s_rcfltState.cameraMtx, obj->transform, xform);
+		robj3d_mulMatrix3x3(s_rcfltState->cameraMtx, obj->transform, xform);
 
 		// Transform model vertices into view space.
 		robj3d_transformVertices(model->vertexCount, (vec3_fixed*)model->vertices, xform, &offsetVS, s_verticesVS.data());
@@ -0,0 +1,397 @@
+#include <TFE_System/simd.h>
+#include "rrasterFloat.h"
+
+namespace TFE_Jedi
+{
+
+namespace RClassic_Float
+{
+	static const RasterKernels c_scalarKernels = { "Scalar", nullptr, nullptr, nullptr, nullptr };
+	RasterKernels s_rasterKernels = c_scalarKernels;
+
+	/////////////////////////////////////////////////
+	// Shared scalar helpers
+	/////////////////////////////////////////////////
+	// Equivalent to floor20(v) & mask for masks up to RASTER_COLUMN_MAX_MASK.
+	static inline u32 raster_columnTexel(u32 v, u32 mask)
+	{
+		return (v >> 20u) & mask;
+	}
+
+	// Equivalent to ((floor20(U) & 63) * 64 + (floor20(V) & 63)) & dataEnd.
+	static inline u32 raster_scanlineTexel(u32 u, u32 v, u32 dataEnd)
+	{
+		return ((((u >> 20u) & 63u) << 6u) | ((v >> 20u) & 63u)) & dataEnd;
+	}
+
+	// Handles the pixels left over after the last full batch, 'v' is the coordinate of the first remaining pixel.
+	static void raster_columnTail(const RasterColumn* col, u8* dst, s32 count, u32 v, bool trans)
+	{
+		const u32 dv = u32(col->dv);
+		const u32 mask = u32(col->heightMask);
+		for (s32 i = 0; i < count; i++, dst -= col->stride, v += dv)
+		{
+			const u8 c = col->tex[raster_columnTexel(v, mask)];
+			if (!trans || c) { *dst = col->light ? col->light[c] : c; }
+		}
+	}
+
+	// Draws pixels [x0, x1), where 'u' and 'v' are the coordinates of pixel x0.
+	// Coordinates decrease moving right since the reference loop steps from right to left.
+	static void raster_scanlineTail(const RasterScanline* scan, s32 x0, s32 x1, u32 u, u32 v, bool trans)
+	{
+		const u32 du = u32(scan->du);
+		const u32 dv = u32(scan->dv);
+		const u32 dataEnd = u32(scan->dataEnd);
+		for (s32 x = x0; x < x1; x++, u -= du, v -= dv)
+		{
+			const u8 c = scan->tex[raster_scanlineTexel(u, v, dataEnd)];
+			if (!trans || c) { scan->out[x] = scan->light ? scan->light[c] : c; }
+		}
+	}
+
+	static inline void raster_writeColumn(u8*& dst, s32 stride, const u8* texels, const u8* light, s32 count, bool trans)
+	{
+		for (s32 i = 0; i < count; i++, dst -= stride)
+		{
+			const u8 c = texels[i];
+			if (!trans || c) { *dst = light ? light[c] : c; }
+		}
+	}
+
+	/////////////////////////////////////////////////
+	// SSE2
+	// SSE2 has no gather, so only the texel addresses
+	// are computed in vector registers.
+	/////////////////////////////////////////////////
+#ifdef TFE_SIMD_SSE2
+	static void raster_column_SSE2(const RasterColumn* col, bool trans)
+	{
+		const u32 dv = u32(col->dv);
+		const __m128i mask = _mm_set1_epi32(col->heightMask);
+		const __m128i step = _mm_set1_epi32(s32(dv * 8u));
+		__m128i v0 = _mm_add_epi32(_mm_set1_epi32(s32(col->v)), _mm_setr_epi32(0, s32(dv), s32(dv * 2u), s32(dv * 3u)));
+		__m128i v1 = _mm_add_epi32(v0, _mm_set1_epi32(s32(dv * 4u)));
+
+		s32 index[8];
+		u8 texels[8];
+		u8* dst = col->out + (col->count - 1) * col->stride;
+		s32 i = 0;
+		for (; i + 8 <= col->count; i += 8)
+		{
+			_mm_storeu_si128((__m128i*)&index[0], _mm_and_si128(_mm_srli_epi32(v0, 20), mask));
+			_mm_storeu_si128((__m128i*)&index[4], _mm_and_si128(_mm_srli_epi32(v1, 20), mask));
+			for (s32 t = 0; t < 8; t++) { texels[t] = col->tex[index[t]]; }
+			raster_writeColumn(dst, col->stride, texels, col->light, 8, trans);
+
+			v0 = _mm_add_epi32(v0, step);
+			v1 = _mm_add_epi32(v1, step);
+		}
+		raster_columnTail(col, dst, col->count - i, u32(col->v) + u32(i) * dv, trans);
+	}
+
+	static void raster_scanline_SSE2(const RasterScanline* scan, bool trans)
+	{
+		const u32 du = u32(scan->du);
+		const u32 dv = u32(scan->dv);
+		const __m128i laneU = _mm_setr_epi32(0, s32(du), s32(du * 2u), s32(du * 3u));
+		const __m128i laneV = _mm_setr_epi32(0, s32(dv), s32(dv * 2u), s32(dv * 3u));
+		const __m128i mask63 = _mm_set1_epi32(63);
+		const __m128i dataEnd = _mm_set1_epi32(scan->dataEnd);
+
+		// Pixel 0 is the last pixel stepped by the reference loop.
+		u32 u = u32(scan->u) + u32(scan->width - 1) * du;
+		u32 v = u32(scan->v) + u32(scan->width - 1) * dv;
+
+		s32 index[16];
+		u8 texels[16];
+		u8 colors[16];
+		s32 x = 0;
+		for (; x + 16 <= scan->width; x += 16, u -= du * 16u, v -= dv * 16u)
+		{
+			for (s32 q = 0; q < 4; q++)
+			{
+				const __m128i uq = _mm_sub_epi32(_mm_set1_epi32(s32(u - u32(q * 4) * du)), laneU);
+				const __m128i vq = _mm_sub_epi32(_mm_set1_epi32(s32(v - u32(q * 4) * dv)), laneV);
+				const __m128i texel = _mm_or_si128(_mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(uq, 20), mask63), 6),
+				                                   _mm_and_si128(_mm_srli_epi32(vq, 20), mask63));
+				_mm_storeu_si128((__m128i*)&index[q * 4], _mm_and_si128(texel, dataEnd));
+			}
+			for (s32 t = 0; t < 16; t++) { texels[t] = scan->tex[index[t]]; }
+
+			const __m128i c = _mm_loadu_si128((const __m128i*)texels);
+			__m128i result = c;
+			if (scan->light)
+			{
+				for (s32 t = 0; t < 16; t++) { colors[t] = scan->light[texels[t]]; }
+				result = _mm_loadu_si128((const __m128i*)colors);
+			}
+			if (trans)
+			{
+				const __m128i keep = _mm_cmpeq_epi8(c, _mm_setzero_si128());
+				const __m128i prev = _mm_loadu_si128((const __m128i*)&scan->out[x]);
+				result = _mm_or_si128(_mm_and_si128(keep, prev), _mm_andnot_si128(keep, result));
+			}
+			_mm_storeu_si128((__m128i*)&scan->out[x], result);
+		}
+		raster_scanlineTail(scan, x, scan->width, u, v, trans);
+	}
+
+	static void raster_column_SSE2_Opaque(const RasterColumn* col) { raster_column_SSE2(col, false); }
+	static void raster_column_SSE2_Trans(const RasterColumn* col)  { raster_column_SSE2(col, true);  }
+	static void raster_scanline_SSE2_Opaque(const RasterScanline* scan) { raster_scanline_SSE2(scan, false); }
+	static void raster_scanline_SSE2_Trans(const RasterScanline* scan)  { raster_scanline_SSE2(scan, true);  }
+
+	static const RasterKernels c_sse2Kernels =
+	{
+		"SSE2",
+		raster_column_SSE2_Opaque,
+		raster_column_SSE2_Trans,
+		raster_scanline_SSE2_Opaque,
+		raster_scanline_SSE2_Trans,
+	};
+#endif
+
+	/////////////////////////////////////////////////
+	// AVX2
+	// Uses hardware gathers for both texels and the
+	// light table.
+	/////////////////////////////////////////////////
+#ifdef TFE_SIMD_AVX2
+	// Gather 8 bytes, base[index[i]], zero-extended to 32 bits.
+	// Gathers read aligned dwords containing the requested byte so reads never cross into the next page.
+	TFE_TARGET_AVX2 static inline __m256i raster_gatherBytes_AVX2(const u8* base, __m256i index)
+	{
+		const s32 misalign = s32(uintptr_t(base) & 3);
+		const int* aligned = (const int*)(base - misalign);
+		const __m256i addr  = _mm256_add_epi32(index, _mm256_set1_epi32(misalign));
+		const __m256i dword = _mm256_i32gather_epi32(aligned, _mm256_srli_epi32(addr, 2), 4);
+		const __m256i shift = _mm256_slli_epi32(_mm256_and_si256(addr, _mm256_set1_epi32(3)), 3);
+		return _mm256_and_si256(_mm256_srlv_epi32(dword, shift), _mm256_set1_epi32(0xff));
+	}
+
+	// Pack two sets of 8 32-bit values (0 - 255) into 16 bytes, keeping order.
+	TFE_TARGET_AVX2 static inline __m128i raster_packBytes_AVX2(__m256i a, __m256i b)
+	{
+		const __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+		return _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+	}
+
+	TFE_TARGET_AVX2 static inline __m256i raster_scanlineIndex_AVX2(__m256i u, __m256i v, __m256i dataEnd)
+	{
+		const __m256i mask63 = _mm256_set1_epi32(63);
+		const __m256i texel = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(u, 20), mask63), 6),
+		                                      _mm256_and_si256(_mm256_srli_epi32(v, 20), mask63));
+		return _mm256_and_si256(texel, dataEnd);
+	}
+
+	TFE_TARGET_AVX2 static void raster_column_AVX2(const RasterColumn* col, bool trans)
+	{
+		const u32 dv = u32(col->dv);
+		const __m256i mask = _mm256_set1_epi32(col->heightMask);
+		const __m256i step = _mm256_set1_epi32(s32(dv * 8u));
+		const __m256i lane = _mm256_mullo_epi32(_mm256_set1_epi32(s32(dv)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+		__m256i v = _mm256_add_epi32(_mm256_set1_epi32(s32(col->v)), lane);
+
+		s32 texels[8];
+		s32 colors[8];
+		u8* dst = col->out + (col->count - 1) * col->stride;
+		s32 i = 0;
+		for (; i + 8 <= col->count; i += 8)
+		{
+			const __m256i c = raster_gatherBytes_AVX2(col->tex, _mm256_and_si256(_mm256_srli_epi32(v, 20), mask));
+			const __m256i lit = col->light ? raster_gatherBytes_AVX2(col->light, c) : c;
+			_mm256_storeu_si256((__m256i*)texels, c);
+			_mm256_storeu_si256((__m256i*)colors, lit);
+
+			// Columns are strided, so the stores stay scalar.
+			for (s32 t = 0; t < 8; t++, dst -= col->stride)
+			{
+				if (!trans || texels[t]) { *dst = u8(colors[t]); }
+			}
+			v = _mm256_add_epi32(v, step);
+		}
+		raster_columnTail(col, dst, col->count - i, u32(col->v) + u32(i) * dv, trans);
+	}
+
+	TFE_TARGET_AVX2 static void raster_scanline_AVX2(const RasterScanline* scan, bool trans)
+	{
+		const u32 du = u32(scan->du);
+		const u32 dv = u32(scan->dv);
+		const __m256i lane0 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i lane1 = _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15);
+		const __m256i laneU0 = _mm256_mullo_epi32(_mm256_set1_epi32(s32(du)), lane0);
+		const __m256i laneU1 = _mm256_mullo_epi32(_mm256_set1_epi32(s32(du)), lane1);
+		const __m256i laneV0 = _mm256_mullo_epi32(_mm256_set1_epi32(s32(dv)), lane0);
+		const __m256i laneV1 = _mm256_mullo_epi32(_mm256_set1_epi32(s32(dv)), lane1);
+		const __m256i dataEnd = _mm256_set1_epi32(scan->dataEnd);
+
+		// Pixel 0 is the last pixel stepped by the reference loop.
+		u32 u = u32(scan->u) + u32(scan->width - 1) * du;
+		u32 v = u32(scan->v) + u32(scan->width - 1) * dv;
+
+		s32 x = 0;
+		for (; x + 16 <= scan->width; x += 16, u -= du * 16u, v -= dv * 16u)
+		{
+			const __m256i ub = _mm256_set1_epi32(s32(u));
+			const __m256i vb = _mm256_set1_epi32(s32(v));
+			const __m256i index0 = raster_scanlineIndex_AVX2(_mm256_sub_epi32(ub, laneU0), _mm256_sub_epi32(vb, laneV0), dataEnd);
+			const __m256i index1 = raster_scanlineIndex_AVX2(_mm256_sub_epi32(ub, laneU1), _mm256_sub_epi32(vb, laneV1), dataEnd);
+			const __m256i c0 = raster_gatherBytes_AVX2(scan->tex, index0);
+			const __m256i c1 = raster_gatherBytes_AVX2(scan->tex, index1);
+
+			const __m128i c = raster_packBytes_AVX2(c0, c1);
+			__m128i result = c;
+			if (scan->light)
+			{
+				result = raster_packBytes_AVX2(raster_gatherBytes_AVX2(scan->light, c0), raster_gatherBytes_AVX2(scan->light, c1));
+			}
+			if (trans)
+			{
+				const __m128i keep = _mm_cmpeq_epi8(c, _mm_setzero_si128());
+				result = _mm_blendv_epi8(result, _mm_loadu_si128((const __m128i*)&scan->out[x]), keep);
+			}
+			_mm_storeu_si128((__m128i*)&scan->out[x], result);
+		}
+		raster_scanlineTail(scan, x, scan->width, u, v, trans);
+	}
+
+	static void raster_column_AVX2_Opaque(const RasterColumn* col) { raster_column_AVX2(col, false); }
+	static void raster_column_AVX2_Trans(const RasterColumn* col)  { raster_column_AVX2(col, true);  }
+	static void raster_scanline_AVX2_Opaque(const RasterScanline* scan) { raster_scanline_AVX2(scan, false); }
+	static void raster_scanline_AVX2_Trans(const RasterScanline* scan)  { raster_scanline_AVX2(scan, true);  }
+
+	static const RasterKernels c_avx2Kernels =
+	{
+		"AVX2",
+		raster_column_AVX2_Opaque,
+		raster_column_AVX2_Trans,
+		raster_scanline_AVX2_Opaque,
+		raster_scanline_AVX2_Trans,
+	};
+#endif
+
+	/////////////////////////////////////////////////
+	// NEON
+	/////////////////////////////////////////////////
+#ifdef TFE_SIMD_NEON
+	static void raster_column_NEON(const RasterColumn* col, bool trans)
+	{
+		const u32 dv = u32(col->dv);
+		const u32 laneOffsets[4] = { 0, dv, dv * 2u, dv * 3u };
+		const uint32x4_t mask = vdupq_n_u32(u32(col->heightMask));
+		const uint32x4_t step = vdupq_n_u32(dv * 8u);
+		uint32x4_t v0 = vaddq_u32(vdupq_n_u32(u32(col->v)), vld1q_u32(laneOffsets));
+		uint32x4_t v1 = vaddq_u32(v0, vdupq_n_u32(dv * 4u));
+
+		u32 index[8];
+		u8 texels[8];
+		u8* dst = col->out + (col->count - 1) * col->stride;
+		s32 i = 0;
+		for (; i + 8 <= col->count; i += 8)
+		{
+			vst1q_u32(&index[0], vandq_u32(vshrq_n_u32(v0, 20), mask));
+			vst1q_u32(&index[4], vandq_u32(vshrq_n_u32(v1, 20), mask));
+			for (s32 t = 0; t < 8; t++) { texels[t] = col->tex[index[t]]; }
+			raster_writeColumn(dst, col->stride, texels, col->light, 8, trans);
+
+			v0 = vaddq_u32(v0, step);
+			v1 = vaddq_u32(v1, step);
+		}
+		raster_columnTail(col, dst, col->count - i, u32(col->v) + u32(i) * dv, trans);
+	}
+
+	static void raster_scanline_NEON(const RasterScanline* scan, bool trans)
+	{
+		const u32 du = u32(scan->du);
+		const u32 dv = u32(scan->dv);
+		const u32 laneOffsetsU[4] = { 0, du, du * 2u, du * 3u };
+		const u32 laneOffsetsV[4] = { 0, dv, dv * 2u, dv * 3u };
+		const uint32x4_t laneU = vld1q_u32(laneOffsetsU);
+		const uint32x4_t laneV = vld1q_u32(laneOffsetsV);
+		const uint32x4_t mask63 = vdupq_n_u32(63);
+		const uint32x4_t dataEnd = vdupq_n_u32(u32(scan->dataEnd));
+
+		// Pixel 0 is the last pixel stepped by the reference loop.
+		u32 u = u32(scan->u) + u32(scan->width - 1) * du;
+		u32 v = u32(scan->v) + u32(scan->width - 1) * dv;
+
+		u32 index[16];
+		u8 texels[16];
+		u8 colors[16];
+		s32 x = 0;
+		for (; x + 16 <= scan->width; x += 16, u -= du * 16u, v -= dv * 16u)
+		{
+			for (s32 q = 0; q < 4; q++)
+			{
+				const uint32x4_t uq = vsubq_u32(vdupq_n_u32(u - u32(q * 4) * du), laneU);
+				const uint32x4_t vq = vsubq_u32(vdupq_n_u32(v - u32(q * 4) * dv), laneV);
+				const uint32x4_t texel = vorrq_u32(vshlq_n_u32(vandq_u32(vshrq_n_u32(uq, 20), mask63), 6),
+				                                   vandq_u32(vshrq_n_u32(vq, 20), mask63));
+				vst1q_u32(&index[q * 4], vandq_u32(texel, dataEnd));
+			}
+			for (s32 t = 0; t < 16; t++) { texels[t] = scan->tex[index[t]]; }
+
+			const uint8x16_t c = vld1q_u8(texels);
+			uint8x16_t result = c;
+			if (scan->light)
+			{
+				for (s32 t = 0; t < 16; t++) { colors[t] = scan->light[texels[t]]; }
+				result = vld1q_u8(colors);
+			}
+			if (trans)
+			{
+				const uint8x16_t keep = vceqq_u8(c, vdupq_n_u8(0));
+				result = vbslq_u8(keep, vld1q_u8(&scan->out[x]), result);
+			}
+			vst1q_u8(&scan->out[x], result);
+		}
+		raster_scanlineTail(scan, x, scan->width, u, v, trans);
+	}
+
+	static void raster_column_NEON_Opaque(const RasterColumn* col) { raster_column_NEON(col, false); }
+	static void raster_column_NEON_Trans(const RasterColumn* col)  { raster_column_NEON(col, true);  }
+	static void raster_scanline_NEON_Opaque(const RasterScanline* scan) { raster_scanline_NEON(scan, false); }
+	static void raster_scanline_NEON_Trans(const RasterScanline* scan)  { raster_scanline_NEON(scan, true);  }
+
+	static const RasterKernels c_neonKernels =
+	{
+		"NEON",
+		raster_column_NEON_Opaque,
+		raster_column_NEON_Trans,
+		raster_scanline_NEON_Opaque,
+		raster_scanline_NEON_Trans,
+	};
+#endif
+
+	/////////////////////////////////////////////////
+	// API
+	/////////////////////////////////////////////////
+	void raster_selectKernels()
+	{
+		s_rasterKernels = c_scalarKernels;
+	#ifdef TFE_SIMD_AVX2
+		if (TFE_Simd::hasFeature(SIMD_AVX2))
+		{
+			s_rasterKernels = c_avx2Kernels;
+			return;
+		}
+	#endif
+	#ifdef TFE_SIMD_SSE2
+		if (TFE_Simd::hasFeature(SIMD_SSE2))
+		{
+			s_rasterKernels = c_sse2Kernels;
+			return;
+		}
+	#endif
+	#ifdef TFE_SIMD_NEON
+		if (TFE_Simd::hasFeature(SIMD_NEON))
+		{
+			s_rasterKernels = c_neonKernels;
+			return;
+		}
+	#endif
+	}
+}  // RClassic_Float
+
+}  // TFE_Jedi
@@ -0,0 +1,70 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Raster
+// Batched (SIMD) versions of the column and scanline inner loops
+// used by the floating point sub-renderer.
+//
+// The scalar loops in rwallFloat.cpp and rflatFloat.cpp remain the
+// reference implementation; the kernels here must produce identical
+// output. Texture coordinates are 44.20 fixed point, but only the
+// low 32 bits affect the texel index as long as the mask fits in
+// 12 bits, so the kernels can step coordinates in 32-bit lanes.
+//////////////////////////////////////////////////////////////////////
+#include <TFE_System/types.h>
+#include "fixedPoint20.h"
+
+namespace TFE_Jedi
+{
+	namespace RClassic_Float
+	{
+		enum RasterConstants
+		{
+			// Largest texture height mask supported by the column kernels (see above).
+			RASTER_COLUMN_MAX_MASK = 0xfff,
+		};
+
+		// A vertical column, drawn from the bottom pixel (out + (count - 1) * stride) upward.
+		struct RasterColumn
+		{
+			u8* out;
+			s32 stride;
+			s32 count;
+			const u8* tex;
+			const u8* light;	// nullptr = fullbright.
+			fixed44_20 v;
+			fixed44_20 dv;
+			s32 heightMask;
+		};
+
+		// A horizontal flat scanline, drawn from the right-most pixel (out + width - 1) to the left.
+		struct RasterScanline
+		{
+			u8* out;
+			s32 width;
+			const u8* tex;
+			const u8* light;	// nullptr = fullbright.
+			fixed44_20 u;
+			fixed44_20 v;
+			fixed44_20 du;
+			fixed44_20 dv;
+			s32 dataEnd;
+		};
+
+		typedef void(*RasterColumnFunc)(const RasterColumn* column);
+		typedef void(*RasterScanlineFunc)(const RasterScanline* scanline);
+
+		struct RasterKernels
+		{
+			const char* name;
+			RasterColumnFunc   column;
+			RasterColumnFunc   columnTrans;
+			RasterScanlineFunc scanline;
+			RasterScanlineFunc scanlineTrans;
+		};
+		// Kernels are null if no supported instruction set is available, in which case the scalar loops are used.
+		extern RasterKernels s_rasterKernels;
+
+		// Select the best kernels for the current CPU, called when the renderer is initialized.
+		void raster_selectKernels();
+	}
+}
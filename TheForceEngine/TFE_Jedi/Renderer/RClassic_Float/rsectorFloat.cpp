@@ -1,6 +1,8 @@
+#include <cstddef>
 #include <cstring>
 
 #include <TFE_System/profiler.h>
+#include <TFE_System/parallel.h>
 #include <TFE_Asset/modelAsset_jedi.h>
 #include <TFE_Game/igame.h>
 #include <TFE_Jedi/Level/level.h>
@@ -25,9 +27,26 @@ using namespace TFE_Jedi::RClassic_Float;
 
 namespace TFE_Jedi
 {
+	extern s32 s_drawnObjCount;
+	extern SecObject* s_drawnObj[];
+
 	namespace
 	{
-		static TFE_Sectors_Float* s_ctx = nullptr;
+		enum StripConstants
+		{
+			MAX_RENDER_STRIPS = 32,
+			MIN_STRIP_WIDTH   = 32,	// Narrow strips spend more time traversing sectors than drawing.
+		};
+
+		struct StripBatch
+		{
+			TFE_Sectors_Float* owner;
+			RSector* sector;
+			const RClassicFloatState* view;
+			s32 stripCount;
+		};
+
+		static thread_local TFE_Sectors_Float* s_ctx = nullptr;
 
 		s32 wallSortX(const void* r0, const void* r1)
 		{
@@ -131,10 +150,10 @@ namespace TFE_Jedi
 
 						// Cull against the current "window."
 						const f32 rcpZ = 1.0f / cached->objPosVS[curObj->index].z;
-						const s32 x0 = roundFloat((xMin*s_rcfltState.focalLength)*rcpZ) + s_screenXMid;
+						const s32 x0 = roundFloat((xMin*s_rcfltState->focalLength)*rcpZ) + s_screenXMid;
 						if (x0 > s_windowMaxX_Pixels) { continue; }
 
-						const s32 x1 = roundFloat((xMax*s_rcfltState.focalLength)*rcpZ) + s_screenXMid;
+						const s32 x1 = roundFloat((xMax*s_rcfltState->focalLength)*rcpZ) + s_screenXMid;
 						if (x1 < s_windowMinX_Pixels) { continue; }
 
 						// Finally add the object to render.
@@ -167,8 +186,19 @@ namespace TFE_Jedi
 		}
 	}
 
+	TFE_Sectors_Float::~TFE_Sectors_Float()
+	{
+		destroy();
+		delete m_stripState;
+	}
+
 	void TFE_Sectors_Float::destroy()
 	{
+		for (size_t i = 0; i < m_strips.size(); i++)
+		{
+			delete m_strips[i];
+		}
+		m_strips.clear();
 	}
 
 	void TFE_Sectors_Float::reset()
@@ -181,9 +211,9 @@ namespace TFE_Jedi
 	{
 		allocateCachedData();
 
-		EdgePairFloat* flatEdge = &s_rcfltState.flatEdgeList[s_flatCount];
-		s_rcfltState.flatEdge = flatEdge;
-		flat_addEdges(s_screenWidth, s_minScreenX_Pixels, 0, s_rcfltState.windowMaxY, 0, s_rcfltState.windowMinY);
+		EdgePairFloat* flatEdge = &s_rcfltState->flatEdgeList[s_flatCount];
+		s_rcfltState->flatEdge = flatEdge;
+		flat_addEdges(s_screenWidth, s_minScreenX_Pixels, 0, s_rcfltState->windowMaxY, 0, s_rcfltState->windowMinY);
 
 		light_transformDirLights();
 	}
@@ -194,12 +224,234 @@ namespace TFE_Jedi
 		const f32 y = fixed16ToFloat(worldPoint->y);
 		const f32 z = fixed16ToFloat(worldPoint->z);
 
-		viewPoint->x = x*s_rcfltState.cosYaw + z*s_rcfltState.sinYaw + s_rcfltState.cameraTrans.x;
-		viewPoint->y = y - s_rcfltState.eyeHeight;
-		viewPoint->z = z*s_rcfltState.cosYaw + x*s_rcfltState.negSinYaw + s_rcfltState.cameraTrans.z;
+		viewPoint->x = x*s_rcfltState->cosYaw + z*s_rcfltState->sinYaw + s_rcfltState->cameraTrans.x;
+		viewPoint->y = y - s_rcfltState->eyeHeight;
+		viewPoint->z = z*s_rcfltState->cosYaw + x*s_rcfltState->negSinYaw + s_rcfltState->cameraTrans.z;
 	}
 	
 	void TFE_Sectors_Float::draw(RSector* sector)
+	{
+		// The full screen is a single strip unless drawing in parallel, see drawStrip().
+		s_rcfltState->wallDrawFrame = m_wallDrawFrame.data();
+		s_rcfltState->stripMinX = s_minScreenX_Pixels;
+		s_rcfltState->stripMaxX = s_maxScreenX_Pixels;
+		s_rcfltState->drawnObj = s_drawnObj;
+		s_rcfltState->drawnObjCount = &s_drawnObjCount;
+
+		const s32 stripCount = getStripCount();
+		if (stripCount > 1)
+		{
+			drawStrips(sector, stripCount);
+		}
+		else
+		{
+			drawSector(sector);
+		}
+	}
+
+	s32 TFE_Sectors_Float::getStripCount() const
+	{
+		s32 stripCount = (s_renderThreads > 0) ? s_renderThreads : TFE_Parallel::getHardwareThreadCount();
+		stripCount = min(stripCount, s32(MAX_RENDER_STRIPS));
+		stripCount = min(stripCount, s_screenWidth / MIN_STRIP_WIDTH);
+		return max(stripCount, 1);
+	}
+
+	// TFE: Split the screen into vertical strips that are traversed and drawn independently.
+	// Each strip starts at the root sector with its window limited to the strip, so sectors
+	// visible through several strips are traversed once per strip, but the columns written
+	// never overlap. Each strip gets the full traversal limits (MAX_SEG_EXT, MAX_ADJOIN_DEPTH_EXT).
+	void TFE_Sectors_Float::drawStrips(RSector* sector, s32 stripCount)
+	{
+		// Update the shared sector cache up front, the strips only read from it.
+		TFE_ZONE_BEGIN(secUpdate, "Update Sectors");
+		for (u32 i = 0; i < m_cachedSectorCount; i++)
+		{
+			updateSector(&m_cachedSectors[i]);
+		}
+		TFE_ZONE_END(secUpdate);
+
+		while (s32(m_strips.size()) < stripCount)
+		{
+			TFE_Sectors_Float* strip = new TFE_Sectors_Float();
+			strip->m_isStrip = true;
+			// The state is too large to keep per thread, so each strip owns one.
+			strip->m_stripState = new RClassicFloatState();
+			// The adjoin edge index is limited by the adjoin segment count, rather than the depth.
+			strip->m_adjoinEdgeList.resize(MAX_ADJOIN_SEG_EXT);
+			m_strips.push_back(strip);
+		}
+		for (s32 i = 0; i < stripCount; i++)
+		{
+			TFE_Sectors_Float* strip = m_strips[i];
+			strip->m_cachedSectors = m_cachedSectors;
+			strip->m_cachedSectorCount = m_cachedSectorCount;
+			if (strip->m_sectorState.size() != m_sectorState.size() || strip->m_wallDrawFrame.size() != m_wallDrawFrame.size())
+			{
+				strip->m_sectorState.assign(m_sectorState.size(), SectorDrawState());
+				strip->m_wallDrawFrame.assign(m_wallDrawFrame.size(), 0);
+			}
+		}
+
+		TFE_ZONE_BEGIN(secStrips, "Draw Strips");
+		StripBatch batch = { this, sector, s_rcfltState, stripCount };
+		TFE_Parallel::run(stripCount, drawStripTask, &batch);
+		TFE_ZONE_END(secStrips);
+
+		// Merge the results of each strip.
+		for (u32 s = 0; s < m_cachedSectorCount; s++)
+		{
+			for (s32 i = 0; i < stripCount; i++)
+			{
+				if (m_strips[i]->m_sectorState[s].prevDrawFrame2 == s_drawFrame)
+				{
+					m_cachedSectors[s].sector->flags1 |= SEC_FLAGS1_RENDERED;
+					break;
+				}
+			}
+		}
+
+		s_sectorIndex = 0;
+		s_maxAdjoinIndex = 0;
+		s_maxAdjoinDepth = 0;
+		s_flatCount = 0;
+		s_curWallSeg = 0;
+		s_adjoinSegCount = 0;
+		for (s32 i = 0; i < stripCount; i++)
+		{
+			const TFE_Sectors_Float* strip = m_strips[i];
+			const SectorStripStats* stats = &strip->m_stats;
+			s_sectorIndex += stats->sectorCount;
+			s_maxAdjoinIndex = max(s_maxAdjoinIndex, stats->maxAdjoinIndex);
+			s_maxAdjoinDepth = max(s_maxAdjoinDepth, stats->maxAdjoinDepth);
+			s_flatCount += stats->flatCount;
+			s_curWallSeg += stats->wallSegCount;
+			s_adjoinSegCount += stats->adjoinSegCount;
+
+			// Objects may be drawn by several strips.
+			for (s32 o = 0; o < strip->m_drawnObjCount && s_drawnObjCount < MAX_DRAWN_OBJ_STORE; o++)
+			{
+				SecObject* obj = strip->m_drawnObj[o];
+				s32 d = 0;
+				for (; d < s_drawnObjCount && s_drawnObj[d] != obj; d++);
+				if (d == s_drawnObjCount)
+				{
+					s_drawnObj[s_drawnObjCount++] = obj;
+				}
+			}
+		}
+	}
+
+	void TFE_Sectors_Float::drawStripTask(s32 index, void* userData)
+	{
+		const StripBatch* batch = (const StripBatch*)userData;
+		const s32 x0 = s_minScreenX_Pixels + s_screenWidth * index / batch->stripCount;
+		const s32 x1 = s_minScreenX_Pixels + s_screenWidth * (index + 1) / batch->stripCount - 1;
+		batch->owner->m_strips[index]->drawStrip(batch->sector, batch->view, x0, x1);
+	}
+
+	void TFE_Sectors_Float::drawStrip(RSector* sector, const RClassicFloatState* view, s32 x0, s32 x1)
+	{
+		// Draw using the strip state, which copies the view from the main thread.
+		RClassicFloatState* prevState = s_rcfltState;
+		s_rcfltState = m_stripState;
+		memcpy(s_rcfltState, view, offsetof(RClassicFloatState, flatEdge));
+		const s32 windowX0 = s_windowX0;
+		const s32 windowX1 = s_windowX1;
+
+		s_rcfltState->adjoinEdgeList = m_adjoinEdgeList.data();
+		s_rcfltState->wallDrawFrame = m_wallDrawFrame.data();
+		s_rcfltState->stripMinX = x0;
+		s_rcfltState->stripMaxX = x1;
+		s_rcfltState->drawnObj = m_drawnObj;
+		s_rcfltState->drawnObjCount = &m_drawnObjCount;
+		s_rcfltState->windowMinZ = 0.0f;
+		m_drawnObjCount = 0;
+
+		// Start the same way as drawWorld(), but limited to the strip.
+		s_windowMinX_Pixels = x0;
+		s_windowMaxX_Pixels = x1;
+		s_windowMinY_Pixels = 1;
+		s_windowMaxY_Pixels = s_height - 1;
+		s_windowMaxCeil  = s_minScreenY;
+		s_windowMinFloor = s_maxScreenY;
+		s_windowX0 = x0;
+		s_windowX1 = x1;
+		s_flatCount  = 0;
+		s_nextWall   = 0;
+		s_curWallSeg = 0;
+
+		s_prevSector = nullptr;
+		s_sectorIndex = 0;
+		s_maxAdjoinIndex = 0;
+		s_adjoinSegCount = 1;
+		s_adjoinIndex = 0;
+
+		s_adjoinDepth = 1;
+		s_maxAdjoinDepth = 1;
+
+		EdgePairFloat* flatEdge = &s_rcfltState->flatEdgeList[s_flatCount];
+		s_rcfltState->flatEdge = flatEdge;
+		flat_addEdges(x1 - x0 + 1, x0, 0, s_rcfltState->windowMaxY, 0, s_rcfltState->windowMinY);
+
+		drawSector(sector);
+
+		m_stats.sectorCount = s_sectorIndex;
+		m_stats.maxAdjoinIndex = s_maxAdjoinIndex;
+		m_stats.maxAdjoinDepth = s_maxAdjoinDepth;
+		m_stats.flatCount = s_flatCount;
+		m_stats.wallSegCount = s_curWallSeg;
+		m_stats.adjoinSegCount = s_adjoinSegCount;
+
+		s_rcfltState = prevState;
+		s_windowX0 = windowX0;
+		s_windowX1 = windowX1;
+	}
+
+	// Update the cached sector and transform its vertices and objects into view space.
+	void TFE_Sectors_Float::updateSector(SectorCached* cachedSector)
+	{
+		RSector* sector = cachedSector->sector;
+		TFE_ZONE_BEGIN(secUpdateCache, "Update Sector Cache");
+			updateCachedSector(cachedSector, sector->dirtyFlags);
+		TFE_ZONE_END(secUpdateCache);
+
+		TFE_ZONE_BEGIN(secXform, "Sector Vertex Transform");
+			vec2_fixed* vtxWS = sector->verticesWS;
+			vec2_float* vtxVS = cachedSector->verticesVS;
+			for (s32 v = 0; v < sector->vertexCount; v++)
+			{
+				const f32 x = fixed16ToFloat(vtxWS->x);
+				const f32 z = fixed16ToFloat(vtxWS->z);
+
+				vtxVS->x = x*s_rcfltState->cosYaw     + z*s_rcfltState->sinYaw + s_rcfltState->cameraTrans.x;
+				vtxVS->z = x*s_rcfltState->negSinYaw  + z*s_rcfltState->cosYaw + s_rcfltState->cameraTrans.z;
+				vtxVS++;
+				vtxWS++;
+			}
+		TFE_ZONE_END(secXform);
+
+		TFE_ZONE_BEGIN(objXform, "Sector Object Transform");
+			SecObject** obj = sector->objectList;
+			vec3_float* objPosVS = cachedSector->objPosVS;
+			for (s32 i = sector->objectCount - 1; i >= 0; i--, obj++)
+			{
+				SecObject* curObj = *obj;
+				while (!curObj)
+				{
+					obj++;
+					curObj = *obj;
+				}
+
+				if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
+				{
+					transformPointByCameraFixedToFloat(&curObj->posWS, &objPosVS[curObj->index]);
+				}
+			}
+		TFE_ZONE_END(objXform);
+	}
+
+	void TFE_Sectors_Float::drawSector(RSector* sector)
 	{
 		s_ctx = this;
 		s_curSector = sector;
@@ -215,10 +467,11 @@ namespace TFE_Jedi
 		s32* winTopNext = &s_windowTop_all[s_adjoinDepth * s_width];
 		s32* winBotNext = &s_windowBot_all[s_adjoinDepth * s_width];
 
-		s_rcfltState.depth1d = &s_rcfltState.depth1d_all[(s_adjoinDepth - 1) * s_width];
+		s_rcfltState->depth1d = &s_rcfltState->depth1d_all[(s_adjoinDepth - 1) * s_width];
 
-		s32 startWall = s_curSector->startWall;
-		s32 drawWallCount = s_curSector->drawWallCnt;
+		SectorDrawState* drawState = &m_sectorState[s_curSector->index];
+		s32 startWall = drawState->startWall;
+		s32 drawWallCount = drawState->drawWallCnt;
 
 		if (s_flatLighting)
 		{
@@ -236,53 +489,22 @@ namespace TFE_Jedi
 		f32* depthPrev = nullptr;
 		if (s_adjoinDepth > 1)
 		{
-			depthPrev = &s_rcfltState.depth1d_all[(s_adjoinDepth - 2) * s_width];
-			memcpy(&s_rcfltState.depth1d[s_minScreenX_Pixels], &depthPrev[s_minScreenX_Pixels], s_width * 4);
+			depthPrev = &s_rcfltState->depth1d_all[(s_adjoinDepth - 2) * s_width];
+			const s32 x0 = s_rcfltState->stripMinX;
+			memcpy(&s_rcfltState->depth1d[x0], &depthPrev[x0], (s_rcfltState->stripMaxX - x0 + 1) * sizeof(f32));
 		}
 
 		s_wallMaxCeilY  = s_windowMinY_Pixels;
 		s_wallMinFloorY = s_windowMaxY_Pixels;
 		SectorCached* cachedSector = &m_cachedSectors[s_curSector->index];
 
-		if (s_drawFrame != s_curSector->prevDrawFrame)
+		if (s_drawFrame != drawState->prevDrawFrame)
 		{
-			TFE_ZONE_BEGIN(secUpdateCache, "Update Sector Cache");
-				updateCachedSector(cachedSector, s_curSector->dirtyFlags);
-			TFE_ZONE_END(secUpdateCache);
-
-			TFE_ZONE_BEGIN(secXform, "Sector Vertex Transform");
-				vec2_fixed* vtxWS = s_curSector->verticesWS;
-				vec2_float* vtxVS = cachedSector->verticesVS;
-				for (s32 v = 0; v < s_curSector->vertexCount; v++)
-				{
-					const f32 x = fixed16ToFloat(vtxWS->x);
-					const f32 z = fixed16ToFloat(vtxWS->z);
-
-					vtxVS->x = x*s_rcfltState.cosYaw     + z*s_rcfltState.sinYaw + s_rcfltState.cameraTrans.x;
-					vtxVS->z = x*s_rcfltState.negSinYaw  + z*s_rcfltState.cosYaw + s_rcfltState.cameraTrans.z;
-					vtxVS++;
-					vtxWS++;
-				}
-			TFE_ZONE_END(secXform);
-
-			TFE_ZONE_BEGIN(objXform, "Sector Object Transform");
-				SecObject** obj = s_curSector->objectList;
-				vec3_float* objPosVS = cachedSector->objPosVS;
-				for (s32 i = s_curSector->objectCount - 1; i >= 0; i--, obj++)
-				{
-					SecObject* curObj = *obj;
-					while (!curObj)
-					{
-						obj++;
-						curObj = *obj;
-					}
-
-					if (curObj->flags & OBJ_FLAG_NEEDS_TRANSFORM)
-					{
-						transformPointByCameraFixedToFloat(&curObj->posWS, &objPosVS[curObj->index]);
-					}
-				}
-			TFE_ZONE_END(objXform);
+			// Strips are updated up front, see drawStrips().
+			if (!m_isStrip)
+			{
+				updateSector(cachedSector);
+			}
 
 			TFE_ZONE_BEGIN(wallProcess, "Sector Wall Process");
 				startWall = s_nextWall;
@@ -293,13 +515,13 @@ namespace TFE_Jedi
 				}
 				drawWallCount = s_nextWall - startWall;
 
-				s_curSector->startWall = startWall;
-				s_curSector->drawWallCnt = drawWallCount;
-				s_curSector->prevDrawFrame = s_drawFrame;
+				drawState->startWall = startWall;
+				drawState->drawWallCnt = drawWallCount;
+				drawState->prevDrawFrame = s_drawFrame;
 			TFE_ZONE_END(wallProcess);
 		}
 
-		RWallSegmentFloat* wallSegment = &s_rcfltState.wallSegListDst[s_curWallSeg];
+		RWallSegmentFloat* wallSegment = &s_rcfltState->wallSegListDst[s_curWallSeg];
 		s32 drawSegCnt = wall_mergeSort(wallSegment, s_maxSegCount - s_curWallSeg, startWall, drawWallCount);
 		s_curWallSeg += drawSegCnt;
 
@@ -308,15 +530,15 @@ namespace TFE_Jedi
 		TFE_ZONE_END(wallQSort);
 
 		s32 flatCount = s_flatCount;
-		EdgePairFloat* flatEdge = &s_rcfltState.flatEdgeList[s_flatCount];
-		s_rcfltState.flatEdge = flatEdge;
+		EdgePairFloat* flatEdge = &s_rcfltState->flatEdgeList[s_flatCount];
+		s_rcfltState->flatEdge = flatEdge;
 
 		s32 adjoinStart = s_adjoinSegCount;
-		EdgePairFloat* adjoinEdges = &s_rcfltState.adjoinEdgeList[adjoinStart];
+		EdgePairFloat* adjoinEdges = &s_rcfltState->adjoinEdgeList[adjoinStart];
 		RWallSegmentFloat* adjoinList[MAX_ADJOIN_DEPTH_EXT];
 
-		s_rcfltState.adjoinEdge = adjoinEdges;
-		s_rcfltState.adjoinSegment = adjoinList;
+		s_rcfltState->adjoinEdge = adjoinEdges;
+		s_rcfltState->adjoinSegment = adjoinList;
 
 		// Draw each wall segment in the sector.
 		TFE_ZONE_BEGIN(secDrawWalls, "Draw Walls");
@@ -457,7 +679,7 @@ namespace TFE_Jedi
 						s_maxAdjoinDepth = s_adjoinDepth;
 					}
 
-					srcWall->drawFrame = s_drawFrame;
+					s_rcfltState->wallDrawFrame[curAdjoinSeg->srcWall->index] = s_drawFrame;
 					s_windowTop = winTopNext;
 					s_windowBot = winBotNext;
 					if (prevAdjoinSeg != 0)
@@ -475,8 +697,8 @@ namespace TFE_Jedi
 						}
 					}
 
-					s_rcfltState.windowMinZ = min(curAdjoinSeg->z0, curAdjoinSeg->z1);
-					draw(nextSector);
+					s_rcfltState->windowMinZ = min(curAdjoinSeg->z0, curAdjoinSeg->z1);
+					drawSector(nextSector);
 					
 					if (s_adjoinDepth)
 					{
@@ -484,7 +706,7 @@ namespace TFE_Jedi
 						s_adjoinDepth--;
 						restoreValues(index);
 					}
-					srcWall->drawFrame = 0;
+					s_rcfltState->wallDrawFrame[curAdjoinSeg->srcWall->index] = 0;
 					if (srcWall->flags1 & WF1_ADJ_MID_TEX)
 					{
 						TFE_ZONE("Draw Transparent Walls");
@@ -494,9 +716,9 @@ namespace TFE_Jedi
 			}
 		}
 
-		if (!(s_curSector->flags1 & SEC_FLAGS1_SUBSECTOR) && depthPrev && s_drawFrame != s_prevSector->prevDrawFrame2)
+		if (!(s_curSector->flags1 & SEC_FLAGS1_SUBSECTOR) && depthPrev && s_drawFrame != m_sectorState[s_prevSector->index].prevDrawFrame2)
 		{
-			memcpy(&depthPrev[s_windowMinX_Pixels], &s_rcfltState.depth1d[s_windowMinX_Pixels], (s_windowMaxX_Pixels - s_windowMinX_Pixels + 1) * sizeof(f32));
+			memcpy(&depthPrev[s_windowMinX_Pixels], &s_rcfltState->depth1d[s_windowMinX_Pixels], (s_windowMaxX_Pixels - s_windowMinX_Pixels + 1) * sizeof(f32));
 		}
 
 		// Objects
@@ -535,8 +757,8 @@ namespace TFE_Jedi
 				{
 					TFE_ZONE("Draw WAX");
 
-					f32 dx = s_rcfltState.cameraPos.x - fixed16ToFloat(obj->posWS.x);
-					f32 dz = s_rcfltState.cameraPos.z - fixed16ToFloat(obj->posWS.z);
+					f32 dx = s_rcfltState->cameraPos.x - fixed16ToFloat(obj->posWS.x);
+					f32 dz = s_rcfltState->cameraPos.z - fixed16ToFloat(obj->posWS.z);
 					s32 angle = vec2ToAngle(dx, dz);
 
 					sprite_drawWax(angle, obj, &cachedPosVS[obj->index]);
@@ -557,8 +779,12 @@ namespace TFE_Jedi
 		}
 		TFE_ZONE_END(secDrawObjects);
 
-		s_curSector->flags1 |= SEC_FLAGS1_RENDERED;
-		s_curSector->prevDrawFrame2 = s_drawFrame;
+		// Strips are merged in drawStrips().
+		if (!m_isStrip)
+		{
+			s_curSector->flags1 |= SEC_FLAGS1_RENDERED;
+		}
+		drawState->prevDrawFrame2 = s_drawFrame;
 	}
 		
 	void TFE_Sectors_Float::adjoin_setupAdjoinWindow(s32* winBot, s32* winBotNext, s32* winTop, s32* winTopNext, EdgePairFloat* adjoinEdges, s32 adjoinCount)
@@ -567,8 +793,10 @@ namespace TFE_Jedi
 
 		// Note: This is pretty inefficient, especially at higher resolutions.
 		// The column loops below can be adjusted to do the copy only in the required ranges.
-		memcpy(&winTopNext[s_minScreenX_Pixels], &winTop[s_minScreenX_Pixels], s_width * 4);
-		memcpy(&winBotNext[s_minScreenX_Pixels], &winBot[s_minScreenX_Pixels], s_width * 4);
+		const s32 x0 = s_rcfltState->stripMinX;
+		const s32 stripWidth = s_rcfltState->stripMaxX - x0 + 1;
+		memcpy(&winTopNext[x0], &winTop[x0], stripWidth * sizeof(s32));
+		memcpy(&winBotNext[x0], &winBot[x0], stripWidth * sizeof(s32));
 
 		// Loop through each adjoin and setup the column range based on the edge pair and the parent
 		// column range.
@@ -640,7 +868,7 @@ namespace TFE_Jedi
 		SectorSaveValues* dst = &s_sectorStack[index];
 		dst->curSector = s_curSector;
 		dst->prevSector = s_prevSector;
-		dst->depth1d = s_rcfltState.depth1d;
+		dst->depth1d = s_rcfltState->depth1d;
 		dst->windowX0 = s_windowX0;
 		dst->windowX1 = s_windowX1;
 		dst->windowMinY = s_windowMinY_Pixels;
@@ -665,7 +893,7 @@ namespace TFE_Jedi
 		const SectorSaveValues* src = &s_sectorStack[index];
 		s_curSector = src->curSector;
 		s_prevSector = src->prevSector;
-		s_rcfltState.depth1d = (f32*)src->depth1d;
+		s_rcfltState->depth1d = (f32*)src->depth1d;
 		s_windowX0 = src->windowX0;
 		s_windowX1 = src->windowX1;
 		s_windowMinY_Pixels = src->windowMinY;
@@ -712,6 +940,7 @@ namespace TFE_Jedi
 			{
 				wcached->wall = srcWall;
 				wcached->sector = cached;
+				wcached->index = cached->wallIndex + w;
 				wcached->v0 = &cached->verticesVS[PTR_OFFSET(srcWall->v0, srcSector->verticesVS) / sizeof(vec2_fixed)];
 				wcached->v1 = &cached->verticesVS[PTR_OFFSET(srcWall->v1, srcSector->verticesVS) / sizeof(vec2_fixed)];
 			}
@@ -792,11 +1021,23 @@ namespace TFE_Jedi
 			m_cachedSectors = (SectorCached*)level_alloc(sizeof(SectorCached) * m_cachedSectorCount);
 			memset(m_cachedSectors, 0, sizeof(SectorCached) * m_cachedSectorCount);
 
+			m_wallCount = 0;
 			for (u32 i = 0; i < m_cachedSectorCount; i++)
 			{
 				m_cachedSectors[i].sector = &s_levelState.sectors[i];
+				m_cachedSectors[i].wallIndex = m_wallCount;
+				m_wallCount += s_levelState.sectors[i].wallCount;
 				updateCachedSector(&m_cachedSectors[i], SDF_ALL);
 			}
+
+			m_sectorState.assign(m_cachedSectorCount, SectorDrawState());
+			m_wallDrawFrame.assign(m_wallCount, 0);
+			// The strips pick up the new sizes the next time they are drawn.
+			for (size_t i = 0; i < m_strips.size(); i++)
+			{
+				m_strips[i]->m_sectorState.clear();
+				m_strips[i]->m_wallDrawFrame.clear();
+			}
 		}
 	}
 
@@ -6,8 +6,10 @@
 #include <TFE_System/memoryPool.h>
 #include <TFE_Jedi/Math/fixedPoint.h>
 #include <TFE_Jedi/Math/core_math.h>
+#include <vector>
 #include "rwallFloat.h"
 #include "rflatFloat.h"
+#include "../redgePair.h"
 #include "../rsectorRender.h"
 
 struct RWall;
@@ -15,10 +17,13 @@ struct SecObject;
 
 namespace TFE_Jedi
 {
+	struct RClassicFloatState;
+
 	struct SectorCached
 	{
 		RSector* sector;		// base sector.
 		WallCached* cachedWalls;
+		s32 wallIndex;			// index of the first wall in the level, used for per-wall render state.
 		s32 objectCapacity;
 		// Floating point version of view space vertices.
 		vec2_float* verticesVS;
@@ -32,10 +37,32 @@ namespace TFE_Jedi
 		vec2_float ceilOffset;
 	};
 
+	// TFE: Per-frame traversal state, this used to live in RSector but is kept by each sector renderer
+	// so that several screen strips can traverse the same sectors at the same time.
+	struct SectorDrawState
+	{
+		s32 prevDrawFrame;		// previous frame that this sector was drawn/updated.
+		s32 prevDrawFrame2;		// previous frame that this sector was fully drawn.
+		s32 startWall;			// wall segment start index for rendering
+		s32 drawWallCnt;		// wall segment draw count for rendering
+	};
+
+	// Traversal results of a single screen strip, merged into the global counters once all strips are done.
+	struct SectorStripStats
+	{
+		s32 sectorCount;
+		s32 maxAdjoinIndex;
+		s32 maxAdjoinDepth;
+		s32 flatCount;
+		s32 wallSegCount;
+		s32 adjoinSegCount;
+	};
+
 	class TFE_Sectors_Float : public TFE_Sectors
 	{
 	public:
-		TFE_Sectors_Float() : m_cachedSectors(nullptr), m_cachedSectorCount(0) {}
+		TFE_Sectors_Float() : m_cachedSectors(nullptr), m_cachedSectorCount(0), m_wallCount(0), m_isStrip(false), m_stripState(nullptr), m_drawnObjCount(0) {}
+		~TFE_Sectors_Float() override;
 
 		// Sub-Renderer specific
 		void destroy() override;
@@ -45,6 +72,13 @@ namespace TFE_Jedi
 		void subrendererChanged() override;
 
 	private:
+		void drawSector(RSector* sector);
+		void drawStrips(RSector* sector, s32 stripCount);
+		void drawStrip(RSector* sector, const RClassicFloatState* view, s32 x0, s32 x1);
+		static void drawStripTask(s32 index, void* userData);
+		s32  getStripCount() const;
+		void updateSector(SectorCached* cached);
+
 		void saveValues(s32 index);
 		void restoreValues(s32 index);
 		void adjoin_computeWindowBounds(EdgePairFloat* adjoinEdges);
@@ -58,5 +92,19 @@ namespace TFE_Jedi
 	public:
 		SectorCached* m_cachedSectors = nullptr;
 		u32 m_cachedSectorCount = 0;
+
+	private:
+		s32 m_wallCount;
+		std::vector<SectorDrawState> m_sectorState;
+		std::vector<s32> m_wallDrawFrame;
+
+		// Screen strips drawn in parallel (see d_renderThreads), the strips share the cached sectors of their owner.
+		std::vector<TFE_Sectors_Float*> m_strips;
+		bool m_isStrip;
+		RClassicFloatState* m_stripState;
+		std::vector<EdgePairFloat> m_adjoinEdgeList;
+		SecObject* m_drawnObj[MAX_DRAWN_OBJ_STORE];
+		s32 m_drawnObjCount;
+		SectorStripStats m_stats;
 	};
 }  // TFE_Jedi
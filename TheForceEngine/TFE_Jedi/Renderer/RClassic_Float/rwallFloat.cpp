@@ -11,6 +11,7 @@
 #include "rlightingFloat.h"
 #include "rsectorFloat.h"
 #include "redgePairFloat.h"
+#include "rrasterFloat.h"
 #include "rclassicFloatSharedState.h"
 #include "../rcommon.h"
 #include "../jediRenderer.h"
@@ -28,15 +29,15 @@ namespace RClassic_Float
 		BACK = 0,
 	};
 
-	static f32 s_segmentCross;
-	static s32 s_texHeightMask;
-	static s32 s_yPixelCount;
-	static fixed44_20 s_vCoordStep;
-	static fixed44_20 s_vCoordFixed;
-	static const u8* s_columnLight;
-	static u8* s_texImage;
-	static u8* s_columnOut;
-	static u8  s_workBuffer[WAX_DECOMPRESS_SIZE];
+	static thread_local f32 s_segmentCross;
+	static thread_local s32 s_texHeightMask;
+	static thread_local s32 s_yPixelCount;
+	static thread_local fixed44_20 s_vCoordStep;
+	static thread_local fixed44_20 s_vCoordFixed;
+	static thread_local const u8* s_columnLight;
+	static thread_local u8* s_texImage;
+	static thread_local u8* s_columnOut;
+	static thread_local u8  s_workBuffer[WAX_DECOMPRESS_SIZE];
 
 	s32 segmentCrossesLine(f32 ax0, f32 ay0, f32 ax1, f32 ay1, f32 bx0, f32 by0, f32 bx1, f32 by1);
 	f32 solveForZ_Numerator(RWallSegmentFloat* wallSegment);
@@ -91,7 +92,7 @@ namespace RClassic_Float
 	{
 		f32 xz;
 		xz = (x0 * z1) - (z0 * x1);
-		f32 dyx = dz * s_rcfltState.nearPlaneHalfLen - dx;
+		f32 dyx = dz * s_rcfltState->nearPlaneHalfLen - dx;
 		if (dyx != 0.0f)
 		{
 			xz /= dyx;
@@ -125,11 +126,11 @@ namespace RClassic_Float
 			}
 			else if (dx != 0)
 			{
-				s = (-xz * s_rcfltState.nearPlaneHalfLen - x0) / dx;
+				s = (-xz * s_rcfltState->nearPlaneHalfLen - x0) / dx;
 			}
 
 			// Update the x0,y0 coordinate of the segment.
-			x0 = -xz * s_rcfltState.nearPlaneHalfLen;
+			x0 = -xz * s_rcfltState->nearPlaneHalfLen;
 			z0 = xz;
 
 			if (s != 0)
@@ -166,11 +167,11 @@ namespace RClassic_Float
 			}
 			else if (dx != 0)
 			{
-				s = (xz*s_rcfltState.nearPlaneHalfLen - x1) / dx;
+				s = (xz*s_rcfltState->nearPlaneHalfLen - x1) / dx;
 			}
 
 			// Update the x1,y1 coordinate of the segment.
-			x1 = xz * s_rcfltState.nearPlaneHalfLen;
+			x1 = xz * s_rcfltState->nearPlaneHalfLen;
 			z1 = xz;
 			if (s != 0)
 			{
@@ -191,7 +192,7 @@ namespace RClassic_Float
 		//////////////////////////////////////////////////
 		// Clip the Wall Segment by the near plane.
 		//////////////////////////////////////////////////
-		if ((z0 < 0 || z1 < 0) && segmentCrossesLine(0.0f, 0.0f, 0.0f, -s_rcfltState.halfHeight, x0, x0, x1, z1) != 0)
+		if ((z0 < 0 || z1 < 0) && segmentCrossesLine(0.0f, 0.0f, 0.0f, -s_rcfltState->halfHeight, x0, x0, x1, z1) != 0)
 		{
 			return false;
 		}
@@ -291,10 +292,10 @@ namespace RClassic_Float
 		f32 z1 = p1->z;
 
 		// x values of frustum lines that pass through (x0,z0) and (x1,z1)
-		f32 left0 = -z0 * s_rcfltState.nearPlaneHalfLen;
-		f32 left1 = -z1 * s_rcfltState.nearPlaneHalfLen;
-		f32 right0 = z0 * s_rcfltState.nearPlaneHalfLen;
-		f32 right1 = z1 * s_rcfltState.nearPlaneHalfLen;
+		f32 left0 = -z0 * s_rcfltState->nearPlaneHalfLen;
+		f32 left1 = -z1 * s_rcfltState->nearPlaneHalfLen;
+		f32 right0 = z0 * s_rcfltState->nearPlaneHalfLen;
+		f32 right1 = z1 * s_rcfltState->nearPlaneHalfLen;
 
 		// Cull the wall if it is completely beyind the camera.
 		if (z0 < 0.0f && z1 < 0.0f)
@@ -342,21 +343,21 @@ namespace RClassic_Float
 		//////////////////////////////////////////////////
 		// Project.
 		//////////////////////////////////////////////////
-		f32 x0proj = (x0*s_rcfltState.focalLength)/z0 + s_rcfltState.projOffsetX;
-		f32 x1proj = (x1*s_rcfltState.focalLength)/z1 + s_rcfltState.projOffsetX;
+		f32 x0proj = (x0*s_rcfltState->focalLength)/z0 + s_rcfltState->projOffsetX;
+		f32 x1proj = (x1*s_rcfltState->focalLength)/z1 + s_rcfltState->projOffsetX;
 		s32 x0pixel = roundFloat(x0proj);
 		s32 x1pixel = roundFloat(x1proj) - 1;
 		
 		// Handle near plane clipping by adjusting the walls to avoid holes.
 		if (clipX0_Near != 0 && x0pixel > s_minScreenX_Pixels)
 		{
-			x0 = -s_rcfltState.nearPlaneHalfLen;
-			dx = x1 + s_rcfltState.nearPlaneHalfLen;
+			x0 = -s_rcfltState->nearPlaneHalfLen;
+			dx = x1 + s_rcfltState->nearPlaneHalfLen;
 			x0pixel = s_minScreenX_Pixels;
 		}
 		if (clipX1_Near != 0 && x1pixel < s_maxScreenX_Pixels)
 		{
-			dx = s_rcfltState.nearPlaneHalfLen - x0;
+			dx = s_rcfltState->nearPlaneHalfLen - x0;
 			x1pixel = s_maxScreenX_Pixels;
 		}
 
@@ -379,7 +380,7 @@ namespace RClassic_Float
 			return;
 		}
 	
-		RWallSegmentFloat* wallSeg = &s_rcfltState.wallSegListSrc[s_nextWall];
+		RWallSegmentFloat* wallSeg = &s_rcfltState->wallSegListSrc[s_nextWall];
 		s_nextWall++;
 
 		if (x0pixel < s_minScreenX_Pixels)
@@ -434,7 +435,7 @@ namespace RClassic_Float
 		s32 splitWallCount = 0;
 		s32 splitWallIndex = -count;
 
-		RWallSegmentFloat* srcSeg = &s_rcfltState.wallSegListSrc[start];
+		RWallSegmentFloat* srcSeg = &s_rcfltState->wallSegListSrc[start];
 		RWallSegmentFloat* curSegOut = segOutList;
 
 		RWallSegmentFloat  tempSeg;
@@ -444,8 +445,8 @@ namespace RClassic_Float
 		while (1)
 		{
 			WallCached* srcWall = srcSeg->srcWall;
-			JBool processed = (s_drawFrame == srcWall->wall->drawFrame) ? JTRUE : JFALSE;
-			JBool insideWindow = ((srcSeg->z0 >= s_rcfltState.windowMinZ || srcSeg->z1 >= s_rcfltState.windowMinZ) && srcSeg->wallX0 <= s_windowMaxX_Pixels && srcSeg->wallX1 >= s_windowMinX_Pixels) ? JTRUE : JFALSE;
+			JBool processed = (s_drawFrame == s_rcfltState->wallDrawFrame[srcWall->index]) ? JTRUE : JFALSE;
+			JBool insideWindow = ((srcSeg->z0 >= s_rcfltState->windowMinZ || srcSeg->z1 >= s_rcfltState->windowMinZ) && srcSeg->wallX0 <= s_windowMaxX_Pixels && srcSeg->wallX1 >= s_windowMinX_Pixels) ? JTRUE : JFALSE;
 			if (!processed && insideWindow)
 			{
 				// Copy the source segment into "newSeg" so it can be modified.
@@ -752,16 +753,16 @@ namespace RClassic_Float
 		f32 ceilingHeight = cachedSector->ceilingHeight;
 		f32 floorHeight = cachedSector->floorHeight;
 
-		f32 ceilEyeRel  = ceilingHeight - s_rcfltState.eyeHeight;
-		f32 floorEyeRel = floorHeight   - s_rcfltState.eyeHeight;
+		f32 ceilEyeRel  = ceilingHeight - s_rcfltState->eyeHeight;
+		f32 floorEyeRel = floorHeight   - s_rcfltState->eyeHeight;
 
 		f32 z0 = wallSegment->z0;
 		f32 z1 = wallSegment->z1;
 
-		f32 y0C = (ceilEyeRel  * s_rcfltState.focalLenAspect) / z0 + s_rcfltState.projOffsetY;
-		f32 y1C = (ceilEyeRel  * s_rcfltState.focalLenAspect) / z1 + s_rcfltState.projOffsetY;
-		f32 y0F = (floorEyeRel * s_rcfltState.focalLenAspect) / z0 + s_rcfltState.projOffsetY;
-		f32 y1F = (floorEyeRel * s_rcfltState.focalLenAspect) / z1 + s_rcfltState.projOffsetY;
+		f32 y0C = (ceilEyeRel  * s_rcfltState->focalLenAspect) / z0 + s_rcfltState->projOffsetY;
+		f32 y1C = (ceilEyeRel  * s_rcfltState->focalLenAspect) / z1 + s_rcfltState->projOffsetY;
+		f32 y0F = (floorEyeRel * s_rcfltState->focalLenAspect) / z0 + s_rcfltState->projOffsetY;
+		f32 y1F = (floorEyeRel * s_rcfltState->focalLenAspect) / z1 + s_rcfltState->projOffsetY;
 
 		s32 y0C_pixel = roundFloat(y0C);
 		s32 y1C_pixel = roundFloat(y1C);
@@ -780,7 +781,7 @@ namespace RClassic_Float
 
 			for (s32 i = 0; i < length; i++, x++)
 			{
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, numerator);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, numerator);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
 
@@ -826,7 +827,7 @@ namespace RClassic_Float
 
 			f32 dxView = 0;
 			f32 z = solveForZ(wallSegment, x, numerator, &dxView);
-			s_rcfltState.depth1d[x] = z;
+			s_rcfltState->depth1d[x] = z;
 
 			f32 uScale  = wallSegment->uScale;
 			f32 uCoord0 = wallSegment->uCoord0 + cachedWall->midOffset.x;
@@ -959,7 +960,7 @@ namespace RClassic_Float
 				s_vCoordFixed = floatToFixed20((yF0 - f32(yF_pixel) + 0.5f)*vCoordStep + cachedWall->midOffset.z);
 
 				s_columnOut = &s_display[yC_pixel*s_width + x];
-				s_rcfltState.depth1d[x] = z;
+				s_rcfltState->depth1d[x] = z;
 				s_columnLight = computeLighting(z, floor16(srcWall->wallLight));
 
 				if (s_columnLight)
@@ -994,13 +995,13 @@ namespace RClassic_Float
 		f32 cProj0, cProj1;
 		if ((flags1 & SEC_FLAGS1_EXTERIOR) && (nextFlags1 & SEC_FLAGS1_EXT_ADJ))  // ceiling
 		{
-			cProj0 = cProj1 = s_rcfltState.windowMinY;
+			cProj0 = cProj1 = s_rcfltState->windowMinY;
 		}
 		else
 		{
-			f32 ceilRel = cachedSector->ceilingHeight - s_rcfltState.eyeHeight;
-			cProj0 = ((ceilRel*s_rcfltState.focalLenAspect)/z0) + s_rcfltState.projOffsetY;
-			cProj1 = ((ceilRel*s_rcfltState.focalLenAspect)/z1) + s_rcfltState.projOffsetY;
+			f32 ceilRel = cachedSector->ceilingHeight - s_rcfltState->eyeHeight;
+			cProj0 = ((ceilRel*s_rcfltState->focalLenAspect)/z0) + s_rcfltState->projOffsetY;
+			cProj1 = ((ceilRel*s_rcfltState->focalLenAspect)/z1) + s_rcfltState->projOffsetY;
 		}
 
 		s32 c0pixel = roundFloat(cProj0);
@@ -1013,7 +1014,7 @@ namespace RClassic_Float
 			const f32 numerator = solveForZ_Numerator(wallSegment);
 			for (s32 i = 0; i < length; i++, x++)
 			{
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, numerator);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, numerator);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
 
@@ -1025,13 +1026,13 @@ namespace RClassic_Float
 		f32 fProj0, fProj1;
 		if ((sector->flags1 & SEC_FLAGS1_PIT) && (nextFlags1 & SEC_FLAGS1_EXT_FLOOR_ADJ))	// floor
 		{
-			fProj0 = fProj1 = s_rcfltState.windowMaxY;
+			fProj0 = fProj1 = s_rcfltState->windowMaxY;
 		}
 		else
 		{
-			f32 floorRel = cachedSector->floorHeight - s_rcfltState.eyeHeight;
-			fProj0 = ((floorRel*s_rcfltState.focalLenAspect)/z0) + s_rcfltState.projOffsetY;
-			fProj1 = ((floorRel*s_rcfltState.focalLenAspect)/z1) + s_rcfltState.projOffsetY;
+			f32 floorRel = cachedSector->floorHeight - s_rcfltState->eyeHeight;
+			fProj0 = ((floorRel*s_rcfltState->focalLenAspect)/z0) + s_rcfltState->projOffsetY;
+			fProj1 = ((floorRel*s_rcfltState->focalLenAspect)/z1) + s_rcfltState->projOffsetY;
 		}
 
 		s32 f0pixel = roundFloat(fProj0);
@@ -1045,7 +1046,7 @@ namespace RClassic_Float
 			const f32 numerator = solveForZ_Numerator(wallSegment);
 			for (s32 i = 0; i < length; i++, x++)
 			{
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, numerator);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, numerator);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
 			srcWall->visible = 0;
@@ -1091,7 +1092,7 @@ namespace RClassic_Float
 				s_columnTop[x] = y0_pixel - 1;
 				s_columnBot[x] = y1_pixel + 1;
 
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, numerator);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, numerator);
 				y0 += dydxCeil;
 				y1 += dydxFloor;
 			}
@@ -1117,14 +1118,14 @@ namespace RClassic_Float
 		f32 cProj0, cProj1;
 		if ((sector->flags1 & SEC_FLAGS1_EXTERIOR) && (nextSector->flags1 & SEC_FLAGS1_EXT_ADJ))
 		{
-			cProj0 = s_rcfltState.windowMinY;
+			cProj0 = s_rcfltState->windowMinY;
 			cProj1 = cProj0;
 		}
 		else
 		{
-			f32 ceilRel = cachedSector->ceilingHeight - s_rcfltState.eyeHeight;
-			cProj0 = (ceilRel*s_rcfltState.focalLenAspect)/z0 + s_rcfltState.projOffsetY;
-			cProj1 = (ceilRel*s_rcfltState.focalLenAspect)/z1 + s_rcfltState.projOffsetY;
+			f32 ceilRel = cachedSector->ceilingHeight - s_rcfltState->eyeHeight;
+			cProj0 = (ceilRel*s_rcfltState->focalLenAspect)/z0 + s_rcfltState->projOffsetY;
+			cProj1 = (ceilRel*s_rcfltState->focalLenAspect)/z1 + s_rcfltState->projOffsetY;
 		}
 
 		s32 cy0 = roundFloat(cProj0);
@@ -1140,16 +1141,16 @@ namespace RClassic_Float
 			f32 num = solveForZ_Numerator(wallSegment);
 			for (s32 i = 0; i < length; i++, x++)
 			{
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
 			srcWall->seen = JTRUE;
 			return;
 		}
 
-		f32 floorRel = cachedSector->floorHeight - s_rcfltState.eyeHeight;
-		f32 fProj0 = (floorRel*s_rcfltState.focalLenAspect)/z0 + s_rcfltState.projOffsetY;
-		f32 fProj1 = (floorRel*s_rcfltState.focalLenAspect)/z1 + s_rcfltState.projOffsetY;
+		f32 floorRel = cachedSector->floorHeight - s_rcfltState->eyeHeight;
+		f32 fProj0 = (floorRel*s_rcfltState->focalLenAspect)/z0 + s_rcfltState->projOffsetY;
+		f32 fProj1 = (floorRel*s_rcfltState->focalLenAspect)/z1 + s_rcfltState->projOffsetY;
 
 		s32 fy0 = roundFloat(fProj0);
 		s32 fy1 = roundFloat(fProj1);
@@ -1165,16 +1166,16 @@ namespace RClassic_Float
 			f32 num = solveForZ_Numerator(wallSegment);
 			for (s32 i = 0; i < length; i++, x++)
 			{
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
 			srcWall->seen = JTRUE;
 			return;
 		}
 
-		f32 floorRelNext = fixed16ToFloat(nextSector->floorHeight) - s_rcfltState.eyeHeight;
-		f32 fNextProj0 = (floorRelNext*s_rcfltState.focalLenAspect)/z0 + s_rcfltState.projOffsetY;
-		f32 fNextProj1 = (floorRelNext*s_rcfltState.focalLenAspect)/z1 + s_rcfltState.projOffsetY;
+		f32 floorRelNext = fixed16ToFloat(nextSector->floorHeight) - s_rcfltState->eyeHeight;
+		f32 fNextProj0 = (floorRelNext*s_rcfltState->focalLenAspect)/z0 + s_rcfltState->projOffsetY;
+		f32 fNextProj1 = (floorRelNext*s_rcfltState->focalLenAspect)/z1 + s_rcfltState->projOffsetY;
 
 		s32 xOffset = wallSegment->wallX0 - wallSegment->wallX0_raw;
 		s32 length  = wallSegment->wallX1 - wallSegment->wallX0 + 1;
@@ -1220,7 +1221,7 @@ namespace RClassic_Float
 				s32 yC_pixel = min(roundFloat(yC), s_windowBot[x]);
 				s_columnTop[x] = yC_pixel - 1;
 				s_columnBot[x] = bot;
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, num);
 			}
 			srcWall->seen = JTRUE;
 			return;
@@ -1272,7 +1273,7 @@ namespace RClassic_Float
 					f32 dz = z - z0;
 					uCoord = u0 + (dz*wallSegment->uScale) + cachedWall->botOffset.x;
 				}
-				s_rcfltState.depth1d[x] = z;
+				s_rcfltState->depth1d[x] = z;
 				if (s_yPixelCount > 0)
 				{
 					s32 widthMask = tex->width - 1;
@@ -1354,9 +1355,9 @@ namespace RClassic_Float
 		s32 x0 = wallSegment->wallX0;
 		s32 lengthInPixels = wallSegment->wallX1 - wallSegment->wallX0 + 1;
 
-		f32 ceilRel = cachedSector->ceilingHeight - s_rcfltState.eyeHeight;
-		f32 yC0 =((ceilRel*s_rcfltState.focalLenAspect)/z0) + s_rcfltState.projOffsetY;
-		f32 yC1 =((ceilRel*s_rcfltState.focalLenAspect)/z1) + s_rcfltState.projOffsetY;
+		f32 ceilRel = cachedSector->ceilingHeight - s_rcfltState->eyeHeight;
+		f32 yC0 =((ceilRel*s_rcfltState->focalLenAspect)/z0) + s_rcfltState->projOffsetY;
+		f32 yC1 =((ceilRel*s_rcfltState->focalLenAspect)/z1) + s_rcfltState->projOffsetY;
 
 		s32 yC0_pixel = roundFloat(yC0);
 		s32 yC1_pixel = roundFloat(yC1);
@@ -1370,7 +1371,7 @@ namespace RClassic_Float
 			flat_addEdges(lengthInPixels, x0, 0, f32(s_windowMaxY_Pixels + 1), 0, f32(s_windowMaxY_Pixels + 1));
 			for (s32 i = 0, x = x0; i < lengthInPixels; i++, x++)
 			{
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
 			srcWall->seen = JTRUE;
@@ -1384,9 +1385,9 @@ namespace RClassic_Float
 		}
 		else
 		{
-			f32 floorRel = cachedSector->floorHeight - s_rcfltState.eyeHeight;
-			yF0 = (floorRel*s_rcfltState.focalLenAspect)/z0 + s_rcfltState.projOffsetY;
-			yF1 = (floorRel*s_rcfltState.focalLenAspect)/z1 + s_rcfltState.projOffsetY;
+			f32 floorRel = cachedSector->floorHeight - s_rcfltState->eyeHeight;
+			yF0 = (floorRel*s_rcfltState->focalLenAspect)/z0 + s_rcfltState->projOffsetY;
+			yF1 = (floorRel*s_rcfltState->focalLenAspect)/z1 + s_rcfltState->projOffsetY;
 		}
 
 		s32 yF0_pixel = roundFloat(yF0);
@@ -1398,16 +1399,16 @@ namespace RClassic_Float
 			flat_addEdges(lengthInPixels, x0, 0, f32(s_windowMinY_Pixels - 1), 0, f32(s_windowMinY_Pixels - 1));
 			for (s32 i = 0, x = x0; i < lengthInPixels; i++, x++)
 			{
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
 			srcWall->seen = JTRUE;
 			return;
 		}
 
-		f32 next_ceilRel = fixed16ToFloat(next->ceilingHeight) - s_rcfltState.eyeHeight;
-		f32 next_yC0 = (next_ceilRel*s_rcfltState.focalLenAspect)/z0 + s_rcfltState.projOffsetY;
-		f32 next_yC1 = (next_ceilRel*s_rcfltState.focalLenAspect)/z1 + s_rcfltState.projOffsetY;
+		f32 next_ceilRel = fixed16ToFloat(next->ceilingHeight) - s_rcfltState->eyeHeight;
+		f32 next_yC0 = (next_ceilRel*s_rcfltState->focalLenAspect)/z0 + s_rcfltState->projOffsetY;
+		f32 next_yC1 = (next_ceilRel*s_rcfltState->focalLenAspect)/z1 + s_rcfltState->projOffsetY;
 
 		f32 xOffset = f32(wallSegment->wallX0 - wallSegment->wallX0_raw);
 		f32 length  = f32(wallSegment->wallX1_raw - wallSegment->wallX0_raw);
@@ -1447,7 +1448,7 @@ namespace RClassic_Float
 				}
 
 				s_columnBot[x] = yF0_pixel + 1;
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, num);
 				yF0 += floor_dYdX;
 			}
 			srcWall->seen = JTRUE;
@@ -1490,7 +1491,7 @@ namespace RClassic_Float
 			f32 uCoord0 = wallSegment->uCoord0 + cachedWall->topOffset.x;
 			f32 uCoord = uCoord0 + ((wallSegment->orient == WORIENT_DZ_DX) ? dxView*uScale : (z - z0)*uScale);
 
-			s_rcfltState.depth1d[x] = z;
+			s_rcfltState->depth1d[x] = z;
 			if (s_yPixelCount > 0)
 			{
 				s32 widthMask = texture->width - 1;
@@ -1571,9 +1572,9 @@ namespace RClassic_Float
 		s32 length  = wallSegment->wallX1 - wallSegment->wallX0 + 1;
 		f32 lengthRaw = f32(wallSegment->wallX1_raw - wallSegment->wallX0_raw);
 
-		f32 ceilRel = cachedSector->ceilingHeight - s_rcfltState.eyeHeight;
-		f32 cProj0 = (ceilRel*s_rcfltState.focalLenAspect)/z0 + s_rcfltState.projOffsetY;
-		f32 cProj1 = (ceilRel*s_rcfltState.focalLenAspect)/z1 + s_rcfltState.projOffsetY;
+		f32 ceilRel = cachedSector->ceilingHeight - s_rcfltState->eyeHeight;
+		f32 cProj0 = (ceilRel*s_rcfltState->focalLenAspect)/z0 + s_rcfltState->projOffsetY;
+		f32 cProj1 = (ceilRel*s_rcfltState->focalLenAspect)/z1 + s_rcfltState->projOffsetY;
 
 		s32 c0_pixel = roundFloat(cProj0);
 		s32 c1_pixel = roundFloat(cProj1);
@@ -1587,16 +1588,16 @@ namespace RClassic_Float
 			f32 num = solveForZ_Numerator(wallSegment);
 			for (s32 i = 0, x = x0; i < length; i++, x++)
 			{
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnTop[x] = s_windowMaxY_Pixels;
 			}
 			srcWall->seen = JTRUE;
 			return;
 		}
 
-		f32 floorRel = cachedSector->floorHeight - s_rcfltState.eyeHeight;
-		f32 fProj0 = (floorRel*s_rcfltState.focalLenAspect)/z0 + s_rcfltState.projOffsetY;
-		f32 fProj1 = (floorRel*s_rcfltState.focalLenAspect)/z1 + s_rcfltState.projOffsetY;
+		f32 floorRel = cachedSector->floorHeight - s_rcfltState->eyeHeight;
+		f32 fProj0 = (floorRel*s_rcfltState->focalLenAspect)/z0 + s_rcfltState->projOffsetY;
+		f32 fProj1 = (floorRel*s_rcfltState->focalLenAspect)/z1 + s_rcfltState->projOffsetY;
 
 		s32 f0_pixel = roundFloat(fProj0);
 		s32 f1_pixel = roundFloat(fProj1);
@@ -1610,7 +1611,7 @@ namespace RClassic_Float
 
 			for (s32 i = 0, x = x0; i < length; i++, x++)
 			{
-				s_rcfltState.depth1d[x] = solveForZ(wallSegment, x, num);
+				s_rcfltState->depth1d[x] = solveForZ(wallSegment, x, num);
 				s_columnBot[x] = s_windowMinY_Pixels;
 			}
 			srcWall->seen = JTRUE;
@@ -1618,9 +1619,9 @@ namespace RClassic_Float
 		}
 
 		RSector* nextSector = srcWall->nextSector;
-		f32 next_ceilRel = fixed16ToFloat(nextSector->ceilingHeight) - s_rcfltState.eyeHeight;
-		f32 next_cProj0 = (next_ceilRel*s_rcfltState.focalLenAspect)/z0 + s_rcfltState.projOffsetY;
-		f32 next_cProj1 = (next_ceilRel*s_rcfltState.focalLenAspect)/z1 + s_rcfltState.projOffsetY;
+		f32 next_ceilRel = fixed16ToFloat(nextSector->ceilingHeight) - s_rcfltState->eyeHeight;
+		f32 next_cProj0 = (next_ceilRel*s_rcfltState->focalLenAspect)/z0 + s_rcfltState->projOffsetY;
+		f32 next_cProj1 = (next_ceilRel*s_rcfltState->focalLenAspect)/z1 + s_rcfltState->projOffsetY;
 
 		f32 ceil_dYdX = 0;
 		f32 next_ceil_dYdX = 0;
@@ -1677,7 +1678,7 @@ namespace RClassic_Float
 					f32 dz = z - z0;
 					u = u0 + (dz*wallSegment->uScale) + cachedWall->topOffset.x;
 				}
-				s_rcfltState.depth1d[x] = z;
+				s_rcfltState->depth1d[x] = z;
 				if (s_yPixelCount > 0)
 				{
 					s32 widthMask = topTex->width - 1;
@@ -1713,9 +1714,9 @@ namespace RClassic_Float
 			for (s32 i = 0; i < length; i++) { s_columnTop[x0 + i] = s_windowMinY_Pixels - 1; }
 		}
 
-		f32 next_floorRel = fixed16ToFloat(nextSector->floorHeight) - s_rcfltState.eyeHeight;
-		f32 next_fProj0 = (next_floorRel*s_rcfltState.focalLenAspect)/z0 + s_rcfltState.projOffsetY;
-		f32 next_fProj1 = (next_floorRel*s_rcfltState.focalLenAspect)/z1 + s_rcfltState.projOffsetY;
+		f32 next_floorRel = fixed16ToFloat(nextSector->floorHeight) - s_rcfltState->eyeHeight;
+		f32 next_fProj0 = (next_floorRel*s_rcfltState->focalLenAspect)/z0 + s_rcfltState->projOffsetY;
+		f32 next_fProj1 = (next_floorRel*s_rcfltState->focalLenAspect)/z1 + s_rcfltState->projOffsetY;
 
 		f32 next_floor_dYdX = 0;
 		f32 floor_dYdX = 0;
@@ -1781,7 +1782,7 @@ namespace RClassic_Float
 						f32 dz = z - z0;
 						uCoord = u0 + (dz*wallSegment->uScale) + cachedWall->botOffset.x;
 					}
-					s_rcfltState.depth1d[x] = z;
+					s_rcfltState->depth1d[x] = z;
 					if (s_yPixelCount > 0)
 					{
 						s32 widthMask = botTex->width - 1;
@@ -1900,14 +1901,14 @@ namespace RClassic_Float
 			{
 				if (s_height == SKY_BASE_HEIGHT)
 				{
-					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask - y1) - s_rcfltState.skyPitchOffset - fixed16ToFloat(sector->ceilOffset.z));
+					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask - y1) - s_rcfltState->skyPitchOffset - fixed16ToFloat(sector->ceilOffset.z));
 				}
 				else
 				{
-					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask) - (f32(y1)*heightScale) - s_rcfltState.skyPitchOffset - fixed16ToFloat(sector->ceilOffset.z));
+					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask) - (f32(y1)*heightScale) - s_rcfltState->skyPitchOffset - fixed16ToFloat(sector->ceilOffset.z));
 				}
 
-				s32 texelU = (floorFloat(fixed16ToFloat(sector->ceilOffset.x) - s_rcfltState.skyYawOffset + s_rcfltState.skyTable[x]) ) & texWidthMask;
+				s32 texelU = (floorFloat(fixed16ToFloat(sector->ceilOffset.x) - s_rcfltState->skyYawOffset + s_rcfltState->skyTable[x]) ) & texWidthMask;
 				s_texImage = &texture->image[texelU << texture->logSizeY];
 				s_columnOut = &s_display[y0*s_width + x];
 				drawColumn_Fullbright();
@@ -1948,15 +1949,15 @@ namespace RClassic_Float
 			{
 				if (s_height == SKY_BASE_HEIGHT)
 				{
-					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask - y1) - s_rcfltState.skyPitchOffset - fixed16ToFloat(sector->ceilOffset.z));
+					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask - y1) - s_rcfltState->skyPitchOffset - fixed16ToFloat(sector->ceilOffset.z));
 				}
 				else
 				{
-					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask) - (f32(y1)*heightScale) - s_rcfltState.skyPitchOffset - fixed16ToFloat(sector->ceilOffset.z));
+					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask) - (f32(y1)*heightScale) - s_rcfltState->skyPitchOffset - fixed16ToFloat(sector->ceilOffset.z));
 				}
 
 				s32 widthMask = texture->width - 1;
-				s32 texelU = floorFloat(fixed16ToFloat(sector->ceilOffset.x) - s_rcfltState.skyYawOffset + s_rcfltState.skyTable[x]) & widthMask;
+				s32 texelU = floorFloat(fixed16ToFloat(sector->ceilOffset.x) - s_rcfltState->skyYawOffset + s_rcfltState->skyTable[x]) & widthMask;
 				s_texImage = &texture->image[texelU << texture->logSizeY];
 				s_columnOut = &s_display[y0*s_width + x];
 
@@ -2004,14 +2005,14 @@ namespace RClassic_Float
 			{
 				if (s_height == SKY_BASE_HEIGHT)
 				{
-					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask - y1) - s_rcfltState.skyPitchOffset - fixed16ToFloat(sector->floorOffset.z));
+					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask - y1) - s_rcfltState->skyPitchOffset - fixed16ToFloat(sector->floorOffset.z));
 				}
 				else
 				{
-					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask) - (f32(y1)*heightScale) - s_rcfltState.skyPitchOffset - fixed16ToFloat(sector->floorOffset.z));
+					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask) - (f32(y1)*heightScale) - s_rcfltState->skyPitchOffset - fixed16ToFloat(sector->floorOffset.z));
 				}
 
-				s32 texelU = floorFloat(fixed16ToFloat(sector->floorOffset.x) - s_rcfltState.skyYawOffset + s_rcfltState.skyTable[x]) & texWidthMask;
+				s32 texelU = floorFloat(fixed16ToFloat(sector->floorOffset.x) - s_rcfltState->skyYawOffset + s_rcfltState->skyTable[x]) & texWidthMask;
 				s_texImage = &texture->image[texelU << texture->logSizeY];
 				s_columnOut = &s_display[y0*s_width + x];
 				drawColumn_Fullbright();
@@ -2052,15 +2053,15 @@ namespace RClassic_Float
 			{
 				if (s_height == SKY_BASE_HEIGHT)
 				{
-					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask - y1) - s_rcfltState.skyPitchOffset - fixed16ToFloat(sector->floorOffset.z));
+					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask - y1) - s_rcfltState->skyPitchOffset - fixed16ToFloat(sector->floorOffset.z));
 				}
 				else
 				{
-					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask) - (f32(y1)*heightScale) - s_rcfltState.skyPitchOffset - fixed16ToFloat(sector->floorOffset.z));
+					s_vCoordFixed = floatToFixed20(f32(s_texHeightMask) - (f32(y1)*heightScale) - s_rcfltState->skyPitchOffset - fixed16ToFloat(sector->floorOffset.z));
 				}
 
 				s32 widthMask = texture->width - 1;
-				s32 texelU = floorFloat(fixed16ToFloat(sector->floorOffset.x) - s_rcfltState.skyYawOffset + s_rcfltState.skyTable[x]) & widthMask;
+				s32 texelU = floorFloat(fixed16ToFloat(sector->floorOffset.x) - s_rcfltState->skyYawOffset + s_rcfltState->skyTable[x]) & widthMask;
 				s_texImage = &texture->image[texelU << texture->logSizeY];
 				s_columnOut = &s_display[y0*s_width + x];
 
@@ -2109,7 +2110,7 @@ namespace RClassic_Float
 			const f32 fx = f32(x);
 			// Scale halfWidthOverX by focal length to account for widescreen.
 			// Note in the original code s_focalLength == s_halfWidth, so in that case the code is functionally equivalent.
-			const f32 halfWidthOverX = ((fx != s_rcfltState.halfWidth) ? s_rcfltState.focalLength / (fx - s_rcfltState.halfWidth) : s_rcfltState.focalLength);
+			const f32 halfWidthOverX = ((fx != s_rcfltState->halfWidth) ? s_rcfltState->focalLength / (fx - s_rcfltState->halfWidth) : s_rcfltState->focalLength);
 			f32 den = halfWidthOverX - wallSegment->slope;
 			// Avoid divide by zero.
 			if (den == 0.0f) { den = 1.0f; }
@@ -2129,7 +2130,7 @@ namespace RClassic_Float
 			// Directly solve for Z at the current pixel x coordinate.
 			// Scale xOverHalfWidth by focal length to account for widescreen.
 			// Note in the original code s_focalLength == s_halfWidth, so in that case the code is functionally equivalent.
-			const f32 xOverHalfWidth = (f32(x) - s_rcfltState.halfWidth) / s_rcfltState.focalLength;
+			const f32 xOverHalfWidth = (f32(x) - s_rcfltState->halfWidth) / s_rcfltState->focalLength;
 			f32 den = xOverHalfWidth - wallSegment->slope;
 			// Avoid divide by 0.
 			if (den == 0.0f) { den = 1.0f; }
@@ -2140,8 +2141,22 @@ namespace RClassic_Float
 		return z;
 	}
 
+	// TFE: Draw the current column with the batched (SIMD) kernels if available.
+	// Returns false if the scalar reference loop must be used instead.
+	static bool drawColumn_Batched(const u8* light, bool trans)
+	{
+		const RasterColumnFunc func = trans ? s_rasterKernels.columnTrans : s_rasterKernels.column;
+		if (!func || s_texHeightMask > RASTER_COLUMN_MAX_MASK) { return false; }
+
+		const RasterColumn column = { s_columnOut, s_width, s_yPixelCount, s_texImage, light, s_vCoordFixed, s_vCoordStep, s_texHeightMask };
+		func(&column);
+		return true;
+	}
+
 	void drawColumn_Fullbright()
 	{
+		if (drawColumn_Batched(nullptr, false)) { return; }
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2156,6 +2171,8 @@ namespace RClassic_Float
 
 	void drawColumn_Lit()
 	{
+		if (drawColumn_Batched(s_columnLight, false)) { return; }
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2170,6 +2187,8 @@ namespace RClassic_Float
 
 	void drawColumn_Fullbright_Trans()
 	{
+		if (drawColumn_Batched(nullptr, true)) { return; }
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2185,6 +2204,8 @@ namespace RClassic_Float
 
 	void drawColumn_Lit_Trans()
 	{
+		if (drawColumn_Batched(s_columnLight, true)) { return; }
+
 		fixed44_20 vCoordFixed = s_vCoordFixed;
 		const u8* tex = s_texImage;
 		const s32 end = s_yPixelCount - 1;
@@ -2213,13 +2234,13 @@ namespace RClassic_Float
 			{
 				y1End += (top_dydx * lengthFlt);
 			}
-			edgePair_setup(length, x0, top_dydx, y1End, y1, bot_dydx, y0, y0End, s_rcfltState.adjoinEdge);
+			edgePair_setup(length, x0, top_dydx, y1End, y1, bot_dydx, y0, y0End, s_rcfltState->adjoinEdge);
 
-			s_rcfltState.adjoinEdge++;
+			s_rcfltState->adjoinEdge++;
 			s_adjoinSegCount++;
 
-			*s_rcfltState.adjoinSegment = wallSegment;
-			s_rcfltState.adjoinSegment++;
+			*s_rcfltState->adjoinSegment = wallSegment;
+			s_rcfltState->adjoinSegment++;
 		}
 	}
 
@@ -2245,8 +2266,8 @@ namespace RClassic_Float
 		const f32 y0 = cachedPosVS->y - yOffset;
 
 		const f32 rcpZ = 1.0f/z;
-		const f32 projX0 = x0*s_rcfltState.focalLength   *rcpZ + s_rcfltState.projOffsetX;
-		const f32 projY0 = y0*s_rcfltState.focalLenAspect*rcpZ + s_rcfltState.projOffsetY;
+		const f32 projX0 = x0*s_rcfltState->focalLength   *rcpZ + s_rcfltState->projOffsetX;
+		const f32 projY0 = y0*s_rcfltState->focalLenAspect*rcpZ + s_rcfltState->projOffsetY;
 
 		s32 x0_pixel = roundFloat(projX0);
 		s32 y0_pixel = roundFloat(projY0);
@@ -2257,8 +2278,8 @@ namespace RClassic_Float
 
 		const f32 x1 = x0 + widthWS;
 		const f32 y1 = y0 + heightWS;
-		const f32 projX1 = x1*s_rcfltState.focalLength   *rcpZ + s_rcfltState.projOffsetX;
-		const f32 projY1 = y1*s_rcfltState.focalLenAspect*rcpZ + s_rcfltState.projOffsetY;
+		const f32 projX1 = x1*s_rcfltState->focalLength   *rcpZ + s_rcfltState->projOffsetX;
+		const f32 projY1 = y1*s_rcfltState->focalLenAspect*rcpZ + s_rcfltState->projOffsetY;
 
 		s32 x1_pixel = roundFloat(projX1);
 		s32 y1_pixel = roundFloat(projY1);
@@ -2332,7 +2353,7 @@ namespace RClassic_Float
 		const u32* columnOffset = (u32*)(basePtr + cell->columnOffset);
 		for (s32 x = x0_pixel; x <= x1_pixel; x++, uCoord += uCoordStep)
 		{
-			if (z < s_rcfltState.depth1d[x])
+			if (z < s_rcfltState->depth1d[x])
 			{
 				s32 y0 = y0_pixel;
 				s32 y1 = y1_pixel;
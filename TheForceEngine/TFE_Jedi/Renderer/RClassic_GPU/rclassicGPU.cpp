@@ -37,35 +37,35 @@ namespace RClassic_GPU
 	{
 		s_width = width;
 		s_height = height;
-		s_rcfltState.halfWidth      = f32(width >> 1);
-		s_rcfltState.focalLength    = s_rcfltState.halfWidth;
-		s_rcfltState.focalLenAspect = s_rcfltState.halfWidth;
-		s_rcfltState.aspectScaleY   = 1.0f;
+		s_rcfltState->halfWidth      = f32(width >> 1);
+		s_rcfltState->focalLength    = s_rcfltState->halfWidth;
+		s_rcfltState->focalLenAspect = s_rcfltState->halfWidth;
+		s_rcfltState->aspectScaleY   = 1.0f;
 
 		if (TFE_RenderBackend::getWidescreen())
 		{
 			// 200p and 400p get special handling because they are 16:10 resolutions in 4:3.
 			if (s_height == 200 || s_height == 400)
 			{
-				s_rcfltState.focalLenAspect = (s_height == 200) ? 160.0f : 320.0f;
+				s_rcfltState->focalLenAspect = (s_height == 200) ? 160.0f : 320.0f;
 			}
 			else
 			{
-				s_rcfltState.focalLenAspect = (s_height * 4 / 3) * 0.5f;
+				s_rcfltState->focalLenAspect = (s_height * 4 / 3) * 0.5f;
 			}
 
 			// The (4/3) or (16/10) factor removes the 4:3 or 16:10 aspect ratio already factored in 's_halfWidth' 
 			// The (height/width) factor adjusts for the resolution pixel aspect ratio.
 			const f32 scaleFactor = (s_height == 200 || s_height == 400) ? (16.0f / 10.0f) : (4.0f / 3.0f);
-			s_rcfltState.focalLength = s_rcfltState.halfWidth * scaleFactor * f32(s_height) / f32(s_width);
+			s_rcfltState->focalLength = s_rcfltState->halfWidth * scaleFactor * f32(s_height) / f32(s_width);
 		}
 		if (s_height != 200 && s_height != 400)
 		{
 			// Scale factor to account for converting from rectangular pixels to square pixels when computing flat texture coordinates.
 			// Factor = (16/10) / (4/3)
-			s_rcfltState.aspectScaleY = 1.2f;
+			s_rcfltState->aspectScaleY = 1.2f;
 		}
-		s_rcfltState.focalLenAspect *= s_rcfltState.aspectScaleY;
+		s_rcfltState->focalLenAspect *= s_rcfltState->aspectScaleY;
 
 		// Allow for FOV changes, assumes the base horizontal FOV when using 4:3 is 90 degrees.
 		// FOV scale = tan(FOV/2)
@@ -73,19 +73,19 @@ namespace RClassic_GPU
 		if (fov != 90 && fov > 0 && fov < 180)
 		{
 			const f32 fovScale = 1.0f / tanf(f32(fov) * 0.5f * PI / 180.0f);
-			s_rcfltState.focalLength *= fovScale;
-			s_rcfltState.focalLenAspect *= fovScale;
+			s_rcfltState->focalLength *= fovScale;
+			s_rcfltState->focalLenAspect *= fovScale;
 		}
 
-		s_cameraProj = TFE_Math::computeProjMatrixExplicit(2.0f*s_rcfltState.focalLength / f32(s_width),
-			2.0f*s_rcfltState.focalLenAspect / f32(s_height), 0.01f, 4096.0f);
+		s_cameraProj = TFE_Math::computeProjMatrixExplicit(2.0f*s_rcfltState->focalLength / f32(s_width),
+			2.0f*s_rcfltState->focalLenAspect / f32(s_height), 0.01f, 4096.0f);
 	}
 
 	void computeCameraTransform(RSector* sector, f32 pitch, f32 yaw, f32 camX, f32 camY, f32 camZ)
 	{
 		s_cameraPos = { camX, camY, camZ };
-		s_cameraProj = TFE_Math::computeProjMatrixExplicit(2.0f*s_rcfltState.focalLength / f32(s_width),
-			2.0f*s_rcfltState.focalLenAspect / f32(s_height), 0.01f, 4096.0f);
+		s_cameraProj = TFE_Math::computeProjMatrixExplicit(2.0f*s_rcfltState->focalLength / f32(s_width),
+			2.0f*s_rcfltState->focalLenAspect / f32(s_height), 0.01f, 4096.0f);
 
 		f32 sinYaw, cosYaw, sinPitch, cosPitch;
 		sinCosFlt(-yaw, &sinYaw, &cosYaw);
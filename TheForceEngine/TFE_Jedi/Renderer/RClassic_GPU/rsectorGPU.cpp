@@ -1905,8 +1905,8 @@ namespace TFE_Jedi
 			};
 			const f32 skyParam1[2] =
 			{
-			   -s_rcfltState.nearPlaneHalfLen,
-				s_rcfltState.nearPlaneHalfLen * 2.0f / f32(dispWidth),
+			   -s_rcfltState->nearPlaneHalfLen,
+				s_rcfltState->nearPlaneHalfLen * 2.0f / f32(dispWidth),
 			};
 			shader->setVariable(skyInputs->skyParam0Id, SVT_VEC4, skyParam0);
 			shader->setVariable(skyInputs->skyParam1Id, SVT_VEC2, skyParam1);
@@ -17,6 +17,7 @@
 #include "RClassic_GPU/rsectorGPU.h"
 #include "RClassic_GPU/screenDrawGPU.h"
 
+#include <TFE_System/system.h>
 #include <TFE_System/profiler.h>
 #include <TFE_RenderBackend/renderBackend.h>
 #include <TFE_Settings/settings.h>
@@ -35,6 +36,7 @@ namespace TFE_Jedi
 	static Vec3f s_lumMask = { 0 };
 	static Vec3f s_palFx = { 0 };
 	static u32 s_sourcePalette[256];
+	static u64 s_drawTicks = 0;
 	bool s_showWireframe = false;
 	TFE_Sectors* s_sectorRenderer = nullptr;
 	RendererType s_rendererType = RENDERER_SOFTWARE;
@@ -116,6 +118,7 @@ namespace TFE_Jedi
 		CVAR_INT(s_maxDepthCount, "d_maxDepthCount", CVFLAG_DO_NOT_SERIALIZE, "Maximum adjoin depth count.");
 		CVAR_INT(s_sectorAmbient, "d_sectorAmbient", CVFLAG_DO_NOT_SERIALIZE, "Current Sector Ambient.");
 		CVAR_BOOL(s_showWireframe, "d_enableWireframe", CVFLAG_DO_NOT_SERIALIZE, "Enable wireframe rendering.");
+		CVAR_INT(s_renderThreads, "d_renderThreads", CVFLAG_NONE, "Number of threads used by the Classic_Float sub-renderer, 0 = one per hardware thread.");
 
 		// Remove temporarily until they do something useful again.
 		CCMD("rsetSubRenderer", console_setSubRenderer, 1, "Set the sub-renderer - valid values are: Classic_Fixed, Classic_Float, Classic_GPU.");
@@ -494,6 +497,7 @@ namespace TFE_Jedi
 
 	void drawWorld(u8* display, RSector* sector, const u8* colormap, const u8* lightSourceRamp)
 	{
+		const u64 startTicks = TFE_System::getCurrentTimeInTicks();
 		// Clear the top pixel row.
 		if (s_subRenderer != TSR_CLASSIC_GPU)
 		{
@@ -560,6 +564,14 @@ namespace TFE_Jedi
 			s_sectorRenderer->prepare();
 			s_sectorRenderer->draw(sector);
 		}
+		s_drawTicks += TFE_System::getCurrentTimeInTicks() - startTicks;
+	}
+
+	u64 renderer_takeDrawTicks()
+	{
+		const u64 ticks = s_drawTicks;
+		s_drawTicks = 0;
+		return ticks;
 	}
 
 	/////////////////////////////////////////////
@@ -574,8 +586,8 @@ namespace TFE_Jedi
 		}
 		else if (s_subRenderer == TSR_CLASSIC_FLOAT)
 		{
-			memset(s_rcfltState.depth1d_all, 0, s_width * sizeof(f32));
-			s_rcfltState.windowMinZ = 0.0f;
+			memset(s_rcfltState->depth1d_all, 0, s_width * sizeof(f32));
+			s_rcfltState->windowMinZ = 0.0f;
 		}
 	}
 }
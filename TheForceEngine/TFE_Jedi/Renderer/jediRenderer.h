@@ -67,6 +67,8 @@ namespace TFE_Jedi
 	//void setCamera(f32 yaw, f32 pitch, f32 x, f32 y, f32 z, s32 sectorId, s32 worldAmbient = 0, bool cameraLightSource = false);
 	// Draw the scene to the passed in display using the colormap for shading.
 	void drawWorld(u8* display, RSector* sector, const u8* colormap, const u8* lightSourceRamp);
+	// TFE: Time spent in drawWorld() since the last call, in system timer ticks.
+	u64 renderer_takeDrawTicks();
 
 	// Added for TFE so the GPU renderer knows the beginning and end of the drawing frame.
 	void beginRender();
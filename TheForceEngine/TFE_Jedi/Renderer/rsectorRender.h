@@ -53,6 +53,7 @@ namespace TFE_Jedi
 	class TFE_Sectors
 	{
 	public:
+		virtual ~TFE_Sectors() {}
 		void computeAdjoinWindowBounds(EdgePairFixed* adjoinEdges);
 
 		// Sub-Renderer specific
@@ -72,7 +73,7 @@ namespace TFE_Jedi
 		}
 
 	protected:
-		SectorSaveValues s_sectorStack[MAX_ADJOIN_DEPTH];
+		SectorSaveValues s_sectorStack[MAX_ADJOIN_DEPTH_EXT];
 
 		RSector* s_curSector;
 		MemoryPool* s_memPool;
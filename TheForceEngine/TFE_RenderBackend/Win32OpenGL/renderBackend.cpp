@@ -87,6 +87,11 @@ namespace TFE_RenderBackend
 	{
 		u32 windowFlags = SDL_WINDOW_OPENGL;
 		bool windowed = !(state.flags & WINFLAG_FULLSCREEN);
+		if (state.flags & WINFLAG_HIDDEN)
+		{
+			// A GL context is still required, so headless runs use a hidden window.
+			windowFlags |= SDL_WINDOW_HIDDEN;
+		}
 
 		TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 		
@@ -638,7 +643,7 @@ namespace TFE_RenderBackend
 	void updateVirtualDisplay(const void* buffer, size_t size)
 	{
 		TFE_ZONE("Update Virtual Display");
-		if (s_virtualDisplay)
+		if (s_virtualDisplay && !(m_windowState.flags & WINFLAG_HIDDEN))
 		{
 			s_virtualDisplay->update(buffer, size);
 		}
@@ -18,6 +18,7 @@ enum WindowFlags
 {
 	WINFLAG_FULLSCREEN = 1 << 0,
 	WINFLAG_VSYNC = 1 << 1,
+	WINFLAG_HIDDEN = 1 << 2,	// TFE: Headless runs, the window is never shown and the virtual display is not uploaded.
 };
 
 enum DisplayMode
@@ -2,6 +2,8 @@
 
 #include <TFE_System/profiler.h>
 #include <TFE_System/math.h>
+#include <TFE_System/parallel.h>
+#include <TFE_System/simd.h>
 #include <TFE_Asset/modelAsset_jedi.h>
 #include <TFE_Game/igame.h>
 #include <TFE_Jedi/Level/level.h>
@@ -44,6 +46,37 @@ namespace TFE_Jedi
 		s32 pageId = 0;
 	};
 
+	// TFE: Packing is split into a serial placement pass, which builds the node tree and records a job for each
+	// texture, and a parallel pass that converts the texels and builds the mips. Each job only writes inside of
+	// its own node (and the matching region of each mip level), so jobs never overlap.
+	// The packed pages are not cached on disk. The texel pass is a palette lookup or copy per texel plus the mips,
+	// so hashing the source textures for a cache key would cost about as much as packing them again.
+	enum PackJobType
+	{
+		PACK_TEXTURE = 0,
+		PACK_DELT_TEXTURE,
+		PACK_WAX_CELL,
+	};
+
+	struct PackJob
+	{
+		PackJobType type;
+		s32 page;
+		const TextureNode* node;
+		Vec4i* tableEntry;
+		s32 paddingX;
+		s32 paddingY;
+		// Textures.
+		const TextureData* texData;
+		const TextureData* hdSrc;
+		s32 mipCount;
+		s32 frameIndex;
+		// Wax cells.
+		const void* basePtr;
+		const WaxCell* cell;
+		const HdWax* hdWax;
+	};
+
 	enum
 	{
 		TIGHT_FIT_PIXELS = 2,
@@ -64,6 +97,7 @@ namespace TFE_Jedi
 	static std::map<WaxCell*, s32> s_waxDataMap;
 	static std::vector<TextureInfo> s_texInfoPool;
 	static std::vector<TextureInfo*> s_unpackedTextures[2];
+	static std::vector<PackJob> s_packJobs;
 	static ChunkedArray* s_nodePool = nullptr;
 	static MemoryRegion* s_texturePackerRegion = nullptr;
 
@@ -373,41 +407,100 @@ namespace TFE_Jedi
 		return &s_texturePacker->pages[page]->backingMemory[addr * s_texturePacker->bytesPerTexel];
 	}
 
+	// Box filter a row of 2x2 texel blocks into 'count' output texels.
+	void generateMipmapRow(const u32* src, u32* dst, s32 stride, s32 count)
+	{
+		for (s32 x = 0; x < count; x++)
+		{
+			const s32 srcX = x * 2;
+			const s32 dstX = x;
+
+			u32 c0 = src[srcX];
+			u32 c1 = src[srcX + 1];
+			u32 c2 = src[srcX + stride];
+			u32 c3 = src[srcX + 1 + stride];
+
+			u32 r[4] = { c0 & 0xff, c1 & 0xff, c2 & 0xff, c3 & 0xff };
+			u32 g[4] = { (c0>>8) & 0xff, (c1>>8) & 0xff, (c2>>8) & 0xff, (c3>>8) & 0xff };
+			u32 b[4] = { (c0>>16) & 0xff, (c1>>16) & 0xff, (c2>>16) & 0xff, (c3>>16) & 0xff };
+			u32 a[4] = { (c0>>24) & 0xff, (c1>>24) & 0xff, (c2>>24) & 0xff, (c3>>24) & 0xff };
+
+			u32 dr = (r[0] + r[1] + r[2] + r[3]) >> 2;
+			u32 dg = (g[0] + g[1] + g[2] + g[3]) >> 2;
+			u32 db = (b[0] + b[1] + b[2] + b[3]) >> 2;
+			u32 da = (a[0] + a[1] + a[2] + a[3]) >> 2;
+
+			dst[dstX] = dr | (dg << 8) | (db << 16) | (da << 24);
+		}
+	}
+
+	// The vector kernels sum the four texels of each block per channel in 16 bits and shift, which matches
+	// the scalar filter exactly.
+#ifdef TFE_SIMD_SSE2
+	void generateMipmapRow_SSE2(const u32* src, u32* dst, s32 stride, s32 count)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		s32 x = 0;
+		for (; x + 4 <= count; x += 4)
+		{
+			const u32* src0 = src + x * 2;
+			const u32* src1 = src0 + stride;
+			__m128i result[2];
+			for (s32 i = 0; i < 2; i++)
+			{
+				const __m128i row0 = _mm_loadu_si128((const __m128i*)(src0 + i * 4));
+				const __m128i row1 = _mm_loadu_si128((const __m128i*)(src1 + i * 4));
+				// Channels of texels 0,1 and 2,3, summed vertically.
+				const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+				const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+				// Then horizontally: (0 + 1), (2 + 3).
+				const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+				result[i] = _mm_srli_epi16(sum, 2);
+			}
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_packus_epi16(result[0], result[1]));
+		}
+		generateMipmapRow(src + x * 2, dst + x, stride, count - x);
+	}
+#endif
+
+#ifdef TFE_SIMD_NEON
+	void generateMipmapRow_NEON(const u32* src, u32* dst, s32 stride, s32 count)
+	{
+		s32 x = 0;
+		for (; x + 2 <= count; x += 2)
+		{
+			const uint8x16_t row0 = vld1q_u8((const u8*)(src + x * 2));
+			const uint8x16_t row1 = vld1q_u8((const u8*)(src + x * 2 + stride));
+			// Channels of texels 0,1 and 2,3, summed vertically.
+			const uint16x8_t lo = vaddl_u8(vget_low_u8(row0), vget_low_u8(row1));
+			const uint16x8_t hi = vaddl_u8(vget_high_u8(row0), vget_high_u8(row1));
+			// Then horizontally: (0 + 1), (2 + 3).
+			const uint16x8_t sum = vcombine_u16(vadd_u16(vget_low_u16(lo), vget_high_u16(lo)), vadd_u16(vget_low_u16(hi), vget_high_u16(hi)));
+			vst1_u8((u8*)(dst + x), vshrn_n_u16(sum, 2));
+		}
+		generateMipmapRow(src + x * 2, dst + x, stride, count - x);
+	}
+#endif
+
 	void generateMipmap(const u32* source, u32* output, s32 w, s32 h, s32 stride)
 	{
 		s32 wDst = w >> 1;
 		s32 hDst = h >> 1;
 		s32 strideDst = stride >> 1;
 
+		void(*generateRow)(const u32*, u32*, s32, s32) = generateMipmapRow;
+	#ifdef TFE_SIMD_SSE2
+		if (TFE_Simd::hasFeature(SIMD_SSE2)) { generateRow = generateMipmapRow_SSE2; }
+	#endif
+	#ifdef TFE_SIMD_NEON
+		if (TFE_Simd::hasFeature(SIMD_NEON)) { generateRow = generateMipmapRow_NEON; }
+	#endif
+
 		for (s32 y = 0; y < hDst; y++)
 		{
 			const s32 srcY = y * 2;
 			const s32 dstY = y;
-
-			const u32* src = &source[srcY * stride];
-			u32* dst = &output[dstY * strideDst];
-			for (s32 x = 0; x < wDst; x++)
-			{
-				const s32 srcX = x * 2;
-				const s32 dstX = x;
-
-				u32 c0 = src[srcX];
-				u32 c1 = src[srcX + 1];
-				u32 c2 = src[srcX + stride];
-				u32 c3 = src[srcX + 1 + stride];
-
-				u32 r[4] = { c0 & 0xff, c1 & 0xff, c2 & 0xff, c3 & 0xff };
-				u32 g[4] = { (c0>>8) & 0xff, (c1>>8) & 0xff, (c2>>8) & 0xff, (c3>>8) & 0xff };
-				u32 b[4] = { (c0>>16) & 0xff, (c1>>16) & 0xff, (c2>>16) & 0xff, (c3>>16) & 0xff };
-				u32 a[4] = { (c0>>24) & 0xff, (c1>>24) & 0xff, (c2>>24) & 0xff, (c3>>24) & 0xff };
-
-				u32 dr = (r[0] + r[1] + r[2] + r[3]) >> 2;
-				u32 dg = (g[0] + g[1] + g[2] + g[3]) >> 2;
-				u32 db = (b[0] + b[1] + b[2] + b[3]) >> 2;
-				u32 da = (a[0] + a[1] + a[2] + a[3]) >> 2;
-
-				dst[dstX] = dr | (dg << 8) | (db << 16) | (da << 24);
-			}
+			generateRow(&source[srcY * stride], &output[dstY * strideDst], stride, wDst);
 		}
 	}
 
@@ -731,15 +824,15 @@ namespace TFE_Jedi
 		}
 	}
 
-	void generateTrueColorMips(const TextureNode* node, const TextureData* texData, s32 scaleFactor, s32 paddingX, s32 paddingY, s32 mipCount, u32* output)
+	void generateTrueColorMips(const TextureNode* node, s32 page, const TextureData* texData, s32 scaleFactor, s32 paddingX, s32 paddingY, s32 mipCount, u32* output)
 	{
-		const u32* source = (u32*)getWritePointer(s_currentPage, node->rect.x, node->rect.y, 0);
+		const u32* source = (u32*)getWritePointer(page, node->rect.x, node->rect.y, 0);
 		u32 w = texData->width  * scaleFactor + paddingX;
 		u32 h = texData->height * scaleFactor + paddingY;
 		u32 stride = s_texturePacker->width;
 		for (s32 m = 1; m < mipCount; m++)
 		{
-			output = (u32*)getWritePointer(s_currentPage, node->rect.x, node->rect.y, m);
+			output = (u32*)getWritePointer(page, node->rect.x, node->rect.y, m);
 			generateMipmap(source, output, w, h, stride);
 
 			stride >>= 1;
@@ -763,7 +856,7 @@ namespace TFE_Jedi
 		}
 	}
 
-	void packNode(const TextureNode* node, const TextureData* texData, Vec4i* tableEntry, s32 paddingX, s32 paddingY, s32 mipCount, const TextureData* hdSrc, s32 frameIndex)
+	void packNode(const TextureNode* node, s32 page, const TextureData* texData, Vec4i* tableEntry, s32 paddingX, s32 paddingY, s32 mipCount, const TextureData* hdSrc, s32 frameIndex)
 	{
 		// Copy the texture into place.
 		const s32 offsetX = paddingX / 2;
@@ -775,7 +868,7 @@ namespace TFE_Jedi
 		Vec3f halfTint = { 1.0f, 1.0f, 1.0f };
 		if (s_texturePacker->trueColor)
 		{
-			u32* output = (u32*)getWritePointer(s_currentPage, node->rect.x, node->rect.y, 0);
+			u32* output = (u32*)getWritePointer(page, node->rect.x, node->rect.y, 0);
 			if (isHdTex)
 			{
 				const u32* srcImageHd = (u32*)hdSrc->hdAssetData;
@@ -785,15 +878,13 @@ namespace TFE_Jedi
 			{
 				copy8BitToTrueColorTexture(texData, srcImage, paddingX, paddingY, offsetX, offsetY, output, halfTint);
 			}
-			generateTrueColorMips(node, texData, scaleFactor, paddingX, paddingY, mipCount, output);
+			generateTrueColorMips(node, page, texData, scaleFactor, paddingX, paddingY, mipCount, output);
 		}
 		else
 		{
-			u8* output = getWritePointer(s_currentPage, node->rect.x, node->rect.y, 0);
+			u8* output = getWritePointer(page, node->rect.x, node->rect.y, 0);
 			copy8BitTo8BitTexture(texData, srcImage, output);
 		}
-		s_usedTexels += texData->width * texData->height;
-
 		// Copy the mapping into the texture table.
 		tableEntry->x = (s32)node->rect.x + offsetX;
 		tableEntry->y = (s32)node->rect.y + offsetY;
@@ -801,7 +892,7 @@ namespace TFE_Jedi
 		tableEntry->w = (s32)texData->height * scaleFactor;
 
 		// Page the page index into the x offset.
-		tableEntry->x |= (s_currentPage << 12);
+		tableEntry->x |= (page << 12);
 		tableEntry->y |= (scaleFactor << 12);
 
 		// Half color tint packed.
@@ -812,7 +903,7 @@ namespace TFE_Jedi
 		tableEntry->w |= (b << 15);
 	}
 
-	void packNodeDeltaTex(const TextureNode* node, const TextureData* texData, Vec4i* tableEntry, s32 paddingX, s32 paddingY)
+	void packNodeDeltaTex(const TextureNode* node, s32 page, const TextureData* texData, Vec4i* tableEntry, s32 paddingX, s32 paddingY)
 	{
 		// Copy the texture into place.
 		s32 offsetX = paddingX / 2;
@@ -822,7 +913,7 @@ namespace TFE_Jedi
 		{
 			const u32* pal = getPalette(texData->palIndex);
 
-			u32* output = (u32*)getWritePointer(s_currentPage, node->rect.x, node->rect.y, 0);
+			u32* output = (u32*)getWritePointer(page, node->rect.x, node->rect.y, 0);
 			for (s32 y = 0; y < texData->height + paddingY; y++, output += s_texturePacker->width)
 			{
 				const s32 ySrc = y - offsetY;
@@ -839,7 +930,7 @@ namespace TFE_Jedi
 		}
 		else
 		{
-			u8* output = getWritePointer(s_currentPage, node->rect.x, node->rect.y, 0);
+			u8* output = getWritePointer(page, node->rect.x, node->rect.y, 0);
 			for (s32 y = 0; y < texData->height; y++, output += s_texturePacker->width)
 			{
 				for (s32 x = 0; x < texData->width; x++)
@@ -848,8 +939,6 @@ namespace TFE_Jedi
 				}
 			}
 		}
-		s_usedTexels += texData->width * texData->height;
-
 		// Copy the mapping into the texture table.
 		tableEntry->x = (s32)node->rect.x + offsetX;
 		tableEntry->y = (s32)node->rect.y + offsetY;
@@ -858,11 +947,11 @@ namespace TFE_Jedi
 
 		// Page the page index into the x offset.
 		s32 scaleFactor = 1;
-		tableEntry->x |= (s_currentPage << 12);
+		tableEntry->x |= (page << 12);
 		tableEntry->y |= (scaleFactor << 12);
 	}
 		
-	void packNodeCell(const TextureNode* node, const void* basePtr, const WaxCell* cell, const HdWax* hdWax, Vec4i* tableEntry, s32 paddingX, s32 paddingY)
+	void packNodeCell(const TextureNode* node, s32 page, const void* basePtr, const WaxCell* cell, const HdWax* hdWax, Vec4i* tableEntry, s32 paddingX, s32 paddingY)
 	{
 		// Copy the texture into place.
 		s32 offsetX = paddingX / 2;
@@ -883,7 +972,7 @@ namespace TFE_Jedi
 			const u32* pal = getPalette(PALETTE_DEFAULT_IDX);
 			const u8* remap = &TFE_DarkForces::s_levelColorMap[31 << 8];
 
-			u32* output = (u32*)getWritePointer(s_currentPage, node->rect.x, node->rect.y, 0);
+			u32* output = (u32*)getWritePointer(page, node->rect.x, node->rect.y, 0);
 
 			for (s32 x = 0; x < w + paddingX; x++)
 			{
@@ -938,7 +1027,7 @@ namespace TFE_Jedi
 		}
 		else
 		{
-			u8* output = getWritePointer(s_currentPage, node->rect.x, node->rect.y, 0);
+			u8* output = getWritePointer(page, node->rect.x, node->rect.y, 0);
 			for (s32 x = 0; x < w; x++)
 			{
 				u8* column = (u8*)image + columnOffset[x];
@@ -955,8 +1044,6 @@ namespace TFE_Jedi
 				}
 			}
 		}
-		s_usedTexels += w * h;
-
 		// Copy the mapping into the texture table.
 		tableEntry->x = (s32)node->rect.x + offsetX;
 		tableEntry->y = (s32)node->rect.y + offsetY;
@@ -964,10 +1051,30 @@ namespace TFE_Jedi
 		tableEntry->w = (s32)h;
 
 		// Page the page index into the x offset.
-		tableEntry->x |= (s_currentPage << 12);
+		tableEntry->x |= (page << 12);
 		tableEntry->y |= (scaleFactor << 12);
 	}
 
+	void packJob(s32 index, void* userData)
+	{
+		const PackJob& job = s_packJobs[index];
+		switch (job.type)
+		{
+			case PACK_TEXTURE:
+			{
+				packNode(job.node, job.page, job.texData, job.tableEntry, job.paddingX, job.paddingY, job.mipCount, job.hdSrc, job.frameIndex);
+			} break;
+			case PACK_DELT_TEXTURE:
+			{
+				packNodeDeltaTex(job.node, job.page, job.texData, job.tableEntry, job.paddingX, job.paddingY);
+			} break;
+			case PACK_WAX_CELL:
+			{
+				packNodeCell(job.node, job.page, job.basePtr, job.cell, job.hdWax, job.tableEntry, job.paddingX, job.paddingY);
+			} break;
+		}
+	}
+
 	bool isTextureInMap(TextureData* tex)
 	{
 		return (s_textureDataMap.find(tex) != s_textureDataMap.end());
@@ -1057,11 +1164,24 @@ namespace TFE_Jedi
 		}
 
 		s_totalTexels += w * h;
+		s_usedTexels += tex->width * tex->height;
 		insertTextureIntoMap(tex, s_texturePacker->texturesPacked);
 
 		assert(node->tex == tex && s_texturePacker->texturesPacked < MAX_TEXTURE_COUNT);
 		tex->textureId = s_texturePacker->texturesPacked;
-		packNode(node, tex, &s_texturePacker->textureTable[s_texturePacker->texturesPacked], paddingX, paddingY, (tex->flags & ENABLE_MIP_MAPS) ? s_texturePacker->mipCount : 1, packHdTextures ? baseFrame : nullptr, frameIndex);
+
+		PackJob job = {};
+		job.type = PACK_TEXTURE;
+		job.page = s_currentPage;
+		job.node = node;
+		job.tableEntry = &s_texturePacker->textureTable[s_texturePacker->texturesPacked];
+		job.paddingX = paddingX;
+		job.paddingY = paddingY;
+		job.texData = tex;
+		job.hdSrc = packHdTextures ? baseFrame : nullptr;
+		job.mipCount = (tex->flags & ENABLE_MIP_MAPS) ? s_texturePacker->mipCount : 1;
+		job.frameIndex = frameIndex;
+		s_packJobs.push_back(job);
 		s_texturePacker->texturesPacked++;
 		return true;
 	}
@@ -1077,11 +1197,21 @@ namespace TFE_Jedi
 		}
 
 		s_totalTexels += tex->width * tex->height;
+		s_usedTexels += tex->width * tex->height;
 		insertTextureIntoMap(tex, s_texturePacker->texturesPacked);
 
 		assert(node->tex == tex && s_texturePacker->texturesPacked < MAX_TEXTURE_COUNT);
 		tex->textureId = s_texturePacker->texturesPacked;
-		packNodeDeltaTex(node, tex, &s_texturePacker->textureTable[s_texturePacker->texturesPacked], padding, padding);
+
+		PackJob job = {};
+		job.type = PACK_DELT_TEXTURE;
+		job.page = s_currentPage;
+		job.node = node;
+		job.tableEntry = &s_texturePacker->textureTable[s_texturePacker->texturesPacked];
+		job.paddingX = padding;
+		job.paddingY = padding;
+		job.texData = tex;
+		s_packJobs.push_back(job);
 		s_texturePacker->texturesPacked++;
 		return true;
 	}
@@ -1105,11 +1235,23 @@ namespace TFE_Jedi
 		}
 
 		s_totalTexels += w * h;
+		s_usedTexels += w * h;
 		insertWaxCellIntoMap(cell, s_texturePacker->texturesPacked);
 
 		assert(node->tex == cell && s_texturePacker->texturesPacked < MAX_TEXTURE_COUNT);
 		cell->textureId = s_texturePacker->texturesPacked;
-		packNodeCell(node, basePtr, cell, hdWax, &s_texturePacker->textureTable[s_texturePacker->texturesPacked], padding, padding);
+
+		PackJob job = {};
+		job.type = PACK_WAX_CELL;
+		job.page = s_currentPage;
+		job.node = node;
+		job.tableEntry = &s_texturePacker->textureTable[s_texturePacker->texturesPacked];
+		job.paddingX = padding;
+		job.paddingY = padding;
+		job.basePtr = basePtr;
+		job.cell = cell;
+		job.hdWax = hdWax;
+		s_packJobs.push_back(job);
 		s_texturePacker->texturesPacked++;
 		return true;
 	}
@@ -1436,6 +1578,13 @@ namespace TFE_Jedi
 				}
 			}
 		}
+
+		// Now that every texture has a place, copy the texels and build the mips in parallel.
+		{
+			TFE_ZONE("Texture Packer Copy");
+			TFE_Parallel::run((s32)s_packJobs.size(), packJob, nullptr);
+			s_packJobs.clear();
+		}
 		return s_texturePacker->texturesPacked;
 	}
 
@@ -466,6 +466,7 @@ namespace TFE_Settings
 		writeKeyValue_Int(settings, "midiType", s_soundSettings.midiType);
 		writeKeyValue_Bool(settings, "use16Channels", s_soundSettings.use16Channels);
 		writeKeyValue_Bool(settings, "disableSoundInMenus", s_soundSettings.disableSoundInMenus);
+		writeKeyValue_Bool(settings, "midiCache", s_soundSettings.midiCache);
 	}
 
 	void writeSystemSettings(FileStream& settings)
@@ -533,6 +534,7 @@ namespace TFE_Settings
 				writeKeyValue_Bool(settings, "stepSecondAlt", s_gameSettings.df_stepSecondAlt);
 				writeKeyValue_Int(settings, "pitchLimit", s_gameSettings.df_pitchLimit);
 				writeKeyValue_Bool(settings, "solidWallFlagFix", s_gameSettings.df_solidWallFlagFix);
+				writeKeyValue_Bool(settings, "collisionBroadphase", s_gameSettings.df_collisionBroadphase);
 			}
 		}
 	}
@@ -939,6 +941,10 @@ namespace TFE_Settings
 		{
 			s_soundSettings.disableSoundInMenus = parseBool(value);
 		}
+		else if (strcasecmp("midiCache", key) == 0)
+		{
+			s_soundSettings.midiCache = parseBool(value);
+		}
 	}
 
 	void parseSystemSettings(const char* key, const char* value)
@@ -1133,6 +1139,10 @@ namespace TFE_Settings
 		{
 			s_gameSettings.df_solidWallFlagFix = parseBool(value);
 		}
+		else if (strcasecmp("collisionBroadphase", key) == 0)
+		{
+			s_gameSettings.df_collisionBroadphase = parseBool(value);
+		}
 	}
 
 	void parseOutlawsSettings(const char* key, const char* value)
@@ -183,6 +183,7 @@ struct TFE_Settings_Sound
 	s32 midiType = MIDI_TYPE_DEFAULT;
 	bool use16Channels = false;
 	bool disableSoundInMenus = false;
+	bool midiCache = false;		// Cache synthesized music on disk and play it back instead of synthesizing it.
 };
 
 struct TFE_Game
@@ -214,6 +215,7 @@ struct TFE_Settings_Game
 	bool df_ignoreInfLimit = true;		// Ignore the vanilla INF limit.
 	bool df_stepSecondAlt = false;		// Allow the player to step up onto second heights, similar to the way normal stairs work.
 	bool df_solidWallFlagFix = true;	// Solid wall flag is enforced for collision with moving walls.
+	bool df_collisionBroadphase = true;	// Only search nearby sectors for explosion and proximity range queries; false = original full level search.
 	PitchLimit df_pitchLimit  = PITCH_VANILLA_PLUS;
 };
 
@@ -58,6 +58,8 @@ static void tfe_sigaction(int signo, siginfo_t *siginfo, void *uctx)
 		return;
 	}
 
+	// Never wait on the log writer thread from here, it may be the thread that crashed.
+	TFE_System::logEnterCrashMode();
 	TFE_System::logWrite(LOG_ERROR, "CrashHandler", "Received Signal %d errno %d code %d", signo, siginfo->si_addr, siginfo->si_errno, siginfo->si_code);
 
 	switch (signo) {
@@ -80,6 +82,8 @@ static void tfe_sigaction(int signo, siginfo_t *siginfo, void *uctx)
 	} else {
 		TFE_System::logWrite(LOG_ERROR, "CrashHandler", "no backtrace possible");
 	}
+	// Make sure everything queued before the crash reaches the disk before the process dies.
+	TFE_System::logFlush();
 
 	// for certain signals, the default handler will create
 	// a coredump if enabled by administrator.
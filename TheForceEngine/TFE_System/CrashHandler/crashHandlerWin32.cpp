@@ -240,8 +240,10 @@ void showCrashReportPopup(const char* message)
 	// Build the message.
 	sprintf_s(s_msgBuffer, TFE_MAX_PATH, "The Force Engine (TFE) Crashed.\n%s\nCrash dump written to '%s'.", message, s_dirBuffer);
 	// Write to the log.
+	// Flush rather than close and never wait on the log writer thread, it may be the one that crashed.
+	TFE_System::logEnterCrashMode();
 	TFE_System::logWrite(LOG_ERROR, "Crash", s_msgBuffer);
-	TFE_System::logClose();
+	TFE_System::logFlush();
 	// Output to a popup message box.
 	MessageBoxA(NULL, (LPCSTR)s_msgBuffer, (LPCSTR)"Crash Report", MB_OK | MB_ICONERROR | MB_SYSTEMMODAL);
 }
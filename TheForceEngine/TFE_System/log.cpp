@@ -1,7 +1,15 @@
 #include <cstdarg>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 #include <TFE_System/system.h>
+#include <TFE_System/profiler.h>
+#include <TFE_System/mpscQueue.h>
 #include <TFE_FileSystem/filestream.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_FrontEndUI/frontEndUi.h>
@@ -15,11 +23,32 @@
 	#include <io.h>
 #endif
 
+// Log lines are formatted on the calling thread, using per-thread buffers, and pushed into a lock-free queue.
+// A background writer thread drains the queue and writes the lines to disk and the terminal in batches.
+// The writer also collapses repeated lines into a count, so spammy warnings do not flood the log.
+// Logging never blocks the calling thread, which may be the audio or midi thread: long lines are split into
+// several records and lines that do not fit in the queue are dropped, the writer reports how many were lost.
 namespace TFE_System
 {
+	static const u32 c_maxMessageSize   = 8192;
+	static const u32 c_logRecordSize    = 1024;		// Lines longer than this are split into several records.
+	static const u32 c_logQueueSize     = 256;
+	static const u32 c_logBatchSize     = 65536;
+	static const u32 c_logWriteInterval = 10;		// Milliseconds between writer updates when no errors are logged.
+	static const u32 c_logRepeatWindow  = 1000;		// Milliseconds between "repeated" summaries for a line that keeps repeating.
+	static const u32 c_crashLockTries   = 50;		// Attempts, 1ms apart, to get the writer lock after a crash.
+
+	struct LogRecord
+	{
+		u32 type;
+		u32 length;
+		bool partial;		// More of the line follows in the next record.
+		char text[c_logRecordSize];
+	};
+
 	static FileStream s_logFile;
-	static char s_workStr[32768];
-	static char s_msgStr[32768];
+	static thread_local char s_workStr[c_maxMessageSize + 256];
+	static thread_local char s_msgStr[c_maxMessageSize];
 	static const char* c_typeNames[]=
 	{
 		"",			//LOG_MSG = 0,
@@ -28,18 +57,85 @@ namespace TFE_System
 		"Critical", //LOG_CRITICAL,
 	};
 
+	static MpscQueue<LogRecord, c_logQueueSize> s_logQueue;
+	static std::atomic<bool> s_runWriter(false);
+	static std::atomic<bool> s_crashMode(false);
+	static std::atomic<u32> s_droppedLines(0);
+	static std::thread s_writerThread;
+	static std::condition_variable s_wake;
+	// Held by whoever is consuming the queue and writing to the file: the writer thread or a direct write.
+	static std::mutex s_writeMutex;
+
+	// Writer state, only accessed while holding s_writeMutex.
+	static char s_batch[c_logBatchSize + 1];
+	static u32  s_batchSize = 0;
+	static LogRecord s_lastRecord;
+	static bool s_hasLastRecord = false;
+	static u32  s_repeatCount = 0;
+	static bool s_lineOpen = false;		// The last record written was partial, so the line has not ended.
+	static std::chrono::steady_clock::time_point s_repeatWindowStart;
+
+	void logFlushInternal();
+	void logWriterFunc();
+
+	// After a crash the writer thread may be the one that crashed, possibly while holding s_writeMutex, so never
+	// block on it. If it cannot be locked, the crashing thread writes the queued records without it.
+	static bool crashLock()
+	{
+		for (u32 i = 0; i < c_crashLockTries; i++)
+		{
+			if (s_writeMutex.try_lock()) { return true; }
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return false;
+	}
+
 	bool logOpen(const char* filename)
 	{
 		char logPath[TFE_MAX_PATH];
 		TFE_Paths::appendPath(PATH_USER_DOCUMENTS, filename, logPath);
 
-		return s_logFile.open(logPath, Stream::MODE_WRITE);
+		if (!s_logFile.open(logPath, Stream::MODE_WRITE))
+		{
+			return false;
+		}
+		s_repeatWindowStart = std::chrono::steady_clock::now();
+		s_runWriter.store(true);
+		s_writerThread = std::thread(logWriterFunc);
+		return true;
 	}
 
 	void logClose()
 	{
+		if (s_writerThread.joinable())
+		{
+			s_runWriter.store(false);
+			s_wake.notify_one();
+			s_writerThread.join();
+		}
+		logFlush();
 		s_logFile.close();
 	}
+
+	void logFlush()
+	{
+		if (!s_logFile.isOpen()) { return; }
+
+		if (s_crashMode.load())
+		{
+			const bool locked = crashLock();
+			logFlushInternal();
+			if (locked) { s_writeMutex.unlock(); }
+			return;
+		}
+		std::lock_guard<std::mutex> lock(s_writeMutex);
+		logFlushInternal();
+	}
+
+	void logEnterCrashMode()
+	{
+		s_crashMode.store(true);
+	}
 	
 	void debugWrite(const char* tag, const char* str, ...)
 	{
@@ -48,10 +144,10 @@ namespace TFE_System
 		//Handle the variable input, "printf" style messages
 		va_list arg;
 		va_start(arg, str);
-		vsprintf(s_msgStr, str, arg);
+		vsnprintf(s_msgStr, c_maxMessageSize, str, arg);
 		va_end(arg);
 
-		sprintf(s_workStr, "[%s] %s\r\n", tag, s_msgStr);
+		snprintf(s_workStr, sizeof(s_workStr), "[%s] %s\r\n", tag, s_msgStr);
 
 		//Write to the debugger or terminal output.
 		#ifdef _WIN32
@@ -61,6 +157,193 @@ namespace TFE_System
 		#endif
 	}
 
+	////////////////////////////////////////////
+	// Writer, called with s_writeMutex held.
+	////////////////////////////////////////////
+	static void batchFlush()
+	{
+		if (!s_batchSize) { return; }
+
+		s_logFile.writeBuffer(s_batch, s_batchSize);
+		s_logFile.flush();
+		//Write to the debugger or terminal output.
+		s_batch[s_batchSize] = 0;
+		#ifdef _WIN32
+			OutputDebugStringA(s_batch);
+		#else
+			fprintf(stderr, "%s", s_batch);
+		#endif
+		s_batchSize = 0;
+	}
+
+	static void batchAppend(const char* text, u32 length)
+	{
+		if (s_batchSize + length > c_logBatchSize)
+		{
+			batchFlush();
+		}
+		// Lines larger than the batch itself are written on their own.
+		if (length > c_logBatchSize)
+		{
+			s_logFile.writeBuffer(text, length);
+			fwrite(text, 1, length, stderr);
+			return;
+		}
+		memcpy(s_batch + s_batchSize, text, length);
+		s_batchSize += length;
+	}
+
+	static void batchAppendSummary(const char* str, u32 count)
+	{
+		char line[256];
+		s32 length = snprintf(line, sizeof(line), str, count);
+		if (length > 0)
+		{
+			batchAppend(line, (u32)length);
+		}
+	}
+
+	static void writeRepeatSummary()
+	{
+		if (s_repeatCount)
+		{
+			batchAppendSummary("[Log] The previous message was repeated %u times.\r\n", s_repeatCount);
+			s_repeatCount = 0;
+		}
+	}
+
+	// Report lines that keep repeating at least once per window, rather than only when a different line arrives.
+	static void updateRepeatWindow()
+	{
+		const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now - s_repeatWindowStart < std::chrono::milliseconds(c_logRepeatWindow)) { return; }
+
+		writeRepeatSummary();
+		s_repeatWindowStart = now;
+	}
+
+	static void writeRecord(const LogRecord& record)
+	{
+		// Collapse repeated lines into a count, pieces of long lines are always written.
+		const bool wholeLine = !record.partial && !s_lineOpen;
+		if (wholeLine && s_hasLastRecord && record.length == s_lastRecord.length && memcmp(record.text, s_lastRecord.text, record.length) == 0)
+		{
+			s_repeatCount++;
+			return;
+		}
+		writeRepeatSummary();
+		batchAppend(record.text, record.length);
+		s_lineOpen = record.partial;
+
+		s_hasLastRecord = wholeLine;
+		if (wholeLine)
+		{
+			s_lastRecord.type = record.type;
+			s_lastRecord.length = record.length;
+			memcpy(s_lastRecord.text, record.text, record.length);
+		}
+	}
+
+	static void writeDroppedSummary()
+	{
+		const u32 dropped = s_droppedLines.exchange(0);
+		if (!dropped) { return; }
+
+		writeRepeatSummary();
+		if (s_lineOpen)
+		{
+			// The rest of the line was dropped.
+			batchAppend("\r\n", 2);
+			s_lineOpen = false;
+		}
+		batchAppendSummary("[Log] %u lines were dropped because the log queue was full.\r\n", dropped);
+		s_hasLastRecord = false;
+	}
+
+	static void writeQueued()
+	{
+		LogRecord record;
+		while (s_logQueue.pop(record))
+		{
+			writeRecord(record);
+		}
+		writeDroppedSummary();
+		updateRepeatWindow();
+	}
+
+	void logFlushInternal()
+	{
+		writeQueued();
+		writeRepeatSummary();
+		batchFlush();
+	}
+
+	void logWriterFunc()
+	{
+		TFE_Profiler::setThreadName("Log Writer");
+
+		std::unique_lock<std::mutex> lock(s_writeMutex);
+		while (s_runWriter.load())
+		{
+			s_wake.wait_for(lock, std::chrono::milliseconds(c_logWriteInterval));
+			// Leave the queue to the crash handler.
+			if (s_crashMode.load()) { continue; }
+			writeQueued();
+			batchFlush();
+		}
+	}
+
+	////////////////////////////////////////////
+	// Producer, any thread.
+	////////////////////////////////////////////
+	// Write a line immediately, after everything already queued. Only used after a crash.
+	static void writeLineDirect(const char* text, u32 length)
+	{
+		writeQueued();
+		writeRepeatSummary();
+		if (s_lineOpen)
+		{
+			batchAppend("\r\n", 2);
+			s_lineOpen = false;
+		}
+		batchAppend(text, length);
+		s_hasLastRecord = false;
+		batchFlush();
+	}
+
+	static void queueLine(LogWriteType type, const char* text, u32 length)
+	{
+		// After a crash, write lines immediately since the process may not survive until the next flush.
+		if (s_crashMode.load())
+		{
+			const bool locked = crashLock();
+			writeLineDirect(text, length);
+			if (locked) { s_writeMutex.unlock(); }
+			return;
+		}
+
+		// Records from other threads may land between the pieces of a long line.
+		bool dropped = false;
+		LogRecord record;
+		record.type = type;
+		for (u32 offset = 0; offset < length;)
+		{
+			record.length = std::min(length - offset, c_logRecordSize);
+			record.partial = offset + record.length < length;
+			memcpy(record.text, text + offset, record.length);
+			if (!s_logQueue.push(record))
+			{
+				// Never wait for the writer, count the line so the writer can report it.
+				s_droppedLines.fetch_add(1, std::memory_order_relaxed);
+				dropped = true;
+				break;
+			}
+			offset += record.length;
+		}
+		// Get errors to disk quickly, in case a crash follows, and drain a full queue as soon as possible.
+		if (type >= LOG_ERROR || dropped) { s_wake.notify_one(); }
+	}
+
 	void logWrite(LogWriteType type, const char* tag, const char* str, ...)
 	{
 		if (type >= LOG_COUNT || !s_logFile.isOpen() || !tag || !str) { return; }
@@ -68,37 +351,29 @@ namespace TFE_System
 		//Handle the variable input, "printf" style messages
 		va_list arg;
 		va_start(arg, str);
-		vsprintf(s_msgStr, str, arg);
+		vsnprintf(s_msgStr, c_maxMessageSize, str, arg);
 		va_end(arg);
 		//Format the message
+		s32 length;
 		if (type != LOG_MSG)
 		{
-			sprintf(s_workStr, "[%s : %s] %s\r\n", c_typeNames[type], tag, s_msgStr);
+			length = snprintf(s_workStr, sizeof(s_workStr), "[%s : %s] %s\r\n", c_typeNames[type], tag, s_msgStr);
 		}
 		else
 		{
-			sprintf(s_workStr, "[%s] %s\r\n", tag, s_msgStr);
-		}
-		//Write to disk
-		s_logFile.writeBuffer(s_workStr, (u32)strlen(s_workStr));
-		//Make sure to flush the file to disk if a crash is likely.
-		//if (type == LOG_ERROR || type == LOG_CRITICAL)
-		{
-			s_logFile.flush();
+			length = snprintf(s_workStr, sizeof(s_workStr), "[%s] %s\r\n", tag, s_msgStr);
 		}
-		//Write to the debugger or terminal output.
-		#ifdef _WIN32
-			OutputDebugStringA(s_workStr);
-		#else
-			fprintf(stderr, "%s", s_workStr);
-		#endif
+		if (length < 0) { return; }
+		if (length >= (s32)sizeof(s_workStr)) { length = (s32)sizeof(s_workStr) - 1; }
+		//Queue for the writer thread
+		queueLine(type, s_workStr, (u32)length);
 		//Critical log messages also act as asserts in the debugger.
 		if (type == LOG_CRITICAL)
 		{
+			logFlush();
 			assert(0);
 		}
 
-		sprintf(s_workStr, "[%s] %s", tag, s_msgStr);
 		size_t len = strlen(s_msgStr);
 		char* msg = s_msgStr;
 		char* msgStart = msg;
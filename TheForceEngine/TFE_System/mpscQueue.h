@@ -0,0 +1,86 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Multiple Producer / Single Consumer Queue
+// A fixed size lock-free ring buffer that any number of threads can
+// push into while exactly one thread pops, such as log records
+// written from the game, audio and midi threads.
+//////////////////////////////////////////////////////////////////////
+#include "types.h"
+#include <atomic>
+
+template <typename T, u32 Capacity>
+class MpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "MpscQueue capacity must be a power of two.");
+
+public:
+	MpscQueue() : m_head(0), m_tail(0)
+	{
+		for (u32 i = 0; i < Capacity; i++)
+		{
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	// Any thread, returns false if the queue is full.
+	bool push(const T& item)
+	{
+		u32 tail = m_tail.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = m_slots[tail & (Capacity - 1)];
+			const s32 diff = s32(slot.sequence.load(std::memory_order_acquire) - tail);
+			if (diff == 0)
+			{
+				// The slot is free, claim it by advancing the tail.
+				if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+				{
+					slot.item = item;
+					slot.sequence.store(tail + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				// The consumer has not released this slot yet.
+				return false;
+			}
+			else
+			{
+				// Another producer claimed the slot first.
+				tail = m_tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Consumer only, returns false if the queue is empty or the oldest item is still being written.
+	bool pop(T& item)
+	{
+		const u32 head = m_head.load(std::memory_order_relaxed);
+		Slot& slot = m_slots[head & (Capacity - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != head + 1) { return false; }
+
+		item = slot.item;
+		slot.sequence.store(head + Capacity, std::memory_order_release);
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// The number of queued items, this is only a snapshot while other threads are active.
+	u32 size() const
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<u32> sequence;
+		T item;
+	};
+
+	// Keep the indices on separate cache lines so producers and the consumer do not contend.
+	alignas(64) std::atomic<u32> m_head;
+	alignas(64) std::atomic<u32> m_tail;
+	Slot m_slots[Capacity];
+};
@@ -0,0 +1,158 @@
+#include "parallel.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace TFE_Parallel
+{
+	enum ParallelConstants
+	{
+		MAX_WORKER_COUNT = 63,
+	};
+
+	static std::vector<std::thread> s_workers;
+	// Held for the duration of run(), so batches from different threads do not overlap.
+	static std::mutex s_runMutex;
+	static std::mutex s_mutex;
+	static std::condition_variable s_wake;
+	static std::condition_variable s_done;
+	static bool s_quit = false;
+	static u32  s_generation = 0;
+	static s32  s_activeWorkers = 0;
+	static thread_local bool s_inTask = false;
+
+	// The current batch, only modified while no worker is active.
+	static ParallelTaskFunc s_task = nullptr;
+	static void* s_userData = nullptr;
+	static s32 s_taskCount = 0;
+	static std::atomic<s32> s_nextTask(0);
+	static std::atomic<s32> s_tasksRemaining(0);
+
+	static void executeTasks()
+	{
+		s_inTask = true;
+		for (s32 i = s_nextTask++; i < s_taskCount; i = s_nextTask++)
+		{
+			s_task(i, s_userData);
+			s_tasksRemaining--;
+		}
+		s_inTask = false;
+	}
+
+	static void workerLoop(s32 index)
+	{
+		char name[32];
+		sprintf(name, "Worker %d", index);
+		TFE_Profiler::setThreadName(name);
+
+		u32 generation = 0;
+		std::unique_lock<std::mutex> lock(s_mutex);
+		while (1)
+		{
+			s_wake.wait(lock, [&generation] { return s_quit || s_generation != generation; });
+			if (s_quit) { break; }
+			generation = s_generation;
+
+			s_activeWorkers++;
+			lock.unlock();
+			executeTasks();
+			lock.lock();
+
+			s_activeWorkers--;
+			if (s_activeWorkers == 0)
+			{
+				s_done.notify_all();
+			}
+		}
+	}
+
+	static void startWorkers()
+	{
+		const s32 workerCount = std::min(getHardwareThreadCount() - 1, s32(MAX_WORKER_COUNT));
+		s_quit = false;
+		for (s32 i = 0; i < workerCount; i++)
+		{
+			s_workers.push_back(std::thread(workerLoop, i));
+		}
+	}
+
+	s32 getHardwareThreadCount()
+	{
+		return std::max(1, s32(std::thread::hardware_concurrency()));
+	}
+
+	static void runSerial(s32 count, ParallelTaskFunc task, void* userData)
+	{
+		const bool inTask = s_inTask;
+		s_inTask = true;
+		for (s32 i = 0; i < count; i++)
+		{
+			task(i, userData);
+		}
+		s_inTask = inTask;
+	}
+
+	void run(s32 count, ParallelTaskFunc task, void* userData)
+	{
+		if (count <= 0 || !task) { return; }
+		// Nested calls cannot wait for the batch they are part of.
+		if (count == 1 || s_inTask)
+		{
+			runSerial(count, task, userData);
+			return;
+		}
+
+		// Calls from other threads wait for the current batch to finish.
+		std::lock_guard<std::mutex> runLock(s_runMutex);
+		if (s_workers.empty())
+		{
+			startWorkers();
+		}
+		// Nothing to gain from the workers, so just run the tasks in order.
+		if (s_workers.empty())
+		{
+			runSerial(count, task, userData);
+			return;
+		}
+
+		{
+			// A worker that woke up after the previous batch finished may still be on its way out.
+			std::unique_lock<std::mutex> lock(s_mutex);
+			s_done.wait(lock, [] { return s_activeWorkers == 0; });
+			s_task = task;
+			s_userData = userData;
+			s_taskCount = count;
+			s_nextTask = 0;
+			s_tasksRemaining = count;
+			s_generation++;
+		}
+		s_wake.notify_all();
+		executeTasks();
+
+		// Workers that wake up late may still join the batch, so wait for them to leave before the next batch can start.
+		std::unique_lock<std::mutex> lock(s_mutex);
+		s_done.wait(lock, [] { return s_tasksRemaining == 0 && s_activeWorkers == 0; });
+		s_task = nullptr;
+		s_userData = nullptr;
+		s_taskCount = 0;
+	}
+
+	void shutdown()
+	{
+		std::lock_guard<std::mutex> runLock(s_runMutex);
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_quit = true;
+		}
+		s_wake.notify_all();
+		for (size_t i = 0; i < s_workers.size(); i++)
+		{
+			s_workers[i].join();
+		}
+		s_workers.clear();
+	}
+}
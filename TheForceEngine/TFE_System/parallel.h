@@ -0,0 +1,23 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Parallel
+// A small pool of persistent worker threads used to split work that
+// is already divided into independent tasks (such as screen strips)
+// across the available cores. The calling thread always takes part,
+// so a single task never leaves the calling thread.
+//////////////////////////////////////////////////////////////////////
+#include "types.h"
+
+namespace TFE_Parallel
+{
+	typedef void(*ParallelTaskFunc)(s32 index, void* userData);
+
+	// Number of hardware threads, including the calling thread.
+	s32  getHardwareThreadCount();
+	// Calls task(i, userData) for every i in [0, count) using the calling thread and the worker threads.
+	// Returns once all of the tasks have completed. Calls made from inside of a task run serially.
+	// Any thread may call run(), batches started from different threads are run one at a time.
+	void run(s32 count, ParallelTaskFunc task, void* userData);
+	// Stops the worker threads, which are restarted on demand by run().
+	void shutdown();
+}
@@ -1,25 +1,29 @@
 #include <cstring>
 
 #include "profiler.h"
+#include <TFE_FileSystem/filestream.h>
 #include <assert.h>
 #include <algorithm>
+#include <atomic>
 #include <vector>
 #include <string>
 #include <map>
-
-// TODO: Support call "paths" - with seperate time per path.
+#include <mutex>
+#include <thread>
 
 namespace TFE_Profiler
 {
 	#define ZONE_BUFFER_COUNT 2
 	#define MAX_ZONE_STACK 256
-	
+	#define TRACE_EVENT_COUNT (1 << 15)	// Per thread, the oldest events are overwritten.
+	#define THREAD_ZONE 0xfffffffe		// Zone id returned on threads other than the main thread.
+
+	// A zone is a unique call path: the same name under different parents results in different zones.
 	struct Zone
 	{
 		u32  id;
 		u32  level = 0;
 		u32  parent = NULL_ZONE;
-		u64  path;
 		u64  frame;
 		char name[64];
 		char func[64];
@@ -42,12 +46,48 @@ namespace TFE_Profiler
 		char name[64];
 	};
 
+	enum TraceEventType : u32
+	{
+		TRACE_BEGIN = 0,
+		TRACE_END,
+	};
+
+	struct TraceEvent
+	{
+		u64 time;
+		const char* name;
+		TraceEventType type;
+	};
+
+	// Each thread has its own zone stack and trace event ring buffer, only the owning thread writes to them.
+	struct ThreadState
+	{
+		~ThreadState() { delete[] events; }
+
+		u32 index;
+		char name[64];
+		u32 level = 0;
+		u32 zoneStack[MAX_ZONE_STACK];
+		bool retired = false;			// The thread has exited, the state is freed once no capture needs its events.
+
+		TraceEvent* events = nullptr;
+		std::atomic<u32> eventCount;	// Total events written, the ring index is eventCount % TRACE_EVENT_COUNT.
+	};
+
+	// Retires the thread state when its thread exits.
+	struct ThreadStateOwner
+	{
+		~ThreadStateOwner();
+		ThreadState* state = nullptr;
+	};
+
 	typedef std::map<std::string, u32> ZoneMap;
+	typedef std::map<std::pair<u32, std::string>, u32> ZonePathMap;
 	typedef std::vector<Zone> ZoneList;
 	typedef std::vector<u32> SortedZoneList;
 	typedef std::vector<Counter> CounterList;
 
-	static ZoneMap  s_zoneMap;
+	static ZonePathMap s_zoneMap;
 	static ZoneList s_zoneList;
 	static SortedZoneList s_sortedZoneList;
 	static SortedZoneList s_roots;
@@ -59,52 +99,139 @@ namespace TFE_Profiler
 	static f64 s_frameTime;
 	static u32 s_readBuffer = 0;
 	static u32 s_writeBuffer = 1;
-	static u32 s_level;
-	static u32 s_maxLevel;
-	static u32 s_zoneStack[MAX_ZONE_STACK];
 	static u64 s_currentFrame = 1;
-	static u64 s_currentPath;
+	// frameEnd() is skipped on frames where the game does not update, so a frame may span several frameBegin() calls.
+	static bool s_frameOpen = false;
+	// Zone timing is aggregated on the main thread, other threads (such as render strips or audio) only record trace events.
+	static const std::thread::id s_mainThread = std::this_thread::get_id();
+
+	static std::mutex s_threadMutex;
+	static std::vector<ThreadState*> s_threads;
+	static u32 s_threadIndex = 0;	// Trace thread IDs are never reused.
+	static thread_local ThreadStateOwner s_threadState;
+
+	// Trace capture
+	static std::atomic<bool> s_capturing(false);
+	static u32 s_captureFramesRemaining = 0;
+	static u32 s_captureFrameCount = 0;
+	static u64 s_captureBegin = 0;
+	static u64 s_captureEnd = 0;
+	static std::string s_capturePath;
+	static std::string s_lastTracePath;
+
+	static void writeTrace();
+
+	static ThreadState* getThreadState()
+	{
+		if (!s_threadState.state)
+		{
+			ThreadState* state = new ThreadState();
+			state->eventCount = 0;
 
-	void addZoneChild(u32 parentId, u32 zoneId)
+			std::lock_guard<std::mutex> lock(s_threadMutex);
+			state->index = s_threadIndex++;
+			if (std::this_thread::get_id() == s_mainThread)
+			{
+				strcpy(state->name, "Main");
+			}
+			else
+			{
+				sprintf(state->name, "Thread %u", state->index);
+			}
+			s_threads.push_back(state);
+			s_threadState.state = state;
+		}
+		return s_threadState.state;
+	}
+
+	ThreadStateOwner::~ThreadStateOwner()
 	{
-		Zone& parent = s_zoneList[parentId];
-		Zone& zone = s_zoneList[zoneId];
-		// This has already been added.
-		if (zone.sibling != NULL_ZONE)
+		if (!state) { return; }
+
+		std::lock_guard<std::mutex> lock(s_threadMutex);
+		// Other threads have finished by the time the main thread exits, so nothing else can need the state.
+		if (std::this_thread::get_id() == s_mainThread)
 		{
-			return;
+			s_threads.erase(std::find(s_threads.begin(), s_threads.end(), state));
+			delete state;
+		}
+		else
+		{
+			// The events may still be needed for the current capture, so the main thread frees it later.
+			state->retired = true;
 		}
+		state = nullptr;
+	}
 
-		if (parent.child == zoneId)
+	// Called from the main thread when no capture is in progress.
+	static void freeRetiredThreads()
+	{
+		std::lock_guard<std::mutex> lock(s_threadMutex);
+		for (size_t t = 0; t < s_threads.size();)
 		{
-			return;
+			if (s_threads[t]->retired)
+			{
+				delete s_threads[t];
+				s_threads.erase(s_threads.begin() + t);
+			}
+			else
+			{
+				t++;
+			}
 		}
-		else if (parent.child == NULL_ZONE)
+	}
+
+	static void addTraceEvent(ThreadState* thread, const char* name, TraceEventType type)
+	{
+		if (!s_capturing.load(std::memory_order_relaxed)) { return; }
+		if (!thread->events)
+		{
+			thread->events = new TraceEvent[TRACE_EVENT_COUNT];
+		}
+
+		const u32 count = thread->eventCount.load(std::memory_order_relaxed);
+		TraceEvent& evt = thread->events[count & (TRACE_EVENT_COUNT - 1)];
+		evt.time = TFE_System::getCurrentTimeInTicks();
+		evt.name = name;
+		evt.type = type;
+		thread->eventCount.store(count + 1, std::memory_order_release);
+	}
+
+	void addZoneChild(u32 parentId, u32 zoneId)
+	{
+		Zone& parent = s_zoneList[parentId];
+		if (parent.child == NULL_ZONE)
 		{
 			parent.child = zoneId;
+			return;
 		}
-		else
+
+		Zone* child = &s_zoneList[parent.child];
+		while (child->sibling != NULL_ZONE)
 		{
-			Zone* child = &s_zoneList[parent.child];
-			while (1)
-			{
-				if (child->sibling == zoneId)
-				{
-					return;
-				}
-				else if (child->sibling == NULL_ZONE)
-				{
-					child->sibling = zoneId;
-					break;
-				}
-				child = &s_zoneList[child->sibling];
-			};
+			child = &s_zoneList[child->sibling];
 		}
+		child->sibling = zoneId;
 	}
 
 	u32 beginZone(const char* name, const char* func, u32 lineNumber)
 	{
-		ZoneMap::iterator iZone = s_zoneMap.find(name);
+		ThreadState* thread = getThreadState();
+		const bool mainThread = std::this_thread::get_id() == s_mainThread;
+		// endZone() does nothing for NULL_ZONE, so no trace event is recorded for it either.
+		if (mainThread && thread->level >= MAX_ZONE_STACK) { return NULL_ZONE; }
+
+		addTraceEvent(thread, name, TRACE_BEGIN);
+		if (!mainThread)
+		{
+			thread->level++;
+			return THREAD_ZONE;
+		}
+
+		// Zones are keyed by their parent, so each call path is timed separately.
+		const u32 parentId = thread->level > 0 ? thread->zoneStack[thread->level - 1] : NULL_ZONE;
+		const std::pair<u32, std::string> key(parentId, name);
+		ZonePathMap::iterator iZone = s_zoneMap.find(key);
 		u32 id = 0;
 
 		if (iZone == s_zoneMap.end())
@@ -113,47 +240,52 @@ namespace TFE_Profiler
 
 			Zone zone;
 			zone.id = id;
-			zone.path = s_currentPath;
+			zone.level = thread->level;
+			zone.parent = parentId;
 			zone.timeInZone[s_readBuffer]  = 0;
 			zone.timeInZone[s_writeBuffer] = 0;
 			zone.timeInZoneAve = 0.0;
 			zone.fractOfParentAve = 0.0;
 			zone.frame = 0;
-			
-			s_zoneList.push_back(zone);
-			s_zoneMap[name] = id;
-		}
-		else
-		{
-			id = iZone->second;
-		}
+			strncpy(zone.name, name, sizeof(zone.name) - 1);
+			zone.name[sizeof(zone.name) - 1] = 0;
+			strncpy(zone.func, func, sizeof(zone.func) - 1);
+			zone.func[sizeof(zone.func) - 1] = 0;
+			zone.lineNumber = lineNumber;
 
-		Zone& zone = s_zoneList[id];
-		strcpy(zone.name, name);
-		strcpy(zone.func, func);
-		zone.lineNumber = lineNumber;
-		zone.level = s_level;
+			s_zoneList.push_back(zone);
+			s_zoneMap[key] = id;
 
-		zone.parent = s_level > 0 ? s_zoneStack[s_level - 1] : NULL_ZONE;
-		if (zone.parent == NULL_ZONE)
-		{
-			s_roots.push_back(id);
+			if (parentId == NULL_ZONE)
+			{
+				s_roots.push_back(id);
+			}
+			else
+			{
+				addZoneChild(parentId, id);
+			}
 		}
 		else
 		{
-			addZoneChild(zone.parent, zone.id);
+			id = iZone->second;
 		}
 
-		s_zoneStack[s_level] = id;
-		s_level++;
+		s_zoneList[id].frame = s_currentFrame;
+		thread->zoneStack[thread->level] = id;
+		thread->level++;
 
 		return id;
 	}
 
 	void endZone(u32 id, u64 dt)
 	{
+		if (id == NULL_ZONE) { return; }
+		ThreadState* thread = getThreadState();
+		addTraceEvent(thread, nullptr, TRACE_END);
+		if (thread->level > 0) { thread->level--; }
+		if (id == THREAD_ZONE) { return; }
+
 		s_zoneList[id].timeInZone[s_writeBuffer] += TFE_System::convertFromTicksToSeconds(dt);
-		s_level--;
 	}
 
 	void addCounter(const char* name, s32* counter)
@@ -174,6 +306,14 @@ namespace TFE_Profiler
 		}
 	}
 
+	void setThreadName(const char* name)
+	{
+		ThreadState* thread = getThreadState();
+		std::lock_guard<std::mutex> lock(s_threadMutex);
+		strncpy(thread->name, name, sizeof(thread->name) - 1);
+		thread->name[sizeof(thread->name) - 1] = 0;
+	}
+
 	void frameBegin()
 	{
 		std::swap(s_readBuffer, s_writeBuffer);
@@ -182,9 +322,7 @@ namespace TFE_Profiler
 		s_readBuffer  %= ZONE_BUFFER_COUNT;
 		s_writeBuffer %= ZONE_BUFFER_COUNT;
 
-		s_level = 0;
-		s_maxLevel = 0;
-		s_roots.clear();
+		getThreadState()->level = 0;
 
 		// Swap buffers, s_readBuffer is safe to read in the middle of the next frame.
 		const size_t zoneCount = s_zoneList.size();
@@ -201,31 +339,33 @@ namespace TFE_Profiler
 			s_counterList[i].prevValue = *s_counterList[i].ptr;
 		}
 
+		if (!s_frameOpen)
+		{
+			// Start a requested capture on a frame boundary.
+			if (s_captureFramesRemaining && !s_capturing)
+			{
+				s_captureBegin = TFE_System::getCurrentTimeInTicks();
+				s_capturing = true;
+			}
+			addTraceEvent(getThreadState(), "Frame", TRACE_BEGIN);
+			s_frameOpen = true;
+		}
+
 		s_frameBegin = TFE_System::getCurrentTimeInTicks();
 	}
 
+	// Lists the zones used in the current frame in depth first order.
 	void traverseZoneTree(u32 id)
 	{
-		if (id == NULL_ZONE) { return; }
-		Zone* zone = &s_zoneList[id];
-		// Make sure zones are only inserted once for now.
-		if (zone->frame != s_currentFrame)
-		{
-			s_sortedZoneList.push_back(id);
-		}
-		zone->frame = s_currentFrame;
-		
-		while (zone->child != NULL_ZONE)
-		{
-			traverseZoneTree(zone->child);
-			zone = &s_zoneList[zone->child];
-		}
-
-		zone = &s_zoneList[id];
-		while (zone->sibling != NULL_ZONE)
+		while (id != NULL_ZONE)
 		{
-			traverseZoneTree(zone->sibling);
-			zone = &s_zoneList[zone->sibling];
+			const Zone& zone = s_zoneList[id];
+			if (zone.frame == s_currentFrame)
+			{
+				s_sortedZoneList.push_back(id);
+				traverseZoneTree(zone.child);
+			}
+			id = zone.sibling;
 		}
 	}
 
@@ -249,7 +389,7 @@ namespace TFE_Profiler
 			s_zoneList[i].timeInZoneAve = expBlend * s_zoneList[i].timeInZoneAve + (1.0 - expBlend)*s_zoneList[i].timeInZone[s_writeBuffer];
 		}
 
-		// Then handle percentage of parent and clear
+		// Then handle percentage of parent.
 		for (size_t i = 0; i < zoneCount; i++)
 		{
 			f64 parentTime = (s_zoneList[i].parent != NULL_ZONE) ? s_zoneList[s_zoneList[i].parent].timeInZone[s_writeBuffer] : s_frameTime;
@@ -260,9 +400,23 @@ namespace TFE_Profiler
 			{
 				s_zoneList[i].fractOfParentAve = 0.0;
 			}
+		}
 
-			s_zoneList[i].child = NULL_ZONE;
-			s_zoneList[i].sibling = NULL_ZONE;
+		addTraceEvent(getThreadState(), "Frame", TRACE_END);
+		s_frameOpen = false;
+		if (s_capturing)
+		{
+			s_captureFramesRemaining--;
+			if (!s_captureFramesRemaining)
+			{
+				s_capturing = false;
+				s_captureEnd = TFE_System::getCurrentTimeInTicks();
+				writeTrace();
+			}
+		}
+		if (!s_capturing)
+		{
+			freeRetiredThreads();
 		}
 
 		s_currentFrame++;
@@ -306,4 +460,133 @@ namespace TFE_Profiler
 		info->name = counter.name;
 		info->value = counter.prevValue;
 	}
+
+	/////////////////////////////////////////////////
+	// Trace capture
+	/////////////////////////////////////////////////
+	bool captureTrace(u32 frameCount, const char* path)
+	{
+		if (isCapturingTrace() || !frameCount || !path) { return false; }
+		s_capturePath = path;
+		s_captureFrameCount = frameCount;
+		s_captureFramesRemaining = frameCount;
+		return true;
+	}
+
+	bool isCapturingTrace()
+	{
+		return s_captureFramesRemaining > 0;
+	}
+
+	const char* getLastTracePath()
+	{
+		return s_lastTracePath.c_str();
+	}
+
+	static void writeTraceName(FileStream& file, const char* name)
+	{
+		char escaped[256];
+		size_t len = 0;
+		for (const char* c = name; *c && len < sizeof(escaped) - 2; c++)
+		{
+			if (*c == '"' || *c == '\\') { escaped[len++] = '\\'; }
+			escaped[len++] = (*c >= ' ') ? *c : ' ';
+		}
+		escaped[len] = 0;
+		file.writeString("\"name\":\"%s\"", escaped);
+	}
+
+	// Events of one thread copied out of its ring buffer.
+	struct TraceThread
+	{
+		u32 index;
+		char name[64];
+		std::vector<TraceEvent> events;
+	};
+
+	// Writes the captured events in the Chrome trace event format, times are in microseconds from the start of the capture.
+	static void writeTrace()
+	{
+		// Copy the captured events while holding the lock, so other threads are not blocked on the file writes.
+		std::vector<TraceThread> threads;
+		{
+			std::lock_guard<std::mutex> lock(s_threadMutex);
+			threads.reserve(s_threads.size());
+			for (size_t t = 0; t < s_threads.size(); t++)
+			{
+				const ThreadState* thread = s_threads[t];
+				const u32 count = thread->eventCount.load(std::memory_order_acquire);
+				if (!count || !thread->events) { continue; }
+
+				threads.push_back({});
+				TraceThread& copy = threads.back();
+				copy.index = thread->index;
+				memcpy(copy.name, thread->name, sizeof(copy.name));
+
+				const u32 start = count > TRACE_EVENT_COUNT ? count - TRACE_EVENT_COUNT : 0;
+				copy.events.reserve(count - start);
+				for (u32 i = start; i < count; i++)
+				{
+					const TraceEvent& evt = thread->events[i & (TRACE_EVENT_COUNT - 1)];
+					if (evt.time < s_captureBegin || evt.time > s_captureEnd) { continue; }
+					copy.events.push_back(evt);
+				}
+			}
+		}
+
+		FileStream file;
+		if (!file.open(s_capturePath.c_str(), Stream::MODE_WRITE))
+		{
+			TFE_System::logWrite(LOG_ERROR, "Profiler", "Cannot write trace '%s'.", s_capturePath.c_str());
+			return;
+		}
+
+		file.writeString("{\"traceEvents\":[\n");
+		bool first = true;
+		u32 eventTotal = 0;
+		std::vector<const char*> stack;
+		for (size_t t = 0; t < threads.size(); t++)
+		{
+			const TraceThread* thread = &threads[t];
+			file.writeString("%s{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{", first ? "" : ",\n", thread->index);
+			writeTraceName(file, thread->name);
+			file.writeString("}}");
+			first = false;
+
+			// Events that began before the capture or are missing their begin event (overwritten) are skipped,
+			// zones that are still open at the end of the capture are closed.
+			stack.clear();
+			for (size_t i = 0; i < thread->events.size(); i++)
+			{
+				const TraceEvent& evt = thread->events[i];
+				if (evt.type == TRACE_END && stack.empty()) { continue; }
+
+				const f64 ts = TFE_System::convertFromTicksToSeconds(evt.time - s_captureBegin) * 1000000.0;
+				if (evt.type == TRACE_BEGIN)
+				{
+					stack.push_back(evt.name);
+					file.writeString(",\n{\"ph\":\"B\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,", thread->index, ts);
+					writeTraceName(file, evt.name);
+					file.writeString("}");
+				}
+				else
+				{
+					stack.pop_back();
+					file.writeString(",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", thread->index, ts);
+				}
+				eventTotal++;
+			}
+
+			const f64 endTs = TFE_System::convertFromTicksToSeconds(s_captureEnd - s_captureBegin) * 1000000.0;
+			for (size_t i = 0; i < stack.size(); i++)
+			{
+				file.writeString(",\n{\"ph\":\"E\",\"pid\":1,\"tid\":%u,\"ts\":%.3f}", thread->index, endTs);
+			}
+		}
+		file.writeString("\n]}\n");
+		file.close();
+
+		s_lastTracePath = s_capturePath;
+		TFE_System::logWrite(LOG_MSG, "Profiler", "Wrote %u trace events over %u frames to '%s'.", eventTotal, s_captureFrameCount, s_capturePath.c_str());
+	}
 }
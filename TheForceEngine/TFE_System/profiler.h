@@ -3,7 +3,12 @@
 // The Force Engine Profiler
 // Simple "zone" based profiler.
 // Add TFE_PROFILE_ENABLED to preprocessor defines in the build to enable.
-// Currently does not respect the call path, that is TODO.
+//
+// Zones on the main thread are aggregated per call path, so the same
+// zone reached from different parents is timed separately.
+// Zones on all threads can also be captured as raw begin/end events
+// for a number of frames and exported in the Chrome trace event
+// format, which can be viewed in chrome://tracing or Perfetto.
 //////////////////////////////////////////////////////////////////////
 
 #include "types.h"
@@ -61,6 +66,16 @@ namespace TFE_Profiler
 
 	void addCounter(const char* name, s32* counter);
 
+	// Name the calling thread in trace captures.
+	void setThreadName(const char* name);
+
+	// Trace capture, zone names must be string literals (or otherwise stay valid) while capturing.
+	// Capture 'frameCount' frames starting with the next frame, then write the trace to 'path'.
+	bool captureTrace(u32 frameCount, const char* path);
+	bool isCapturingTrace();
+	// Path of the last trace that was written, or an empty string.
+	const char* getLastTracePath();
+
 	// Profile data API, this is used directly.
 	f64  getTimeInFrame();
 
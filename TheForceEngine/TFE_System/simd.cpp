@@ -0,0 +1,51 @@
+#include "simd.h"
+#include <TFE_FrontEndUI/console.h>
+#include <SDL_cpuinfo.h>
+
+namespace TFE_Simd
+{
+	static u32 s_features = 0;
+	static bool s_featuresQueried = false;
+	static bool s_enabled = true;
+
+	u32 getFeatures()
+	{
+		if (!s_featuresQueried)
+		{
+			s_features = SIMD_NONE;
+		#ifdef TFE_SIMD_SSE2
+			if (SDL_HasSSE2()) { s_features |= SIMD_SSE2; }
+		#endif
+		#ifdef TFE_SIMD_AVX2
+			if (SDL_HasAVX2()) { s_features |= SIMD_AVX2; }
+		#endif
+		#ifdef TFE_SIMD_NEON
+			// NEON is mandatory on AArch64 but may be missing on 32-bit ARM.
+			if (SDL_HasNEON()) { s_features |= SIMD_NEON; }
+		#endif
+			s_featuresQueried = true;
+		}
+		return s_enabled ? s_features : u32(SIMD_NONE);
+	}
+
+	void init()
+	{
+		// Most kernels are selected when their system starts up, so this is read from the settings before those systems are initialized.
+		CVAR_BOOL(s_enabled, "d_enableSimd", CVFLAG_NONE, "Use the SIMD code paths supported by the CPU, disable to use the scalar reference code. Requires a restart.");
+	}
+
+	bool hasFeature(SimdFeature feature)
+	{
+		return (getFeatures() & feature) != 0;
+	}
+
+	void enable(bool enable)
+	{
+		s_enabled = enable;
+	}
+
+	bool isEnabled()
+	{
+		return s_enabled;
+	}
+}
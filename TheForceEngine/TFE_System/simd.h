@@ -0,0 +1,49 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// SIMD support
+// Compile-time instruction set detection and runtime CPU feature
+// queries, used to select vectorized inner loops at runtime.
+// Scalar code is always kept as the reference implementation.
+//////////////////////////////////////////////////////////////////////
+#include "types.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define TFE_SIMD_SSE2 1
+	#define TFE_SIMD_AVX2 1
+	#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM_NEON)
+	#define TFE_SIMD_NEON 1
+	#include <arm_neon.h>
+#endif
+
+// Functions using AVX2 intrinsics must be tagged so GCC/Clang generate AVX2 code for them without
+// requiring -mavx2 for the whole program. They must only be called if TFE_Simd::hasFeature(SIMD_AVX2).
+#if defined(TFE_SIMD_AVX2) && (defined(__GNUC__) || defined(__clang__))
+	#define TFE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define TFE_TARGET_AVX2
+#endif
+
+enum SimdFeature
+{
+	SIMD_NONE = 0,
+	SIMD_SSE2 = FLAG_BIT(0),
+	SIMD_AVX2 = FLAG_BIT(1),
+	SIMD_NEON = FLAG_BIT(2),
+};
+
+namespace TFE_Simd
+{
+	// Registers the d_enableSimd console variable, call before initializing the systems that select SIMD code paths.
+	void init();
+
+	// Returns the SIMD features supported by both the build and the CPU (SimdFeature flags).
+	u32 getFeatures();
+	bool hasFeature(SimdFeature feature);
+
+	// Allows SIMD code paths to be disabled for debugging and comparison against the scalar reference.
+	void enable(bool enable);
+	bool isEnabled();
+}
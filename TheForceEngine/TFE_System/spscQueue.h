@@ -0,0 +1,68 @@
+#pragma once
+//////////////////////////////////////////////////////////////////////
+// Single Producer / Single Consumer Queue
+// A fixed size lock-free ring buffer used to pass small messages
+// from exactly one producer thread to exactly one consumer thread,
+// such as commands from the game thread to the audio mixer.
+//////////////////////////////////////////////////////////////////////
+#include "types.h"
+#include <atomic>
+
+template <typename T, u32 Capacity>
+class SpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two.");
+
+public:
+	SpscQueue() : m_head(0), m_tail(0) {}
+
+	// Producer only, returns false if the queue is full.
+	bool push(const T& item)
+	{
+		const u32 tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) >= Capacity) { return false; }
+
+		m_items[tail & (Capacity - 1)] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only, returns false if the queue is empty.
+	bool pop(T& item)
+	{
+		const u32 head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire)) { return false; }
+
+		item = m_items[head & (Capacity - 1)];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only, read the oldest item without removing it. Returns false if the queue is empty.
+	bool peek(T& item) const
+	{
+		const u32 head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire)) { return false; }
+
+		item = m_items[head & (Capacity - 1)];
+		return true;
+	}
+
+	// The number of queued items, this is only a snapshot if the other thread is active.
+	u32 size() const
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+
+	// Drops all queued items, only valid while neither thread is using the queue.
+	void clear()
+	{
+		m_head.store(m_tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	}
+
+private:
+	// Keep the indices on separate cache lines so the producer and consumer do not contend.
+	alignas(64) std::atomic<u32> m_head;
+	alignas(64) std::atomic<u32> m_tail;
+	T m_items[Capacity];
+};
@@ -39,6 +39,9 @@ namespace TFE_System
 
 	static bool s_synced = false;
 	static bool s_resetStartTime = false;
+	static bool s_timeOverride = false;
+	static f64 s_overrideTime = 0.0;
+	static f64 s_overrideDt = 0.0;
 	static bool s_quitMessagePosted = false;
 	static bool s_systemUiRequestPosted = false;
 
@@ -104,6 +107,15 @@ namespace TFE_System
 
 	void update()
 	{
+		if (s_timeOverride)
+		{
+			// The frame time comes from a recording, so the result does not depend on the speed of the machine.
+			s_resetStartTime = false;
+			s_dtRaw = s_overrideDt;
+			s_dt = std::min(s_overrideDt, c_maxDt);
+			return;
+		}
+
 		// This assumes that SDL_GetPerformanceCounter() is monotonic.
 		// However if errors do occur, the dt clamp later should limit the side effects.
 		const u64 curTime = SDL_GetPerformanceCounter();
@@ -170,10 +182,23 @@ namespace TFE_System
 	// Get time since "start time"
 	f64 getTime()
 	{
+		if (s_timeOverride) { return s_overrideTime; }
 		const u64 uDt = s_time - s_startTime;
 		return f64(uDt) * s_freq;
 	}
 	
+	void setFrameTimeOverride(f64 time, f64 dtRaw)
+	{
+		s_timeOverride = true;
+		s_overrideTime = time;
+		s_overrideDt = dtRaw;
+	}
+
+	void clearFrameTimeOverride()
+	{
+		s_timeOverride = false;
+	}
+	
 	u64 getCurrentTimeInTicks()
 	{
 		return SDL_GetPerformanceCounter() - s_startTime;
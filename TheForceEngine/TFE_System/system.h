@@ -47,6 +47,9 @@ namespace TFE_System
 	f64 getDeltaTimeRaw();
 	// Get the absolute time since the last start time.
 	f64 getTime();
+	// Replays: update() uses the recorded frame time instead of the system timer until the override is cleared.
+	void setFrameTimeOverride(f64 time, f64 dtRaw);
+	void clearFrameTimeOverride();
 
 	u64 getCurrentTimeInTicks();
 	f64 convertFromTicksToSeconds(u64 ticks);
@@ -57,6 +60,10 @@ namespace TFE_System
 	// Log
 	bool logOpen(const char* filename);
 	void logClose();
+	// Write out all queued log messages now, such as from a crash handler.
+	void logFlush();
+	// Crash handlers call this first: logging then writes directly and never blocks on the log writer thread.
+	void logEnterCrashMode();
 	void logWrite(LogWriteType type, const char* tag, const char* str, ...);
 
 	// Lighter weight debug output (only useful when running in a terminal or debugger).
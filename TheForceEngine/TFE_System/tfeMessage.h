@@ -21,6 +21,7 @@ enum TFE_Message
 	TFE_MSG_ONEHITKILL,
 	TFE_MSG_HARDCORE,
 	TFE_MSG_FULLBRIGHT,
+	TFE_MSG_SAVE_FAILED,
 	TFE_MSG_COUNT
 };
 
@@ -7,9 +7,12 @@
 #include <TFE_Archive/gobArchive.h>
 #include <TFE_Game/igame.h>
 #include <TFE_Game/saveSystem.h>
+#include <TFE_Game/inputRecorder.h>
 #include <TFE_Game/reticle.h>
 #include <TFE_Jedi/InfSystem/infSystem.h>
 #include <TFE_FileSystem/fileutil.h>
+#include <TFE_FileSystem/filestream.h>
+#include <TFE_FileSystem/filewriterAsync.h>
 #include <TFE_Audio/audioSystem.h>
 #include <TFE_FileSystem/paths.h>
 #include <TFE_Polygon/polygon.h>
@@ -19,8 +22,11 @@
 #include <TFE_System/system.h>
 #include <TFE_System/CrashHandler/crashHandler.h>
 #include <TFE_System/frameLimiter.h>
+#include <TFE_System/parallel.h>
+#include <TFE_System/simd.h>
 #include <TFE_System/tfeMessage.h>
 #include <TFE_Jedi/Task/task.h>
+#include <TFE_Jedi/Renderer/jediRenderer.h>
 #include <TFE_RenderShared/texturePacker.h>
 #include <TFE_Asset/paletteAsset.h>
 #include <TFE_Asset/imageAsset.h>
@@ -79,6 +85,7 @@ static char s_screenshotTime[TFE_MAX_PATH];
 static s32  s_startupGame = -1;
 static IGame* s_curGame = nullptr;
 static const char* s_loadRequestFilename = nullptr;
+static const char* s_benchmarkReplay = nullptr;
 
 void parseOption(const char* name, const std::vector<const char*>& values, bool longName);
 bool validatePath();
@@ -189,6 +196,22 @@ void handleEvent(SDL_Event& Event)
 						_recording = false;
 					}
 				}
+				else if (code == KeyboardCode::KEY_F3 && altHeld)
+				{
+					static u64 _replayIndex = 0;
+					if (TFE_InputRecorder::isRecording())
+					{
+						TFE_InputRecorder::stopRecording(s_curGame);
+					}
+					else if (s_curGame)
+					{
+						char replayName[TFE_MAX_PATH];
+						sprintf(replayName, "tfe_replay_%s_%" PRIu64 ".tfr", s_screenshotTime, _replayIndex);
+						_replayIndex++;
+
+						TFE_InputRecorder::startRecording(s_curGame, replayName);
+					}
+				}
 			}
 		} break;
 		case SDL_TEXTINPUT:
@@ -348,6 +371,7 @@ void setAppState(AppState newState, int argc, char* argv[])
 			TFE_Game* gameInfo = TFE_Settings::getGame();
 			if (s_curGame)
 			{
+				TFE_InputRecorder::stopRecording(s_curGame);
 				freeGame(s_curGame);
 				s_curGame = nullptr;
 			}
@@ -390,6 +414,7 @@ void setAppState(AppState newState, int argc, char* argv[])
 				s_soundPaused = false;
 				if (s_curGame)
 				{
+					TFE_InputRecorder::stopRecording(s_curGame);
 					freeGame(s_curGame);
 					s_curGame = nullptr;
 				}
@@ -530,6 +555,106 @@ bool validatePath()
 	return TFE_Paths::hasPath(PATH_SOURCE_DATA);
 }
 
+// Logs the average, 99th percentile and maximum of the per-frame times.
+static void reportFrameTimes(const char* name, std::vector<f64>& times)
+{
+	if (times.empty()) { return; }
+	f64 total = 0.0;
+	for (size_t i = 0; i < times.size(); i++)
+	{
+		total += times[i];
+	}
+	std::sort(times.begin(), times.end());
+	const size_t p99 = std::min(times.size() - 1, times.size() * 99 / 100);
+	TFE_System::logWrite(LOG_MSG, "Benchmark", "%s: avg %.3f ms, p99 %.3f ms, max %.3f ms, total %.3f ms.",
+		name, total / f64(times.size()), times[p99], times.back(), total);
+}
+
+// Replays a recording without presenting frames, as fast as possible, and reports the time spent
+// in the simulation and world rendering. The final game state hash is compared to the recording to
+// verify that the replay did not diverge. Per-frame times are written next to the recording as CSV.
+static bool runBenchmark(const char* replayName)
+{
+	TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
+	const s32 rendererIndex = graphics->rendererIndex;
+	graphics->rendererIndex = RENDERER_SOFTWARE;
+
+	TFE_Game* gameInfo = TFE_Settings::getGame();
+	s_curGame = validatePath() ? createGame(gameInfo->id) : nullptr;
+	TFE_SaveSystem::setCurrentGame(s_curGame);
+	if (!s_curGame || !TFE_InputRecorder::startReplay(s_curGame, replayName))
+	{
+		TFE_System::logWrite(LOG_ERROR, "Benchmark", "Cannot start replay '%s'.", replayName);
+		if (s_curGame)
+		{
+			freeGame(s_curGame);
+			s_curGame = nullptr;
+		}
+		graphics->rendererIndex = rendererIndex;
+		return false;
+	}
+	s_curState = APP_STATE_GAME;
+
+	const u32 frameCount = TFE_InputRecorder::getFrameCount();
+	std::vector<f64> simTime, renderTime;
+	simTime.reserve(frameCount);
+	renderTime.reserve(frameCount);
+
+	const u64 startTicks = TFE_System::getCurrentTimeInTicks();
+	TFE_Jedi::renderer_takeDrawTicks();
+	while (TFE_InputRecorder::replayFrame(s_curGame))
+	{
+		inputMapping_updateInput();
+		TFE_System::update();
+
+		const u64 frameStart = TFE_System::getCurrentTimeInTicks();
+		s_curGame->loopGame();
+		const bool endInputFrame = TFE_Jedi::task_run() != 0;
+		const u64 frameTicks = TFE_System::getCurrentTimeInTicks() - frameStart;
+		const u64 drawTicks = std::min(frameTicks, TFE_Jedi::renderer_takeDrawTicks());
+
+		simTime.push_back(TFE_System::convertFromTicksToSeconds(frameTicks - drawTicks) * 1000.0);
+		renderTime.push_back(TFE_System::convertFromTicksToSeconds(drawTicks) * 1000.0);
+		if (endInputFrame)
+		{
+			TFE_Input::endFrame();
+			inputMapping_endFrame();
+		}
+	}
+	const f64 totalTime = TFE_System::convertFromTicksToSeconds(TFE_System::getCurrentTimeInTicks() - startTicks);
+
+	const u64 stateHash = TFE_InputRecorder::computeStateHash(s_curGame);
+	const u64 recordedHash = TFE_InputRecorder::getRecordedStateHash();
+	const bool match = !recordedHash || stateHash == recordedHash;
+	TFE_InputRecorder::stopReplay();
+
+	char csvPath[TFE_MAX_PATH], replayPath[TFE_MAX_PATH];
+	TFE_InputRecorder::getReplayPath(replayName, replayPath);
+	FileUtil::replaceExtension(replayPath, "csv", csvPath);
+	FileStream csv;
+	if (csv.open(csvPath, Stream::MODE_WRITE))
+	{
+		csv.writeString("frame,simulation_ms,render_ms\n");
+		for (size_t i = 0; i < simTime.size(); i++)
+		{
+			csv.writeString("%zu,%.4f,%.4f\n", i, simTime[i], renderTime[i]);
+		}
+		csv.close();
+	}
+
+	TFE_System::logWrite(LOG_MSG, "Benchmark", "Replayed %zu of %u frames in %.3f sec (%.1f fps).", simTime.size(), frameCount,
+		totalTime, totalTime > 0.0 ? f64(simTime.size()) / totalTime : 0.0);
+	reportFrameTimes("Simulation", simTime);
+	reportFrameTimes("Render", renderTime);
+	TFE_System::logWrite(match ? LOG_MSG : LOG_ERROR, "Benchmark", "Final state hash %016" PRIx64 ", recorded %016" PRIx64 " - %s.",
+		stateHash, recordedHash, !recordedHash ? "not recorded" : (match ? "match" : "DESYNC"));
+
+	freeGame(s_curGame);
+	s_curGame = nullptr;
+	graphics->rendererIndex = rendererIndex;
+	return match && simTime.size() == frameCount;
+}
+
 int main(int argc, char* argv[])
 {
 	#if INSTALL_CRASH_HANDLER
@@ -615,7 +740,7 @@ int main(int argc, char* argv[])
 	}
 	TFE_Settings_Window* windowSettings = TFE_Settings::getWindowSettings();
 	TFE_Settings_Graphics* graphics = TFE_Settings::getGraphicsSettings();
-	TFE_System::init(s_refreshRate, graphics->vsync, c_gitVersion);
+	TFE_System::init(s_refreshRate, graphics->vsync && !s_benchmarkReplay, c_gitVersion);
 	
 	// Setup the GPU Device and Window.
 	u32 windowFlags = 0;
@@ -624,7 +749,12 @@ int main(int argc, char* argv[])
 		TFE_System::logWrite(LOG_MSG, "Display", "Fullscreen enabled.");
 		windowFlags |= WINFLAG_FULLSCREEN;
 	}
-	if (graphics->vsync) { TFE_System::logWrite(LOG_MSG, "Display", "Vertical Sync enabled."); windowFlags |= WINFLAG_VSYNC; }
+	if (s_benchmarkReplay)
+	{
+		// Benchmarks only render to the CPU framebuffer and run as fast as possible.
+		windowFlags = WINFLAG_HIDDEN;
+	}
+	else if (graphics->vsync) { TFE_System::logWrite(LOG_MSG, "Display", "Vertical Sync enabled."); windowFlags |= WINFLAG_VSYNC; }
 	
 	WindowState windowState =
 	{
@@ -646,6 +776,7 @@ int main(int argc, char* argv[])
 		return PROGRAM_ERROR;
 	}
 	TFE_FrontEndUI::initConsole();
+	TFE_Simd::init();
 	TFE_Audio::init(s_nullAudioDevice, TFE_Settings::getSoundSettings()->audioDevice);
 	TFE_MidiPlayer::init(TFE_Settings::getSoundSettings()->midiOutput, (MidiDeviceType)TFE_Settings::getSoundSettings()->midiType);
 	TFE_Image::init();
@@ -688,6 +819,16 @@ int main(int argc, char* argv[])
 	// Setup the framelimiter.
 	TFE_System::frameLimiter_set(graphics->frameRateLimit);
 
+	s32 exitCode = PROGRAM_SUCCESS;
+	if (s_benchmarkReplay)
+	{
+		s_loop = false;
+		if (!runBenchmark(s_benchmarkReplay))
+		{
+			exitCode = PROGRAM_ERROR;
+		}
+	}
+
 	// Start reading the mods immediately?
 	TFE_FrontEndUI::modLoader_read();
 
@@ -751,6 +892,7 @@ int main(int argc, char* argv[])
 			{
 				if (s_curGame)
 				{
+					TFE_InputRecorder::stopRecording(s_curGame);
 					freeGame(s_curGame);
 					s_curGame = nullptr;
 				}
@@ -778,6 +920,7 @@ int main(int argc, char* argv[])
 		if (TFE_A11Y::hasPendingFont()) { TFE_A11Y::loadPendingFont(); } // Can't load new fonts between TFE_Ui::begin() and TFE_Ui::render();
 		TFE_Ui::begin();
 		TFE_System::update();
+		TFE_Audio::update();
 
 		// Update
 		if (TFE_FrontEndUI::uiControlsEnabled() && task_canRun())
@@ -871,6 +1014,8 @@ int main(int argc, char* argv[])
 			}
 			else
 			{
+				// Every simulated frame is recorded, including paused frames and frames with the console open.
+				TFE_InputRecorder::recordFrame(s_curGame);
 				TFE_SaveSystem::update();
 				s_curGame->loopGame();
 				endInputFrame = TFE_Jedi::task_run() != 0;
@@ -924,6 +1069,7 @@ int main(int argc, char* argv[])
 
 	if (s_curGame)
 	{
+		TFE_InputRecorder::stopRecording(s_curGame);
 		freeGame(s_curGame);
 		s_curGame = nullptr;
 	}
@@ -943,6 +1089,8 @@ int main(int argc, char* argv[])
 	TFE_Jedi::texturepacker_freeGlobal();
 	TFE_RenderBackend::destroy();
 	TFE_SaveSystem::destroy();
+	FileWriterAsync::shutdown();
+	TFE_Parallel::shutdown();
 	SDL_Quit();
 
 	#ifdef ENABLE_FORCE_SCRIPT
@@ -952,7 +1100,7 @@ int main(int argc, char* argv[])
 	TFE_System::logWrite(LOG_MSG, "Progam Flow", "The Force Engine Game Loop Ended.");
 	TFE_System::logClose();
 	TFE_System::freeMessages();
-	return PROGRAM_SUCCESS;
+	return exitCode;
 }
 
 void parseOption(const char* name, const std::vector<const char*>& values, bool longName)
@@ -1008,5 +1156,12 @@ void parseOption(const char* name, const std::vector<const char*>& values, bool
 		{
 			TFE_Settings::getTempSettings()->skipLoadDelay = true;
 		}
+		else if (strcasecmp(name, "benchmark") == 0 && values.size() >= 1)
+		{
+			// --benchmark replayName
+			s_benchmarkReplay = values[0];
+			s_nullAudioDevice = true;
+			TFE_System::logWrite(LOG_MSG, "CommandLine", "Benchmark replay: %s", s_benchmarkReplay);
+		}
 	}
 }
\ No newline at end of file